@@ -50,7 +50,10 @@
 
 #include <angles/angles.h>
 
+#include <nav_msgs/OccupancyGrid.h>
 #include <nav_msgs/Odometry.h>
+#include <nav_msgs/Path.h>
+#include <sensor_msgs/LaserScan.h>
 
 #include <costmap_2d/costmap_2d_ros.h>
 #include <nav_core/base_local_planner.h>
@@ -59,12 +62,23 @@
 #include <base_local_planner/odometry_helper_ros.h>
 
 #include <dubins_plus/dubins_plus.h>
+#include <mprim_lattice/mprim_lattice.h>
+#include <mprim_lattice/parametric.h>
+
+#include <ackermann_local_planner/message_pool.h>
+#include <ackermann_local_planner/planner_core.h>
+#include <ackermann_local_planner/planner_policies.h>
+#include <ackermann_local_planner/recorder.h>
 
 namespace ackermann_local_planner {
   /**
    * @class AckermannPlannerROS
    * @brief ROS Wrapper for the AckermannPlanner that adheres to the
    * BaseLocalPlanner interface and can be used as a plugin for move_base.
+   *
+   * The planning itself is in DefaultPlanner; this reads its parameters,
+   * gathers its inputs from tf, odometry and the costmap, and logs and
+   * publishes what it did.
    */
   class AckermannPlannerROS : public nav_core::BaseLocalPlanner {
     public:
@@ -118,13 +132,41 @@ namespace ackermann_local_planner {
        */
       void reconfigureCB(AckermannPlannerConfig &config, uint32_t level);
 
-      int nearestPoint(const int start_point, 
-          const tf::Stamped<tf::Pose> & pose) const;
-      double scoreTrajectory(const std::vector<dubins_plus::Segment> &path,
-          double global_length, double global_dtheta) const;
+      /**
+       * @brief One planning cycle; computeVelocityCommands wraps this in a
+       * trace span
+       */
+      bool planCycle(geometry_msgs::Twist& cmd_vel);
+
+      /**
+       * @brief Log what a cycle did
+       */
+      void logCycle(const CycleResult &result) const;
 
-      void publishLocalPlan(std::vector<geometry_msgs::PoseStamped>& path);
-      void publishGlobalPlan(std::vector<geometry_msgs::PoseStamped>& path);
+      void scanCallback(const sensor_msgs::LaserScan::ConstPtr &scan);
+
+      /**
+       * @brief Pass the points of the latest scan to the planner, in the
+       * costmap frame
+       * @return false if there is no recent scan to check against
+       */
+      bool updateScan();
+
+      void globalCostmapCallback(
+          const nav_msgs::OccupancyGrid::ConstPtr &grid);
+
+      /**
+       * @brief If the global costmap or the plan changed, give the planner
+       * the part of the global costmap around the plan to compute the cost
+       * to go on
+       */
+      void updateCostToGoMap();
+
+      void publishLocalPlan(const std::vector<dubins_plus::Segment>& path,
+          const Pose2D& start);
+      void publishGlobalPlan(const std::vector<geometry_msgs::PoseStamped>& path);
+      void publishPose(const Pose2D& pose,
+          const ros::Publisher& pub);
 
       tf::TransformListener* tf_; ///< @brief Used for transforming point clouds
 
@@ -140,23 +182,6 @@ namespace ackermann_local_planner {
 
       base_local_planner::OdometryHelperRos odom_helper_;
 
-      std::vector<geometry_msgs::PoseStamped> plan_;
-
-      // Limits
-      double max_vel_;
-      double min_vel_;
-      double min_radius_;
-      double acc_lim_;
-
-      double lookahead_factor_;
-
-      double xy_goal_tolerance_;
-      double yaw_goal_tolerance_;
-
-      bool move_;
-
-      int radius_samples_;
-
       // configuration
       bool have_particlecloud_;
       bool have_pose_with_cow_;
@@ -167,25 +192,35 @@ namespace ackermann_local_planner {
       ros::Publisher goal_pub_;
       ros::Publisher near_point_pub_;
 
-      // transient data
-      int last_plan_point_;
-
-      bool goal_reached_;
+      // debug messages are published by pointer so that subscribers in the
+      // same process don't pay for serialization
+      MessagePool<nav_msgs::Path> path_pool_;
+      MessagePool<geometry_msgs::PoseStamped> pose_pool_;
+
+      // what the planner sees each cycle, for replaying it offline
+      InputRecorder recorder_;
+
+      // the laser scan, for collision checks against it and for tracking
+      // moving obstacles
+      ros::Subscriber scan_sub_;
+      boost::mutex scan_mutex_;
+      sensor_msgs::LaserScan::ConstPtr scan_;
+      std::vector<double> scan_x_;
+      std::vector<double> scan_y_;
+
+      // the global costmap, for the cost to go, cropped to the plan's
+      // bounds plus cost_to_go_margin
+      ros::Subscriber global_costmap_sub_;
+      boost::mutex global_costmap_mutex_;
+      nav_msgs::OccupancyGrid::ConstPtr global_costmap_;
+      bool global_costmap_changed_;
+      std::string plan_frame_;
+      dubins_plus::Bounds plan_bounds_;
+      double cost_to_go_margin_;
+      std::vector<unsigned char> cost_to_go_cells_;
+
+      // the planner itself; everything above just feeds it
+      DefaultPlanner planner_;
   };
-
-  // Helper functions that don't need class context
-
-  /**
-   * @brief determine if one point is forward or backwards from another
-   */
-  bool isForwards(const geometry_msgs::PoseStamped &start,
-      const geometry_msgs::PoseStamped &end);
-
-  /**
-   * @brief compute the distance between two points
-   */
-  double dist(const geometry_msgs::PoseStamped &start,
-      const geometry_msgs::PoseStamped &end);
-
 };
 #endif
@@ -0,0 +1,141 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_CELL_TRAVERSAL_H_
+#define ACKERMANN_LOCAL_PLANNER_CELL_TRAVERSAL_H_
+
+namespace ackermann_local_planner {
+  /**
+   * @class CellTraversal
+   * @brief The grid cells that a line or a circular arc passes through, in
+   * the order it passes through them
+   *
+   * Coordinates are in cells: cell (i, j) covers [i, i+1) x [j, j+1). Every
+   * cell the curve touches is visited, with no samples in between; a cell
+   * is only visited again if the curve leaves it and comes back.
+   *
+   * A line is walked as in Amanatides and Woo: the arc length to the next
+   * grid line in x and in y is known, and whichever is nearer is crossed.
+   * An arc is split where its heading crosses a multiple of pi/2. Within
+   * each piece x and y are monotone, so the same walk works, with the next
+   * crossing in each axis found in closed form on the circle.
+   */
+  class CellTraversal {
+    public:
+      /**
+       * @param x, y, theta Start pose, in cells
+       * @param length Arc length, in cells
+       * @param curvature Signed, per cell; + turns left
+       */
+      CellTraversal(double x, double y, double theta, double length,
+          double curvature);
+
+      /**
+       * @brief The next cell along the curve
+       * @return false once the end of the curve has been passed
+       */
+      bool next(int &cx, int &cy);
+
+      /**
+       * @brief Arc length, in cells, at which the curve entered the cell
+       * last returned by next()
+       */
+      double entry() const { return entry_; }
+
+    private:
+      void beginPiece();
+      double crossingX(double gx) const;
+      double crossingY(double gy) const;
+
+      // the curve
+      double x_;
+      double y_;
+      double theta_;
+      double length_;
+      double curvature_;
+      bool arc_;
+      // center of the arc
+      double center_x_;
+      double center_y_;
+
+      // the current piece: where it starts and ends, its quadrant of
+      // headings, and the direction of travel in each axis across it
+      int piece_;
+      double piece_start_;
+      double piece_end_;
+      int quadrant_;
+      int step_x_;
+      int step_y_;
+      // where the piece ends, for crossings it can't reach
+      double end_x_;
+      double end_y_;
+
+      // the current cell, and the arc length to the next grid line in
+      // each axis
+      int cx_;
+      int cy_;
+      double entry_;
+      double next_x_;
+      double next_y_;
+
+      bool started_;
+      bool done_;
+  };
+
+  /**
+   * @brief The lowest inflated cost a cell can have when a disc, centered
+   * anywhere inside it, touches a lethal cell
+   *
+   * The inflation layer gives each cell a cost that falls off with the
+   * distance from its center to the nearest lethal cell. The disc center is
+   * within half a cell diagonal of the center of its cell, so any lethal
+   * cell the disc touches is within radius plus that of the cell center,
+   * and the cell's cost is at least the cost at that distance. Checking the
+   * cells the disc center passes through against this threshold finds every
+   * collision that checking every cell under the disc would.
+   *
+   * @param radius Disc radius, in meters
+   * @param resolution Costmap cell size, in meters
+   * @param inscribed_radius, inflation_radius, cost_scaling_factor The
+   * costmap's inflation parameters
+   * @return The threshold, or 0 if the disc reaches further than the
+   * inflation, and the cost of the cell under its center can't tell
+   */
+  unsigned char inflatedThreshold(double radius, double resolution,
+      double inscribed_radius, double inflation_radius,
+      double cost_scaling_factor);
+};
+#endif
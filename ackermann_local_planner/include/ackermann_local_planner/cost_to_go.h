@@ -0,0 +1,133 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_COST_TO_GO_H_
+#define ACKERMANN_LOCAL_PLANNER_COST_TO_GO_H_
+
+#include <vector>
+#include <utility>
+
+#include <ackermann_local_planner/planner_types.h>
+
+namespace ackermann_local_planner {
+  /**
+   * @class CostToGoField
+   * @brief Wavefront of the cost to reach the goal along the global plan
+   *
+   * Every cell of the costmap that the plan passes through is a source,
+   * seeded with the length of the plan that remains from there to the goal,
+   * and a Dijkstra expansion spreads that outwards around obstacles. The
+   * field is kept across cycles: an update only recomputes the cells whose
+   * cost changed, the cells whose best route went through them, and the
+   * cells that scrolled into a rolling window.
+   */
+  class CostToGoField {
+    public:
+      CostToGoField();
+
+      /**
+       * @brief Set the plan the field leads to. The next update() is a full
+       * recomputation
+       */
+      void setPlan(const std::vector<Pose2D> &plan);
+
+      /**
+       * @brief Bring the field up to date with the costmap
+       */
+      void update(const CostGrid &costmap);
+
+      /**
+       * @brief Cost to go from a point in the costmap frame, in meters of
+       * (cost weighted) travel. Infinite if the point is unreachable or
+       * outside the map
+       */
+      double costAt(double wx, double wy) const;
+
+      /**
+       * @brief The number of cells recomputed by the last update
+       */
+      int lastUpdateSize() const { return updated_cells_; }
+
+    private:
+      typedef std::pair<float, int> QueueEntry;
+
+      void reset(const CostGrid &costmap);
+      bool shift(const CostGrid &costmap);
+      void computeSeeds(std::vector<float> &seeds) const;
+      void invalidate(std::vector<int> &roots);
+      void reseed(int cell);
+      void push(int cell, float dist);
+      void propagate();
+
+      inline float traversal(unsigned char cost) const;
+
+      // the plan, as x, y and the length of plan remaining to the goal
+      struct PlanPoint {
+        double x;
+        double y;
+        float remaining;
+      };
+      std::vector<PlanPoint> plan_;
+      bool plan_changed_;
+
+      // geometry of the costmap the field was computed on
+      int size_x_;
+      int size_y_;
+      double resolution_;
+      double origin_x_;
+      double origin_y_;
+
+      std::vector<unsigned char> costs_;
+      std::vector<float> seeds_;
+      std::vector<float> dist_;
+      // the neighbour each cell's cost to go was computed from; -1 for none
+      std::vector<int> parent_;
+
+      // scratch space, kept to avoid allocating during updates
+      std::vector<char> invalid_;
+      std::vector<int> invalid_cells_;
+      std::vector<QueueEntry> queue_;
+      std::vector<float> new_seeds_;
+      std::vector<int> roots_;
+      std::vector<int> decreased_;
+      std::vector<unsigned char> shift_costs_;
+      std::vector<float> shift_dist_;
+      std::vector<int> shift_parent_;
+
+      int updated_cells_;
+  };
+};
+#endif
@@ -0,0 +1,178 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_COSTMAP_PYRAMID_H_
+#define ACKERMANN_LOCAL_PLANNER_COSTMAP_PYRAMID_H_
+
+#include <vector>
+
+#include <dubins_plus/dubins_plus.h>
+#include <ackermann_local_planner/planner_types.h>
+#include <ackermann_local_planner/scan_collision.h>
+
+namespace ackermann_local_planner {
+  /**
+   * @class CostmapPyramid
+   * @brief Max-pooled copies of the costmap at 1x, 2x, 4x and 8x the cell
+   * size, for coarse-to-fine collision checks
+   *
+   * Each cell of a coarse level holds the highest cost of the cells it
+   * covers, so a coarse cell below the threshold proves that all of them are
+   * free, and a coarse cell at or above the threshold that lies entirely
+   * inside a disc proves a collision. Only the cells where neither holds are
+   * looked at more closely, and the answer is always the same as checking
+   * every cell.
+   *
+   * Coarse cells are aligned to the world rather than to the costmap, so
+   * that when a rolling window scrolls the levels can be shifted instead of
+   * rebuilt. An update only recomputes the rows and columns that changed.
+   */
+  class CostmapPyramid {
+    public:
+      /// @brief the full resolution level and three max-pooled levels
+      static const int LEVELS = 4;
+
+      CostmapPyramid();
+
+      /**
+       * @brief Bring the pyramid up to date with the costmap
+       *
+       * Cells of unknown cost are treated as free.
+       */
+      void update(const CostGrid &costmap);
+
+      /**
+       * @brief The number of cells, across all levels, recomputed by the last
+       * update
+       */
+      int lastUpdateSize() const { return updated_cells_; }
+
+      /**
+       * @brief The cost of the cell of a level that covers a cell of the
+       * costmap
+       */
+      unsigned char levelCost(int level, int mx, int my) const;
+
+      /**
+       * @brief Check that no cell with its center inside a disc has a cost at
+       * or above the threshold. Cells outside of the costmap are free
+       *
+       * @param wx, wy Center of the disc, in the costmap frame
+       * @param radius Radius of the disc, in meters
+       * @param threshold Lowest cost that is a collision
+       * @param coarse_to_fine Use the coarse levels; if false every cell under
+       * the disc is checked
+       */
+      bool discFree(double wx, double wy, double radius,
+          unsigned char threshold, bool coarse_to_fine) const;
+
+      /**
+       * @brief Check that no cell with its center inside a box has a cost at
+       * or above the threshold, using the coarse levels. Cells outside of
+       * the costmap are free
+       */
+      bool boxFree(const dubins_plus::Bounds &box,
+          unsigned char threshold) const;
+
+      /**
+       * @brief Check the discs covering the robot at poses along a path, at
+       * most one cell apart
+       *
+       * @param path Segments with positive lengths, driven in the direction
+       * of theta
+       * @param x, y, theta Start pose, in the costmap frame
+       * @param discs The robot, in the robot frame
+       */
+      bool pathClear(const std::vector<dubins_plus::Segment> &path,
+          double x, double y, double theta,
+          const std::vector<Disc> &discs, unsigned char threshold,
+          bool coarse_to_fine) const;
+
+      /**
+       * @brief Check the cells the center of each disc passes through along
+       * a path against an inflated cost threshold
+       *
+       * The disc centers move along lines and arcs, which are walked exactly
+       * cell by cell; see CellTraversal and inflatedThreshold.
+       *
+       * @param thresholds Lowest cost that is a collision, for each disc
+       */
+      bool traversalClear(const std::vector<dubins_plus::Segment> &path,
+          double x, double y, double theta,
+          const std::vector<Disc> &discs,
+          const std::vector<unsigned char> &thresholds) const;
+
+    private:
+      struct Level {
+        // world-aligned index of cell 0, and size, in cells of this level
+        int base_x;
+        int base_y;
+        int size_x;
+        int size_y;
+        std::vector<unsigned char> cost;
+        // the span of each row that changed in this update; empty if
+        // lo > hi
+        std::vector<int> dirty_lo;
+        std::vector<int> dirty_hi;
+
+        Level() : base_x(0), base_y(0), size_x(0), size_y(0) {}
+      };
+
+      void resize(int size_x, int size_y);
+      void shift(int dx, int dy);
+      void markDirty(int level, int x, int y);
+      void poolCell(int level, int x, int y);
+      void propagate(bool edges);
+
+      bool nodeFree(int level, int cx, int cy, double u, double v,
+          double r2, unsigned char threshold) const;
+      bool boxNodeFree(int level, int cx, int cy, int x0, int y0, int x1,
+          int y1, unsigned char threshold) const;
+
+      Level levels_[LEVELS];
+
+      // geometry of the costmap the pyramid was built from
+      double resolution_;
+      double origin_x_;
+      double origin_y_;
+      // world-aligned index of the costmap's cell 0,0
+      int cell_x_;
+      int cell_y_;
+
+      int updated_cells_;
+  };
+};
+#endif
@@ -0,0 +1,100 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_ESCAPE_RECOVERY_H_
+#define ACKERMANN_LOCAL_PLANNER_ESCAPE_RECOVERY_H_
+
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+#include <tf/transform_listener.h>
+#include <costmap_2d/costmap_2d_ros.h>
+#include <nav_core/recovery_behavior.h>
+
+#include <dubins_plus/dubins_plus.h>
+#include <ackermann_local_planner/escape_search.h>
+
+namespace ackermann_local_planner {
+  /**
+   * @class EscapeRecovery
+   * @brief A recovery behavior that backs and fills out of tight spots
+   *
+   * Runs an EscapeSearch against the local costmap, and drives the maneuver
+   * it finds, checking the rest of each segment against the costmap as it
+   * goes.
+   *
+   * The turning radius is the local planner's min_radius, read from the
+   * planner's namespace (planner_namespace, AckermannPlannerROS by default)
+   * unless it is set for this behavior.
+   */
+  class EscapeRecovery : public nav_core::RecoveryBehavior {
+    public:
+      EscapeRecovery();
+
+      void initialize(std::string name, tf::TransformListener *tf,
+          costmap_2d::Costmap2DROS *global_costmap,
+          costmap_2d::Costmap2DROS *local_costmap);
+
+      void runBehavior();
+
+      /**
+       * @brief Search the current local costmap for a maneuver from a pose,
+       * in the costmap frame
+       * @param maneuver Set to the segments to drive; negative lengths are
+       * driven in reverse
+       * @return false if no maneuver gets any more free space ahead
+       */
+      bool search(double x, double y, double theta,
+          std::vector<dubins_plus::Segment> &maneuver);
+
+    private:
+      bool getRobotPose(double &x, double &y, double &theta);
+      void updateCostmap();
+      bool drive(const dubins_plus::Segment &segment);
+      void stop();
+
+      bool initialized_;
+      std::string name_;
+      costmap_2d::Costmap2DROS *local_costmap_;
+      EscapeSearch search_;
+      ros::Publisher vel_pub_;
+
+      double speed_;
+      double frequency_;
+  };
+};
+#endif
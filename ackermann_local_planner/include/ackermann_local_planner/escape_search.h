@@ -0,0 +1,141 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_ESCAPE_SEARCH_H_
+#define ACKERMANN_LOCAL_PLANNER_ESCAPE_SEARCH_H_
+
+#include <vector>
+
+#include <dubins_plus/dubins_plus.h>
+#include <ackermann_local_planner/costmap_pyramid.h>
+#include <ackermann_local_planner/planner_types.h>
+#include <ackermann_local_planner/scan_collision.h>
+
+namespace ackermann_local_planner {
+  /**
+   * @brief Parameters of an EscapeSearch; the same names as the parameters
+   * of EscapeRecovery
+   */
+  struct EscapeSearchOptions {
+    /// @brief turning radius of the arcs
+    double min_radius;
+    /// @brief most segments in a maneuver
+    int max_segments;
+    double min_segment_length;
+    double max_segment_length;
+    /// @brief segment lengths tried, from the shortest to the longest
+    int length_samples;
+    /// @brief extra cost of changing direction, in meters
+    double reverse_penalty;
+    /// @brief free space ahead to count as escaped
+    double clear_distance;
+    /// @brief longest a search can take, in seconds
+    double search_time;
+
+    EscapeSearchOptions();
+  };
+
+  /**
+   * @class EscapeSearch
+   * @brief Searches for a maneuver that backs and fills out of a tight spot
+   *
+   * Searches short maneuvers of up to max_segments forward and reverse arcs
+   * at the minimum turning radius, or straight, against a costmap: three-point
+   * and N-point turns. The cheapest maneuver that ends with clear_distance of
+   * free space ahead, both straight and at full lock either way, is found.
+   * The search is bounded by search_time; if it runs out first, the maneuver
+   * found so far that ends with the most free space ahead is returned
+   * instead.
+   */
+  class EscapeSearch {
+    public:
+      EscapeSearch();
+
+      void setOptions(const EscapeSearchOptions &options);
+      const EscapeSearchOptions &options() const { return options_; }
+
+      /**
+       * @brief Set the robot's footprint, in the robot frame
+       */
+      void setFootprint(const std::vector<Point2D> &footprint);
+
+      /**
+       * @brief Bring the search up to date with the costmap
+       */
+      void updateCostmap(const CostGrid &costmap);
+
+      /**
+       * @brief Search for a maneuver from a pose, in the costmap frame
+       * @param maneuver Set to the segments to drive; negative lengths are
+       * driven in reverse
+       * @return false if no maneuver gets any more free space ahead, or if
+       * there is already enough
+       */
+      bool search(double x, double y, double theta,
+          std::vector<dubins_plus::Segment> &maneuver);
+
+      /**
+       * @brief Check a segment against the costmap; a negative length is
+       * driven in reverse
+       */
+      bool segmentClear(const dubins_plus::Segment &segment,
+          double x, double y, double theta) const;
+
+      /**
+       * @brief Free space ahead of a pose, straight and at full lock either
+       * way, up to clear_distance in quarters of it
+       */
+      double freeAhead(double x, double y, double theta) const;
+
+      /// @brief maneuvers looked at by the last search
+      int expanded() const { return expanded_; }
+      /// @brief whether the last search ran out of time
+      bool timedOut() const { return timed_out_; }
+      /// @brief free space ahead at the end of the last search's maneuver
+      double ahead() const { return ahead_; }
+
+    private:
+      EscapeSearchOptions options_;
+      CostmapPyramid costmap_pyramid_;
+      std::vector<Disc> forward_discs_;
+      std::vector<Disc> reverse_discs_;
+
+      int expanded_;
+      bool timed_out_;
+      double ahead_;
+  };
+};
+#endif
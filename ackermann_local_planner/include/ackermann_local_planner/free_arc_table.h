@@ -0,0 +1,114 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_FREE_ARC_TABLE_H_
+#define ACKERMANN_LOCAL_PLANNER_FREE_ARC_TABLE_H_
+
+#include <vector>
+
+#include <ackermann_local_planner/planner_types.h>
+#include <ackermann_local_planner/scan_collision.h>
+
+namespace ackermann_local_planner {
+  /**
+   * @class FreeArcTable
+   * @brief How far the robot can drive along each curvature before it hits
+   * something
+   *
+   * Built in one pass over the obstacles. Driving at a constant curvature,
+   * the center of each disc covering the robot moves around a circle, so an
+   * obstacle point can only be hit at the curvatures where it lies within a
+   * disc radius of that circle. Squaring out the distance condition gives a
+   * quadratic in the curvature, so the range of curvature bins an obstacle
+   * affects is found from its roots, and the arc length to first contact in
+   * each of those bins is closed form as well.
+   *
+   * Lengths are exact at the curvature of each bin, in the robot's frame.
+   */
+  class FreeArcTable {
+    public:
+      FreeArcTable();
+
+      /**
+       * @brief Clear the table
+       * @param max_curvature Bins are evenly spaced from -max_curvature to
+       * max_curvature
+       * @param max_length Lengths are capped at this
+       * @param discs The robot, in its own frame
+       * @param margin Added to the disc radii; half a cell diagonal when the
+       * obstacles are cell centers
+       */
+      void reset(double max_curvature, int bins, double max_length,
+          const std::vector<Disc> &discs, double margin);
+
+      /**
+       * @brief Shorten the bins that an obstacle point blocks
+       * @param x, y The point, in the robot's frame
+       */
+      void addObstacle(double x, double y);
+
+      /**
+       * @brief Add the costmap cells at or above a threshold that are in reach
+       * @param x, y, theta The robot, in the costmap frame
+       */
+      void addCostmap(const CostGrid &costmap, double x,
+          double y, double theta, unsigned char threshold);
+
+      /**
+       * @brief Free length at a curvature; the shorter of the two bins either
+       * side of it
+       */
+      double freeLength(double curvature) const;
+
+      int size() const { return lengths_.size(); }
+      double curvature(int bin) const;
+      double length(int bin) const { return lengths_[bin]; }
+
+    private:
+      void addBins(double x, double y, const Disc &disc, double k0,
+          double k1);
+      double contact(double x, double y, const Disc &disc, double k) const;
+
+      double max_curvature_;
+      double max_length_;
+      double step_;
+      // how far any part of the robot reaches from its origin
+      double reach_;
+      std::vector<Disc> discs_;
+      std::vector<double> lengths_;
+  };
+};
+#endif
@@ -0,0 +1,90 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_FRENET_FRAME_H_
+#define ACKERMANN_LOCAL_PLANNER_FRENET_FRAME_H_
+
+#include <vector>
+
+#include <ackermann_local_planner/planner_types.h>
+
+namespace ackermann_local_planner {
+  /**
+   * @class FrenetFrame
+   * @brief Coordinates along the global plan: arc length s, and lateral
+   * offset d to the left of the plan's heading
+   *
+   * The cumulative arc length and the tangent of every plan pose are
+   * computed once per plan, so mapping a point back to the costmap frame is
+   * a binary search and an interpolation.
+   */
+  class FrenetFrame {
+    public:
+      FrenetFrame();
+
+      void setPlan(const std::vector<Pose2D> &plan);
+
+      int size() const { return s_.size(); }
+
+      /**
+       * @brief Arc length from the start of the plan to pose i
+       */
+      double arcLength(int i) const { return s_[i]; }
+
+      /**
+       * @brief The pose at arc length s, moved d to its left; clamped to the
+       * ends of the plan
+       */
+      void toCartesian(double s, double d, double &x, double &y,
+          double &theta) const;
+
+      /**
+       * @brief Project a point onto the plan between two poses
+       */
+      void toFrenet(double x, double y, int first, int last, double &s,
+          double &d) const;
+
+    private:
+      std::vector<double> s_;
+      std::vector<double> x_;
+      std::vector<double> y_;
+      std::vector<double> theta_;
+      // unit tangents, along the plan's headings
+      std::vector<double> cos_;
+      std::vector<double> sin_;
+  };
+};
+#endif
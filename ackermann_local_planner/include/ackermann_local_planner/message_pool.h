@@ -0,0 +1,100 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_MESSAGE_POOL_H_
+#define ACKERMANN_LOCAL_PLANNER_MESSAGE_POOL_H_
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+namespace ackermann_local_planner {
+  /**
+   * @class MessagePool
+   * @brief A small ring of reusable messages for publishing by pointer
+   *
+   * roscpp hands a published shared_ptr directly to subscribers in the same
+   * process without serializing it, but only if the publisher never touches
+   * the message again. A pooled message is reused once nobody else holds a
+   * reference to it, so steady-state publishing doesn't allocate and the
+   * vectors inside the message keep their capacity.
+   *
+   * Messages are filled through the Ptr from get(), and published as a
+   * ConstPtr, so that subscribers can't change a message the pool will hand
+   * out again.
+   */
+  template<class M>
+  class MessagePool {
+    public:
+      typedef boost::shared_ptr<M> Ptr;
+      typedef boost::shared_ptr<const M> ConstPtr;
+
+      /**
+       * @brief Create a pool that keeps up to size messages around
+       */
+      explicit MessagePool(size_t size = 4) : pool_(size), next_(0) {}
+
+      /**
+       * @brief Get a message that no subscriber is holding on to
+       *
+       * The returned message may contain data from a previous publish; the
+       * caller is expected to overwrite all of it. If every pooled message
+       * is still in use, the oldest one is handed over to its subscribers
+       * and replaced with a fresh message.
+       */
+      Ptr get() {
+        for( size_t i=0; i<pool_.size(); i++ ) {
+          Ptr & msg = pool_[next_];
+          next_ = (next_ + 1) % pool_.size();
+          if( ! msg ) {
+            msg.reset(new M());
+            return msg;
+          }
+          if( msg.unique() ) {
+            return msg;
+          }
+        }
+        Ptr & msg = pool_[next_];
+        next_ = (next_ + 1) % pool_.size();
+        msg.reset(new M());
+        return msg;
+      }
+
+    private:
+      std::vector<Ptr> pool_;
+      size_t next_;
+  };
+};
+#endif
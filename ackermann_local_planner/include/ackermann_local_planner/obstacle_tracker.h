@@ -0,0 +1,188 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_OBSTACLE_TRACKER_H_
+#define ACKERMANN_LOCAL_PLANNER_OBSTACLE_TRACKER_H_
+
+#include <vector>
+
+#include <dubins_plus/dubins_plus.h>
+#include <ackermann_local_planner/scan_collision.h>
+
+namespace ackermann_local_planner {
+  /**
+   * @brief A cluster of scan points followed from scan to scan, predicted
+   * to keep moving at a constant velocity
+   */
+  struct MovingObstacle {
+    double x;                   ///< @brief center when last seen
+    double y;
+    double vx;
+    double vy;
+    double radius;
+    double stamp;               ///< @brief when last seen
+    int hits;                   ///< @brief scans it has been seen in
+    int misses;                 ///< @brief scans since it was last seen
+  };
+
+  /**
+   * @brief How fast the robot drives along a candidate: from its current
+   * speed, accelerating up to a maximum
+   */
+  struct SpeedProfile {
+    double initial;
+    double max;
+    double accel;
+
+    SpeedProfile() : initial(0), max(0), accel(0) {}
+    SpeedProfile(double initial, double max, double accel) :
+      initial(initial), max(max), accel(accel) {}
+
+    /**
+     * @brief How long it takes to drive a distance; infinite if the robot
+     * never gets there
+     */
+    double time(double distance) const;
+  };
+
+  /**
+   * @brief Parameters of an ObstacleTracker
+   */
+  struct ObstacleTrackerOptions {
+    /// @brief neighboring scan points further apart than this start a new
+    /// cluster
+    double cluster_distance;
+    /// @brief larger clusters are walls, and left to the costmap
+    double max_cluster_radius;
+    /// @brief furthest a cluster can be from a track's prediction and still
+    /// be matched to it
+    double match_distance;
+    /// @brief weight of the newest measurement in the velocity estimate
+    double velocity_smoothing;
+    /// @brief scans a track has to be seen in before it is checked against
+    int min_hits;
+    /// @brief scans a track can go unseen before it is dropped
+    int max_misses;
+    /// @brief slower tracks are left to the costmap
+    double min_speed;
+    /// @brief how far ahead candidates are checked, in seconds
+    double horizon;
+    /// @brief extra clearance from moving obstacles
+    double margin;
+    /// @brief distance between the poses checked along a candidate
+    double step;
+
+    ObstacleTrackerOptions();
+  };
+
+  /**
+   * @class ObstacleTracker
+   * @brief Moving obstacles from consecutive laser scans, for space-time
+   * collision checks of candidate paths
+   *
+   * Each scan is split into clusters where neighboring points are far
+   * apart, and each cluster is matched to the nearest prediction of a
+   * track. Candidates are timed with a speed profile and checked, pose by
+   * pose, against where each moving track will be at that time. Only the
+   * tracks whose predicted sweep over the horizon overlaps the candidate's
+   * bounding box are looked at, and only out to the horizon, so the cost
+   * per candidate is bounded.
+   */
+  class ObstacleTracker {
+    public:
+      ObstacleTracker();
+
+      void setOptions(const ObstacleTrackerOptions &options) {
+        options_ = options;
+      }
+      const ObstacleTrackerOptions &options() const { return options_; }
+
+      /**
+       * @brief Drop all tracks
+       */
+      void clear();
+
+      /**
+       * @brief Add a scan. Scans no newer than the last one are ignored
+       * @param stamp Time of the scan, in seconds
+       * @param x, y The points in scan order, in the planning frame
+       */
+      void update(double stamp, const std::vector<double> &x,
+          const std::vector<double> &y);
+
+      const std::vector<MovingObstacle> &tracks() const { return tracks_; }
+
+      /**
+       * @brief Whether a track has been seen often enough, and is moving
+       * fast enough, to be checked against
+       */
+      bool isMoving(const MovingObstacle &track) const;
+
+      /**
+       * @brief Check that no disc of the robot comes near a moving obstacle
+       * while it drives a path
+       *
+       * @param path Segments with positive lengths, driven in the direction
+       * of theta
+       * @param x, y, theta Start pose, in the planning frame
+       * @param discs The robot, in the robot frame
+       * @param profile How fast the path is driven
+       * @param now The time the robot starts along the path, in seconds
+       */
+      bool pathClear(const std::vector<dubins_plus::Segment> &path,
+          double x, double y, double theta,
+          const std::vector<Disc> &discs, const SpeedProfile &profile,
+          double now) const;
+
+    private:
+      struct Cluster {
+        double x;
+        double y;
+        double radius;
+      };
+
+      void addCluster(const std::vector<double> &x,
+          const std::vector<double> &y, int begin, int end);
+
+      ObstacleTrackerOptions options_;
+      std::vector<MovingObstacle> tracks_;
+      double last_stamp_;
+
+      // scratch, kept to save allocating each scan
+      std::vector<Cluster> clusters_;
+  };
+};
+#endif
@@ -0,0 +1,175 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_PLAN_CORRIDOR_H_
+#define ACKERMANN_LOCAL_PLANNER_PLAN_CORRIDOR_H_
+
+#include <vector>
+#include <utility>
+
+#include <dubins_plus/dubins_plus.h>
+#include <ackermann_local_planner/planner_types.h>
+#include <ackermann_local_planner/frenet_frame.h>
+
+namespace ackermann_local_planner {
+  /**
+   * @class PlanCorridor
+   * @brief The free space around the global plan: how far the robot's
+   * center can move to the left and right of each plan pose before it
+   * reaches an obstacle
+   *
+   * Each plan pose is a station, with a ray to either side along the
+   * normal of its heading. A ray ends at the first cell it enters whose
+   * cost is at or above the threshold, or at the maximum width. Cells of
+   * unknown cost and cells outside of the costmap are free, as in the rest
+   * of the planner.
+   *
+   * The cells under every ray are indexed once per plan, on a grid aligned
+   * to the world rather than to the costmap, so that an update only looks
+   * up the cells whose cost crossed the threshold, including the cells that
+   * scrolled into or out of a rolling window, and recomputes the stations
+   * whose rays pass through them.
+   */
+  class PlanCorridor {
+    public:
+      PlanCorridor();
+
+      /**
+       * @brief Set the plan, as its arc length parameterization. The next
+       * update() computes every station
+       */
+      void setPlan(const FrenetFrame &frame);
+
+      /**
+       * @brief Set how far the corridor reaches to either side, in meters
+       */
+      void setWidth(double max_width);
+
+      /**
+       * @brief Bring the corridor up to date with the costmap
+       */
+      void update(const CostGrid &costmap);
+
+      /**
+       * @brief The number of stations recomputed by the last update
+       */
+      int lastUpdateSize() const { return updated_stations_; }
+
+      int size() const { return left_.size(); }
+
+      /**
+       * @brief Free distance to the left and right of station i
+       */
+      double left(int i) const { return left_[i]; }
+      double right(int i) const { return right_[i]; }
+
+      /**
+       * @brief Whether a point, at an offset d to the left of station i,
+       * is inside the corridor
+       */
+      bool contains(int i, double d) const {
+        return d <= left_[i] && -d <= right_[i];
+      }
+
+      /**
+       * @brief How far a point at offset d from station i is from the
+       * nearer edge of the corridor; negative outside of it
+       */
+      double clearance(int i, double d) const;
+
+      /**
+       * @brief Check that a path stays inside the corridor, at poses a cell
+       * apart
+       *
+       * Each pose is tested against the interval of the nearest station.
+       * The stations are searched near the one the last pose matched, so a
+       * path is checked in time linear in its length.
+       *
+       * @param path Segments with positive lengths, driven in the direction
+       * of theta
+       * @param x, y, theta Start pose, in the costmap frame
+       * @param station The station nearest the start
+       */
+      bool pathInside(const std::vector<dubins_plus::Segment> &path,
+          double x, double y, double theta, int station) const;
+
+    private:
+      typedef std::pair<int, int> Cell;
+      typedef std::pair<Cell, int> IndexEntry;
+
+      void reset(const CostGrid &costmap);
+      void buildIndex();
+      void computeStation(int i);
+      double castRay(int i, double side) const;
+      void markCell(int wx, int wy);
+      bool blocked(unsigned char cost) const;
+      int nearestStation(double x, double y, int near) const;
+
+      double max_width_;
+      unsigned char threshold_;
+
+      // the stations: plan poses, their unit tangents and free extents
+      std::vector<double> x_;
+      std::vector<double> y_;
+      std::vector<double> cos_;
+      std::vector<double> sin_;
+      std::vector<double> left_;
+      std::vector<double> right_;
+      bool plan_changed_;
+
+      // world-aligned cells are counted from the anchor; cell 0,0 of the
+      // costmap is world-aligned cell offset_x_, offset_y_
+      double resolution_;
+      double anchor_x_;
+      double anchor_y_;
+      int offset_x_;
+      int offset_y_;
+      int size_x_;
+      int size_y_;
+      std::vector<unsigned char> costs_;
+
+      // the stations whose rays cross each world-aligned cell, sorted by
+      // cell
+      std::vector<IndexEntry> index_;
+
+      // scratch space, kept to avoid allocating during updates
+      std::vector<char> dirty_;
+      std::vector<int> dirty_stations_;
+
+      int updated_stations_;
+  };
+};
+#endif
@@ -0,0 +1,77 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_PLAN_VALIDATION_H_
+#define ACKERMANN_LOCAL_PLANNER_PLAN_VALIDATION_H_
+
+#include <vector>
+
+#include <ackermann_local_planner/planner_types.h>
+
+namespace ackermann_local_planner {
+  /**
+   * @brief A stretch of a plan that an Ackermann robot can't follow
+   */
+  struct InfeasibleStretch {
+    enum Reason {
+      CURVATURE, ///< @brief tighter than the minimum turning radius
+      CUSP       ///< @brief direction reversal where the heading jumps
+    };
+    Reason reason;
+    int start; ///< @brief index of the first pose in the stretch
+    int end;   ///< @brief index of the last pose in the stretch
+    double worst; ///< @brief worst curvature (1/m) or heading jump (rad)
+  };
+
+  /**
+   * @brief Check that a plan can be driven by an Ackermann robot
+   *
+   * Curvature is estimated from the heading change between consecutive
+   * poses. Where the plan reverses direction the robot has to stop and back
+   * up, which is only possible if the heading is continuous across the
+   * reversal; a heading that flips instead (a plan for a robot that can turn
+   * in place) is reported as a bad cusp.
+   *
+   * @param plan The plan to check
+   * @param max_curvature The maximum curvature the robot can drive (1/m)
+   * @param cusp_tolerance Maximum heading change across a reversal (rad)
+   * @return The infeasible stretches, in order. Empty if the plan is good
+   */
+  std::vector<InfeasibleStretch> validatePlan(
+      const std::vector<Pose2D> &plan,
+      double max_curvature, double cusp_tolerance);
+};
+#endif
@@ -0,0 +1,599 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_PLANNER_CORE_H_
+#define ACKERMANN_LOCAL_PLANNER_PLANNER_CORE_H_
+
+#include <vector>
+
+#include <dubins_plus/dubins_plus.h>
+#include <mprim_lattice/mprim_lattice.h>
+
+#include <ackermann_local_planner/cost_to_go.h>
+#include <ackermann_local_planner/costmap_pyramid.h>
+#include <ackermann_local_planner/free_arc_table.h>
+#include <ackermann_local_planner/frenet_frame.h>
+#include <ackermann_local_planner/obstacle_tracker.h>
+#include <ackermann_local_planner/plan_corridor.h>
+#include <ackermann_local_planner/plan_validation.h>
+#include <ackermann_local_planner/planner_types.h>
+#include <ackermann_local_planner/scan_collision.h>
+#include <ackermann_local_planner/trace.h>
+#include <ackermann_local_planner/trajectory_library.h>
+
+namespace ackermann_local_planner {
+  /**
+   * @brief How candidates are checked against the costmap; the same values
+   * as collision_mode in AckermannPlanner.cfg
+   */
+  enum CollisionMode {
+    NO_COLLISION_CHECK = 0,
+    CELL_COLLISION_CHECK = 1,
+    PYRAMID_COLLISION_CHECK = 2,
+    TRAVERSAL_COLLISION_CHECK = 3
+  };
+
+  /**
+   * @brief Everything the planner can be configured with
+   */
+  struct PlannerParams {
+    // limits
+    double max_vel;
+    double min_vel;
+    double min_radius;
+    double acc_lim;
+
+    double lookahead_factor;
+
+    double xy_goal_tolerance;
+    double yaw_goal_tolerance;
+
+    /// @brief if false, every command is zero
+    bool move;
+
+    int radius_samples;
+
+    bool reject_infeasible_plans;
+    double plan_curvature_tolerance;
+
+    double cost_to_go_scale;
+
+    int collision_mode;
+
+    /// @brief the costmap's inflation, which traversal collision checks
+    /// rely on; the same as the inflation layer's
+    double inscribed_radius;
+    double inflation_radius;
+    double cost_scaling_factor;
+
+    bool primitive_tracking;
+    double max_lateral_acc;
+    double primitive_lateral_gain;
+    double primitive_heading_gain;
+
+    /// @brief free arc table size; 0 disables it
+    int free_arc_bins;
+    double free_arc_length;
+
+    /// @brief candidates offset from the plan; 0 offset samples disables
+    /// them
+    int frenet_offset_samples;
+    double frenet_max_offset;
+    int frenet_merge_samples;
+    double frenet_min_merge;
+    double frenet_max_merge;
+    double frenet_offset_cost;
+
+    /// @brief how far candidates may stray from the plan before they leave
+    /// its free corridor; 0 disables it
+    double corridor_width;
+
+    bool use_scan_collision;
+    bool track_obstacles;
+
+    PlannerParams();
+  };
+
+  /**
+   * @brief What the planner sees at the start of a cycle
+   */
+  struct PlannerInput {
+    const CostGrid *costmap;
+    double x;                   ///< @brief robot pose, in the costmap frame
+    double y;
+    double theta;
+    double linear_vel;          ///< @brief from odometry
+    double angular_vel;
+    double now;                 ///< @brief seconds, on the clock of the scans
+
+    PlannerInput() : costmap(NULL), x(0), y(0), theta(0), linear_vel(0),
+      angular_vel(0), now(0) {}
+  };
+
+  /**
+   * @brief What one cycle did
+   */
+  struct CycleResult {
+    enum Status {
+      EMPTY_PLAN,               ///< @brief nothing to follow; stopped
+      INFEASIBLE_PLAN,          ///< @brief the plan can't be driven
+      TRACKING,                 ///< @brief following a primitive's tables
+      SAMPLED,                  ///< @brief driving the best candidate
+      NO_PATH,                  ///< @brief no candidate was good enough
+      AT_GOAL                   ///< @brief at the last pose of the plan
+    };
+    Status status;
+
+    /// @brief the command
+    double linear;
+    double angular;
+
+    /// @brief nearest pose on the plan
+    int plan_point;
+    /// @brief the nearest pose moved further than expected since the last
+    /// cycle
+    bool jumped;
+
+    /// @brief the path being driven, from start; start faces backwards
+    /// when reversing
+    Pose2D start;
+    std::vector<dubins_plus::Segment> local_path;
+    /// @brief the lookahead target on the plan
+    Pose2D goal;
+    /// @brief index of the plan pose after the target
+    int target;
+    /// @brief length of the plan from the robot to the target
+    double target_distance;
+    double best_score;
+
+    /// @brief candidates generated, and rejected by each check
+    int candidates;
+    int rejected_free_arc;
+    int rejected_corridor;
+    int rejected_scan;
+    int rejected_costmap;
+    int rejected_moving;
+    int rejected_library;
+
+    /// @brief the primitive step being tracked, and the errors from it
+    const mprim_lattice::Primitive *primitive;
+    int primitive_step;
+    double lateral_error;
+    double heading_error;
+    /// @brief the primitives ahead were blocked, so candidates were sampled
+    /// instead of tracking them
+    bool tracking_blocked;
+
+    /// @brief traversal collision checks were asked for, but the discs
+    /// reach past the inflation, so every cell under them was checked
+    bool traversal_fallback;
+
+    CycleResult();
+  };
+
+  /**
+   * @brief What candidates are checked against this cycle
+   */
+  struct CandidateChecks {
+    double x;                   ///< @brief start, in the planning frame
+    double y;
+    double theta;
+    const std::vector<Disc> *discs;
+    double reach;               ///< @brief of the discs, from the origin
+    bool free_arcs;
+    bool corridor;
+    int station;                ///< @brief plan pose nearest the start
+    bool scan;
+    bool costmap;
+    bool moving;
+    SpeedProfile profile;
+    double now;
+    /// @brief per disc, for traversal checks; NULL to check every cell
+    const std::vector<unsigned char> *thresholds;
+  };
+
+  /**
+   * @brief Everything a cycle has worked out before sampling candidates,
+   * handed to the sampler, scorer and speed policies
+   */
+  struct CycleContext {
+    const CostGrid *costmap;
+    double linear_vel;
+
+    /// @brief where candidates start and end; both face backwards when
+    /// reversing
+    Pose2D start;
+    Pose2D goal;
+    bool forward;
+    /// @brief the target is the end of the plan, so anywhere within the
+    /// goal tolerances will do
+    bool target_is_goal;
+
+    int plan_point;
+    /// @brief index of the plan pose after the target
+    int target;
+    /// @brief length of the plan to the target, and how much it turns
+    double forward_dist;
+    double dtheta;
+
+    CandidateChecks checks;
+
+    /// @brief the best candidate so far, and the counters
+    CycleResult *result;
+  };
+
+  /**
+   * @class PlannerCore
+   * @brief The planner's state and every part of a cycle that doesn't
+   * depend on how candidates are sampled, scored and driven
+   *
+   * Inputs and outputs are plain data (see planner_types.h): the plan, a
+   * view of the costmap, the pose and velocity and the scan points come in,
+   * and a command and a local path go out. The core is its own library,
+   * ackermann_planner_core, which depends on dubins_plus and mprim_lattice
+   * but not on roscpp, tf or costmap_2d, so the same planner runs in
+   * move_base and in offline tools. It is not free of ROS packages:
+   * dubins_plus.h still includes the geometry_msgs/Pose.h message header
+   * for its Pose overloads. See Planner for the cycle itself.
+   */
+  class PlannerCore {
+    public:
+      PlannerCore();
+
+      const PlannerParams &params() const { return params_; }
+
+      /**
+       * @brief Set the parameters, and update the speed limits that depend
+       * on them
+       */
+      void setParams(const PlannerParams &params);
+
+      /**
+       * @brief Cover the footprint with discs, for the collision checks
+       */
+      void setFootprint(const std::vector<Point2D> &footprint);
+
+      /**
+       * @brief Set the plan to follow
+       * @param infeasible Filled with the stretches of the plan that can't
+       * be driven
+       * @return The number of plan steps matched to motion primitives
+       */
+      int setPlan(const std::vector<Pose2D> &plan,
+          std::vector<InfeasibleStretch> &infeasible);
+
+      const std::vector<Pose2D> &plan() const {
+        return plan_;
+      }
+
+      /**
+       * @brief Compute the cost to go on this grid instead of on the local
+       * costmap, until the next plan. The grid is in the plan's frame, and
+       * is copied
+       *
+       * The local costmap is a small rolling window, and can't see the far
+       * side of a wall that the plan goes around; the global costmap can.
+       */
+      void setCostToGoMap(const CostGrid &grid);
+
+      bool goalReached() const { return goal_reached_; }
+      bool planInfeasible() const { return plan_infeasible_; }
+
+      /**
+       * @brief Set the points of the latest laser scan, in the costmap frame
+       * and in scan order
+       */
+      void setScan(double stamp, const std::vector<double> &x,
+          const std::vector<double> &y);
+
+      /**
+       * @brief There is no recent scan; candidates are not checked against
+       * one
+       */
+      void clearScan();
+
+      mprim_lattice::PrimitiveSet &primitives() { return primitives_; }
+      TrajectoryLibrary &trajectoryLibrary() { return trajectory_library_; }
+      const TrajectoryLibrary &trajectoryLibrary() const {
+        return trajectory_library_;
+      }
+      ObstacleTracker &obstacleTracker() { return obstacle_tracker_; }
+      const CostToGoField &costToGo() const { return cost_to_go_; }
+      const FrenetFrame &planFrame() const { return plan_frame_; }
+      const PlanCorridor &corridor() const { return corridor_; }
+      Tracer &tracer() { return tracer_; }
+
+      /**
+       * @brief Run a candidate through the collision checks, cheapest first
+       */
+      bool candidateClear(const std::vector<dubins_plus::Segment> &path,
+          const CandidateChecks &checks, CycleResult &result);
+
+    protected:
+      /**
+       * @brief The start of every cycle: check the plan, bring the costmap
+       * copies up to date and find the robot on the plan
+       * @return false if the cycle is over; see result.status
+       */
+      bool beginCycle(const PlannerInput &input, CycleResult &result);
+
+      /**
+       * @brief Whether the plan step at plan_point is followed by its
+       * primitive's tables
+       */
+      bool tracksPrimitive(int plan_point) const;
+
+      /**
+       * @brief Follow the primitive under the robot: feedforward curvature
+       * and speed from the tables, plus feedback on lateral and heading error
+       *
+       * The primitives ahead go through the same collision checks as the
+       * candidates first.
+       * @return false if they are blocked; the candidates are searched
+       * instead
+       */
+      bool trackPrimitive(const PlannerInput &input, CycleResult &result);
+
+      /**
+       * @brief Pick the lookahead target, and set up the collision checks
+       * for the candidates that reach for it
+       */
+      void beginCandidates(const PlannerInput &input, CycleResult &result,
+          CycleContext &ctx);
+
+      /**
+       * @brief Set up the collision checks for paths from start
+       * @param forward Whether the paths are driven forwards; start faces
+       * backwards if not
+       */
+      void beginChecks(const PlannerInput &input, const Pose2D &start,
+          bool forward, int plan_point, CycleResult &result,
+          CandidateChecks &checks);
+
+      /**
+       * @brief Turn the best candidate into a command
+       * @param speed Speed to drive it at, from the speed policy
+       * @return false if no candidate was good enough
+       */
+      bool endCandidates(const CycleContext &ctx, double speed,
+          CycleResult &result);
+
+      /**
+       * @brief The end of every cycle
+       */
+      void endCycle(CycleResult &result);
+
+      int nearestPoint(int start_point, double x, double y,
+          double theta) const;
+
+      /**
+       * @brief Match the plan to the lattice primitives it was built from,
+       * and fill in the per-step tracking tables
+       * @return The number of steps matched
+       */
+      int matchPrimitives();
+
+      /**
+       * @brief Recompute the speed of each plan step from the primitive
+       * speed tables, so that the robot slows in time for tight turns,
+       * reversals and the goal
+       */
+      void updateSpeedProfile();
+
+      PlannerParams params_;
+
+      std::vector<Pose2D> plan_;
+
+      // cost to reach the goal from each cell, following the global plan;
+      // on the local costmap unless it was given a grid of its own
+      CostToGoField cost_to_go_;
+      bool cost_to_go_map_;
+
+      // the costmap at several resolutions, for collision checks
+      CostmapPyramid costmap_pyramid_;
+
+      // free length along each curvature, to reject candidates early
+      FreeArcTable free_arcs_;
+
+      // inflated cost thresholds of the discs, for traversal checks
+      std::vector<unsigned char> traversal_thresholds_;
+
+      // the plan's arc length parameterization, for offset candidates
+      FrenetFrame plan_frame_;
+
+      // free space either side of the plan, to reject candidates that
+      // wander off it
+      PlanCorridor corridor_;
+
+      // precomputed arcs from the robot, checked by their swept cells
+      TrajectoryLibrary trajectory_library_;
+
+      // the latest laser scan, and the moving obstacles in it
+      ScanObstacles scan_obstacles_;
+      ObstacleTracker obstacle_tracker_;
+      bool have_scan_;
+
+      // the footprint as discs, facing forwards and backwards
+      std::vector<Disc> forward_discs_;
+      std::vector<Disc> reverse_discs_;
+
+      // the lattice primitives the global planner uses, if we have them
+      mprim_lattice::PrimitiveSet primitives_;
+
+      // one entry for each step of the plan, from pose i to pose i+1
+      struct PlanStep {
+        const mprim_lattice::Primitive *primitive; ///< @brief NULL if unmatched
+        int index; ///< @brief step within the primitive
+        double length;
+        double curvature;
+        int direction;
+        double speed;
+      };
+      std::vector<PlanStep> plan_steps_;
+
+      Tracer tracer_;
+
+      // transient data
+      int last_plan_point_;
+
+      bool goal_reached_;
+      bool plan_infeasible_;
+  };
+
+  /**
+   * @class Planner
+   * @brief A planning cycle, built from a sampler, a scorer and a speed
+   * policy
+   *
+   * The policies are template parameters rather than virtual interfaces, so
+   * that every combination compiles into one straight-line cycle, and a
+   * candidate goes from the sampler through the collision checks and the
+   * scorer without an indirect call. See planner_policies.h for the
+   * policies and their interfaces.
+   */
+  template<class Sampler, class Scorer, class Speed>
+  class Planner : public PlannerCore {
+    public:
+      Planner() {}
+      Planner(const Sampler &sampler, const Scorer &scorer,
+          const Speed &speed) : sampler_(sampler), scorer_(scorer),
+        speed_(speed) {}
+
+      Sampler &sampler() { return sampler_; }
+      Scorer &scorer() { return scorer_; }
+      Speed &speed() { return speed_; }
+
+      /**
+       * @brief One planning cycle
+       * @return false if the plan has to be replanned; see result.status
+       */
+      bool cycle(const PlannerInput &input, CycleResult &result) {
+        if( ! beginCycle(input, result) ) {
+          return result.status != CycleResult::INFEASIBLE_PLAN;
+        }
+        bool tracking = false;
+        if( tracksPrimitive(result.plan_point) ) {
+          ScopedSpan primitive_span(tracer_, "track_primitive");
+          tracking = trackPrimitive(input, result);
+        }
+        if( tracking ) {
+          // driving the primitive's tables
+        } else if( result.plan_point < int(plan_.size()) - 1 ) {
+          CycleContext ctx;
+          beginCandidates(input, result, ctx);
+          ScopedSpan candidates_span(tracer_, "candidates");
+          sampler_(*this, ctx);
+          candidates_span.end();
+          if( ! endCandidates(ctx, speed_(params_, ctx), result) ) {
+            return false;
+          }
+        } else {
+          result.status = CycleResult::AT_GOAL;
+          goal_reached_ = true;
+        }
+        endCycle(result);
+        return true;
+      }
+
+      /**
+       * @brief Check a candidate, and keep it if it is the best so far
+       * @param extra_cost Added to its score
+       */
+      void consider(const std::vector<dubins_plus::Segment> &path,
+          double extra_cost, CycleContext &ctx) {
+        CycleResult &result = *ctx.result;
+        result.candidates++;
+        if( ! candidateClear(path, ctx.checks, result) ) {
+          return;
+        }
+        keep(path, extra_cost, ctx);
+      }
+
+      /**
+       * @brief Check a candidate whose swept cells were already checked
+       * against the costmap, and keep it if it is the best so far
+       *
+       * Only the costmap check is skipped; the free arc, corridor, scan and
+       * moving obstacle checks run as for any other candidate.
+       */
+      void considerSwept(const std::vector<dubins_plus::Segment> &path,
+          double extra_cost, CycleContext &ctx) {
+        CycleResult &result = *ctx.result;
+        result.candidates++;
+        CandidateChecks checks = ctx.checks;
+        checks.costmap = false;
+        if( ! candidateClear(path, checks, result) ) {
+          return;
+        }
+        keep(path, extra_cost, ctx);
+      }
+
+    private:
+      void keep(const std::vector<dubins_plus::Segment> &path,
+          double extra_cost, CycleContext &ctx) {
+        ScopedSpan score_span(tracer_, "score");
+        const double score = scorer_(*this, ctx, path) + extra_cost;
+        score_span.end();
+        CycleResult &result = *ctx.result;
+        if( score < result.best_score ) {
+          result.best_score = score;
+          result.local_path = path;
+        }
+      }
+
+      Sampler sampler_;
+      Scorer scorer_;
+      Speed speed_;
+  };
+
+  // Helper functions that don't need class context
+
+  /**
+   * @brief determine if one point is forward or backwards from another
+   */
+  bool isForwards(const Pose2D &start, const Pose2D &end);
+
+  /**
+   * @brief compute the distance between two points
+   */
+  double dist(const Pose2D &start, const Pose2D &end);
+
+  /**
+   * @brief unsigned curvature between two poses, from their heading change
+   */
+  double curvature(const Pose2D &start, const Pose2D &end);
+};
+#endif
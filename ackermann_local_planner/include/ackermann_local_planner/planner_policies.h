@@ -0,0 +1,325 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_PLANNER_POLICIES_H_
+#define ACKERMANN_LOCAL_PLANNER_PLANNER_POLICIES_H_
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include <ackermann_local_planner/planner_core.h>
+
+/*
+ * The policies a Planner is built from. Each is a small copyable class:
+ *
+ *  - A sampler generates candidates for a cycle and hands each to the
+ *    planner:
+ *      template<class P> void operator()(P &planner, CycleContext &ctx);
+ *    calling planner.consider(path, extra_cost, ctx), or
+ *    planner.considerSwept() for candidates it has already checked against
+ *    the costmap itself.
+ *  - A scorer scores a candidate that passed the collision checks; lower is
+ *    better:
+ *      double operator()(const PlannerCore &core, const CycleContext &ctx,
+ *          const std::vector<dubins_plus::Segment> &path);
+ *  - A speed policy picks the speed to drive the best candidate at:
+ *      double operator()(const PlannerParams &params,
+ *          const CycleContext &ctx);
+ */
+
+namespace ackermann_local_planner {
+  /**
+   * @brief Dubins paths to the lookahead target, across the turning radii
+   * from the minimum up
+   */
+  struct RadiusSampler {
+    template<class P>
+    void operator()(P &planner, CycleContext &ctx) const {
+      const PlannerParams &params = planner.params();
+      const double max_curvature = 1 / params.min_radius;
+      for( int i=0; i<params.radius_samples; i++ ) {
+        double curvature = (max_curvature/params.radius_samples) * (i+1);
+        double radius = 1/curvature;
+        ScopedSpan dubins_span(planner.tracer(), "dubins_path");
+        std::vector<dubins_plus::Segment> path;
+        if( ctx.target_is_goal ) {
+          path = dubins_plus::dubins_path_to_region(radius, ctx.start.x,
+              ctx.start.y, ctx.start.theta, ctx.goal.x, ctx.goal.y,
+              ctx.goal.theta, params.xy_goal_tolerance,
+              params.yaw_goal_tolerance);
+        } else {
+          path = dubins_plus::dubins_path(radius, ctx.start.x, ctx.start.y,
+              ctx.start.theta, ctx.goal.x, ctx.goal.y, ctx.goal.theta);
+        }
+        dubins_span.end();
+        planner.consider(path, 0, ctx);
+      }
+    }
+  };
+
+  /**
+   * @brief Candidates shifted sideways from the plan, merging back in at a
+   * few distances ahead of the robot; for passing obstacles on the plan
+   */
+  struct FrenetSampler {
+    template<class P>
+    void operator()(P &planner, CycleContext &ctx) const {
+      const PlannerParams &params = planner.params();
+      const FrenetFrame &frame = planner.planFrame();
+      if( params.frenet_offset_samples <= 0 ||
+          params.frenet_merge_samples <= 0 ||
+          frame.size() != planner.plan().size() ) {
+        return;
+      }
+      ScopedSpan frenet_span(planner.tracer(), "frenet");
+      double s0, d0;
+      frame.toFrenet(ctx.start.x, ctx.start.y,
+          ctx.plan_point - 1, ctx.plan_point + 1, s0, d0);
+      // not past the end of this direction of travel on the plan
+      const double s_end = frame.arcLength(ctx.target - 1);
+
+      // all of the targets first, from the precomputed plan tangents
+      std::vector<double> offsets;
+      std::vector<Pose2D> targets;
+      for( int m=0; m<params.frenet_merge_samples; m++ ) {
+        const double merge = params.frenet_merge_samples > 1 ?
+          params.frenet_min_merge + (params.frenet_max_merge -
+              params.frenet_min_merge) * m /
+          (params.frenet_merge_samples - 1) : params.frenet_max_merge;
+        const double s = std::min(s0 + merge, s_end);
+        if( m > 0 && s0 + merge > s_end ) {
+          break;
+        }
+        for( int k=0; k<params.frenet_offset_samples; k++ ) {
+          const double d = params.frenet_offset_samples > 1 ?
+            params.frenet_max_offset * (2.0 * k /
+                (params.frenet_offset_samples - 1) - 1) : 0;
+          double x, y, theta;
+          frame.toCartesian(s, d, x, y, theta);
+          if( ! ctx.forward ) {
+            theta += M_PI;
+          }
+          targets.push_back(Pose2D(x, y, theta));
+          offsets.push_back(d);
+        }
+      }
+
+      // then check and score them together
+      for( int j=0; j<targets.size(); j++ ) {
+        std::vector<dubins_plus::Segment> path = dubins_plus::dubins_path(
+            params.min_radius, ctx.start.x, ctx.start.y, ctx.start.theta,
+            targets[j].x, targets[j].y, targets[j].theta);
+        planner.consider(path, params.frenet_offset_cost * fabs(offsets[j]),
+            ctx);
+      }
+    }
+  };
+
+  /**
+   * @brief Candidates from the trajectory library, at the speed nearest the
+   * current one; checked against the costmap by looking up the cells they
+   * sweep, instead of by the costmap check
+   */
+  struct LibrarySampler {
+    template<class P>
+    void operator()(P &planner, CycleContext &ctx) const {
+      const TrajectoryLibrary &library = planner.trajectoryLibrary();
+      if( ! library.isOpen() ) {
+        return;
+      }
+      ScopedSpan library_span(planner.tracer(), "trajectory_library");
+      const CostGrid &costmap = *ctx.costmap;
+      int mx, my;
+      costmap.worldToMapNoBounds(ctx.start.x, ctx.start.y, mx, my);
+      const int heading = library.headingIndex(ctx.start.theta);
+      const double linear_vel = fabs(ctx.linear_vel);
+      double speed = -1;
+      for( int j=0; j<library.size(); j++ ) {
+        const LibraryTrajectory &t = library.trajectory(j);
+        if( (t.speed >= 0) == ctx.forward && (speed < 0 ||
+              fabs(fabs(t.speed) - linear_vel) < fabs(speed - linear_vel)) ) {
+          speed = fabs(t.speed);
+        }
+      }
+      for( int j=0; j<library.size(); j++ ) {
+        const LibraryTrajectory &t = library.trajectory(j);
+        if( (t.speed >= 0) != ctx.forward ||
+            fabs(fabs(t.speed) - speed) > 1e-6 ) {
+          continue;
+        }
+        if( library.cost(costmap, mx, my, heading, j,
+              LETHAL_OBSTACLE) < 0 ) {
+          ctx.result->candidates++;
+          ctx.result->rejected_library++;
+          continue;
+        }
+        std::vector<dubins_plus::Segment> path(1,
+            dubins_plus::Segment(t.length, t.curvature));
+        planner.considerSwept(path, 0, ctx);
+      }
+    }
+  };
+
+  /**
+   * @brief Three samplers, one after the other
+   */
+  template<class A, class B, class C>
+  struct SamplerChain {
+    A first;
+    B second;
+    C third;
+
+    template<class P>
+    void operator()(P &planner, CycleContext &ctx) const {
+      first(planner, ctx);
+      second(planner, ctx);
+      third(planner, ctx);
+    }
+  };
+
+  /**
+   * @brief How much longer a candidate is than the plan, and how much
+   * further it leaves the robot from the goal around the obstacles
+   *
+   * Candidates that stop short of the lookahead target, like the library
+   * arcs, are charged for the rest of the way to it, so that they don't
+   * score as well as paths that get there.
+   */
+  struct CostToGoScorer {
+    double operator()(const PlannerCore &core, const CycleContext &ctx,
+        const std::vector<dubins_plus::Segment> &path) const {
+      // possible scoring parameters:
+      //  - curvature. lower is better
+      //  - distance/match to global plan
+      //    - include x/y and angular distance
+      //  - length of path compared to length of global plan
+      double local_length = 0;
+      double end_x = ctx.start.x;
+      double end_y = ctx.start.y;
+      double end_theta = ctx.start.theta;
+      for( int i=0; i<path.size(); i++ ) {
+        local_length += path[i].getLength();
+        dubins_plus::advance(path[i], end_x, end_y, end_theta);
+      }
+      // the rest of the way: at least the straight line to the target, and
+      // the turn left to its heading at the minimum radius. Nothing for
+      // paths that end at the target, or in the goal region
+      const PlannerParams &params = core.params();
+      double rest_xy = hypot(ctx.goal.x - end_x, ctx.goal.y - end_y);
+      double rest_theta = fabs(shortestAngularDistance(end_theta,
+            ctx.goal.theta));
+      if( ctx.target_is_goal ) {
+        rest_xy = std::max(0.0, rest_xy - params.xy_goal_tolerance);
+        rest_theta = std::max(0.0, rest_theta - params.yaw_goal_tolerance);
+      }
+      const double rest = rest_xy + params.min_radius * rest_theta;
+      // normalized to a base of 1.0. Values > 1.0 are worse
+      //  don't count paths shorter than the global path as better
+      double length_cost = std::max((local_length + rest)/ctx.forward_dist,
+          1.0);
+
+      // compare the cost to go at the end of the first real segment (the
+      // one we're about to drive) with the cost to go from here. Going
+      // around an obstacle the plan didn't know about costs more than 1.0
+      double ctg_cost = 1.0;
+      const CostToGoField &cost_to_go = core.costToGo();
+      double ctg_start = cost_to_go.costAt(ctx.start.x, ctx.start.y);
+      int first = 0;
+      for( ; first<path.size() && path[first].getLength() < 0.01; first++ );
+      if( first < path.size() && ctg_start > 0 &&
+          ctg_start < std::numeric_limits<double>::infinity() ) {
+        double x = ctx.start.x;
+        double y = ctx.start.y;
+        double theta = ctx.start.theta;
+        for( int i=0; i<=first; i++ ) {
+          dubins_plus::advance(path[i], x, y, theta);
+        }
+        double ctg_end = cost_to_go.costAt(x, y);
+        if( ctg_end == std::numeric_limits<double>::infinity() ) {
+          // drives into an obstacle, or off the map
+          return std::numeric_limits<double>::max();
+        }
+        ctg_cost = std::max((path[first].getLength() + ctg_end) / ctg_start,
+            1.0);
+      }
+
+      return length_cost + params.cost_to_go_scale * (ctg_cost - 1.0);
+    }
+  };
+
+  /**
+   * @brief Speed up to the maximum within the acceleration limit, and slow
+   * down to the minimum approaching the lookahead target
+   */
+  struct DecelerateToTarget {
+    double operator()(const PlannerParams &params,
+        const CycleContext &ctx) const {
+      // target maximum velocity
+      double target_speed = params.max_vel;
+      // limit to maximum acceleration
+      target_speed = std::min(target_speed, ctx.linear_vel + params.acc_lim);
+      // decelerate to min_vel at end of path (using acc_lim)
+      //  we have forward_dist meters remaining
+      // required_decel = (target_speed - min_vel)
+      // decel_time = required_decel / acc_lim
+      // x = a*t^2 + v0*t + x0
+      // decel_distance = acc_lim * decel_time * decel_time +
+      //                  linear_vel * decel_time + 0
+      double required_decel = target_speed - params.min_vel;
+      double decel_time = required_decel / params.acc_lim;
+      double decel_distance = params.acc_lim * decel_time * decel_time +
+                              target_speed * decel_time +
+                              0;
+      // if we have less than decel_distance to the goal, we should be
+      // decelerating
+      // TODO: this oscillates. makes me sad.
+      if( decel_distance * 1.1 >= ctx.forward_dist ) {
+        target_speed = target_speed - params.acc_lim;
+      }
+      // limit to minimum speed
+      return std::max(target_speed, params.min_vel);
+    }
+  };
+
+  /**
+   * @brief The planner move_base runs: radius, offset and library
+   * candidates, scored against the cost to go
+   */
+  typedef Planner<SamplerChain<RadiusSampler, FrenetSampler, LibrarySampler>,
+          CostToGoScorer, DecelerateToTarget> DefaultPlanner;
+};
+#endif
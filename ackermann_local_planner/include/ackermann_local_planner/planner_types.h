@@ -0,0 +1,145 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_PLANNER_TYPES_H_
+#define ACKERMANN_LOCAL_PLANNER_PLANNER_TYPES_H_
+
+#include <cmath>
+#include <cstddef>
+
+namespace ackermann_local_planner {
+  /**
+   * Plain geometry and grid types for the planning core. The core takes and
+   * returns only these, so that it builds without ROS; AckermannPlannerROS
+   * converts to and from messages and costmaps.
+   */
+
+  // cell costs, with the same values as in costmap_2d/cost_values.h
+  static const unsigned char NO_INFORMATION = 255;
+  static const unsigned char LETHAL_OBSTACLE = 254;
+  static const unsigned char INSCRIBED_INFLATED_OBSTACLE = 253;
+  static const unsigned char FREE_SPACE = 0;
+
+  /**
+   * @brief A point in the plane
+   */
+  struct Point2D {
+    double x;
+    double y;
+
+    Point2D() : x(0), y(0) {}
+    Point2D(double x, double y) : x(x), y(y) {}
+  };
+
+  /**
+   * @brief A position and heading in the plane
+   */
+  struct Pose2D {
+    double x;
+    double y;
+    double theta;
+
+    Pose2D() : x(0), y(0), theta(0) {}
+    Pose2D(double x, double y, double theta) : x(x), y(y), theta(theta) {}
+  };
+
+  /**
+   * @brief Normalize an angle to [-pi, pi]
+   */
+  inline double normalizeAngle(double angle) {
+    const double a = fmod(fmod(angle, 2.0*M_PI) + 2.0*M_PI, 2.0*M_PI);
+    return a > M_PI ? a - 2.0*M_PI : a;
+  }
+
+  /**
+   * @brief The shortest signed angle that turns from one heading to another
+   */
+  inline double shortestAngularDistance(double from, double to) {
+    return normalizeAngle(to - from);
+  }
+
+  /**
+   * @class CostGrid
+   * @brief A view of a row-major grid of cell costs
+   *
+   * Doesn't own the cells; whoever builds it keeps them alive for as long as
+   * the view is used. The accessors are named as on costmap_2d::Costmap2D,
+   * which is what the ROS adapter builds these from.
+   */
+  class CostGrid {
+    public:
+      CostGrid() : size_x_(0), size_y_(0), resolution_(1.0),
+        origin_x_(0), origin_y_(0), cells_(NULL) {}
+
+      /**
+       * @param origin_x, origin_y The world position of the corner of cell
+       * (0, 0)
+       */
+      CostGrid(unsigned int size_x, unsigned int size_y, double resolution,
+          double origin_x, double origin_y, const unsigned char *cells) :
+        size_x_(size_x), size_y_(size_y), resolution_(resolution),
+        origin_x_(origin_x), origin_y_(origin_y), cells_(cells) {}
+
+      unsigned int getSizeInCellsX() const { return size_x_; }
+      unsigned int getSizeInCellsY() const { return size_y_; }
+      double getResolution() const { return resolution_; }
+      double getOriginX() const { return origin_x_; }
+      double getOriginY() const { return origin_y_; }
+      const unsigned char *getCharMap() const { return cells_; }
+
+      unsigned char getCost(unsigned int mx, unsigned int my) const {
+        return cells_[my * size_x_ + mx];
+      }
+
+      /**
+       * @brief The cell under a world point, which may be off the grid
+       */
+      void worldToMapNoBounds(double wx, double wy, int &mx, int &my) const {
+        mx = (int)((wx - origin_x_) / resolution_);
+        my = (int)((wy - origin_y_) / resolution_);
+      }
+
+    private:
+      unsigned int size_x_;
+      unsigned int size_y_;
+      double resolution_;
+      double origin_x_;
+      double origin_y_;
+      const unsigned char *cells_;
+  };
+};
+
+#endif
@@ -0,0 +1,104 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_RECORDER_H_
+#define ACKERMANN_LOCAL_PLANNER_RECORDER_H_
+
+#include <string>
+#include <vector>
+
+#include <geometry_msgs/PoseStamped.h>
+#include <geometry_msgs/Twist.h>
+#include <costmap_2d/costmap_2d.h>
+
+#include <ackermann_local_planner/recording.h>
+
+namespace ackermann_local_planner {
+  /**
+   * @class InputRecorder
+   * @brief Records what the planner sees into a memory-mapped ring file
+   *
+   * Records are copied straight into the mapping, so recording costs little
+   * more than a memcpy, and the file survives the process crashing. When
+   * the ring fills up the oldest records are overwritten.
+   */
+  class InputRecorder {
+    public:
+      InputRecorder();
+      ~InputRecorder();
+
+      /**
+       * @brief Start recording to a file, replacing it
+       * @param capacity Size of the ring, in bytes
+       * @return False if the file couldn't be created and mapped
+       */
+      bool open(const std::string &filename, size_t capacity);
+
+      void close();
+
+      bool enabled() const { return header_ != NULL; }
+
+      void recordCycleBegin(double stamp);
+      void recordCycleEnd(double stamp, const geometry_msgs::Twist &cmd_vel,
+          bool result);
+
+      /**
+       * @brief Record a plan, unless it is the same as the last one
+       */
+      void recordPlan(double stamp,
+          const std::vector<geometry_msgs::PoseStamped> &plan);
+
+      void recordPose(double stamp, double x, double y, double theta);
+      void recordOdom(double stamp, double linear, double angular);
+      void recordCostmap(double stamp, const costmap_2d::Costmap2D &costmap);
+
+    private:
+      char *reserve(RecordType type, double stamp, size_t size);
+      void commit();
+      void evict();
+
+      int fd_;
+      size_t mapped_size_;
+      RecordFileHeader *header_;
+      char *ring_;
+      // size of the reserved record, with its header and padding
+      size_t reserved_;
+
+      std::vector<RecordedPose> last_plan_;
+  };
+
+};
+#endif
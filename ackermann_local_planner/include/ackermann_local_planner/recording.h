@@ -0,0 +1,156 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_RECORDING_H_
+#define ACKERMANN_LOCAL_PLANNER_RECORDING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace ackermann_local_planner {
+  /**
+   * @brief Record types in a recording
+   */
+  enum RecordType {
+    RECORD_WRAP = 0,        ///< @brief the rest of the ring is unused
+    RECORD_CYCLE_BEGIN = 1, ///< @brief RecordedCycle
+    RECORD_CYCLE_END = 2,   ///< @brief RecordedCycle
+    RECORD_PLAN = 3,        ///< @brief uint32_t count, then RecordedPose
+    RECORD_POSE = 4,        ///< @brief RecordedPose
+    RECORD_ODOM = 5,        ///< @brief RecordedOdom
+    RECORD_COSTMAP = 6      ///< @brief RecordedCostmap, then the cells
+  };
+
+  /**
+   * @brief Start of a recording file. The ring of records follows it
+   */
+  struct RecordFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t capacity;  ///< @brief size of the ring, in bytes
+    uint64_t head;      ///< @brief where the next record goes
+    uint64_t tail;      ///< @brief the oldest record
+    uint64_t count;     ///< @brief records in the ring
+    uint64_t dropped;   ///< @brief records too big to record
+  };
+
+  /**
+   * @brief Start of each record. Records are padded to 8 bytes
+   */
+  struct RecordHeader {
+    uint32_t type;
+    uint32_t size;      ///< @brief payload size, without padding
+    double stamp;       ///< @brief ROS time, in seconds
+  };
+
+  struct RecordedPose {
+    double x;
+    double y;
+    double theta;
+  };
+
+  struct RecordedOdom {
+    double linear;
+    double angular;
+  };
+
+  struct RecordedCycle {
+    uint64_t monotonic_ns;  ///< @brief for measuring cycle times
+    double linear;          ///< @brief the command; 0 at the start of a cycle
+    double angular;
+    int32_t result;         ///< @brief what computeVelocityCommands returned
+    int32_t pad;
+  };
+
+  struct RecordedCostmap {
+    uint32_t size_x;
+    uint32_t size_y;
+    double resolution;
+    double origin_x;
+    double origin_y;
+  };
+
+  extern const char RECORD_MAGIC[8];
+  extern const uint32_t RECORD_VERSION;
+
+  /**
+   * @brief Space a record takes in the ring: its header and payload, padded
+   * to 8 bytes
+   */
+  inline size_t recordSize(size_t payload) {
+    return (sizeof(RecordHeader) + payload + 7) & ~size_t(7);
+  }
+
+  /**
+   * @class RecordingReader
+   * @brief Reads the records in a recording, oldest first
+   */
+  class RecordingReader {
+    public:
+      RecordingReader();
+      ~RecordingReader();
+
+      bool open(const std::string &filename);
+      void close();
+
+      const std::string &error() const { return error_; }
+
+      /**
+       * @brief The number of records in the recording
+       */
+      uint64_t size() const { return header_ ? header_->count : 0; }
+
+      /**
+       * @brief Get the next record
+       * @param payload Set to the record's payload, which stays valid until
+       * the reader is closed
+       * @return False at the end of the recording
+       */
+      bool next(RecordHeader &header, const char *&payload);
+
+    private:
+      int fd_;
+      size_t mapped_size_;
+      const RecordFileHeader *header_;
+      const char *ring_;
+      uint64_t position_;
+      uint64_t read_;
+      std::string error_;
+  };
+};
+#endif
@@ -0,0 +1,99 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_ROS_CONVERSIONS_H_
+#define ACKERMANN_LOCAL_PLANNER_ROS_CONVERSIONS_H_
+
+#include <vector>
+
+#include <geometry_msgs/Point.h>
+#include <geometry_msgs/Pose.h>
+#include <geometry_msgs/PoseStamped.h>
+#include <costmap_2d/costmap_2d.h>
+#include <tf/transform_datatypes.h>
+
+#include <ackermann_local_planner/planner_types.h>
+
+namespace ackermann_local_planner {
+  /*
+   * Conversions between the planning core's plain types and ROS messages
+   * and costmaps; only the plugins use these.
+   */
+
+  inline Pose2D toPose2D(const geometry_msgs::Pose &pose) {
+    return Pose2D(pose.position.x, pose.position.y,
+        tf::getYaw(pose.orientation));
+  }
+
+  inline std::vector<Pose2D> toPose2D(
+      const std::vector<geometry_msgs::PoseStamped> &poses) {
+    std::vector<Pose2D> result(poses.size());
+    for( int i=0; i<poses.size(); i++ ) {
+      result[i] = toPose2D(poses[i].pose);
+    }
+    return result;
+  }
+
+  inline geometry_msgs::Pose toPose(const Pose2D &pose) {
+    geometry_msgs::Pose result;
+    result.position.x = pose.x;
+    result.position.y = pose.y;
+    result.position.z = 0;
+    result.orientation = tf::createQuaternionMsgFromYaw(pose.theta);
+    return result;
+  }
+
+  inline std::vector<Point2D> toPoint2D(
+      const std::vector<geometry_msgs::Point> &points) {
+    std::vector<Point2D> result(points.size());
+    for( int i=0; i<points.size(); i++ ) {
+      result[i] = Point2D(points[i].x, points[i].y);
+    }
+    return result;
+  }
+
+  /**
+   * @brief A view of the costmap's cells; only valid while the costmap
+   * isn't resized
+   */
+  inline CostGrid toCostGrid(const costmap_2d::Costmap2D &costmap) {
+    return CostGrid(costmap.getSizeInCellsX(), costmap.getSizeInCellsY(),
+        costmap.getResolution(), costmap.getOriginX(), costmap.getOriginY(),
+        costmap.getCharMap());
+  }
+};
+
+#endif
@@ -0,0 +1,129 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_SCAN_COLLISION_H_
+#define ACKERMANN_LOCAL_PLANNER_SCAN_COLLISION_H_
+
+#include <vector>
+
+#include <dubins_plus/dubins_plus.h>
+#include <ackermann_local_planner/planner_types.h>
+
+namespace ackermann_local_planner {
+  /**
+   * @brief A disc covering part of the robot, in the robot's frame
+   */
+  struct Disc {
+    double x;
+    double y;
+    double radius;
+  };
+
+  /**
+   * @brief Cover a footprint with a row of discs along the robot's x axis
+   *
+   * The discs cover the bounding box of the footprint; about as many discs
+   * as the footprint is long for its width.
+   */
+  std::vector<Disc> coverFootprint(
+      const std::vector<Point2D> &footprint);
+
+  /**
+   * @class ScanObstacles
+   * @brief Obstacle points from a laser scan, indexed for collision checking
+   * of candidate paths
+   *
+   * The points are bucketed into a coarse grid that is rebuilt every cycle.
+   * Each segment of a path is checked against only the buckets under its
+   * swept bounding box, and each point is checked exactly: the disc
+   * centers move along lines and circular arcs, so the distance from a point
+   * to the path of a disc is closed form.
+   */
+  class ScanObstacles {
+    public:
+      ScanObstacles();
+
+      /**
+       * @brief Remove all points
+       */
+      void clear();
+
+      /**
+       * @brief Add a point, in the planning frame
+       */
+      void addPoint(double x, double y);
+
+      /**
+       * @brief Build the index over the points added since clear()
+       * @param cell_size Bucket size, in meters
+       */
+      void buildIndex(double cell_size);
+
+      int size() const { return x_.size(); }
+
+      /**
+       * @brief Check that the robot can drive a path without any disc
+       * touching a point
+       *
+       * @param path Segments with positive lengths, driven in the direction
+       * of theta
+       * @param x, y, theta Start pose, in the planning frame
+       * @param discs The robot, in the robot frame
+       */
+      bool pathClear(const std::vector<dubins_plus::Segment> &path,
+          double x, double y, double theta,
+          const std::vector<Disc> &discs) const;
+
+    private:
+      bool segmentClear(const dubins_plus::Segment &segment,
+          double x, double y, double theta, const Disc &disc) const;
+
+      std::vector<double> x_;
+      std::vector<double> y_;
+
+      // the index: the points in bucket i are sorted_[start_[i]] up to
+      // sorted_[start_[i+1]]
+      double cell_size_;
+      double min_x_;
+      double min_y_;
+      int size_x_;
+      int size_y_;
+      std::vector<int> start_;
+      std::vector<int> sorted_;
+      std::vector<int> cell_;
+  };
+};
+#endif
@@ -0,0 +1,211 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_TRACE_H_
+#define ACKERMANN_LOCAL_PLANNER_TRACE_H_
+
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
+
+namespace ackermann_local_planner {
+  /**
+   * @brief One timed span, as recorded by the Tracer
+   */
+  struct TraceSpan {
+    const char* name; ///< @brief must point to a string literal
+    uint64_t start_ns;
+    uint64_t end_ns;
+  };
+
+  /**
+   * @class Tracer
+   * @brief Records timed spans and writes them out as a timeline
+   *
+   * Spans are recorded into a preallocated buffer owned by the recording
+   * thread, so recording never allocates, and only takes the buffer's own
+   * lock, which nothing else wants unless the buffer is being handed off.
+   * Each thread periodically hands its buffer to a writer thread by swapping
+   * it with a second, empty one, and the writer writes the spans to a file
+   * in the Chrome Trace Event format, which can be opened in
+   * chrome://tracing or ui.perfetto.dev. A flush never touches the file, so
+   * it doesn't stall the thread that calls it.
+   *
+   * Spans may be recorded and flushed from any thread, even while another
+   * thread closes the tracer; spans recorded after close() starts are lost.
+   *
+   * The tracer doesn't log; failures are returned to the caller.
+   */
+  class Tracer {
+    public:
+      Tracer();
+      ~Tracer();
+
+      /**
+       * @brief Start tracing to a file, and start the writer thread
+       * @param filename The file to write the trace to
+       * @param capacity The number of spans to buffer per thread
+       * @param flush_period Flush a thread's buffer at least this often (s)
+       * @return True if the file could be opened; if not, see error()
+       */
+      bool open(const std::string &filename, size_t capacity,
+          double flush_period);
+
+      /**
+       * @brief Stop the writer thread, write out the spans of every thread
+       * and close the trace file
+       * @return The number of spans dropped since they were last flushed
+       */
+      size_t close();
+
+      bool enabled() const { return enabled_.load(); }
+
+      const std::string &error() const { return error_; }
+
+      /**
+       * @brief Record a span on the calling thread
+       *
+       * If the thread's buffer is full the span is dropped and counted.
+       */
+      void record(const char* name, uint64_t start_ns, uint64_t end_ns);
+
+      /**
+       * @brief Flush the calling thread's buffer if it is getting full or if
+       * the flush period has passed. Call this between planning cycles.
+       * @return The number of spans dropped because the buffer was full
+       */
+      size_t maybeFlush();
+
+      /**
+       * @brief Hand all spans buffered by the calling thread to the writer.
+       * If the writer hasn't finished with the last ones yet, they stay in
+       * the buffer until the next flush
+       * @return The number of spans dropped because the buffer was full
+       */
+      size_t flush();
+
+      /**
+       * @brief Monotonic timestamp in nanoseconds
+       */
+      static uint64_t now();
+
+    private:
+      struct ThreadBuffer {
+        boost::mutex mutex;
+        std::vector<TraceSpan> spans;
+        size_t count;
+        size_t dropped;
+        // spans handed to the writer, which owns them while pending is set
+        std::vector<TraceSpan> written;
+        size_t written_count;
+        bool pending;
+        int tid;
+        uint64_t last_flush_ns;
+      };
+
+      ThreadBuffer* buffer();
+      size_t flush(ThreadBuffer &buf);
+      void writer();
+      void writeSpans(const std::vector<TraceSpan> &spans, size_t count,
+          int tid);
+      void writePending();
+
+      // buffers belong to the tracer rather than to their threads, so that
+      // close() can reach them all
+      static void keepBuffer(ThreadBuffer *) {}
+
+      boost::atomic<bool> enabled_;
+      // the file is only written by the writer thread, and by close() once
+      // the writer has stopped
+      FILE* file_;
+      boost::mutex file_mutex_;
+      bool first_event_;
+      std::string error_;
+
+      size_t capacity_;
+      uint64_t flush_period_ns_;
+      uint64_t epoch_ns_;
+
+      boost::thread_specific_ptr<ThreadBuffer> buffers_;
+      // every thread's buffer; guarded by file_mutex_
+      std::vector<ThreadBuffer*> all_buffers_;
+      int next_tid_;
+
+      // wakes the writer when a buffer is handed off, or to stop
+      boost::thread writer_;
+      boost::mutex work_mutex_;
+      boost::condition_variable work_cv_;
+      bool work_;
+      bool stop_;
+  };
+
+  /**
+   * @class ScopedSpan
+   * @brief Records a span from construction until end() or destruction
+   */
+  class ScopedSpan {
+    public:
+      ScopedSpan(Tracer &tracer, const char* name) : tracer_(tracer),
+        name_(name), start_ns_(tracer.enabled() ? Tracer::now() : 0) {}
+
+      ~ScopedSpan() {
+        end();
+      }
+
+      /**
+       * @brief End the span early
+       */
+      void end() {
+        if( start_ns_ != 0 ) {
+          tracer_.record(name_, start_ns_, Tracer::now());
+          start_ns_ = 0;
+        }
+      }
+
+    private:
+      Tracer & tracer_;
+      const char* name_;
+      uint64_t start_ns_;
+  };
+};
+#endif
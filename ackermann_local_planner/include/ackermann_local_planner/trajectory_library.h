@@ -0,0 +1,195 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+#ifndef ACKERMANN_LOCAL_PLANNER_TRAJECTORY_LIBRARY_H_
+#define ACKERMANN_LOCAL_PLANNER_TRAJECTORY_LIBRARY_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <ackermann_local_planner/planner_types.h>
+#include <ackermann_local_planner/scan_collision.h>
+
+namespace ackermann_local_planner {
+  /**
+   * @brief Start of a trajectory library file
+   *
+   * The header is followed by the trajectories, then one SweptMask for each
+   * start heading and trajectory, heading-major, then the cell offsets of
+   * all of the masks.
+   */
+  struct TrajectoryLibraryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    double resolution;          ///< @brief costmap resolution it was built for
+    uint32_t num_headings;      ///< @brief start headings, evenly spaced
+    uint32_t num_trajectories;
+    uint64_t num_offsets;
+    uint64_t trajectories_offset;
+    uint64_t masks_offset;
+    uint64_t offsets_offset;
+  };
+
+  /**
+   * @brief One candidate; an arc from the robot, in its direction of travel
+   *
+   * Negative speeds are driven in reverse. As in the planner, reverse
+   * trajectories are relative to the robot turned around, and are swept
+   * with its footprint turned around.
+   */
+  struct LibraryTrajectory {
+    float speed;
+    float curvature;
+    float length;
+    uint32_t pad;
+  };
+
+  /**
+   * @brief The cells a trajectory sweeps from one start heading, and their
+   * bounding box
+   */
+  struct SweptMask {
+    uint32_t first;             ///< @brief index of the first offset
+    uint32_t count;
+    int16_t min_dx;
+    int16_t max_dx;
+    int16_t min_dy;
+    int16_t max_dy;
+  };
+
+  /**
+   * @brief A cell, relative to the cell the robot is in
+   */
+  struct CellOffset {
+    int16_t dx;
+    int16_t dy;
+  };
+
+  /**
+   * @brief What to build a trajectory library for
+   */
+  struct TrajectoryLibraryOptions {
+    double resolution;          ///< @brief of the costmap
+    int num_headings;
+    /// @brief the robot, in its own frame
+    std::vector<Point2D> footprint;
+    double min_radius;
+    double max_lateral_acc;     ///< @brief limits the curvature at speed
+    std::vector<double> speeds; ///< @brief negative for reverse
+    /// @brief each trajectory is driven for each of these times, at its speed
+    std::vector<double> times;
+    int curvature_samples;      ///< @brief across the curvature limits
+
+    TrajectoryLibraryOptions();
+  };
+
+  /**
+   * @brief Sweep every trajectory from every start heading, and write the
+   * library to a file
+   *
+   * A cell is in a swept mask if the center of any disc covering the
+   * footprint comes within its radius of the cell center, plus a margin
+   * because the robot can be anywhere in its cell. Each mask is swept across
+   * the width of its heading bin, for the same reason, so the masks are
+   * conservative.
+   *
+   * @return false if the file couldn't be written
+   */
+  bool buildTrajectoryLibrary(const TrajectoryLibraryOptions &options,
+      const std::string &filename);
+
+  /**
+   * @class TrajectoryLibrary
+   * @brief Egocentric candidate trajectories with precomputed swept masks
+   *
+   * The library is mapped from its file in one go, and used in place.
+   * Evaluating a candidate is one costmap lookup per swept cell, with no
+   * geometry at run time.
+   */
+  class TrajectoryLibrary {
+    public:
+      TrajectoryLibrary();
+      ~TrajectoryLibrary();
+
+      bool open(const std::string &filename);
+      void close();
+
+      bool isOpen() const { return header_ != NULL; }
+      const std::string &error() const { return error_; }
+
+      double resolution() const { return header_->resolution; }
+      int numHeadings() const { return header_->num_headings; }
+      int size() const { return header_->num_trajectories; }
+
+      const LibraryTrajectory &trajectory(int i) const {
+        return trajectories_[i];
+      }
+
+      const SweptMask &mask(int heading, int i) const {
+        return masks_[heading * header_->num_trajectories + i];
+      }
+
+      /**
+       * @brief The start heading nearest to an angle
+       */
+      int headingIndex(double theta) const;
+
+      /**
+       * @brief Sum the costs of the cells that a trajectory sweeps
+       *
+       * Cells off of the costmap and of unknown cost count as free.
+       *
+       * @param mx, my The cell the robot is in
+       * @param heading Start heading index; for reverse trajectories, of the
+       * robot turned around
+       * @return The sum, or -1 if any cell is at or above the threshold
+       */
+      double cost(const CostGrid &costmap, int mx, int my,
+          int heading, int i, unsigned char threshold) const;
+
+    private:
+      int fd_;
+      size_t mapped_size_;
+      const TrajectoryLibraryHeader *header_;
+      const LibraryTrajectory *trajectories_;
+      const SweptMask *masks_;
+      const CellOffset *offsets_;
+      std::string error_;
+  };
+};
+#endif
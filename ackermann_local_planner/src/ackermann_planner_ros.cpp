@@ -36,82 +36,81 @@
 *********************************************************************/
 
 #include <ackermann_local_planner/ackermann_planner_ros.h>
+#include <ackermann_local_planner/ros_conversions.h>
 #include <cmath>
-#include <limits>
-#include <boost/foreach.hpp>
 
 #include <ros/console.h>
 
 #include <pluginlib/class_list_macros.h>
 
-#include <base_local_planner/goal_functions.h>
 #include <nav_msgs/Path.h>
-#include <angles/angles.h>
 
 //register this planner as a BaseLocalPlanner plugin
 PLUGINLIB_EXPORT_CLASS(ackermann_local_planner::AckermannPlannerROS, nav_core::BaseLocalPlanner)
 
 namespace ackermann_local_planner {
 
-  bool isForwards(const geometry_msgs::PoseStamped &start,
-      const geometry_msgs::PoseStamped &end) {
-    double yaw1 = tf::getYaw(start.pose.orientation);
-    //double yaw2 = tf::getYaw(end.pose.orientation);
-    //double angle = angles::shortest_angular_distance(yaw1, yaw2);
-
-    double dx = (end.pose.position.x - start.pose.position.x);
-    double dy = (end.pose.position.y - start.pose.position.y);
-    double diff_angle = atan2(dy, dx);
-
-    if( abs(angles::shortest_angular_distance(yaw1, diff_angle)) < M_PI/2 ) {
-      return true;
-    } else {
-      return false;
+  // scans older than this aren't used for collision checking (s)
+  static const double MAX_SCAN_AGE = 0.5;
+
+  // the cost of a cell of a published costmap; the inverse of the
+  // translation in costmap_2d::Costmap2DPublisher
+  static unsigned char occupancyCost(int8_t value) {
+    if( value < 0 ) {
+      return NO_INFORMATION;
+    } else if( value >= 100 ) {
+      return LETHAL_OBSTACLE;
+    } else if( value == 99 ) {
+      return INSCRIBED_INFLATED_OBSTACLE;
+    } else if( value == 0 ) {
+      return FREE_SPACE;
     }
+    return 1 + (value - 1) * 251 / 97;
   }
 
-  inline double sq(double x) {
-    return x*x;
-  }
-
-  double dist(const geometry_msgs::PoseStamped &start,
-      const geometry_msgs::PoseStamped &end) {
-    return hypot((end.pose.position.x - start.pose.position.x),
-                 (end.pose.position.y - start.pose.position.y));
-  }
-
-  double curvature(const geometry_msgs::PoseStamped & start,
-                   const geometry_msgs::PoseStamped & end ) {
-    double dx = (end.pose.position.x - start.pose.position.x);
-    double dy = (end.pose.position.y - start.pose.position.y);
-    double yaw1 = tf::getYaw(start.pose.orientation);
-    double yaw2 = tf::getYaw(end.pose.orientation);
-    double dtheta = fabs(angles::shortest_angular_distance(yaw1, yaw2));
-    double ds = hypot(dx, dy);
-    return dtheta / ds;
+  // tf frame ids, with or without the leading slash
+  static bool sameFrame(const std::string &a, const std::string &b) {
+    const size_t i = a.compare(0, 1, "/") == 0 ? 1 : 0;
+    const size_t j = b.compare(0, 1, "/") == 0 ? 1 : 0;
+    return a.compare(i, std::string::npos, b, j, std::string::npos) == 0;
   }
 
   void AckermannPlannerROS::reconfigureCB(AckermannPlannerConfig &config, uint32_t level) {
-      max_vel_ = config.max_vel;
-      min_vel_ = config.min_vel;
-      min_radius_ = config.min_radius;
-      acc_lim_ = config.acc_lim;
+      PlannerParams params = planner_.params();
+      params.max_vel = config.max_vel;
+      params.min_vel = config.min_vel;
+      params.min_radius = config.min_radius;
+      params.acc_lim = config.acc_lim;
 
-      lookahead_factor_ = config.lookahead_factor;
+      params.lookahead_factor = config.lookahead_factor;
 
       // TODO(hendrix): these may be obsolete
       //vx_samples = config.vx_samples;
-      radius_samples_ = config.radius_samples;
+      params.radius_samples = config.radius_samples;
+
+      params.xy_goal_tolerance = config.xy_goal_tolerance;
+      params.yaw_goal_tolerance = config.yaw_goal_tolerance;
 
-      xy_goal_tolerance_ = config.xy_goal_tolerance;
-      yaw_goal_tolerance_ = config.yaw_goal_tolerance;
+      params.move = config.move;
 
-      move_ = config.move;
+      params.reject_infeasible_plans = config.reject_infeasible_plans;
+      params.plan_curvature_tolerance = config.plan_curvature_tolerance;
+
+      params.cost_to_go_scale = config.cost_to_go_scale;
+
+      params.collision_mode = config.collision_mode;
+
+      params.primitive_tracking = config.primitive_tracking;
+      params.max_lateral_acc = config.max_lateral_acc;
+      params.primitive_lateral_gain = config.primitive_lateral_gain;
+      params.primitive_heading_gain = config.primitive_heading_gain;
+
+      planner_.setParams(params);
   }
 
   AckermannPlannerROS::AckermannPlannerROS() : initialized_(false),
     have_particlecloud_(false), have_pose_with_cow_(false),
-    goal_reached_(false) {
+    global_costmap_changed_(false), cost_to_go_margin_(2.0) {
 
   }
 
@@ -127,9 +126,6 @@ namespace ackermann_local_planner {
       tf_ = tf;
       costmap_ros_ = costmap_ros;
 
-      // make sure to update the costmap we'll use for this cycle
-      costmap_2d::Costmap2D* costmap = costmap_ros_->getCostmap();
-
       std::string odom_topic;
       private_nh.param<std::string>("odom_topic", odom_topic, "odom");
       odom_helper_.setOdomTopic( odom_topic );
@@ -139,6 +135,184 @@ namespace ackermann_local_planner {
       private_nh.param<bool>("publish_near_point", publish_near_point_, false);
       near_point_pub_ = private_nh.advertise<geometry_msgs::PoseStamped>(
           "near_point", 1);
+
+      // timeline tracing of planning cycles; off unless given a file
+      std::string trace_file;
+      private_nh.param<std::string>("trace_file", trace_file, "");
+      if( ! trace_file.empty() ) {
+        int trace_buffer_size;
+        double trace_flush_period;
+        private_nh.param<int>("trace_buffer_size", trace_buffer_size, 65536);
+        private_nh.param<double>("trace_flush_period", trace_flush_period,
+            1.0);
+        if( planner_.tracer().open(trace_file, trace_buffer_size,
+              trace_flush_period) ) {
+          ROS_INFO_NAMED("ackermann_planner", "Tracing planner cycles to %s",
+              trace_file.c_str());
+        } else {
+          ROS_ERROR_NAMED("ackermann_planner", "Not tracing: %s",
+              planner_.tracer().error().c_str());
+        }
+      }
+
+      // recording of the planner's inputs; off unless given a file
+      std::string record_file;
+      private_nh.param<std::string>("record_file", record_file, "");
+      if( ! record_file.empty() ) {
+        int record_size;
+        private_nh.param<int>("record_size", record_size, 64);
+        if( ! recorder_.open(record_file, size_t(record_size) << 20) ) {
+          ROS_ERROR_NAMED("ackermann_planner", "Failed to open %s for "
+              "recording", record_file.c_str());
+        }
+      }
+
+      // the robot as discs, for collision checks of candidates
+      planner_.setFootprint(toPoint2D(costmap_ros_->getRobotFootprint()));
+
+      PlannerParams params = planner_.params();
+
+      // candidates whose first segment runs further than the free arc length
+      // at its curvature are rejected before the full check; 0 bins disables
+      private_nh.param<int>("free_arc_bins", params.free_arc_bins, 61);
+      private_nh.param<double>("free_arc_length", params.free_arc_length,
+          3.0);
+
+      // traversal collision checks compare the cells under the disc centers
+      // against the costmap's inflation, so they need its parameters
+      params.inscribed_radius =
+        costmap_ros_->getLayeredCostmap()->getInscribedRadius();
+      private_nh.param<double>("inflation_radius", params.inflation_radius,
+          0.6);
+      private_nh.param<double>("cost_scaling_factor",
+          params.cost_scaling_factor, 10.0);
+
+      // candidates offset sideways from the plan, in its Frenet frame; 0
+      // offset samples disables them
+      private_nh.param<int>("frenet_offset_samples",
+          params.frenet_offset_samples, 7);
+      private_nh.param<double>("frenet_max_offset", params.frenet_max_offset,
+          0.6);
+      private_nh.param<int>("frenet_merge_samples",
+          params.frenet_merge_samples, 3);
+      private_nh.param<double>("frenet_min_merge", params.frenet_min_merge,
+          1.0);
+      private_nh.param<double>("frenet_max_merge", params.frenet_max_merge,
+          2.5);
+      private_nh.param<double>("frenet_offset_cost",
+          params.frenet_offset_cost, 0.5);
+
+      // reject candidates that leave the free corridor around the plan,
+      // which reaches up to this far to either side; 0 disables it
+      private_nh.param<double>("corridor_width", params.corridor_width, 0.0);
+
+      // check candidates against the raw laser scan as well as the costmap
+      private_nh.param<bool>("use_scan_collision", params.use_scan_collision,
+          false);
+      // predict where moving obstacles in the scan will be, and check
+      // candidates against them along the way
+      private_nh.param<bool>("track_obstacles", params.track_obstacles,
+          false);
+      planner_.setParams(params);
+
+      if( params.track_obstacles ) {
+        ros::NodeHandle tracker_nh(private_nh, "obstacle_tracker");
+        ObstacleTrackerOptions options;
+        tracker_nh.param<double>("cluster_distance",
+            options.cluster_distance, options.cluster_distance);
+        tracker_nh.param<double>("max_cluster_radius",
+            options.max_cluster_radius, options.max_cluster_radius);
+        tracker_nh.param<double>("match_distance", options.match_distance,
+            options.match_distance);
+        tracker_nh.param<double>("velocity_smoothing",
+            options.velocity_smoothing, options.velocity_smoothing);
+        tracker_nh.param<int>("min_hits", options.min_hits, options.min_hits);
+        tracker_nh.param<int>("max_misses", options.max_misses,
+            options.max_misses);
+        tracker_nh.param<double>("min_speed", options.min_speed,
+            options.min_speed);
+        tracker_nh.param<double>("horizon", options.horizon, options.horizon);
+        tracker_nh.param<double>("margin", options.margin, options.margin);
+        planner_.obstacleTracker().setOptions(options);
+      }
+      if( params.use_scan_collision || params.track_obstacles ) {
+        std::string scan_topic;
+        private_nh.param<std::string>("scan_topic", scan_topic, "scan");
+        ros::NodeHandle nh;
+        scan_sub_ = nh.subscribe(scan_topic, 1,
+            &AckermannPlannerROS::scanCallback, this);
+      }
+
+      // compute the cost to go on the global costmap, which sees past the
+      // local window, if it is published; otherwise on the local costmap.
+      // Only full costmaps are used, so the global costmap should set
+      // always_send_full_costmap
+      std::string global_costmap_topic;
+      private_nh.param<std::string>("global_costmap_topic",
+          global_costmap_topic, "");
+      private_nh.param<double>("cost_to_go_margin", cost_to_go_margin_, 2.0);
+      if( ! global_costmap_topic.empty() ) {
+        ros::NodeHandle nh;
+        global_costmap_sub_ = nh.subscribe(global_costmap_topic, 1,
+            &AckermannPlannerROS::globalCostmapCallback, this);
+      }
+
+      // extra candidates from a library built by build_trajectory_library
+      std::string trajectory_library;
+      private_nh.param<std::string>("trajectory_library", trajectory_library,
+          "");
+      if( ! trajectory_library.empty() ) {
+        TrajectoryLibrary &library = planner_.trajectoryLibrary();
+        if( ! library.open(trajectory_library) ) {
+          ROS_ERROR_NAMED("ackermann_planner", "Failed to load trajectory "
+              "library %s: %s", trajectory_library.c_str(),
+              library.error().c_str());
+        } else if( fabs(library.resolution() -
+              costmap_ros_->getCostmap()->getResolution()) > 1e-6 ) {
+          ROS_ERROR_NAMED("ackermann_planner", "Trajectory library %s was "
+              "built for a resolution of %f, not %f",
+              trajectory_library.c_str(), library.resolution(),
+              costmap_ros_->getCostmap()->getResolution());
+          library.close();
+        } else {
+          ROS_INFO_NAMED("ackermann_planner", "Loaded %d trajectories from "
+              "%s", library.size(), trajectory_library.c_str());
+        }
+      }
+
+      // the motion primitives of the global planner, for primitive tracking
+      mprim_lattice::PrimitiveSet &primitives = planner_.primitives();
+      std::string primitive_filename;
+      private_nh.param<std::string>("primitive_filename", primitive_filename,
+          "");
+      // parametric primitives are sampled as densely as we like
+      double primitive_spacing;
+      private_nh.param("primitive_spacing", primitive_spacing, 0.02);
+      const std::string pmprim = ".pmprim";
+      if( primitive_filename.size() > pmprim.size() &&
+          primitive_filename.compare(primitive_filename.size() -
+            pmprim.size(), pmprim.size(), pmprim) == 0 ) {
+        mprim_lattice::ParametricSet parametric;
+        if( parametric.load(primitive_filename) ) {
+          primitives.load(parametric, primitive_spacing);
+          ROS_INFO_NAMED("ackermann_planner", "Loaded %d parametric motion "
+              "primitives from %s", primitives.size(),
+              primitive_filename.c_str());
+        } else {
+          ROS_ERROR_NAMED("ackermann_planner", "Failed to load motion "
+              "primitives from %s: %s", primitive_filename.c_str(),
+              parametric.error().c_str());
+        }
+      } else if( ! primitive_filename.empty() ) {
+        if( primitives.load(primitive_filename) ) {
+          ROS_INFO_NAMED("ackermann_planner", "Loaded %d motion primitives "
+              "from %s", primitives.size(), primitive_filename.c_str());
+        } else {
+          ROS_ERROR_NAMED("ackermann_planner", "Failed to load motion "
+              "primitives from %s: %s", primitive_filename.c_str(),
+              primitives.error().c_str());
+        }
+      }
       
       initialized_ = true;
 
@@ -151,80 +325,53 @@ namespace ackermann_local_planner {
           "initialized, doing nothing.");
     }
   }
-
-  int AckermannPlannerROS::nearestPoint(const int start_point,
-      const tf::Stamped<tf::Pose> & pose) const {
-    int plan_point = start_point;
-    double best_metric = std::numeric_limits<double>::max();
-    for( int i=start_point; i<plan_.size(); i++ ) {
-      double dist = base_local_planner::getGoalPositionDistance(pose,
-          plan_[i].pose.position.x, plan_[i].pose.position.y);
-      double theta = fabs(base_local_planner::getGoalOrientationAngleDifference(
-          pose, tf::getYaw(plan_[i].pose.orientation)));
-      double metric = dist + theta / 10.0;
-      //ROS_INFO_NAMED("ackermann_planner", "Distance to path: %f", dist);
-      if( metric < best_metric ) {
-        best_metric = metric;
-        plan_point = i;
-      }
-    }
-    return plan_point;
-  }
-
-  double AckermannPlannerROS::scoreTrajectory(
-      const std::vector<dubins_plus::Segment> &path,
-      double global_length, double global_dtheta) const {
-    // score and choose a best plan
-    // possible scoring parameters:
-    //  - curvature. lower is better
-    //  - distance/match to global plan
-    //    - include x/y and angular distance
-    //  - length of path compared to length of global plan
-    double dtheta = 0;
-    double local_length = 0;
-    BOOST_FOREACH(dubins_plus::Segment s, path) {
-      local_length += s.getLength();
-      dtheta += std::abs(s.getCurvature() * s.getLength());
-    }
-    // normalized to a base of 1.0. Values > 1.0 are worse
-    //  don't count paths shorter than the global path as better
-    double length_cost = std::max(local_length/global_length, 1.0);
-
-    double curve_cost;
-    curve_cost = std::abs(dtheta - global_dtheta)/(M_PI/180.0);
-
-    //ROS_INFO_NAMED("ackermann_planner", "Length cost: %f, curve cost: %f",
-    //    length_cost, curve_cost);
-
-    //return length_cost + curve_cost;
-    return length_cost;
-  }
   
   bool AckermannPlannerROS::setPlan(const std::vector<geometry_msgs::PoseStamped>& orig_global_plan) {
     if (! isInitialized()) {
       ROS_ERROR("This planner has not been initialized, please call initialize() before using this planner");
       return false;
     }
-    // Transform global plan into local coordinate space
-    /*
-    tf::Stamped<tf::Pose> pose;
-    costmap_ros_->getRobotPose(pose);
-    ROS_INFO_NAMED("ackermann_planner", "Transforming global plan into %s frame", costmap_ros_->getGlobalFrameID().c_str());
-    base_local_planner::transformGlobalPlan(*tf_, orig_global_plan, pose,
-        *costmap_ros_->getCostmap(), costmap_ros_->getGlobalFrameID(), plan_);
-        */
-    //if( plan_ == orig_global_plan ) {
-    if( false ) {
-      ROS_WARN("Got the same plan again");
-    } else {
-      ROS_INFO("Got new plan");
-      plan_ = orig_global_plan;
+    ROS_INFO("Got new plan");
+    recorder_.recordPlan(ros::Time::now().toSec(), orig_global_plan);
+    publishGlobalPlan(orig_global_plan);
+
+    // make sure we can actually drive this plan
+    std::vector<InfeasibleStretch> infeasible;
+    const int matched = planner_.setPlan(toPose2D(orig_global_plan),
+        infeasible);
+    plan_frame_ = orig_global_plan.empty() ? std::string() :
+      orig_global_plan[0].header.frame_id;
+    plan_bounds_ = dubins_plus::Bounds();
+    for( int i=0; i<orig_global_plan.size(); i++ ) {
+      plan_bounds_.add(orig_global_plan[i].pose.position.x,
+          orig_global_plan[i].pose.position.y);
     }
-
-    goal_reached_ = false;
-    last_plan_point_ = 0; // we're at the beginning of the plan
-    // return false here if we would like the global planner to re-plan
-    return true; // TODO: figure out what the return value here means
+    plan_bounds_.grow(cost_to_go_margin_);
+    {
+      // the planner is back on the local costmap until the next crop
+      boost::mutex::scoped_lock lock(global_costmap_mutex_);
+      global_costmap_changed_ = true;
+    }
+    if( orig_global_plan.size() > 1 ) {
+      ROS_INFO_NAMED("ackermann_planner", "Matched %d of %zd plan steps to "
+          "motion primitives", matched, orig_global_plan.size() - 1);
+    }
+    for( int i=0; i<infeasible.size(); i++ ) {
+      const InfeasibleStretch & s = infeasible[i];
+      if( s.reason == InfeasibleStretch::CURVATURE ) {
+        ROS_WARN_NAMED("ackermann_planner", "Plan poses %d to %d have "
+            "curvature %f; we can only drive %f", s.start, s.end, s.worst,
+            1 / planner_.params().min_radius);
+      } else {
+        ROS_WARN_NAMED("ackermann_planner", "Plan reverses between poses %d "
+            "and %d with a heading change of %f rad", s.start, s.end,
+            s.worst);
+      }
+    }
+    // move_base aborts the goal if setPlan fails, so a rejected plan is
+    // reported from computeVelocityCommands instead, which makes move_base
+    // go straight back to planning
+    return true;
   }
 
   bool AckermannPlannerROS::isGoalReached() {
@@ -234,11 +381,70 @@ namespace ackermann_local_planner {
     }
     // TODO(hendrix):
     //  probably use some sort of goal tolerance parameters here
-    return goal_reached_;
+    return planner_.goalReached();
+  }
+
+  void AckermannPlannerROS::publishLocalPlan(
+      const std::vector<dubins_plus::Segment>& path,
+      const Pose2D& start) {
+    // sampling the local plan is only worth it if someone is listening
+    if( l_plan_pub_.getNumSubscribers() == 0 ) {
+      return;
+    }
+    nav_msgs::Path::Ptr local_plan = path_pool_.get();
+    local_plan->header.frame_id = costmap_ros_->getGlobalFrameID();
+    local_plan->header.stamp = ros::Time::now();
+    local_plan->poses.clear();
+
+    geometry_msgs::PoseStamped pose;
+    pose.header = local_plan->header;
+    double x = start.x;
+    double y = start.y;
+    double theta = start.theta;
+
+    for( int i=0; i<path.size(); i++ ) {
+      double length = path[i].getLength();
+      double curvature = path[i].getCurvature();
+      double l = 0;
+      static const double dl = 0.01;
+      while( l < length ) {
+        pose.pose.position.x = x;
+        pose.pose.position.y = y;
+        pose.pose.orientation = tf::createQuaternionMsgFromYaw(theta);
+        local_plan->poses.push_back(pose);
+
+        x += dl * cos(theta);
+        y += dl * sin(theta);
+        theta += curvature * dl;
+        l += dl;
+      }
+    }
+
+    l_plan_pub_.publish(nav_msgs::Path::ConstPtr(local_plan));
+  }
+
+  void AckermannPlannerROS::publishGlobalPlan(
+      const std::vector<geometry_msgs::PoseStamped>& path) {
+    if( path.empty() || g_plan_pub_.getNumSubscribers() == 0 ) {
+      return;
+    }
+    nav_msgs::Path::Ptr global_plan = path_pool_.get();
+    global_plan->header = path[0].header;
+    // assignment reuses the capacity of the pooled message
+    global_plan->poses = path;
+    g_plan_pub_.publish(nav_msgs::Path::ConstPtr(global_plan));
   }
 
-  void AckermannPlannerROS::publishLocalPlan(std::vector<geometry_msgs::PoseStamped>& path) {
-    base_local_planner::publishPlan(path, l_plan_pub_);
+  void AckermannPlannerROS::publishPose(const Pose2D& pose,
+      const ros::Publisher& pub) {
+    if( pub.getNumSubscribers() == 0 ) {
+      return;
+    }
+    geometry_msgs::PoseStamped::Ptr msg = pose_pool_.get();
+    msg->header.frame_id = costmap_ros_->getGlobalFrameID();
+    msg->header.stamp = ros::Time::now();
+    msg->pose = toPose(pose);
+    pub.publish(geometry_msgs::PoseStamped::ConstPtr(msg));
   }
 
 
@@ -249,6 +455,189 @@ namespace ackermann_local_planner {
 
 
   bool AckermannPlannerROS::computeVelocityCommands(geometry_msgs::Twist& cmd_vel) {
+    ScopedSpan cycle(planner_.tracer(), "cycle");
+    if( recorder_.enabled() ) {
+      recorder_.recordCycleBegin(ros::Time::now().toSec());
+    }
+    bool result = planCycle(cmd_vel);
+    if( recorder_.enabled() ) {
+      recorder_.recordCycleEnd(ros::Time::now().toSec(), cmd_vel, result);
+    }
+    cycle.end();
+    const size_t dropped = planner_.tracer().maybeFlush();
+    if( dropped > 0 ) {
+      ROS_WARN_NAMED("ackermann_planner", "Trace buffer full; dropped %zu "
+          "spans. Consider increasing trace_buffer_size", dropped);
+    }
+    return result;
+  }
+
+  void AckermannPlannerROS::scanCallback(
+      const sensor_msgs::LaserScan::ConstPtr &scan) {
+    boost::mutex::scoped_lock lock(scan_mutex_);
+    scan_ = scan;
+  }
+
+  void AckermannPlannerROS::globalCostmapCallback(
+      const nav_msgs::OccupancyGrid::ConstPtr &grid) {
+    boost::mutex::scoped_lock lock(global_costmap_mutex_);
+    global_costmap_ = grid;
+    global_costmap_changed_ = true;
+  }
+
+  void AckermannPlannerROS::updateCostToGoMap() {
+    nav_msgs::OccupancyGrid::ConstPtr grid;
+    {
+      boost::mutex::scoped_lock lock(global_costmap_mutex_);
+      if( ! global_costmap_changed_ ) {
+        return;
+      }
+      grid = global_costmap_;
+      global_costmap_changed_ = false;
+    }
+    if( ! grid || plan_bounds_.empty() ) {
+      return;
+    }
+    if( ! sameFrame(grid->header.frame_id, plan_frame_) ) {
+      ROS_WARN_THROTTLE_NAMED(1.0, "ackermann_planner", "Global costmap is "
+          "in %s, but the plan is in %s; computing the cost to go on the "
+          "local costmap", grid->header.frame_id.c_str(),
+          plan_frame_.c_str());
+      return;
+    }
+
+    // only the cells around the plan, so that a new plan doesn't cost a
+    // wavefront over the whole map
+    const nav_msgs::MapMetaData &info = grid->info;
+    const double resolution = info.resolution;
+    const double origin_x = info.origin.position.x;
+    const double origin_y = info.origin.position.y;
+    const int min_x = std::max(0,
+        int(floor((plan_bounds_.min_x - origin_x) / resolution)));
+    const int min_y = std::max(0,
+        int(floor((plan_bounds_.min_y - origin_y) / resolution)));
+    const int max_x = std::min(int(info.width),
+        int(ceil((plan_bounds_.max_x - origin_x) / resolution)));
+    const int max_y = std::min(int(info.height),
+        int(ceil((plan_bounds_.max_y - origin_y) / resolution)));
+    if( max_x <= min_x || max_y <= min_y ) {
+      return;
+    }
+    const int size_x = max_x - min_x;
+    const int size_y = max_y - min_y;
+    cost_to_go_cells_.resize(size_x * size_y);
+    for( int y=0; y<size_y; y++ ) {
+      const int8_t *row = &grid->data[(min_y + y) * info.width + min_x];
+      for( int x=0; x<size_x; x++ ) {
+        cost_to_go_cells_[y * size_x + x] = occupancyCost(row[x]);
+      }
+    }
+    planner_.setCostToGoMap(CostGrid(size_x, size_y, resolution,
+          origin_x + min_x * resolution, origin_y + min_y * resolution,
+          &cost_to_go_cells_[0]));
+  }
+
+  bool AckermannPlannerROS::updateScan() {
+    sensor_msgs::LaserScan::ConstPtr scan;
+    {
+      boost::mutex::scoped_lock lock(scan_mutex_);
+      scan = scan_;
+    }
+    if( ! scan ) {
+      ROS_WARN_THROTTLE_NAMED(1.0, "ackermann_planner", "No laser scan "
+          "received yet; not checking against it");
+      return false;
+    }
+    double age = (ros::Time::now() - scan->header.stamp).toSec();
+    if( age > MAX_SCAN_AGE ) {
+      ROS_WARN_THROTTLE_NAMED(1.0, "ackermann_planner", "Laser scan is %f "
+          "seconds old; not checking against it", age);
+      return false;
+    }
+
+    tf::StampedTransform transform;
+    try {
+      tf_->lookupTransform(costmap_ros_->getGlobalFrameID(),
+          scan->header.frame_id, ros::Time(0), transform);
+    } catch( tf::TransformException &e ) {
+      ROS_WARN_THROTTLE_NAMED(1.0, "ackermann_planner", "Can't transform "
+          "laser scan: %s", e.what());
+      return false;
+    }
+
+    scan_x_.clear();
+    scan_y_.clear();
+    for( int i=0; i<scan->ranges.size(); i++ ) {
+      double r = scan->ranges[i];
+      if( !(r >= scan->range_min && r < scan->range_max) ) {
+        continue;
+      }
+      double a = scan->angle_min + i * scan->angle_increment;
+      tf::Vector3 p = transform * tf::Vector3(r * cos(a), r * sin(a), 0);
+      scan_x_.push_back(p.x());
+      scan_y_.push_back(p.y());
+    }
+    planner_.setScan(scan->header.stamp.toSec(), scan_x_, scan_y_);
+    return true;
+  }
+
+  void AckermannPlannerROS::logCycle(const CycleResult &result) const {
+    if( result.jumped ) {
+      ROS_WARN_NAMED("ackermann_planner", "Whoa! We moved a lot. Not sure we're still on the right part of the plan");
+    }
+    if( result.traversal_fallback ) {
+      ROS_WARN_THROTTLE_NAMED(10.0, "ackermann_planner", "The footprint "
+          "discs reach past the inflation radius; checking every cell under "
+          "them instead of the cells they pass through");
+    }
+    if( result.tracking_blocked ) {
+      ROS_WARN_NAMED("ackermann_planner", "The primitives ahead are "
+          "blocked; sampling candidates instead of tracking them");
+    }
+    switch( result.status ) {
+      case CycleResult::EMPTY_PLAN:
+        ROS_WARN_NAMED("ackermann_planner", "Got empty plan! Goal reached?");
+        break;
+      case CycleResult::INFEASIBLE_PLAN:
+        ROS_ERROR_NAMED("ackermann_planner", "Plan is not feasible; asking "
+            "for a new one");
+        break;
+      case CycleResult::TRACKING:
+        ROS_INFO_NAMED("ackermann_planner", "Tracking primitive %d (angle "
+            "%d) step %d: lateral error %f, heading error %f, speed %f, "
+            "angular %f", result.primitive->id,
+            result.primitive->start_angle, result.primitive_step,
+            result.lateral_error, result.heading_error, result.linear,
+            result.angular);
+        break;
+      case CycleResult::SAMPLED:
+      case CycleResult::NO_PATH:
+        ROS_INFO_NAMED("ackermann_planner", "Target pose #%d is %f meters "
+            "away", result.target, result.target_distance);
+        ROS_INFO_NAMED("ackermann_planner", "%d candidates; rejected %d by "
+            "free arcs, %d by the corridor, %d by the scan, %d by the "
+            "costmap, %d by moving obstacles, %d by the library",
+            result.candidates, result.rejected_free_arc,
+            result.rejected_corridor, result.rejected_scan,
+            result.rejected_costmap, result.rejected_moving,
+            result.rejected_library);
+        ROS_INFO_NAMED("ackermann_planner", "Best path cost %f",
+            result.best_score);
+        if( result.status == CycleResult::NO_PATH ) {
+          ROS_ERROR_NAMED("ackermann_planner", "Failed to find a good local "
+              "plan");
+        }
+        break;
+      case CycleResult::AT_GOAL:
+        ROS_INFO_NAMED("ackermann_planner", "plan_point is the last point "
+            "on the plan. I guess we're here?");
+        ROS_INFO_NAMED("ackermann_planner", "At point %d; %zd points in "
+            "plan", result.plan_point, planner_.plan().size());
+        break;
+    }
+  }
+
+  bool AckermannPlannerROS::planCycle(geometry_msgs::Twist& cmd_vel) {
     // TODO(hendrix)
     //  do some real plannin' here
     // Ideas and questions:
@@ -276,22 +665,26 @@ namespace ackermann_local_planner {
     //    not completely stopped
     //  - have a config switch that turns off the command output from the
     //    planner. default it to ON
-
-    // if we don't have a plan, what are we doing here???
-    if( plan_.size() < 2 ) {
-      ROS_WARN_NAMED("ackermann_planner", "Got empty plan! Goal reached?");
-      goal_reached_ = true;
-
-      // stop moving
-      cmd_vel.linear.x = 0;
-      cmd_vel.angular.z = 0;
-      return true;
+    Tracer &tracer = planner_.tracer();
+    PlannerInput input;
+    const costmap_2d::Costmap2D &costmap = *costmap_ros_->getCostmap();
+    const CostGrid grid = toCostGrid(costmap);
+    input.costmap = &grid;
+    if( recorder_.enabled() && planner_.plan().size() > 1 ) {
+      ScopedSpan record_span(tracer, "record_costmap");
+      recorder_.recordCostmap(ros::Time::now().toSec(), costmap);
     }
 
     nav_msgs::Odometry odom;
+    ScopedSpan odom_span(tracer, "odometry");
     odom_helper_.getOdom(odom);
-    double linear_vel = odom.twist.twist.linear.x;
-    double angular_vel = odom.twist.twist.angular.z;
+    odom_span.end();
+    input.linear_vel = odom.twist.twist.linear.x;
+    input.angular_vel = odom.twist.twist.angular.z;
+    if( recorder_.enabled() ) {
+      recorder_.recordOdom(odom.header.stamp.toSec(), input.linear_vel,
+          input.angular_vel);
+    }
 
     // if we have a pose cloud, get it, otherwise just use our current pose
     tf::Stamped<tf::Pose> current_pose;
@@ -303,241 +696,59 @@ namespace ackermann_local_planner {
       // TODO(hendrix)
       ROS_INFO_NAMED("ackermann_planner", "Got position from PoseWithCov");
     } else {
+      ScopedSpan pose_span(tracer, "robot_pose");
       costmap_ros_->getRobotPose(current_pose);
+      pose_span.end();
+      if( recorder_.enabled() ) {
+        recorder_.recordPose(current_pose.stamp_.toSec(),
+            current_pose.getOrigin().x(), current_pose.getOrigin().y(),
+            tf::getYaw(current_pose.getRotation()));
+      }
       ROS_INFO_NAMED("ackermann_planner", "Got position from costmap");
     }
     ROS_INFO_NAMED("ackermann_planner", "Starting point (%f, %f)",
         current_pose.getOrigin().x(), current_pose.getOrigin().y());
-
-    // get the nearest point on the global plan; both in angle space and
-    // linear space
-    int plan_point = nearestPoint(last_plan_point_, current_pose);
-
-    if( abs(plan_point - last_plan_point_) > 20 ) {
-      ROS_WARN_NAMED("ackermann_planner", "Whoa! We moved a lot. Not sure we're still on the right part of the plan");
-    }
-
-    last_plan_point_ = plan_point;
-    geometry_msgs::PoseStamped plan_pose = plan_[plan_point];
-
-    // publish plan_point as "here"
-    if( publish_near_point_ ) {
-      near_point_pub_.publish(plan_pose);
-    }
-
-    if( plan_point < plan_.size() - 1 ) {
-      int i = plan_point + 1;
-      geometry_msgs::PoseStamped next_pose = plan_[i];
-      // get the direction (forward/backwards) on the plan
-      bool forward = isForwards(plan_pose, next_pose);
-
-      // Pure pursuit algorithm (Coulter R. Craig, 1992)
-      // compute the curvature at the current point
-      double local_curvature = curvature(plan_pose, next_pose);
-      if( plan_point > 0 ) {
-        const geometry_msgs::PoseStamped & prev_pose = plan_[plan_point-1];
-        // average curvature to previous point with curvature to next point
-        local_curvature = (local_curvature + curvature(prev_pose, plan_pose))/2;
-      }
-      // Pure pursuit lookahead
-      // r = 1 / curvature
-      // lookahend = factor * r
-      //           = factor / curvature
-      double local_radius = 1 / local_curvature;
-      double forward_point_distance = lookahead_factor_ * local_radius;
-      ROS_INFO_NAMED("ackermann_planner", "Local curvature %f, radius %f"
-          ", lookahead distance %f", local_curvature, local_radius,
-          forward_point_distance);
-      // get a point forward of where we are on the plan
-      double forward_dist = 0;
-      double dtheta = 0;
-
-      while( forward_dist < lookahead_factor_ / local_curvature &&
-          i < plan_.size() &&
-          isForwards(plan_pose, next_pose) == forward ) {
-        plan_pose = plan_[i-1];
-        next_pose = plan_[i];
-        forward_dist += dist(plan_pose, next_pose);
-        dtheta += std::abs(angles::shortest_angular_distance(
-              tf::getYaw(next_pose.pose.orientation),
-              tf::getYaw(plan_pose.pose.orientation)));
-
-        double c = curvature(plan_pose, next_pose);
-        if( c > local_curvature ) {
-          local_curvature = c;
-          local_radius = 1 / local_curvature;
-          forward_point_distance = lookahead_factor_ * local_radius;
-          ROS_INFO_NAMED("ackermann_planner", "Updated curvature %f, "
-              "radius %f and lookahead distance: %f", local_curvature,
-              local_radius, forward_point_distance);
-        }
-
-        i++;
-      }
-
-      ROS_INFO_NAMED("ackermann_planner", "Target pose #%d is %f meters away",
-          i, forward_dist);
-
-      geometry_msgs::PoseStamped goal_pose = next_pose;
-
-      // publish goal pose
-      if( publish_goal_ ) {
-        goal_pub_.publish(goal_pose);
-      }
-
-      // TODO(hendrix): for each potential position
-      // for each starting position
-      //   for each radius/curvature
-      //     generate a path from start to end
-      //    choose the best path for this start point
-      //    - possibly publish these
-      // analyze the set of best paths for each starting point
-      // - look for general patterns/concensus
-      // - possibly publish all plans considered
-
-      // Compute Dubins path to the goal
-      geometry_msgs::Pose current_pose_msg;
-      tf::poseTFToMsg(current_pose, current_pose_msg);
-
-      // if the path is backwards, invert the direction of initial and final
-      // poses
-      if( ! forward ) {
-        double start_yaw = tf::getYaw(current_pose_msg.orientation);
-        start_yaw += M_PI;
-        current_pose_msg.orientation = tf::createQuaternionMsgFromYaw(start_yaw);
-
-        double end_yaw = tf::getYaw(goal_pose.pose.orientation);
-        end_yaw += M_PI;
-        goal_pose.pose.orientation = tf::createQuaternionMsgFromYaw(end_yaw);
+    input.x = current_pose.getOrigin().x();
+    input.y = current_pose.getOrigin().y();
+    input.theta = tf::getYaw(current_pose.getRotation());
+    input.now = ros::Time::now().toSec();
+
+    const PlannerParams &params = planner_.params();
+    if( params.use_scan_collision || params.track_obstacles ) {
+      ScopedSpan scan_span(tracer, "scan_index");
+      if( ! updateScan() ) {
+        planner_.clearScan();
       }
+    }
 
-      // path sampling
-      std::vector<dubins_plus::Segment> local_path;
-      double best_score = std::numeric_limits<double>::max();
-      double max_curvature = 1/min_radius_;
-      ROS_INFO_NAMED("ackermann_planner", "Maximum curvature: %f", max_curvature);
-
-      // sample across curvature
-      for( int i=0; i<radius_samples_; i++ ) {
-        double curvature = (max_curvature/radius_samples_) * (i+1);
-        ROS_INFO_NAMED("ackermann_planner", "Considering curvature: %f", curvature);
-        double radius = 1/curvature;
-        std::vector<dubins_plus::Segment> path(dubins_plus::dubins_path(radius,
-              current_pose_msg, goal_pose.pose));
-        double score = scoreTrajectory(path, forward_dist, dtheta);
-        if( score < best_score ) {
-          best_score = score;
-          local_path = path;
-        }
-      }
-      
+    updateCostToGoMap();
 
-      ROS_INFO_NAMED("ackermann_planner", "Best path cost %f", best_score);
+    CycleResult result;
+    const bool ok = planner_.cycle(input, result);
+    logCycle(result);
 
-      // publish goal pose
-      if( publish_goal_ ) {
-        goal_pub_.publish(goal_pose);
+    if( result.status != CycleResult::EMPTY_PLAN &&
+        result.status != CycleResult::INFEASIBLE_PLAN ) {
+      ScopedSpan publish_span(tracer, "publish");
+      // publish plan_point as "here"
+      if( publish_near_point_ ) {
+        publishPose(planner_.plan()[result.plan_point], near_point_pub_);
       }
-
-
-      std::vector<geometry_msgs::PoseStamped> local_plan;
-      double x = current_pose_msg.position.x;
-      double y = current_pose_msg.position.y;
-      double theta = tf::getYaw(current_pose_msg.orientation);
-
-      for( int i=0; i<local_path.size(); i++ ) {
-        /*
-        ROS_INFO_NAMED("ackermann_planner",
-            "Dubins path length %f, curvature %f",
-            local_path[i].getLength(), local_path[i].getCurvature());
-            */
-        double length = local_path[i].getLength();
-        double curvature = local_path[i].getCurvature();
-        double l = 0;
-        static const double dl = 0.01;
-        while( l < length ) {
-          geometry_msgs::PoseStamped pose;
-          pose.header.frame_id = costmap_ros_->getGlobalFrameID();
-          pose.pose.position.x = x;
-          pose.pose.position.y = y;
-          pose.pose.orientation = tf::createQuaternionMsgFromYaw(theta);
-          local_plan.push_back(pose);
-
-          x += dl * cos(theta);
-          y += dl * sin(theta);
-          theta += curvature * dl;
-          l += dl;
+      if( result.status == CycleResult::SAMPLED ||
+          result.status == CycleResult::NO_PATH ) {
+        if( publish_goal_ ) {
+          publishPose(result.goal, goal_pub_);
         }
       }
-
-      publishLocalPlan(local_plan);
-
-      if( best_score > 10.0 ) {
-        // if the best local trajectory we were able to find is 5x worse than
-        // the global path, force the global planner to re-plan
-        ROS_ERROR_NAMED("ackermann_planner", "Failed to find a good local plan");
-        return false;
-      }
-
-      i=0;
-      for( ; i<local_path.size() && local_path[i].getLength() < 0.01; i++ );
-      double target_curvature = local_path[i].getCurvature();
-
-      // target maximum velocity
-      double target_speed = max_vel_;
-      // limit to maximum acceleration
-      target_speed = std::min(target_speed, linear_vel + acc_lim_);
-      // decelerate to min_vel_ at end of path (using acc_lim_)
-      //  we have forward_dist meters remaining
-      // required_decel = (target_speed - min_vel_)
-      // decel_time = required_decel / acc_lim_
-      // x = a*t^2 + v0*t + x0
-      // decel_distance = acc_lim_ * decel_time * decel_time + 
-      //                  linear_vel * decel_time + 0
-      double required_decel = target_speed - min_vel_;
-      double decel_time = required_decel / acc_lim_;
-      double decel_distance = acc_lim_ * decel_time * decel_time +
-                              target_speed * decel_time +
-                              0;
-      // if we have less than decel_distance to the goal, we should be
-      // decelerating
-      // TODO: this oscillates. makes me sad.
-      if( decel_distance * 1.1 >= forward_dist ) {
-        target_speed = target_speed - acc_lim_;
+      if( result.status != CycleResult::AT_GOAL ) {
+        publishLocalPlan(result.local_path, result.start);
       }
-      // limit to minimum speed
-      target_speed = std::max(target_speed, min_vel_);
-
-      double target_angular = target_curvature * target_speed;
-
-      if( ! forward ) {
-        target_speed = -target_speed;
-        //target_angular = -target_angular;
-      }
-
-      cmd_vel.linear.x = target_speed;
-      cmd_vel.angular.z = target_angular;
-
-    } else {
-      // plan_point is the last point on the plan
-      // we're here?
-      //
-      // ????
-      ROS_INFO_NAMED("ackermann_planner", "plan_point is the last point on the"
-          " plan. I guess we're here?");
-      ROS_INFO_NAMED("ackermann_planner", "At point %d; %zd points in plan",
-          plan_point, plan_.size());
-      goal_reached_ = true;
     }
 
-
-    if( !move_ ) {
-      // if we're not supposed to be moving, zero out our command
-      cmd_vel.linear.x = 0;
-      cmd_vel.angular.z = 0;
-    }
+    cmd_vel.linear.x = result.linear;
+    cmd_vel.angular.z = result.angular;
 
     // return true if we were able to find a path, false otherwise
-    return true;
+    return ok;
   }
 };
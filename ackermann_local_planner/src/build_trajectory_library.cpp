@@ -0,0 +1,137 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/trajectory_library.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sstream>
+
+using namespace ackermann_local_planner;
+
+static std::vector<double> parseList(const std::string &value) {
+  std::vector<double> list;
+  std::stringstream ss(value);
+  std::string item;
+  while( std::getline(ss, item, ',') ) {
+    list.push_back(atof(item.c_str()));
+  }
+  return list;
+}
+
+static void usage(const char *name) {
+  fprintf(stderr, "Usage: %s output.trj [option=value ...]\n"
+      "Options:\n"
+      "  resolution=0.05       costmap resolution (m)\n"
+      "  headings=64           start headings\n"
+      "  footprint=x,y,x,y,... robot footprint (m)\n"
+      "  min_radius=0.7        minimum turning radius (m)\n"
+      "  max_lateral_acc=0.5   limits the curvature at speed (m/s^2)\n"
+      "  speeds=0.15,0.3,0.5,-0.15\n"
+      "                        speeds; negative for reverse (m/s)\n"
+      "  times=1,2,3           how long each trajectory is driven (s)\n"
+      "  curvatures=15         curvature samples\n", name);
+}
+
+int main(int argc, char **argv) {
+  if( argc < 2 ) {
+    usage(argv[0]);
+    return 1;
+  }
+  TrajectoryLibraryOptions options;
+  for( int i=2; i<argc; i++ ) {
+    const std::string arg(argv[i]);
+    const size_t eq = arg.find('=');
+    if( eq == std::string::npos ) {
+      usage(argv[0]);
+      return 1;
+    }
+    const std::string key = arg.substr(0, eq);
+    const std::string value = arg.substr(eq + 1);
+    if( key == "resolution" ) {
+      options.resolution = atof(value.c_str());
+    } else if( key == "headings" ) {
+      options.num_headings = atoi(value.c_str());
+    } else if( key == "footprint" ) {
+      const std::vector<double> xy = parseList(value);
+      options.footprint.clear();
+      for( int j=0; j+1<xy.size(); j+=2 ) {
+        options.footprint.push_back(Point2D(xy[j], xy[j+1]));
+      }
+    } else if( key == "min_radius" ) {
+      options.min_radius = atof(value.c_str());
+    } else if( key == "max_lateral_acc" ) {
+      options.max_lateral_acc = atof(value.c_str());
+    } else if( key == "speeds" ) {
+      options.speeds = parseList(value);
+    } else if( key == "times" ) {
+      options.times = parseList(value);
+    } else if( key == "curvatures" ) {
+      options.curvature_samples = atoi(value.c_str());
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if( options.resolution <= 0 || options.num_headings <= 0 ||
+      options.footprint.size() < 3 || options.min_radius <= 0 ) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  if( ! buildTrajectoryLibrary(options, argv[1]) ) {
+    fprintf(stderr, "Failed to write %s\n", argv[1]);
+    return 1;
+  }
+
+  TrajectoryLibrary library;
+  if( ! library.open(argv[1]) ) {
+    fprintf(stderr, "%s\n", library.error().c_str());
+    return 1;
+  }
+  uint64_t cells = 0;
+  for( int h=0; h<library.numHeadings(); h++ ) {
+    for( int i=0; i<library.size(); i++ ) {
+      cells += library.mask(h, i).count;
+    }
+  }
+  printf("Wrote %d trajectories from %d headings to %s; %.1f cells per "
+      "trajectory\n", library.size(), library.numHeadings(), argv[1],
+      double(cells) / library.numHeadings() / library.size());
+  return 0;
+}
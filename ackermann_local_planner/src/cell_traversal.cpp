@@ -0,0 +1,201 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/cell_traversal.h>
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include <ackermann_local_planner/planner_types.h>
+
+namespace ackermann_local_planner {
+
+  // curvatures smaller than this, per cell, are walked as straight lines
+  static const double MIN_CURVATURE = 1e-9;
+
+  // grid lines this close past the end of a piece are still crossed
+  static const double END_TOLERANCE = 1e-9;
+
+  static const double NEVER = std::numeric_limits<double>::infinity();
+
+  CellTraversal::CellTraversal(double x, double y, double theta,
+      double length, double curvature) : x_(x), y_(y), theta_(theta),
+    length_(std::max(0.0, length)), curvature_(curvature),
+    arc_(fabs(curvature) > MIN_CURVATURE), center_x_(0), center_y_(0),
+    piece_(0), piece_start_(0), piece_end_(0), quadrant_(0), step_x_(1),
+    step_y_(1), end_x_(x), end_y_(y), cx_(floor(x)), cy_(floor(y)),
+    entry_(0), next_x_(NEVER), next_y_(NEVER), started_(false),
+    done_(false) {
+    if( arc_ ) {
+      center_x_ = x_ - sin(theta_) / curvature_;
+      center_y_ = y_ + cos(theta_) / curvature_;
+    }
+    beginPiece();
+  }
+
+  void CellTraversal::beginPiece() {
+    piece_start_ = piece_ == 0 ? 0 : piece_end_;
+    if( ! arc_ ) {
+      piece_end_ = length_;
+      const double c = cos(theta_);
+      const double s = sin(theta_);
+      step_x_ = c >= 0 ? 1 : -1;
+      step_y_ = s >= 0 ? 1 : -1;
+      end_x_ = x_ + length_ * c;
+      end_y_ = y_ + length_ * s;
+    } else {
+      // headings in [quadrant * pi/2, (quadrant + 1) * pi/2], walked up for
+      // left turns and down for right turns
+      double end_heading;
+      if( curvature_ > 0 ) {
+        quadrant_ = int(floor(theta_ / M_PI_2)) + piece_;
+        end_heading = (quadrant_ + 1) * M_PI_2;
+      } else {
+        quadrant_ = int(ceil(theta_ / M_PI_2)) - 1 - piece_;
+        end_heading = quadrant_ * M_PI_2;
+      }
+      piece_end_ = std::min(length_, (end_heading - theta_) / curvature_);
+      const int m = ((quadrant_ % 4) + 4) % 4;
+      step_x_ = (m == 0 || m == 3) ? 1 : -1;
+      step_y_ = (m == 0 || m == 1) ? 1 : -1;
+      const double heading = theta_ + curvature_ * piece_end_;
+      end_x_ = center_x_ + sin(heading) / curvature_;
+      end_y_ = center_y_ - cos(heading) / curvature_;
+    }
+    next_x_ = crossingX(step_x_ > 0 ? cx_ + 1 : cx_);
+    next_y_ = crossingY(step_y_ > 0 ? cy_ + 1 : cy_);
+  }
+
+  double CellTraversal::crossingX(double gx) const {
+    if( (gx - end_x_) * step_x_ > END_TOLERANCE ) {
+      return NEVER;
+    }
+    if( ! arc_ ) {
+      const double c = cos(theta_);
+      return fabs(c) > 0 ? (gx - x_) / c : NEVER;
+    }
+    // x = center_x + sin(heading) / curvature. The grid line is between
+    // the ends of the piece, so a is only out of range by rounding, where
+    // the arc is tangent to it
+    const double a = std::max(-1.0, std::min(1.0,
+          curvature_ * (gx - center_x_)));
+    const int m = ((quadrant_ % 4) + 4) % 4;
+    double heading = asin(a);
+    if( m == 1 || m == 2 ) {
+      heading = M_PI - heading;
+    } else if( m == 3 ) {
+      heading += 2 * M_PI;
+    }
+    heading += (quadrant_ - m) * M_PI_2;
+    return (heading - theta_) / curvature_;
+  }
+
+  double CellTraversal::crossingY(double gy) const {
+    if( (gy - end_y_) * step_y_ > END_TOLERANCE ) {
+      return NEVER;
+    }
+    if( ! arc_ ) {
+      const double s = sin(theta_);
+      return fabs(s) > 0 ? (gy - y_) / s : NEVER;
+    }
+    // y = center_y - cos(heading) / curvature
+    const double b = std::max(-1.0, std::min(1.0,
+          -curvature_ * (gy - center_y_)));
+    const int m = ((quadrant_ % 4) + 4) % 4;
+    double heading = acos(b);
+    if( m == 2 || m == 3 ) {
+      heading = 2 * M_PI - heading;
+    }
+    heading += (quadrant_ - m) * M_PI_2;
+    return (heading - theta_) / curvature_;
+  }
+
+  bool CellTraversal::next(int &cx, int &cy) {
+    if( done_ ) {
+      return false;
+    }
+    if( ! started_ ) {
+      started_ = true;
+      cx = cx_;
+      cy = cy_;
+      return true;
+    }
+    while( true ) {
+      // through a corner, both neighbors are visited
+      if( next_x_ <= next_y_ && next_x_ <= piece_end_ ) {
+        cx_ += step_x_;
+        entry_ = std::max(0.0, next_x_);
+        next_x_ = crossingX(step_x_ > 0 ? cx_ + 1 : cx_);
+        break;
+      }
+      if( next_y_ <= piece_end_ ) {
+        cy_ += step_y_;
+        entry_ = std::max(0.0, next_y_);
+        next_y_ = crossingY(step_y_ > 0 ? cy_ + 1 : cy_);
+        break;
+      }
+      if( piece_end_ >= length_ ) {
+        done_ = true;
+        return false;
+      }
+      // the arc turns through another quadrant, and reverses in one axis
+      piece_++;
+      beginPiece();
+    }
+    cx = cx_;
+    cy = cy_;
+    return true;
+  }
+
+  unsigned char inflatedThreshold(double radius, double resolution,
+      double inscribed_radius, double inflation_radius,
+      double cost_scaling_factor) {
+    const double distance = radius + resolution * M_SQRT1_2;
+    if( distance <= inscribed_radius ) {
+      return INSCRIBED_INFLATED_OBSTACLE;
+    }
+    if( distance > inflation_radius ) {
+      return 0;
+    }
+    // as costmap_2d::InflationLayer::computeCost
+    const double factor = exp(-cost_scaling_factor *
+        (distance - inscribed_radius));
+    return (unsigned char)((INSCRIBED_INFLATED_OBSTACLE - 1) *
+        factor);
+  }
+};
@@ -0,0 +1,355 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/cost_to_go.h>
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <functional>
+
+namespace ackermann_local_planner {
+
+  static const float INF = std::numeric_limits<float>::infinity();
+
+  // how much more it costs to drive through a cell of cost 252 than through
+  // free space
+  static const float COST_WEIGHT = 1.0;
+
+  // 8-connected neighbours, and the length of the step to each
+  static const int NEIGHBORS = 8;
+  static const int DX[NEIGHBORS] = { 1, -1, 0,  0, 1,  1, -1, -1 };
+  static const int DY[NEIGHBORS] = { 0,  0, 1, -1, 1, -1,  1, -1 };
+  static const float STEP[NEIGHBORS] = { 1, 1, 1, 1,
+    M_SQRT2, M_SQRT2, M_SQRT2, M_SQRT2 };
+
+  CostToGoField::CostToGoField() : plan_changed_(true), size_x_(0),
+    size_y_(0), resolution_(0), origin_x_(0), origin_y_(0),
+    updated_cells_(0) {
+  }
+
+  float CostToGoField::traversal(unsigned char cost) const {
+    // be optimistic about unknown space, like the global planner
+    if( cost == NO_INFORMATION ) {
+      return 1.0;
+    }
+    if( cost >= INSCRIBED_INFLATED_OBSTACLE ) {
+      return INF;
+    }
+    return 1.0 + COST_WEIGHT * cost / 252.0;
+  }
+
+  void CostToGoField::setPlan(
+      const std::vector<Pose2D> &plan) {
+    plan_.resize(plan.size());
+    float remaining = 0;
+    for( int i=plan.size()-1; i>=0; i-- ) {
+      const Pose2D & p = plan[i];
+      if( i < plan.size()-1 ) {
+        const Pose2D & next = plan[i+1];
+        remaining += hypot(next.x - p.x, next.y - p.y);
+      }
+      plan_[i].x = p.x;
+      plan_[i].y = p.y;
+      plan_[i].remaining = remaining;
+    }
+    plan_changed_ = true;
+  }
+
+  double CostToGoField::costAt(double wx, double wy) const {
+    if( size_x_ == 0 ) {
+      return INF;
+    }
+    int x = floor((wx - origin_x_) / resolution_);
+    int y = floor((wy - origin_y_) / resolution_);
+    if( x < 0 || y < 0 || x >= size_x_ || y >= size_y_ ) {
+      return INF;
+    }
+    return dist_[y * size_x_ + x];
+  }
+
+  void CostToGoField::computeSeeds(std::vector<float> &seeds) const {
+    seeds.assign(size_x_ * size_y_, INF);
+    for( int i=0; i<plan_.size(); i++ ) {
+      int x = floor((plan_[i].x - origin_x_) / resolution_);
+      int y = floor((plan_[i].y - origin_y_) / resolution_);
+      if( x >= 0 && y >= 0 && x < size_x_ && y < size_y_ ) {
+        float & seed = seeds[y * size_x_ + x];
+        seed = std::min(seed, plan_[i].remaining);
+      }
+    }
+  }
+
+  void CostToGoField::push(int cell, float dist) {
+    queue_.push_back(QueueEntry(dist, cell));
+    std::push_heap(queue_.begin(), queue_.end(), std::greater<QueueEntry>());
+  }
+
+  void CostToGoField::propagate() {
+    while( ! queue_.empty() ) {
+      std::pop_heap(queue_.begin(), queue_.end(),
+          std::greater<QueueEntry>());
+      QueueEntry top = queue_.back();
+      queue_.pop_back();
+      float d = top.first;
+      int cell = top.second;
+      if( d > dist_[cell] ) {
+        continue; // stale entry
+      }
+      updated_cells_++;
+      int cx = cell % size_x_;
+      int cy = cell / size_x_;
+      for( int k=0; k<NEIGHBORS; k++ ) {
+        int x = cx + DX[k];
+        int y = cy + DY[k];
+        if( x < 0 || y < 0 || x >= size_x_ || y >= size_y_ ) {
+          continue;
+        }
+        int n = y * size_x_ + x;
+        float t = traversal(costs_[n]);
+        if( t == INF ) {
+          continue;
+        }
+        float nd = d + STEP[k] * resolution_ * t;
+        if( nd < dist_[n] ) {
+          dist_[n] = nd;
+          parent_[n] = cell;
+          push(n, nd);
+        }
+      }
+    }
+  }
+
+  void CostToGoField::reset(const CostGrid &costmap) {
+    size_x_ = costmap.getSizeInCellsX();
+    size_y_ = costmap.getSizeInCellsY();
+    resolution_ = costmap.getResolution();
+    origin_x_ = costmap.getOriginX();
+    origin_y_ = costmap.getOriginY();
+    const int size = size_x_ * size_y_;
+
+    const unsigned char* map = costmap.getCharMap();
+    costs_.assign(map, map + size);
+    computeSeeds(seeds_);
+    dist_.assign(size, INF);
+    parent_.assign(size, -1);
+    invalid_.assign(size, 0);
+    queue_.clear();
+
+    for( int c=0; c<size; c++ ) {
+      if( seeds_[c] < INF && traversal(costs_[c]) < INF ) {
+        dist_[c] = seeds_[c];
+        push(c, seeds_[c]);
+      }
+    }
+    propagate();
+  }
+
+  bool CostToGoField::shift(const CostGrid &costmap) {
+    // rolling windows move by whole cells; anything else starts over
+    double sx = (costmap.getOriginX() - origin_x_) / resolution_;
+    double sy = (costmap.getOriginY() - origin_y_) / resolution_;
+    int dx = round(sx);
+    int dy = round(sy);
+    if( fabs(sx - dx) > 1e-3 || fabs(sy - dy) > 1e-3 ||
+        abs(dx) >= size_x_ || abs(dy) >= size_y_ ) {
+      return false;
+    }
+    origin_x_ = costmap.getOriginX();
+    origin_y_ = costmap.getOriginY();
+
+    const int size = size_x_ * size_y_;
+    // cells that scroll in are marked lethal and unreached, so that the
+    // comparison against the costmap treats them as newly opened up. The
+    // seeds are recomputed by the update, so their scratch is borrowed
+    std::vector<unsigned char> &costs = shift_costs_;
+    std::vector<float> &seeds = new_seeds_;
+    std::vector<float> &dist = shift_dist_;
+    std::vector<int> &parent = shift_parent_;
+    costs.assign(size, LETHAL_OBSTACLE);
+    seeds.assign(size, INF);
+    dist.assign(size, INF);
+    parent.assign(size, -1);
+    for( int y=0; y<size_y_; y++ ) {
+      int oy = y + dy;
+      if( oy < 0 || oy >= size_y_ ) {
+        continue;
+      }
+      for( int x=0; x<size_x_; x++ ) {
+        int ox = x + dx;
+        if( ox < 0 || ox >= size_x_ ) {
+          continue;
+        }
+        int c = y * size_x_ + x;
+        int old = oy * size_x_ + ox;
+        costs[c] = costs_[old];
+        seeds[c] = seeds_[old];
+        dist[c] = dist_[old];
+        int p = parent_[old];
+        if( p >= 0 ) {
+          int px = p % size_x_ - dx;
+          int py = p / size_x_ - dy;
+          if( px >= 0 && py >= 0 && px < size_x_ && py < size_y_ ) {
+            parent[c] = py * size_x_ + px;
+          } else {
+            // our route to the goal scrolled out of the window
+            roots_.push_back(c);
+          }
+        }
+      }
+    }
+    costs_.swap(costs);
+    seeds_.swap(seeds);
+    dist_.swap(dist);
+    parent_.swap(parent);
+    return true;
+  }
+
+  void CostToGoField::invalidate(std::vector<int> &roots) {
+    invalid_cells_.clear();
+    for( int i=0; i<roots.size(); i++ ) {
+      int c = roots[i];
+      if( ! invalid_[c] ) {
+        invalid_[c] = 1;
+        invalid_cells_.push_back(c);
+      }
+    }
+    // everything downstream of an invalid cell is invalid too
+    for( int i=0; i<invalid_cells_.size(); i++ ) {
+      int c = invalid_cells_[i];
+      dist_[c] = INF;
+      int cx = c % size_x_;
+      int cy = c / size_x_;
+      for( int k=0; k<NEIGHBORS; k++ ) {
+        int x = cx + DX[k];
+        int y = cy + DY[k];
+        if( x < 0 || y < 0 || x >= size_x_ || y >= size_y_ ) {
+          continue;
+        }
+        int n = y * size_x_ + x;
+        if( parent_[n] == c && ! invalid_[n] ) {
+          invalid_[n] = 1;
+          invalid_cells_.push_back(n);
+        }
+      }
+      parent_[c] = -1;
+    }
+  }
+
+  void CostToGoField::reseed(int cell) {
+    float t = traversal(costs_[cell]);
+    if( t == INF ) {
+      return;
+    }
+    float best = seeds_[cell];
+    int best_parent = -1;
+    int cx = cell % size_x_;
+    int cy = cell / size_x_;
+    for( int k=0; k<NEIGHBORS; k++ ) {
+      int x = cx + DX[k];
+      int y = cy + DY[k];
+      if( x < 0 || y < 0 || x >= size_x_ || y >= size_y_ ) {
+        continue;
+      }
+      int n = y * size_x_ + x;
+      float d = dist_[n] + STEP[k] * resolution_ * t;
+      if( d < best ) {
+        best = d;
+        best_parent = n;
+      }
+    }
+    if( best < dist_[cell] ) {
+      dist_[cell] = best;
+      parent_[cell] = best_parent;
+      push(cell, best);
+    }
+  }
+
+  void CostToGoField::update(const CostGrid &costmap) {
+    updated_cells_ = 0;
+    if( plan_changed_ ||
+        size_x_ != costmap.getSizeInCellsX() ||
+        size_y_ != costmap.getSizeInCellsY() ||
+        resolution_ != costmap.getResolution() ) {
+      reset(costmap);
+      plan_changed_ = false;
+      return;
+    }
+
+    roots_.clear();
+    decreased_.clear();
+    if( origin_x_ != costmap.getOriginX() ||
+        origin_y_ != costmap.getOriginY() ) {
+      if( ! shift(costmap) ) {
+        reset(costmap);
+        return;
+      }
+    }
+
+    // find the cells that got more or less expensive to reach the goal
+    // through
+    computeSeeds(new_seeds_);
+    const unsigned char* map = costmap.getCharMap();
+    const int size = size_x_ * size_y_;
+    for( int c=0; c<size; c++ ) {
+      float old_t = traversal(costs_[c]);
+      float new_t = traversal(map[c]);
+      if( new_t > old_t || new_seeds_[c] > seeds_[c] ) {
+        roots_.push_back(c);
+      } else if( new_t < old_t || new_seeds_[c] < seeds_[c] ) {
+        decreased_.push_back(c);
+      }
+      costs_[c] = map[c];
+    }
+    seeds_.swap(new_seeds_);
+
+    // cells that got more expensive, and everything that was reached
+    // through them, are recomputed from their valid neighbours
+    invalidate(roots_);
+    for( int i=0; i<invalid_cells_.size(); i++ ) {
+      reseed(invalid_cells_[i]);
+    }
+    for( int i=0; i<invalid_cells_.size(); i++ ) {
+      invalid_[invalid_cells_[i]] = 0;
+    }
+    // cells that got cheaper can only lower the field
+    for( int i=0; i<decreased_.size(); i++ ) {
+      reseed(decreased_[i]);
+    }
+    propagate();
+  }
+};
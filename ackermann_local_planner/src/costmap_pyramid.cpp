@@ -0,0 +1,519 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/costmap_pyramid.h>
+#include <ackermann_local_planner/cell_traversal.h>
+
+#include <cmath>
+#include <algorithm>
+
+
+namespace ackermann_local_planner {
+
+  // turns tighter than this (1/m) are arcs; the rest are lines
+  static const double MIN_CURVATURE = 1e-6;
+
+  // origin moves within this fraction of a cell count as whole cells
+  static const double SHIFT_TOLERANCE = 1e-3;
+
+  // index of the cell of a level l that contains cell a of level 0, rounding
+  // towards negative infinity
+  static inline int coarsen(int a, int l) {
+    return a >= 0 ? a >> l : -((-a + (1 << l) - 1) >> l);
+  }
+
+  static inline unsigned char poolCost(unsigned char cost) {
+    return cost == NO_INFORMATION ? FREE_SPACE : cost;
+  }
+
+  CostmapPyramid::CostmapPyramid() : resolution_(0), origin_x_(0),
+    origin_y_(0), cell_x_(0), cell_y_(0), updated_cells_(0) {
+  }
+
+  void CostmapPyramid::update(const CostGrid &costmap) {
+    const int size_x = costmap.getSizeInCellsX();
+    const int size_y = costmap.getSizeInCellsY();
+    const double resolution = costmap.getResolution();
+    const double origin_x = costmap.getOriginX();
+    const double origin_y = costmap.getOriginY();
+
+    for( int l=0; l<LEVELS; l++ ) {
+      Level & level = levels_[l];
+      level.dirty_lo.assign(level.size_y, level.size_x);
+      level.dirty_hi.assign(level.size_y, -1);
+    }
+    updated_cells_ = 0;
+
+    bool rebuild = levels_[0].cost.empty() || size_x != levels_[0].size_x ||
+      size_y != levels_[0].size_y || resolution != resolution_;
+    int dx = 0, dy = 0;
+    if( ! rebuild ) {
+      double fx = (origin_x - origin_x_) / resolution;
+      double fy = (origin_y - origin_y_) / resolution;
+      dx = floor(fx + 0.5);
+      dy = floor(fy + 0.5);
+      rebuild = fabs(fx - dx) > SHIFT_TOLERANCE ||
+        fabs(fy - dy) > SHIFT_TOLERANCE;
+    }
+    resolution_ = resolution;
+    origin_x_ = origin_x;
+    origin_y_ = origin_y;
+
+    const bool shifted = ! rebuild && (dx != 0 || dy != 0);
+    if( rebuild ) {
+      cell_x_ = 0;
+      cell_y_ = 0;
+      resize(size_x, size_y);
+    } else if( shifted ) {
+      shift(dx, dy);
+    }
+
+    // copy the cells that changed
+    Level & base = levels_[0];
+    const unsigned char * charmap = costmap.getCharMap();
+    for( int y=0; y<size_y; y++ ) {
+      const unsigned char * row = charmap + y * size_x;
+      unsigned char * copy = &base.cost[y * size_x];
+      for( int x=0; x<size_x; x++ ) {
+        unsigned char cost = poolCost(row[x]);
+        if( cost != copy[x] ) {
+          copy[x] = cost;
+          markDirty(0, x, y);
+        }
+      }
+    }
+
+    // coarse cells along the edges of the window may have gained or lost
+    // cells under them when it scrolled
+    propagate(shifted);
+  }
+
+  void CostmapPyramid::resize(int size_x, int size_y) {
+    for( int l=0; l<LEVELS; l++ ) {
+      Level & level = levels_[l];
+      level.base_x = coarsen(cell_x_, l);
+      level.base_y = coarsen(cell_y_, l);
+      level.size_x = coarsen(cell_x_ + size_x - 1, l) - level.base_x + 1;
+      level.size_y = coarsen(cell_y_ + size_y - 1, l) - level.base_y + 1;
+      level.cost.assign(level.size_x * level.size_y, FREE_SPACE);
+      level.dirty_lo.assign(level.size_y, level.size_x);
+      level.dirty_hi.assign(level.size_y, -1);
+    }
+    // everything is new
+    Level & base = levels_[0];
+    base.dirty_lo.assign(base.size_y, 0);
+    base.dirty_hi.assign(base.size_y, base.size_x - 1);
+  }
+
+  void CostmapPyramid::shift(int dx, int dy) {
+    const int size_x = levels_[0].size_x;
+    const int size_y = levels_[0].size_y;
+    cell_x_ += dx;
+    cell_y_ += dy;
+
+    // keep the cells that are still in the window, by world index
+    for( int l=0; l<LEVELS; l++ ) {
+      Level & level = levels_[l];
+      const int old_base_x = level.base_x;
+      const int old_base_y = level.base_y;
+      const int old_size_x = level.size_x;
+      const int old_size_y = level.size_y;
+      std::vector<unsigned char> old_cost;
+      old_cost.swap(level.cost);
+
+      level.base_x = coarsen(cell_x_, l);
+      level.base_y = coarsen(cell_y_, l);
+      level.size_x = coarsen(cell_x_ + size_x - 1, l) - level.base_x + 1;
+      level.size_y = coarsen(cell_y_ + size_y - 1, l) - level.base_y + 1;
+      level.cost.assign(level.size_x * level.size_y, FREE_SPACE);
+      level.dirty_lo.assign(level.size_y, level.size_x);
+      level.dirty_hi.assign(level.size_y, -1);
+
+      for( int y=0; y<level.size_y; y++ ) {
+        const int oy = y + level.base_y - old_base_y;
+        if( oy < 0 || oy >= old_size_y ) {
+          continue;
+        }
+        for( int x=0; x<level.size_x; x++ ) {
+          const int ox = x + level.base_x - old_base_x;
+          if( ox >= 0 && ox < old_size_x ) {
+            level.cost[y * level.size_x + x] = old_cost[oy * old_size_x + ox];
+          }
+        }
+      }
+    }
+
+    // the cells that scrolled in are new
+    for( int y=0; y<size_y; y++ ) {
+      const int oy = y + dy;
+      if( oy < 0 || oy >= size_y ) {
+        markDirty(0, 0, y);
+        markDirty(0, size_x - 1, y);
+      } else if( dx > 0 ) {
+        markDirty(0, std::max(0, size_x - dx), y);
+        markDirty(0, size_x - 1, y);
+      } else if( dx < 0 ) {
+        markDirty(0, 0, y);
+        markDirty(0, std::min(size_x - 1, -dx - 1), y);
+      }
+    }
+  }
+
+  void CostmapPyramid::markDirty(int l, int x, int y) {
+    Level & level = levels_[l];
+    level.dirty_lo[y] = std::min(level.dirty_lo[y], x);
+    level.dirty_hi[y] = std::max(level.dirty_hi[y], x);
+  }
+
+  void CostmapPyramid::poolCell(int l, int cx, int cy) {
+    const Level & fine = levels_[l-1];
+    Level & level = levels_[l];
+    const int fx0 = std::max(0, 2 * (cx + level.base_x) - fine.base_x);
+    const int fy0 = std::max(0, 2 * (cy + level.base_y) - fine.base_y);
+    const int fx1 = std::min(fine.size_x - 1,
+        2 * (cx + level.base_x) + 1 - fine.base_x);
+    const int fy1 = std::min(fine.size_y - 1,
+        2 * (cy + level.base_y) + 1 - fine.base_y);
+    unsigned char cost = 0;
+    for( int fy=fy0; fy<=fy1; fy++ ) {
+      for( int fx=fx0; fx<=fx1; fx++ ) {
+        cost = std::max(cost, fine.cost[fy * fine.size_x + fx]);
+      }
+    }
+    level.cost[cy * level.size_x + cx] = cost;
+    updated_cells_++;
+  }
+
+  void CostmapPyramid::propagate(bool edges) {
+    for( int y=0; y<levels_[0].size_y; y++ ) {
+      updated_cells_ += std::max(0, levels_[0].dirty_hi[y] -
+          levels_[0].dirty_lo[y] + 1);
+    }
+
+    for( int l=1; l<LEVELS; l++ ) {
+      const Level & fine = levels_[l-1];
+      Level & level = levels_[l];
+
+      for( int y=0; y<fine.size_y; y++ ) {
+        if( fine.dirty_lo[y] > fine.dirty_hi[y] ) {
+          continue;
+        }
+        const int cy = coarsen(y + fine.base_y, 1) - level.base_y;
+        markDirty(l, coarsen(fine.dirty_lo[y] + fine.base_x, 1) -
+            level.base_x, cy);
+        markDirty(l, coarsen(fine.dirty_hi[y] + fine.base_x, 1) -
+            level.base_x, cy);
+      }
+
+      if( edges ) {
+        markDirty(l, 0, 0);
+        markDirty(l, level.size_x - 1, 0);
+        markDirty(l, 0, level.size_y - 1);
+        markDirty(l, level.size_x - 1, level.size_y - 1);
+      }
+
+      for( int cy=0; cy<level.size_y; cy++ ) {
+        for( int cx=level.dirty_lo[cy]; cx<=level.dirty_hi[cy]; cx++ ) {
+          poolCell(l, cx, cy);
+        }
+        if( edges && level.dirty_lo[cy] > 0 ) {
+          poolCell(l, 0, cy);
+        }
+        if( edges && level.dirty_hi[cy] < level.size_x - 1 ) {
+          poolCell(l, level.size_x - 1, cy);
+        }
+      }
+    }
+  }
+
+  unsigned char CostmapPyramid::levelCost(int l, int mx, int my) const {
+    const Level & level = levels_[l];
+    const int cx = coarsen(mx + cell_x_, l) - level.base_x;
+    const int cy = coarsen(my + cell_y_, l) - level.base_y;
+    return level.cost[cy * level.size_x + cx];
+  }
+
+  bool CostmapPyramid::discFree(double wx, double wy, double radius,
+      unsigned char threshold, bool coarse_to_fine) const {
+    const Level & base = levels_[0];
+    if( base.cost.empty() ) {
+      return true;
+    }
+    // in cells of the full resolution level
+    const double u = (wx - origin_x_) / resolution_;
+    const double v = (wy - origin_y_) / resolution_;
+    const double r = radius / resolution_;
+    const double r2 = r * r;
+
+    // the cells with centers that might be inside the disc
+    const int x0 = std::max(0, int(ceil(u - r - 0.5)));
+    const int y0 = std::max(0, int(ceil(v - r - 0.5)));
+    const int x1 = std::min(base.size_x - 1, int(floor(u + r - 0.5)));
+    const int y1 = std::min(base.size_y - 1, int(floor(v + r - 0.5)));
+    if( x0 > x1 || y0 > y1 ) {
+      return true;
+    }
+
+    if( ! coarse_to_fine ) {
+      for( int y=y0; y<=y1; y++ ) {
+        const double ey = y + 0.5 - v;
+        for( int x=x0; x<=x1; x++ ) {
+          const double ex = x + 0.5 - u;
+          if( ex * ex + ey * ey <= r2 &&
+              base.cost[y * base.size_x + x] >= threshold ) {
+            return false;
+          }
+        }
+      }
+      return true;
+    }
+
+    const int top = LEVELS - 1;
+    const Level & level = levels_[top];
+    const int cx0 = coarsen(x0 + cell_x_, top) - level.base_x;
+    const int cy0 = coarsen(y0 + cell_y_, top) - level.base_y;
+    const int cx1 = coarsen(x1 + cell_x_, top) - level.base_x;
+    const int cy1 = coarsen(y1 + cell_y_, top) - level.base_y;
+    for( int cy=cy0; cy<=cy1; cy++ ) {
+      for( int cx=cx0; cx<=cx1; cx++ ) {
+        if( ! nodeFree(top, cx, cy, u, v, r2, threshold) ) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  bool CostmapPyramid::nodeFree(int l, int cx, int cy, double u, double v,
+      double r2, unsigned char threshold) const {
+    const Level & level = levels_[l];
+    if( level.cost[cy * level.size_x + cx] < threshold ) {
+      return true;
+    }
+
+    // the full resolution cells under this one
+    const Level & base = levels_[0];
+    const int span = 1 << l;
+    const int x0 = std::max(0, (cx + level.base_x) * span - cell_x_);
+    const int y0 = std::max(0, (cy + level.base_y) * span - cell_y_);
+    const int x1 = std::min(base.size_x - 1,
+        (cx + level.base_x + 1) * span - 1 - cell_x_);
+    const int y1 = std::min(base.size_y - 1,
+        (cy + level.base_y + 1) * span - 1 - cell_y_);
+
+    // nearest and farthest cell centers
+    const double nx = std::max(x0 + 0.5, std::min(x1 + 0.5, u)) - u;
+    const double ny = std::max(y0 + 0.5, std::min(y1 + 0.5, v)) - v;
+    if( nx * nx + ny * ny > r2 ) {
+      return true;
+    }
+    const double fx = std::max(fabs(x0 + 0.5 - u), fabs(x1 + 0.5 - u));
+    const double fy = std::max(fabs(y0 + 0.5 - v), fabs(y1 + 0.5 - v));
+    if( fx * fx + fy * fy <= r2 || l == 0 ) {
+      // every cell is in the disc, and one of them is over the threshold
+      return false;
+    }
+
+    const Level & fine = levels_[l-1];
+    const int fx0 = std::max(0, 2 * (cx + level.base_x) - fine.base_x);
+    const int fy0 = std::max(0, 2 * (cy + level.base_y) - fine.base_y);
+    const int fx1 = std::min(fine.size_x - 1,
+        2 * (cx + level.base_x) + 1 - fine.base_x);
+    const int fy1 = std::min(fine.size_y - 1,
+        2 * (cy + level.base_y) + 1 - fine.base_y);
+    for( int fy=fy0; fy<=fy1; fy++ ) {
+      for( int fx=fx0; fx<=fx1; fx++ ) {
+        if( ! nodeFree(l-1, fx, fy, u, v, r2, threshold) ) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  bool CostmapPyramid::boxFree(const dubins_plus::Bounds &box,
+      unsigned char threshold) const {
+    const Level & base = levels_[0];
+    if( base.cost.empty() || box.empty() ) {
+      return true;
+    }
+    // the cells with centers inside the box
+    const int x0 = std::max(0,
+        int(ceil((box.min_x - origin_x_) / resolution_ - 0.5)));
+    const int y0 = std::max(0,
+        int(ceil((box.min_y - origin_y_) / resolution_ - 0.5)));
+    const int x1 = std::min(base.size_x - 1,
+        int(floor((box.max_x - origin_x_) / resolution_ - 0.5)));
+    const int y1 = std::min(base.size_y - 1,
+        int(floor((box.max_y - origin_y_) / resolution_ - 0.5)));
+    if( x0 > x1 || y0 > y1 ) {
+      return true;
+    }
+
+    const int top = LEVELS - 1;
+    const Level & level = levels_[top];
+    const int cx0 = coarsen(x0 + cell_x_, top) - level.base_x;
+    const int cy0 = coarsen(y0 + cell_y_, top) - level.base_y;
+    const int cx1 = coarsen(x1 + cell_x_, top) - level.base_x;
+    const int cy1 = coarsen(y1 + cell_y_, top) - level.base_y;
+    for( int cy=cy0; cy<=cy1; cy++ ) {
+      for( int cx=cx0; cx<=cx1; cx++ ) {
+        if( ! boxNodeFree(top, cx, cy, x0, y0, x1, y1, threshold) ) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  bool CostmapPyramid::boxNodeFree(int l, int cx, int cy, int x0, int y0,
+      int x1, int y1, unsigned char threshold) const {
+    const Level & level = levels_[l];
+    if( level.cost[cy * level.size_x + cx] < threshold ) {
+      return true;
+    }
+    // the full resolution cells under this one
+    const int span = 1 << l;
+    const int nx0 = (cx + level.base_x) * span - cell_x_;
+    const int ny0 = (cy + level.base_y) * span - cell_y_;
+    if( nx0 + span - 1 < x0 || nx0 > x1 || ny0 + span - 1 < y0 ||
+        ny0 > y1 ) {
+      return true;
+    }
+    if( l == 0 ) {
+      return false;
+    }
+
+    const Level & fine = levels_[l-1];
+    const int fx0 = std::max(0, 2 * (cx + level.base_x) - fine.base_x);
+    const int fy0 = std::max(0, 2 * (cy + level.base_y) - fine.base_y);
+    const int fx1 = std::min(fine.size_x - 1,
+        2 * (cx + level.base_x) + 1 - fine.base_x);
+    const int fy1 = std::min(fine.size_y - 1,
+        2 * (cy + level.base_y) + 1 - fine.base_y);
+    for( int fy=fy0; fy<=fy1; fy++ ) {
+      for( int fx=fx0; fx<=fx1; fx++ ) {
+        if( ! boxNodeFree(l-1, fx, fy, x0, y0, x1, y1, threshold) ) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  bool CostmapPyramid::pathClear(
+      const std::vector<dubins_plus::Segment> &path,
+      double x, double y, double theta, const std::vector<Disc> &discs,
+      unsigned char threshold, bool coarse_to_fine) const {
+    if( levels_[0].cost.empty() ) {
+      return true;
+    }
+    for( int i=0; i<path.size(); i++ ) {
+      const double length = path[i].getLength();
+      if( length <= 0 ) {
+        continue;
+      }
+      const int steps = std::max(1, int(ceil(length / resolution_)));
+      // the first pose of each segment is the last pose of the one before
+      for( int k=(i == 0 ? 0 : 1); k<=steps; k++ ) {
+        double px = x, py = y, ptheta = theta;
+        dubins_plus::advance(dubins_plus::Segment(length * k / steps,
+              path[i].getCurvature()), px, py, ptheta);
+        const double c = cos(ptheta);
+        const double s = sin(ptheta);
+        for( int j=0; j<discs.size(); j++ ) {
+          if( ! discFree(px + c * discs[j].x - s * discs[j].y,
+                py + s * discs[j].x + c * discs[j].y, discs[j].radius,
+                threshold, coarse_to_fine) ) {
+            return false;
+          }
+        }
+      }
+      dubins_plus::advance(path[i], x, y, theta);
+    }
+    return true;
+  }
+
+  bool CostmapPyramid::traversalClear(
+      const std::vector<dubins_plus::Segment> &path,
+      double x, double y, double theta, const std::vector<Disc> &discs,
+      const std::vector<unsigned char> &thresholds) const {
+    const Level & base = levels_[0];
+    if( base.cost.empty() ) {
+      return true;
+    }
+    for( int i=0; i<path.size(); i++ ) {
+      const double length = path[i].getLength();
+      if( length <= 0 ) {
+        continue;
+      }
+      const double curvature = path[i].getCurvature();
+      const double c = cos(theta);
+      const double s = sin(theta);
+      for( int j=0; j<discs.size(); j++ ) {
+        const double dx = x + c * discs[j].x - s * discs[j].y;
+        const double dy = y + s * discs[j].x + c * discs[j].y;
+        // a disc off the robot's axis turns about the same center as the
+        // robot, on a circle of its own radius
+        double d_theta = theta;
+        double d_length = length;
+        double d_curvature = 0;
+        if( fabs(curvature) > MIN_CURVATURE ) {
+          const double rx = dx - (x - s / curvature);
+          const double ry = dy - (y + c / curvature);
+          const double rho = hypot(rx, ry);
+          const double sign = curvature > 0 ? 1 : -1;
+          d_theta = atan2(sign * rx, -sign * ry);
+          d_length = rho * fabs(curvature) * length;
+          d_curvature = rho > 0 ? sign / rho : 0;
+        }
+        CellTraversal cells((dx - origin_x_) / resolution_,
+            (dy - origin_y_) / resolution_, d_theta, d_length / resolution_,
+            d_curvature * resolution_);
+        int cx, cy;
+        while( cells.next(cx, cy) ) {
+          if( cx >= 0 && cy >= 0 && cx < base.size_x && cy < base.size_y &&
+              base.cost[cy * base.size_x + cx] >= thresholds[j] ) {
+            return false;
+          }
+        }
+      }
+      dubins_plus::advance(path[i], x, y, theta);
+    }
+    return true;
+  }
+};
@@ -0,0 +1,225 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/escape_recovery.h>
+#include <ackermann_local_planner/ros_conversions.h>
+
+#include <cmath>
+
+#include <ros/console.h>
+#include <pluginlib/class_list_macros.h>
+#include <geometry_msgs/Twist.h>
+
+//register this behavior as a RecoveryBehavior plugin
+PLUGINLIB_EXPORT_CLASS(ackermann_local_planner::EscapeRecovery, nav_core::RecoveryBehavior)
+
+namespace ackermann_local_planner {
+
+  EscapeRecovery::EscapeRecovery() : initialized_(false),
+    local_costmap_(NULL) {
+  }
+
+  void EscapeRecovery::initialize(std::string name,
+      tf::TransformListener *tf, costmap_2d::Costmap2DROS *global_costmap,
+      costmap_2d::Costmap2DROS *local_costmap) {
+    if( initialized_ ) {
+      ROS_WARN_NAMED("escape_recovery", "This recovery behavior has already "
+          "been initialized; doing nothing");
+      return;
+    }
+    name_ = name;
+    local_costmap_ = local_costmap;
+
+    ros::NodeHandle private_nh("~/" + name);
+    EscapeSearchOptions options;
+    // the same turning radius as the local planner, unless told otherwise
+    std::string planner_namespace;
+    private_nh.param("planner_namespace", planner_namespace,
+        std::string("AckermannPlannerROS"));
+    ros::NodeHandle planner_nh("~/" + planner_namespace);
+    planner_nh.param("min_radius", options.min_radius, options.min_radius);
+    private_nh.param("min_radius", options.min_radius, options.min_radius);
+    private_nh.param("max_segments", options.max_segments,
+        options.max_segments);
+    private_nh.param("min_segment_length", options.min_segment_length,
+        options.min_segment_length);
+    private_nh.param("max_segment_length", options.max_segment_length,
+        options.max_segment_length);
+    private_nh.param("length_samples", options.length_samples,
+        options.length_samples);
+    private_nh.param("reverse_penalty", options.reverse_penalty,
+        options.reverse_penalty);
+    private_nh.param("clear_distance", options.clear_distance,
+        options.clear_distance);
+    private_nh.param("search_time", options.search_time,
+        options.search_time);
+    private_nh.param("speed", speed_, 0.3);
+    private_nh.param("frequency", frequency_, 20.0);
+    search_.setOptions(options);
+    search_.setFootprint(toPoint2D(local_costmap_->getRobotFootprint()));
+
+    ros::NodeHandle n;
+    vel_pub_ = n.advertise<geometry_msgs::Twist>("cmd_vel", 10);
+    initialized_ = true;
+  }
+
+  bool EscapeRecovery::getRobotPose(double &x, double &y, double &theta) {
+    tf::Stamped<tf::Pose> pose;
+    if( ! local_costmap_->getRobotPose(pose) ) {
+      return false;
+    }
+    x = pose.getOrigin().x();
+    y = pose.getOrigin().y();
+    theta = tf::getYaw(pose.getRotation());
+    return true;
+  }
+
+  void EscapeRecovery::updateCostmap() {
+    costmap_2d::Costmap2D *costmap = local_costmap_->getCostmap();
+    boost::unique_lock<costmap_2d::Costmap2D::mutex_t>
+      lock(*(costmap->getMutex()));
+    search_.updateCostmap(toCostGrid(*costmap));
+  }
+
+  bool EscapeRecovery::search(double x, double y, double theta,
+      std::vector<dubins_plus::Segment> &maneuver) {
+    const ros::WallTime start_time = ros::WallTime::now();
+    updateCostmap();
+    const bool found = search_.search(x, y, theta, maneuver);
+    if( search_.timedOut() ) {
+      ROS_WARN_NAMED("escape_recovery", "Ran out of time after %d "
+          "maneuvers", search_.expanded());
+    }
+    if( ! found ) {
+      if( search_.ahead() >= search_.options().clear_distance ) {
+        ROS_INFO_NAMED("escape_recovery", "Already clear ahead");
+      }
+      return false;
+    }
+    ROS_INFO_NAMED("escape_recovery", "Found a %zd point maneuver with %f m "
+        "free ahead in %f s, after %d maneuvers", maneuver.size(),
+        search_.ahead(), (ros::WallTime::now() - start_time).toSec(),
+        search_.expanded());
+    return true;
+  }
+
+  void EscapeRecovery::stop() {
+    geometry_msgs::Twist cmd_vel;
+    cmd_vel.linear.x = 0;
+    cmd_vel.angular.z = 0;
+    vel_pub_.publish(cmd_vel);
+  }
+
+  bool EscapeRecovery::drive(const dubins_plus::Segment &segment) {
+    const double length = fabs(segment.getLength());
+    const double direction = segment.getLength() >= 0 ? 1 : -1;
+    const double timeout = 2 * length / speed_ + 1.0;
+    double x, y, theta;
+    if( ! getRobotPose(x, y, theta) ) {
+      return false;
+    }
+
+    ros::Rate rate(frequency_);
+    const ros::WallTime start_time = ros::WallTime::now();
+    double traveled = 0;
+    while( ros::ok() && traveled < length ) {
+      if( (ros::WallTime::now() - start_time).toSec() > timeout ) {
+        ROS_WARN_NAMED("escape_recovery", "Timed out after %f of %f m",
+            traveled, length);
+        stop();
+        return false;
+      }
+      // the costmap may have changed since the search
+      updateCostmap();
+      if( ! search_.segmentClear(dubins_plus::Segment(
+              direction * (length - traveled),
+              segment.getCurvature()), x, y, theta) ) {
+        ROS_WARN_NAMED("escape_recovery", "Maneuver is blocked after %f of "
+            "%f m", traveled, length);
+        stop();
+        return false;
+      }
+
+      // the same convention as the planner: curvature times the speed,
+      // whichever way we're going
+      geometry_msgs::Twist cmd_vel;
+      cmd_vel.linear.x = direction * speed_;
+      cmd_vel.angular.z = segment.getCurvature() * speed_;
+      vel_pub_.publish(cmd_vel);
+      rate.sleep();
+
+      double nx, ny, ntheta;
+      if( ! getRobotPose(nx, ny, ntheta) ) {
+        stop();
+        return false;
+      }
+      traveled += hypot(nx - x, ny - y);
+      x = nx;
+      y = ny;
+      theta = ntheta;
+    }
+    stop();
+    return true;
+  }
+
+  void EscapeRecovery::runBehavior() {
+    if( ! initialized_ ) {
+      ROS_ERROR_NAMED("escape_recovery", "This recovery behavior has not "
+          "been initialized");
+      return;
+    }
+    ROS_WARN_NAMED("escape_recovery", "Searching for a way out");
+
+    double x, y, theta;
+    if( ! getRobotPose(x, y, theta) ) {
+      ROS_ERROR_NAMED("escape_recovery", "Could not get the robot pose");
+      return;
+    }
+    std::vector<dubins_plus::Segment> maneuver;
+    if( ! search(x, y, theta, maneuver) ) {
+      ROS_WARN_NAMED("escape_recovery", "No maneuver makes any room");
+      return;
+    }
+    for( int i=0; i<maneuver.size(); i++ ) {
+      ROS_INFO_NAMED("escape_recovery", "Segment %d: %f m, curvature %f", i,
+          maneuver[i].getLength(), maneuver[i].getCurvature());
+      if( ! drive(maneuver[i]) ) {
+        return;
+      }
+    }
+  }
+};
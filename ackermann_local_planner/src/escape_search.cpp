@@ -0,0 +1,260 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/escape_search.h>
+
+#include <stdint.h>
+#include <time.h>
+#include <cmath>
+#include <algorithm>
+#include <queue>
+#include <set>
+#include <functional>
+
+namespace ackermann_local_planner {
+
+  // a maneuver in the search; the segment that ends at a pose, and how it
+  // was reached
+  struct EscapeNode {
+    double x;
+    double y;
+    double theta;
+    double length;      // signed; negative in reverse
+    double curvature;
+    double cost;
+    double ahead;       // free space straight ahead at the end
+    int parent;
+    int depth;
+  };
+
+  static double seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+  }
+
+  EscapeSearchOptions::EscapeSearchOptions() :
+    min_radius(0.7),
+    max_segments(5),
+    min_segment_length(0.25),
+    max_segment_length(1.0),
+    length_samples(3),
+    reverse_penalty(0.5),
+    clear_distance(1.0),
+    search_time(0.3) {
+  }
+
+  EscapeSearch::EscapeSearch() : expanded_(0), timed_out_(false),
+    ahead_(0) {
+  }
+
+  void EscapeSearch::setOptions(const EscapeSearchOptions &options) {
+    options_ = options;
+    options_.length_samples = std::max(options_.length_samples, 1);
+  }
+
+  void EscapeSearch::setFootprint(const std::vector<Point2D> &footprint) {
+    // the robot as discs, the same as the planner
+    forward_discs_ = coverFootprint(footprint);
+    reverse_discs_ = forward_discs_;
+    for( int i=0; i<reverse_discs_.size(); i++ ) {
+      reverse_discs_[i].x = -reverse_discs_[i].x;
+      reverse_discs_[i].y = -reverse_discs_[i].y;
+    }
+  }
+
+  void EscapeSearch::updateCostmap(const CostGrid &costmap) {
+    costmap_pyramid_.update(costmap);
+  }
+
+  bool EscapeSearch::segmentClear(const dubins_plus::Segment &segment,
+      double x, double y, double theta) const {
+    // driving backwards, check as if facing the other way, like the planner
+    const bool forward = segment.getLength() >= 0;
+    std::vector<dubins_plus::Segment> path(1, dubins_plus::Segment(
+          fabs(segment.getLength()), segment.getCurvature()));
+    return costmap_pyramid_.pathClear(path, x, y,
+        forward ? theta : theta + M_PI,
+        forward ? forward_discs_ : reverse_discs_,
+        LETHAL_OBSTACLE, true);
+  }
+
+  double EscapeSearch::freeAhead(double x, double y, double theta) const {
+    // in quarters of clear_distance, straight ahead and at full lock either
+    // way, so that the planner has room to steer
+    const double k = 1 / options_.min_radius;
+    double ahead = 0;
+    for( int i=1; i<=4; i++ ) {
+      const double d = options_.clear_distance * i / 4;
+      if( ! segmentClear(dubins_plus::Segment(d, 0), x, y, theta) ||
+          ! segmentClear(dubins_plus::Segment(d, k), x, y, theta) ||
+          ! segmentClear(dubins_plus::Segment(d, -k), x, y, theta) ) {
+        break;
+      }
+      ahead = d;
+    }
+    return ahead;
+  }
+
+  bool EscapeSearch::search(double x, double y, double theta,
+      std::vector<dubins_plus::Segment> &maneuver) {
+    typedef std::pair<double, int> Entry;
+    maneuver.clear();
+    const double start_time = seconds();
+    timed_out_ = false;
+
+    std::vector<EscapeNode> nodes;
+    EscapeNode root;
+    root.x = x;
+    root.y = y;
+    root.theta = theta;
+    root.length = 0;
+    root.curvature = 0;
+    root.cost = 0;
+    root.ahead = freeAhead(x, y, theta);
+    root.parent = -1;
+    root.depth = 0;
+    nodes.push_back(root);
+    expanded_ = 1;
+    ahead_ = root.ahead;
+    if( root.ahead >= options_.clear_distance ) {
+      return false;
+    }
+
+    // poses already reached, to half the shortest segment and a sixteenth
+    // of a turn
+    const double cell = options_.min_segment_length / 2;
+    std::set<int64_t> visited;
+
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > open;
+    open.push(Entry(0, 0));
+    int found = -1;
+    int best = 0;
+    const double k = 1 / options_.min_radius;
+    const int samples = options_.length_samples;
+    while( ! open.empty() ) {
+      if( seconds() - start_time > options_.search_time ) {
+        timed_out_ = true;
+        break;
+      }
+      const int node = open.top().second;
+      open.pop();
+      if( node != 0 && nodes[node].ahead >= options_.clear_distance ) {
+        found = node;
+        break;
+      }
+      if( nodes[node].depth >= options_.max_segments ) {
+        continue;
+      }
+
+      for( int direction = 1; direction >= -1; direction -= 2 ) {
+        for( int turn = -1; turn <= 1; turn++ ) {
+          // a copy; adding nodes may move them
+          const EscapeNode from = nodes[node];
+          // more of the same is a longer segment, which is sampled anyway
+          if( from.depth > 0 && (from.length > 0) == (direction > 0) &&
+              from.curvature == turn * k ) {
+            continue;
+          }
+          for( int s=0; s<samples; s++ ) {
+            const double length = samples > 1 ?
+              options_.min_segment_length + (options_.max_segment_length -
+                  options_.min_segment_length) * s / (samples - 1) :
+              options_.max_segment_length;
+            const dubins_plus::Segment segment(direction * length, turn * k);
+
+            EscapeNode next;
+            next.x = from.x;
+            next.y = from.y;
+            next.theta = direction > 0 ? from.theta : from.theta + M_PI;
+            dubins_plus::advance(dubins_plus::Segment(length, turn * k),
+                next.x, next.y, next.theta);
+            if( direction < 0 ) {
+              next.theta -= M_PI;
+            }
+            next.theta = normalizeAngle(next.theta);
+
+            const int64_t key =
+              (int64_t(floor(next.x / cell) + 32768) << 24) |
+              (int64_t(floor(next.y / cell) + 32768) << 8) |
+              int64_t(floor(next.theta / (M_PI / 8) + 0.5) + 8);
+            if( visited.count(key) ||
+                ! segmentClear(segment, from.x, from.y, from.theta) ) {
+              continue;
+            }
+            visited.insert(key);
+
+            next.length = direction * length;
+            next.curvature = turn * k;
+            next.cost = from.cost + length;
+            if( from.depth > 0 && (from.length > 0) != (direction > 0) ) {
+              next.cost += options_.reverse_penalty;
+            }
+            next.ahead = freeAhead(next.x, next.y, next.theta);
+            next.parent = node;
+            next.depth = from.depth + 1;
+            nodes.push_back(next);
+            const int id = nodes.size() - 1;
+            if( next.ahead > nodes[best].ahead ||
+                (next.ahead == nodes[best].ahead && best != 0 &&
+                 next.cost < nodes[best].cost) ) {
+              best = id;
+            }
+            open.push(Entry(next.cost, id));
+          }
+        }
+      }
+    }
+    expanded_ = nodes.size();
+
+    if( found < 0 ) {
+      // drive towards the most open space we found
+      if( best == 0 ) {
+        return false;
+      }
+      found = best;
+    }
+    for( int node = found; nodes[node].parent >= 0;
+        node = nodes[node].parent ) {
+      maneuver.push_back(dubins_plus::Segment(nodes[node].length,
+            nodes[node].curvature));
+    }
+    std::reverse(maneuver.begin(), maneuver.end());
+    ahead_ = nodes[found].ahead;
+    return true;
+  }
+};
@@ -0,0 +1,219 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/free_arc_table.h>
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+
+namespace ackermann_local_planner {
+
+  FreeArcTable::FreeArcTable() : max_curvature_(0), max_length_(0),
+    step_(0), reach_(0) {
+  }
+
+  void FreeArcTable::reset(double max_curvature, int bins, double max_length,
+      const std::vector<Disc> &discs, double margin) {
+    max_curvature_ = max_curvature;
+    max_length_ = max_length;
+    bins = std::max(bins, 1);
+    step_ = bins > 1 ? 2 * max_curvature / (bins - 1) : 0;
+    lengths_.assign(bins, max_length);
+    discs_ = discs;
+    reach_ = 0;
+    for( int i=0; i<discs_.size(); i++ ) {
+      discs_[i].radius += margin;
+      reach_ = std::max(reach_, hypot(discs_[i].x, discs_[i].y) +
+          discs_[i].radius);
+    }
+  }
+
+  double FreeArcTable::curvature(int bin) const {
+    return lengths_.size() > 1 ? -max_curvature_ + bin * step_ : 0;
+  }
+
+  // arc length the robot drives at curvature k before the disc touches the
+  // point; infinite if it never does
+  double FreeArcTable::contact(double x, double y, const Disc &disc,
+      double k) const {
+    const double r = disc.radius;
+    if( hypot(x - disc.x, y - disc.y) <= r ) {
+      return 0;
+    }
+    if( fabs(k) < 1e-9 ) {
+      const double q = y - disc.y;
+      const double s = (x - disc.x) - sqrt(std::max(r * r - q * q, 0.0));
+      if( fabs(q) > r || s < 0 ) {
+        return std::numeric_limits<double>::infinity();
+      }
+      return s;
+    }
+    // everything turns about (0, R)
+    const double R = 1 / k;
+    const double rd = hypot(disc.x, disc.y - R);
+    const double rho = hypot(x, y - R);
+    const double cos_d = (rd * rd + rho * rho - r * r) / (2 * rd * rho);
+    if( cos_d > 1 ) {
+      return std::numeric_limits<double>::infinity();
+    }
+    const double d = acos(std::max(cos_d, -1.0));
+    const double phi = atan2(disc.y - R, disc.x);
+    const double psi = atan2(y - R, x);
+    // counterclockwise for left turns, clockwise for right turns; contact
+    // is at d before the point's angle
+    double turn = k > 0 ? psi - d - phi : phi - psi - d;
+    turn = fmod(turn, 2 * M_PI);
+    if( turn < 0 ) {
+      turn += 2 * M_PI;
+    }
+    return turn * fabs(R);
+  }
+
+  void FreeArcTable::addBins(double x, double y, const Disc &disc,
+      double k0, double k1) {
+    const int n = lengths_.size();
+    int i0 = 0;
+    int i1 = n - 1;
+    if( n > 1 ) {
+      // one bin of slack either side for rounding; contact() has the final
+      // say
+      i0 = std::max(0, (int)ceil((k0 + max_curvature_) / step_) - 1);
+      i1 = std::min(n - 1, (int)floor((k1 + max_curvature_) / step_) + 1);
+    }
+    for( int i=i0; i<=i1; i++ ) {
+      lengths_[i] = std::min(lengths_[i], contact(x, y, disc, curvature(i)));
+    }
+  }
+
+  void FreeArcTable::addObstacle(double x, double y) {
+    if( hypot(x, y) > max_length_ + reach_ ) {
+      return;
+    }
+    const double lo = -max_curvature_ - step_;
+    const double hi = max_curvature_ + step_;
+    for( int i=0; i<discs_.size(); i++ ) {
+      const Disc &disc = discs_[i];
+      const double a = disc.x;
+      const double b = disc.y;
+      const double r2 = disc.radius * disc.radius;
+      // the disc center circles at distance rd from the turn center, and
+      // the point is at rho; it is hit if |rho - rd| <= r. Squared out and
+      // multiplied through by k^2, that is A k^2 + B k + C <= 0
+      const double q = y - b;
+      const double c = x * x + y * y - a * a - b * b - r2;
+      const double A = c * c - 4 * r2 * (a * a + b * b);
+      const double B = -4 * q * c + 8 * r2 * b;
+      const double C = 4 * (q * q - r2);
+      const double eps = 1e-12;
+      if( fabs(A) < eps ) {
+        if( fabs(B) < eps ) {
+          if( C <= 0 ) {
+            addBins(x, y, disc, lo, hi);
+          }
+        } else if( B > 0 ) {
+          addBins(x, y, disc, lo, std::min(hi, -C / B));
+        } else {
+          addBins(x, y, disc, std::max(lo, -C / B), hi);
+        }
+        continue;
+      }
+      const double disc_b = B * B - 4 * A * C;
+      if( disc_b < 0 ) {
+        if( A < 0 ) {
+          addBins(x, y, disc, lo, hi);
+        }
+        continue;
+      }
+      const double root = sqrt(disc_b);
+      const double k1 = std::min((-B - root) / (2 * A), (-B + root) / (2 * A));
+      const double k2 = std::max((-B - root) / (2 * A), (-B + root) / (2 * A));
+      if( A > 0 ) {
+        if( k2 >= lo && k1 <= hi ) {
+          addBins(x, y, disc, std::max(lo, k1), std::min(hi, k2));
+        }
+      } else {
+        if( k1 >= lo ) {
+          addBins(x, y, disc, lo, std::min(hi, k1));
+        }
+        if( k2 <= hi ) {
+          addBins(x, y, disc, std::max(lo, k2), hi);
+        }
+      }
+    }
+  }
+
+  void FreeArcTable::addCostmap(const CostGrid &costmap,
+      double x, double y, double theta, unsigned char threshold) {
+    const double range = max_length_ + reach_;
+    const double res = costmap.getResolution();
+    const int size_x = costmap.getSizeInCellsX();
+    const int size_y = costmap.getSizeInCellsY();
+    const double ox = costmap.getOriginX();
+    const double oy = costmap.getOriginY();
+    const int x0 = std::max(0, (int)floor((x - range - ox) / res));
+    const int x1 = std::min(size_x - 1, (int)floor((x + range - ox) / res));
+    const int y0 = std::max(0, (int)floor((y - range - oy) / res));
+    const int y1 = std::min(size_y - 1, (int)floor((y + range - oy) / res));
+    const unsigned char *map = costmap.getCharMap();
+    const double c = cos(theta);
+    const double s = sin(theta);
+    for( int my=y0; my<=y1; my++ ) {
+      for( int mx=x0; mx<=x1; mx++ ) {
+        const unsigned char cost = map[my * size_x + mx];
+        if( cost < threshold || cost == NO_INFORMATION ) {
+          continue;
+        }
+        const double dx = ox + (mx + 0.5) * res - x;
+        const double dy = oy + (my + 0.5) * res - y;
+        addObstacle(c * dx + s * dy, c * dy - s * dx);
+      }
+    }
+  }
+
+  double FreeArcTable::freeLength(double curvature) const {
+    const int n = lengths_.size();
+    if( n == 1 ) {
+      return lengths_[0];
+    }
+    const double t = (curvature + max_curvature_) / step_;
+    const int i = std::max(0, std::min(n - 1, (int)floor(t)));
+    const int j = std::max(0, std::min(n - 1, (int)ceil(t)));
+    return std::min(lengths_[i], lengths_[j]);
+  }
+};
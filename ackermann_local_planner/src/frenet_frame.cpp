@@ -0,0 +1,131 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/frenet_frame.h>
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace ackermann_local_planner {
+
+  FrenetFrame::FrenetFrame() {
+  }
+
+  void FrenetFrame::setPlan(
+      const std::vector<Pose2D> &plan) {
+    const int n = plan.size();
+    s_.resize(n);
+    x_.resize(n);
+    y_.resize(n);
+    theta_.resize(n);
+    cos_.resize(n);
+    sin_.resize(n);
+    for( int i=0; i<n; i++ ) {
+      x_[i] = plan[i].x;
+      y_[i] = plan[i].y;
+      theta_[i] = plan[i].theta;
+      cos_[i] = cos(theta_[i]);
+      sin_[i] = sin(theta_[i]);
+      s_[i] = i == 0 ? 0 :
+        s_[i-1] + hypot(x_[i] - x_[i-1], y_[i] - y_[i-1]);
+    }
+  }
+
+  void FrenetFrame::toCartesian(double s, double d, double &x, double &y,
+      double &theta) const {
+    if( s_.empty() ) {
+      x = y = theta = 0;
+      return;
+    }
+    // the step of the plan that s is on
+    const int k = std::max(0, std::min(int(s_.size()) - 2,
+          int(std::upper_bound(s_.begin(), s_.end(), s) - s_.begin()) - 1));
+    double c = cos_[k];
+    double sn = sin_[k];
+    if( s_.size() == 1 || s <= s_[k] ) {
+      x = x_[k];
+      y = y_[k];
+      theta = theta_[k];
+    } else {
+      const double length = s_[k+1] - s_[k];
+      const double t = length > 0 ? std::min(1.0, (s - s_[k]) / length) : 0;
+      x = x_[k] + t * (x_[k+1] - x_[k]);
+      y = y_[k] + t * (y_[k+1] - y_[k]);
+      theta = theta_[k] + t * shortestAngularDistance(theta_[k],
+          theta_[k+1]);
+      c = cos(theta);
+      sn = sin(theta);
+    }
+    x -= d * sn;
+    y += d * c;
+  }
+
+  void FrenetFrame::toFrenet(double x, double y, int first, int last,
+      double &s, double &d) const {
+    s = 0;
+    d = 0;
+    if( s_.empty() ) {
+      return;
+    }
+    first = std::max(0, first);
+    last = std::min(int(s_.size()) - 1, last);
+    double best = std::numeric_limits<double>::infinity();
+    // nearest point on each step between the poses
+    for( int k=first; k<=last; k++ ) {
+      double t = 0;
+      double length = 0;
+      if( k < last ) {
+        length = s_[k+1] - s_[k];
+        if( length > 0 ) {
+          t = ((x - x_[k]) * (x_[k+1] - x_[k]) +
+              (y - y_[k]) * (y_[k+1] - y_[k])) / (length * length);
+          t = std::max(0.0, std::min(1.0, t));
+        }
+      }
+      const double px = k < last ? x_[k] + t * (x_[k+1] - x_[k]) : x_[k];
+      const double py = k < last ? y_[k] + t * (y_[k+1] - y_[k]) : y_[k];
+      const double dist = hypot(x - px, y - py);
+      if( dist < best ) {
+        best = dist;
+        s = s_[k] + t * length;
+        // signed by which side of the pose's heading the point is on
+        d = cos_[k] * (y - py) - sin_[k] * (x - px);
+      }
+    }
+  }
+};
@@ -0,0 +1,293 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/obstacle_tracker.h>
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace ackermann_local_planner {
+
+  double SpeedProfile::time(double distance) const {
+    const double v0 = std::max(initial, 0.0);
+    if( distance <= 0 ) {
+      return 0;
+    }
+    if( accel <= 0 || v0 >= max ) {
+      return v0 > 0 ? distance / v0 : std::numeric_limits<double>::infinity();
+    }
+    // accelerating, then at the maximum
+    const double t1 = (max - v0) / accel;
+    const double d1 = v0 * t1 + 0.5 * accel * t1 * t1;
+    if( distance <= d1 ) {
+      return (sqrt(v0 * v0 + 2 * accel * distance) - v0) / accel;
+    }
+    return t1 + (distance - d1) / max;
+  }
+
+  ObstacleTrackerOptions::ObstacleTrackerOptions() :
+    cluster_distance(0.15),
+    max_cluster_radius(0.5),
+    match_distance(0.5),
+    velocity_smoothing(0.5),
+    min_hits(3),
+    max_misses(2),
+    min_speed(0.15),
+    horizon(3.0),
+    margin(0.1),
+    step(0.1) {
+  }
+
+  ObstacleTracker::ObstacleTracker() : last_stamp_(-1) {
+  }
+
+  void ObstacleTracker::clear() {
+    tracks_.clear();
+    last_stamp_ = -1;
+  }
+
+  void ObstacleTracker::addCluster(const std::vector<double> &x,
+      const std::vector<double> &y, int begin, int end) {
+    // a single point is as likely to be noise as an obstacle
+    if( end - begin < 2 ) {
+      return;
+    }
+    Cluster cluster;
+    cluster.x = 0;
+    cluster.y = 0;
+    for( int i=begin; i<end; i++ ) {
+      cluster.x += x[i];
+      cluster.y += y[i];
+    }
+    cluster.x /= end - begin;
+    cluster.y /= end - begin;
+    cluster.radius = 0;
+    for( int i=begin; i<end; i++ ) {
+      cluster.radius = std::max(cluster.radius,
+          hypot(x[i] - cluster.x, y[i] - cluster.y));
+    }
+    if( cluster.radius <= options_.max_cluster_radius ) {
+      clusters_.push_back(cluster);
+    }
+  }
+
+  struct TrackMatch {
+    double distance;
+    int track;
+    int cluster;
+
+    bool operator<(const TrackMatch &other) const {
+      return distance < other.distance;
+    }
+  };
+
+  void ObstacleTracker::update(double stamp, const std::vector<double> &x,
+      const std::vector<double> &y) {
+    if( stamp <= last_stamp_ ) {
+      return;
+    }
+    last_stamp_ = stamp;
+
+    clusters_.clear();
+    int begin = 0;
+    for( int i=1; i<=x.size(); i++ ) {
+      if( i == x.size() || hypot(x[i] - x[i-1], y[i] - y[i-1]) >
+          options_.cluster_distance ) {
+        addCluster(x, y, begin, i);
+        begin = i;
+      }
+    }
+
+    // match greedily, closest first, to where each track should be now
+    std::vector<TrackMatch> matches;
+    for( int t=0; t<tracks_.size(); t++ ) {
+      const MovingObstacle &track = tracks_[t];
+      const double dt = stamp - track.stamp;
+      const double px = track.x + track.vx * dt;
+      const double py = track.y + track.vy * dt;
+      for( int c=0; c<clusters_.size(); c++ ) {
+        const double d = hypot(clusters_[c].x - px, clusters_[c].y - py);
+        if( d <= options_.match_distance ) {
+          TrackMatch match;
+          match.distance = d;
+          match.track = t;
+          match.cluster = c;
+          matches.push_back(match);
+        }
+      }
+    }
+    std::sort(matches.begin(), matches.end());
+    std::vector<bool> track_matched(tracks_.size(), false);
+    std::vector<bool> cluster_matched(clusters_.size(), false);
+    for( int i=0; i<matches.size(); i++ ) {
+      const TrackMatch &match = matches[i];
+      if( track_matched[match.track] || cluster_matched[match.cluster] ) {
+        continue;
+      }
+      track_matched[match.track] = true;
+      cluster_matched[match.cluster] = true;
+
+      MovingObstacle &track = tracks_[match.track];
+      const Cluster &cluster = clusters_[match.cluster];
+      const double dt = stamp - track.stamp;
+      const double vx = (cluster.x - track.x) / dt;
+      const double vy = (cluster.y - track.y) / dt;
+      // the first velocity is all we have to go on
+      const double a = track.hits == 1 ? 1.0 : options_.velocity_smoothing;
+      track.vx = a * vx + (1 - a) * track.vx;
+      track.vy = a * vy + (1 - a) * track.vy;
+      track.x = cluster.x;
+      track.y = cluster.y;
+      track.radius = cluster.radius;
+      track.stamp = stamp;
+      track.hits++;
+      track.misses = 0;
+    }
+
+    // tracks not seen too many times in a row are gone
+    int kept = 0;
+    for( int t=0; t<tracks_.size(); t++ ) {
+      if( ! track_matched[t] ) {
+        tracks_[t].misses++;
+      }
+      if( tracks_[t].misses <= options_.max_misses ) {
+        tracks_[kept++] = tracks_[t];
+      }
+    }
+    tracks_.resize(kept);
+
+    for( int c=0; c<clusters_.size(); c++ ) {
+      if( ! cluster_matched[c] ) {
+        MovingObstacle track;
+        track.x = clusters_[c].x;
+        track.y = clusters_[c].y;
+        track.vx = 0;
+        track.vy = 0;
+        track.radius = clusters_[c].radius;
+        track.stamp = stamp;
+        track.hits = 1;
+        track.misses = 0;
+        tracks_.push_back(track);
+      }
+    }
+  }
+
+  bool ObstacleTracker::isMoving(const MovingObstacle &track) const {
+    return track.hits >= options_.min_hits &&
+      hypot(track.vx, track.vy) >= options_.min_speed;
+  }
+
+  bool ObstacleTracker::pathClear(
+      const std::vector<dubins_plus::Segment> &path,
+      double x, double y, double theta, const std::vector<Disc> &discs,
+      const SpeedProfile &profile, double now) const {
+    double reach = 0;
+    for( int j=0; j<discs.size(); j++ ) {
+      reach = std::max(reach, hypot(discs[j].x, discs[j].y) +
+          discs[j].radius);
+    }
+
+    // the tracks that could be anywhere near the path within the horizon
+    const dubins_plus::Bounds path_box = dubins_plus::path_bounds(path, x, y,
+        theta);
+    std::vector<int> near;
+    for( int i=0; i<tracks_.size(); i++ ) {
+      const MovingObstacle &track = tracks_[i];
+      if( ! isMoving(track) ) {
+        continue;
+      }
+      const double t0 = now - track.stamp;
+      const double t1 = t0 + options_.horizon;
+      dubins_plus::Bounds sweep;
+      sweep.add(track.x + track.vx * t0, track.y + track.vy * t0);
+      sweep.add(track.x + track.vx * t1, track.y + track.vy * t1);
+      sweep.grow(track.radius + options_.margin + reach + options_.step);
+      if( sweep.intersects(path_box) ) {
+        near.push_back(i);
+      }
+    }
+    if( near.empty() ) {
+      return true;
+    }
+
+    const double step = options_.step;
+    double distance = 0;
+    for( int i=0; i<path.size(); i++ ) {
+      const double length = path[i].getLength();
+      if( length <= 0 ) {
+        continue;
+      }
+      const int steps = std::max(1, int(ceil(length / step)));
+      for( int k=(i == 0 ? 0 : 1); k<=steps; k++ ) {
+        const double s = distance + length * k / steps;
+        const double t = profile.time(s);
+        if( t > options_.horizon ) {
+          return true;
+        }
+        // between poses, the robot and the obstacles each move up to half
+        // of a step from one of them
+        const double dt = std::min(profile.time(s + step) - t,
+            options_.horizon) / 2;
+        double px = x, py = y, ptheta = theta;
+        dubins_plus::advance(dubins_plus::Segment(length * k / steps,
+              path[i].getCurvature()), px, py, ptheta);
+        const double c = cos(ptheta);
+        const double sn = sin(ptheta);
+        for( int n=0; n<near.size(); n++ ) {
+          const MovingObstacle &track = tracks_[near[n]];
+          const double ot = now - track.stamp + t;
+          const double ox = track.x + track.vx * ot;
+          const double oy = track.y + track.vy * ot;
+          const double clearance = track.radius + options_.margin +
+            step / 2 + hypot(track.vx, track.vy) * dt;
+          for( int j=0; j<discs.size(); j++ ) {
+            const double dx = px + c * discs[j].x - sn * discs[j].y - ox;
+            const double dy = py + sn * discs[j].x + c * discs[j].y - oy;
+            const double r = discs[j].radius + clearance;
+            if( dx * dx + dy * dy <= r * r ) {
+              return false;
+            }
+          }
+        }
+      }
+      distance += length;
+      dubins_plus::advance(path[i], x, y, theta);
+    }
+    return true;
+  }
+};
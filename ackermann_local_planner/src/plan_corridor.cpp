@@ -0,0 +1,273 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/plan_corridor.h>
+#include <ackermann_local_planner/cell_traversal.h>
+
+#include <cmath>
+#include <algorithm>
+
+
+namespace ackermann_local_planner {
+
+  // origin moves within this fraction of a cell count as whole cells
+  static const double SHIFT_TOLERANCE = 1e-3;
+
+  // how many stations either side of the last match are searched for the
+  // nearest station to the next pose of a path
+  static const int STATION_WINDOW = 8;
+
+  PlanCorridor::PlanCorridor() : max_width_(1.0),
+    threshold_(INSCRIBED_INFLATED_OBSTACLE),
+    plan_changed_(true), resolution_(0), anchor_x_(0), anchor_y_(0),
+    offset_x_(0), offset_y_(0), size_x_(0), size_y_(0),
+    updated_stations_(0) {
+  }
+
+  void PlanCorridor::setPlan(const FrenetFrame &frame) {
+    const int n = frame.size();
+    x_.resize(n);
+    y_.resize(n);
+    cos_.resize(n);
+    sin_.resize(n);
+    for( int i=0; i<n; i++ ) {
+      double theta;
+      frame.toCartesian(frame.arcLength(i), 0, x_[i], y_[i], theta);
+      cos_[i] = cos(theta);
+      sin_[i] = sin(theta);
+    }
+    left_.assign(n, max_width_);
+    right_.assign(n, max_width_);
+    plan_changed_ = true;
+  }
+
+  void PlanCorridor::setWidth(double max_width) {
+    if( max_width != max_width_ ) {
+      max_width_ = max_width;
+      plan_changed_ = true;
+    }
+  }
+
+  bool PlanCorridor::blocked(unsigned char cost) const {
+    return cost != NO_INFORMATION && cost >= threshold_;
+  }
+
+  void PlanCorridor::update(const CostGrid &costmap) {
+    updated_stations_ = 0;
+    const int size_x = costmap.getSizeInCellsX();
+    const int size_y = costmap.getSizeInCellsY();
+    const double resolution = costmap.getResolution();
+    if( plan_changed_ || costs_.empty() || resolution != resolution_ ||
+        size_x != size_x_ || size_y != size_y_ ) {
+      reset(costmap);
+      return;
+    }
+    const double fx = (costmap.getOriginX() - anchor_x_) / resolution_;
+    const double fy = (costmap.getOriginY() - anchor_y_) / resolution_;
+    const int offset_x = floor(fx + 0.5);
+    const int offset_y = floor(fy + 0.5);
+    if( fabs(fx - offset_x) > SHIFT_TOLERANCE ||
+        fabs(fy - offset_y) > SHIFT_TOLERANCE ) {
+      reset(costmap);
+      return;
+    }
+
+    // cells of the window that became blocked or free, comparing with the
+    // old window where they overlap
+    const int dx = offset_x - offset_x_;
+    const int dy = offset_y - offset_y_;
+    const unsigned char * map = costmap.getCharMap();
+    for( int y=0; y<size_y; y++ ) {
+      const int old_y = y + dy;
+      for( int x=0; x<size_x; x++ ) {
+        const int old_x = x + dx;
+        const bool was_blocked = old_x >= 0 && old_x < size_x &&
+          old_y >= 0 && old_y < size_y &&
+          blocked(costs_[old_y * size_x + old_x]);
+        if( blocked(map[y * size_x + x]) != was_blocked ) {
+          markCell(x + offset_x, y + offset_y);
+        }
+      }
+    }
+    // blocked cells that scrolled out of the window are free now
+    if( dx != 0 || dy != 0 ) {
+      for( int y=0; y<size_y; y++ ) {
+        const int new_y = y - dy;
+        for( int x=0; x<size_x; x++ ) {
+          const int new_x = x - dx;
+          const bool inside = new_x >= 0 && new_x < size_x &&
+            new_y >= 0 && new_y < size_y;
+          if( ! inside && blocked(costs_[y * size_x + x]) ) {
+            markCell(x + offset_x_, y + offset_y_);
+          }
+        }
+      }
+    }
+    costs_.assign(map, map + size_x * size_y);
+    offset_x_ = offset_x;
+    offset_y_ = offset_y;
+
+    for( int i=0; i<dirty_stations_.size(); i++ ) {
+      computeStation(dirty_stations_[i]);
+      dirty_[dirty_stations_[i]] = 0;
+    }
+    updated_stations_ = dirty_stations_.size();
+    dirty_stations_.clear();
+  }
+
+  void PlanCorridor::reset(const CostGrid &costmap) {
+    size_x_ = costmap.getSizeInCellsX();
+    size_y_ = costmap.getSizeInCellsY();
+    resolution_ = costmap.getResolution();
+    anchor_x_ = costmap.getOriginX();
+    anchor_y_ = costmap.getOriginY();
+    offset_x_ = 0;
+    offset_y_ = 0;
+    const unsigned char * map = costmap.getCharMap();
+    costs_.assign(map, map + size_x_ * size_y_);
+    plan_changed_ = false;
+
+    buildIndex();
+    for( int i=0; i<x_.size(); i++ ) {
+      computeStation(i);
+    }
+    updated_stations_ = x_.size();
+  }
+
+  void PlanCorridor::buildIndex() {
+    index_.clear();
+    for( int i=0; i<x_.size(); i++ ) {
+      for( int side=-1; side<=1; side+=2 ) {
+        CellTraversal cells((x_[i] - anchor_x_) / resolution_,
+            (y_[i] - anchor_y_) / resolution_,
+            atan2(side * cos_[i], -side * sin_[i]), max_width_ / resolution_,
+            0);
+        int cx, cy;
+        while( cells.next(cx, cy) ) {
+          index_.push_back(IndexEntry(Cell(cx, cy), i));
+        }
+      }
+    }
+    std::sort(index_.begin(), index_.end());
+    dirty_.assign(x_.size(), 0);
+    dirty_stations_.clear();
+  }
+
+  void PlanCorridor::markCell(int wx, int wy) {
+    const Cell cell(wx, wy);
+    std::vector<IndexEntry>::const_iterator it = std::lower_bound(
+        index_.begin(), index_.end(), IndexEntry(cell, -1));
+    for( ; it != index_.end() && it->first == cell; ++it ) {
+      if( ! dirty_[it->second] ) {
+        dirty_[it->second] = 1;
+        dirty_stations_.push_back(it->second);
+      }
+    }
+  }
+
+  double PlanCorridor::castRay(int i, double side) const {
+    // walked in world-aligned cells, exactly as when indexed
+    CellTraversal cells((x_[i] - anchor_x_) / resolution_,
+        (y_[i] - anchor_y_) / resolution_,
+        atan2(side * cos_[i], -side * sin_[i]), max_width_ / resolution_, 0);
+    int cx, cy;
+    while( cells.next(cx, cy) ) {
+      const int mx = cx - offset_x_;
+      const int my = cy - offset_y_;
+      if( mx >= 0 && my >= 0 && mx < size_x_ && my < size_y_ &&
+          blocked(costs_[my * size_x_ + mx]) ) {
+        return std::min(max_width_, cells.entry() * resolution_);
+      }
+    }
+    return max_width_;
+  }
+
+  void PlanCorridor::computeStation(int i) {
+    left_[i] = castRay(i, 1);
+    right_[i] = castRay(i, -1);
+  }
+
+  double PlanCorridor::clearance(int i, double d) const {
+    return std::min(left_[i] - d, right_[i] + d);
+  }
+
+  int PlanCorridor::nearestStation(double x, double y, int near) const {
+    const int first = std::max(0, near - STATION_WINDOW);
+    const int last = std::min(int(x_.size()) - 1, near + STATION_WINDOW);
+    int best = near;
+    double best_dist = -1;
+    for( int i=first; i<=last; i++ ) {
+      const double dist = hypot(x - x_[i], y - y_[i]);
+      if( best_dist < 0 || dist < best_dist ) {
+        best_dist = dist;
+        best = i;
+      }
+    }
+    return best;
+  }
+
+  bool PlanCorridor::pathInside(
+      const std::vector<dubins_plus::Segment> &path,
+      double x, double y, double theta, int station) const {
+    // nothing is known until the first update
+    if( x_.empty() || resolution_ <= 0 ) {
+      return true;
+    }
+    station = std::max(0, std::min(int(x_.size()) - 1, station));
+    for( int i=0; i<path.size(); i++ ) {
+      const double length = path[i].getLength();
+      if( length <= 0 ) {
+        continue;
+      }
+      const int steps = std::max(1, int(ceil(length / resolution_)));
+      // the first pose of each segment is the last pose of the one before
+      for( int k=(i == 0 ? 0 : 1); k<=steps; k++ ) {
+        double px = x, py = y, ptheta = theta;
+        dubins_plus::advance(dubins_plus::Segment(length * k / steps,
+              path[i].getCurvature()), px, py, ptheta);
+        station = nearestStation(px, py, station);
+        const double d = cos_[station] * (py - y_[station]) -
+          sin_[station] * (px - x_[station]);
+        if( ! contains(station, d) ) {
+          return false;
+        }
+      }
+      dubins_plus::advance(path[i], x, y, theta);
+    }
+    return true;
+  }
+};
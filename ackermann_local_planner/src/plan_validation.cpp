@@ -0,0 +1,126 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/plan_validation.h>
+
+#include <cmath>
+#include <algorithm>
+
+namespace ackermann_local_planner {
+
+  // steps shorter than this don't tell us which way the robot is going
+  static const double MIN_STEP = 1e-4;
+
+  static bool byStart(const InfeasibleStretch &a,
+      const InfeasibleStretch &b) {
+    return a.start < b.start;
+  }
+
+  std::vector<InfeasibleStretch> validatePlan(
+      const std::vector<Pose2D> &plan,
+      double max_curvature, double cusp_tolerance) {
+    std::vector<InfeasibleStretch> result;
+    const int n = plan.size();
+    if( n < 2 ) {
+      return result;
+    }
+
+    const int steps = n - 1;
+    std::vector<double> curvature(steps);
+    std::vector<int> direction(steps);
+    for( int i=0; i<steps; i++ ) {
+      double dx = plan[i+1].x - plan[i].x;
+      double dy = plan[i+1].y - plan[i].y;
+      double ds = sqrt(dx*dx + dy*dy);
+      double dtheta = remainder(plan[i+1].theta - plan[i].theta, 2*M_PI);
+      // turning in place shows up as a huge curvature
+      curvature[i] = fabs(dtheta) / std::max(ds, MIN_STEP);
+      // +1 for forwards, -1 for backwards, 0 if we didn't move
+      double along = cos(plan[i].theta) * dx + sin(plan[i].theta) * dy;
+      direction[i] = (along > MIN_STEP) - (along < -MIN_STEP);
+    }
+
+    // collect runs of steps that are too tight
+    InfeasibleStretch tight;
+    tight.reason = InfeasibleStretch::CURVATURE;
+    bool in_tight = false;
+    for( int i=0; i<steps; i++ ) {
+      if( curvature[i] > max_curvature ) {
+        if( ! in_tight ) {
+          tight.start = i;
+          tight.worst = 0;
+          in_tight = true;
+        }
+        tight.end = i + 1;
+        tight.worst = std::max(tight.worst, curvature[i]);
+      } else if( in_tight ) {
+        result.push_back(tight);
+        in_tight = false;
+      }
+    }
+    if( in_tight ) {
+      result.push_back(tight);
+    }
+
+    // check the heading across each reversal. last is the most recent step
+    // that actually moved
+    int last = -1;
+    for( int i=0; i<steps; i++ ) {
+      if( direction[i] == 0 ) {
+        continue;
+      }
+      if( last >= 0 && direction[i] != direction[last] ) {
+        // heading from the start of the last step before the reversal to
+        // the end of the first step after it
+        double jump = fabs(remainder(plan[i+1].theta - plan[last].theta,
+              2*M_PI));
+        if( jump > cusp_tolerance ) {
+          InfeasibleStretch cusp;
+          cusp.reason = InfeasibleStretch::CUSP;
+          cusp.start = last;
+          cusp.end = i + 1;
+          cusp.worst = jump;
+          result.push_back(cusp);
+        }
+      }
+      last = i;
+    }
+
+    std::stable_sort(result.begin(), result.end(), byStart);
+    return result;
+  }
+};
@@ -0,0 +1,646 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/planner_core.h>
+#include <ackermann_local_planner/cell_traversal.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+
+namespace ackermann_local_planner {
+
+  bool isForwards(const Pose2D &start, const Pose2D &end) {
+    double yaw1 = start.theta;
+
+    double dx = (end.x - start.x);
+    double dy = (end.y - start.y);
+    double diff_angle = atan2(dy, dx);
+
+    if( fabs(shortestAngularDistance(yaw1, diff_angle)) < M_PI/2 ) {
+      return true;
+    } else {
+      return false;
+    }
+  }
+
+  // largest heading change we accept across a reversal in the plan
+  static const double CUSP_TOLERANCE = M_PI/4;
+
+  // how closely the plan has to follow a primitive to be matched to it. SBPL
+  // writes out the primitive poses exactly, so this only has to cover
+  // rounding
+  static const double PRIMITIVE_XY_TOLERANCE = 0.01;
+  static const double PRIMITIVE_THETA_TOLERANCE = 0.02;
+
+  // bucket size for indexing laser points
+  static const double SCAN_CELL_SIZE = 0.25;
+
+  // how far along the primitives being tracked the local plan reaches; it
+  // is collision checked before the primitives are followed, so it covers
+  // more than the robot's stopping distance (m)
+  static const double PRIMITIVE_LOCAL_LENGTH = 2.0;
+
+  // the nearest plan pose moving further than this in one cycle is suspect
+  static const int MAX_PLAN_JUMP = 20;
+
+  // candidates scoring worse than this are not worth driving; the plan is
+  // replanned instead
+  static const double MAX_SCORE = 10.0;
+
+  inline double sq(double x) {
+    return x*x;
+  }
+
+  double dist(const Pose2D &start, const Pose2D &end) {
+    return hypot((end.x - start.x), (end.y - start.y));
+  }
+
+  double curvature(const Pose2D & start, const Pose2D & end ) {
+    double dx = (end.x - start.x);
+    double dy = (end.y - start.y);
+    double dtheta = fabs(shortestAngularDistance(start.theta, end.theta));
+    double ds = hypot(dx, dy);
+    return dtheta / ds;
+  }
+
+  PlannerParams::PlannerParams() :
+    max_vel(0.55),
+    min_vel(0.0),
+    min_radius(0.4),
+    acc_lim(2.5),
+    lookahead_factor(1.0),
+    xy_goal_tolerance(0.1),
+    yaw_goal_tolerance(0.1),
+    move(true),
+    radius_samples(20),
+    reject_infeasible_plans(false),
+    plan_curvature_tolerance(0.25),
+    cost_to_go_scale(1.0),
+    collision_mode(PYRAMID_COLLISION_CHECK),
+    inscribed_radius(0.0),
+    inflation_radius(0.6),
+    cost_scaling_factor(10.0),
+    primitive_tracking(false),
+    max_lateral_acc(0.5),
+    primitive_lateral_gain(1.0),
+    primitive_heading_gain(1.5),
+    free_arc_bins(61),
+    free_arc_length(3.0),
+    frenet_offset_samples(7),
+    frenet_max_offset(0.6),
+    frenet_merge_samples(3),
+    frenet_min_merge(1.0),
+    frenet_max_merge(2.5),
+    frenet_offset_cost(0.5),
+    corridor_width(0.0),
+    use_scan_collision(false),
+    track_obstacles(false) {
+  }
+
+  CycleResult::CycleResult() : status(EMPTY_PLAN), linear(0), angular(0),
+    plan_point(0), jumped(false), target(0), target_distance(0),
+    best_score(std::numeric_limits<double>::max()), candidates(0),
+    rejected_free_arc(0), rejected_corridor(0), rejected_scan(0),
+    rejected_costmap(0), rejected_moving(0), rejected_library(0),
+    primitive(NULL),
+    primitive_step(0), lateral_error(0), heading_error(0),
+    tracking_blocked(false), traversal_fallback(false) {
+  }
+
+  PlannerCore::PlannerCore() : cost_to_go_map_(false), have_scan_(false),
+    last_plan_point_(0), goal_reached_(false), plan_infeasible_(false) {
+  }
+
+  void PlannerCore::setParams(const PlannerParams &params) {
+    params_ = params;
+    primitives_.setSpeedLimits(params_.max_vel, params_.max_lateral_acc);
+    if( params_.corridor_width > 0 ) {
+      corridor_.setWidth(params_.corridor_width);
+    }
+    updateSpeedProfile();
+  }
+
+  void PlannerCore::setFootprint(
+      const std::vector<Point2D> &footprint) {
+    forward_discs_ = coverFootprint(footprint);
+    // driving backwards, the robot is planned as if facing the other way
+    reverse_discs_ = forward_discs_;
+    for( int i=0; i<reverse_discs_.size(); i++ ) {
+      reverse_discs_[i].x = -reverse_discs_[i].x;
+      reverse_discs_[i].y = -reverse_discs_[i].y;
+    }
+  }
+
+  int PlannerCore::setPlan(
+      const std::vector<Pose2D> &plan,
+      std::vector<InfeasibleStretch> &infeasible) {
+    plan_ = plan;
+    cost_to_go_.setPlan(plan_);
+    cost_to_go_map_ = false;
+    plan_frame_.setPlan(plan_);
+    corridor_.setPlan(plan_frame_);
+    const int matched = matchPrimitives();
+
+    // make sure we can actually drive this plan
+    ScopedSpan validate_span(tracer_, "validate_plan");
+    double max_curvature = (1 + params_.plan_curvature_tolerance) /
+      params_.min_radius;
+    infeasible = validatePlan(plan_, max_curvature, CUSP_TOLERANCE);
+    validate_span.end();
+    plan_infeasible_ = params_.reject_infeasible_plans &&
+      ! infeasible.empty();
+
+    goal_reached_ = false;
+    last_plan_point_ = 0; // we're at the beginning of the plan
+    return matched;
+  }
+
+  void PlannerCore::setCostToGoMap(const CostGrid &grid) {
+    ScopedSpan cost_to_go_span(tracer_, "cost_to_go_map");
+    cost_to_go_.update(grid);
+    cost_to_go_map_ = true;
+  }
+
+  void PlannerCore::setScan(double stamp, const std::vector<double> &x,
+      const std::vector<double> &y) {
+    scan_obstacles_.clear();
+    for( int i=0; i<x.size(); i++ ) {
+      scan_obstacles_.addPoint(x[i], y[i]);
+    }
+    scan_obstacles_.buildIndex(SCAN_CELL_SIZE);
+    if( params_.track_obstacles ) {
+      obstacle_tracker_.update(stamp, x, y);
+    }
+    have_scan_ = true;
+  }
+
+  void PlannerCore::clearScan() {
+    scan_obstacles_.clear();
+    have_scan_ = false;
+  }
+
+  int PlannerCore::nearestPoint(int start_point, double x, double y,
+      double theta) const {
+    int plan_point = start_point;
+    double best_metric = std::numeric_limits<double>::max();
+    for( int i=start_point; i<plan_.size(); i++ ) {
+      const Pose2D & p = plan_[i];
+      double d = hypot(p.x - x, p.y - y);
+      double dtheta = fabs(shortestAngularDistance(theta, p.theta));
+      double metric = d + dtheta / 10.0;
+      if( metric < best_metric ) {
+        best_metric = metric;
+        plan_point = i;
+      }
+    }
+    return plan_point;
+  }
+
+  bool PlannerCore::candidateClear(
+      const std::vector<dubins_plus::Segment> &path,
+      const CandidateChecks &checks, CycleResult &result) {
+    const std::vector<Disc> &discs = *checks.discs;
+    if( checks.free_arcs ) {
+      int first = 0;
+      while( first < path.size() && path[first].getLength() < 0.01 ) {
+        first++;
+      }
+      if( first < path.size() && free_arcs_.freeLength(
+            path[first].getCurvature()) < std::min(
+              path[first].getLength(), params_.free_arc_length) ) {
+        // blocked within its first segment
+        result.rejected_free_arc++;
+        return false;
+      }
+    }
+    if( checks.corridor && ! corridor_.pathInside(path, checks.x, checks.y,
+          checks.theta, checks.station) ) {
+      result.rejected_corridor++;
+      return false;
+    }
+    if( checks.scan ) {
+      ScopedSpan scan_check_span(tracer_, "scan_check");
+      if( ! scan_obstacles_.pathClear(path, checks.x, checks.y,
+            checks.theta, discs) ) {
+        result.rejected_scan++;
+        return false;
+      }
+    }
+    if( checks.costmap ) {
+      ScopedSpan costmap_check_span(tracer_, "costmap_check");
+      // in open space the boxes the path sweeps are free, and the path
+      // needs no closer look
+      const std::vector<dubins_plus::Bounds> swept =
+        dubins_plus::swept_bounds(path, checks.x, checks.y, checks.theta,
+            checks.reach);
+      bool swept_free = true;
+      for( int j=0; j<swept.size() && swept_free; j++ ) {
+        swept_free = costmap_pyramid_.boxFree(swept[j],
+            LETHAL_OBSTACLE);
+      }
+      bool clear = swept_free;
+      if( ! clear && checks.thresholds != NULL ) {
+        clear = costmap_pyramid_.traversalClear(path, checks.x, checks.y,
+            checks.theta, discs, *checks.thresholds);
+      } else if( ! clear ) {
+        clear = costmap_pyramid_.pathClear(path, checks.x, checks.y,
+            checks.theta, discs, LETHAL_OBSTACLE,
+            params_.collision_mode == PYRAMID_COLLISION_CHECK);
+      }
+      if( ! clear ) {
+        result.rejected_costmap++;
+        return false;
+      }
+    }
+    if( checks.moving ) {
+      ScopedSpan moving_check_span(tracer_, "moving_check");
+      if( ! obstacle_tracker_.pathClear(path, checks.x, checks.y,
+            checks.theta, discs, checks.profile, checks.now) ) {
+        result.rejected_moving++;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  int PlannerCore::matchPrimitives() {
+    plan_steps_.clear();
+    if( plan_.size() < 2 ) {
+      return 0;
+    }
+    const int steps = plan_.size() - 1;
+    plan_steps_.resize(steps);
+
+    std::vector<mprim_lattice::Pose> path(plan_.size());
+    for( int i=0; i<plan_.size(); i++ ) {
+      path[i] = mprim_lattice::Pose(plan_[i].x, plan_[i].y, plan_[i].theta);
+    }
+
+    int matched = 0;
+    int i = 0;
+    while( i < steps ) {
+      const mprim_lattice::Primitive *p = primitives_.match(path, i,
+          PRIMITIVE_XY_TOLERANCE, PRIMITIVE_THETA_TOLERANCE);
+      if( p != NULL && p->poses.size() > 1 ) {
+        for( int j=0; j+1<p->poses.size(); j++ ) {
+          PlanStep & step = plan_steps_[i+j];
+          step.primitive = p;
+          step.index = j;
+          step.length = p->station[j+1] - p->station[j];
+          step.curvature = p->curvature[j];
+          step.direction = p->direction[j];
+        }
+        matched += p->poses.size() - 1;
+        i += p->poses.size() - 1;
+      } else {
+        // not from a primitive we know; the sampling planner handles these
+        PlanStep & step = plan_steps_[i];
+        step.primitive = NULL;
+        step.index = 0;
+        step.length = dist(plan_[i], plan_[i+1]);
+        step.curvature = curvature(plan_[i], plan_[i+1]);
+        step.direction = isForwards(plan_[i], plan_[i+1]) ? 1 : -1;
+        i++;
+      }
+    }
+    updateSpeedProfile();
+    return matched;
+  }
+
+  void PlannerCore::updateSpeedProfile() {
+    // work backwards from the goal so that we start slowing down in time.
+    // The robot has to be slow at the goal and wherever it reverses
+    double next_speed = params_.min_vel;
+    for( int i=plan_steps_.size()-1; i>=0; i-- ) {
+      PlanStep & step = plan_steps_[i];
+      double limit = params_.max_vel;
+      if( step.primitive != NULL ) {
+        limit = step.primitive->speed[step.index];
+      }
+      if( i+1 < plan_steps_.size() &&
+          plan_steps_[i+1].direction != step.direction ) {
+        next_speed = params_.min_vel;
+      }
+      step.speed = std::min(limit,
+          sqrt(sq(next_speed) + 2 * params_.acc_lim * step.length));
+      next_speed = step.speed;
+    }
+  }
+
+  bool PlannerCore::beginCycle(const PlannerInput &input,
+      CycleResult &result) {
+    result = CycleResult();
+
+    // if we don't have a plan, what are we doing here???
+    if( plan_.size() < 2 ) {
+      goal_reached_ = true;
+      result.status = CycleResult::EMPTY_PLAN;
+      return false;
+    }
+
+    if( plan_infeasible_ ) {
+      result.status = CycleResult::INFEASIBLE_PLAN;
+      return false;
+    }
+
+    if( ! cost_to_go_map_ ) {
+      ScopedSpan cost_to_go_span(tracer_, "cost_to_go");
+      cost_to_go_.update(*input.costmap);
+    }
+
+    if( params_.collision_mode != NO_COLLISION_CHECK ) {
+      ScopedSpan pyramid_span(tracer_, "costmap_pyramid");
+      costmap_pyramid_.update(*input.costmap);
+    }
+
+    if( params_.corridor_width > 0 ) {
+      ScopedSpan corridor_span(tracer_, "corridor");
+      corridor_.update(*input.costmap);
+    }
+
+    // get the nearest point on the global plan; both in angle space and
+    // linear space
+    ScopedSpan nearest_span(tracer_, "nearest_point");
+    result.plan_point = nearestPoint(last_plan_point_, input.x, input.y,
+        input.theta);
+    nearest_span.end();
+    result.jumped = abs(result.plan_point - last_plan_point_) >
+      MAX_PLAN_JUMP;
+    last_plan_point_ = result.plan_point;
+    return true;
+  }
+
+  bool PlannerCore::tracksPrimitive(int plan_point) const {
+    return params_.primitive_tracking && plan_point < plan_steps_.size() &&
+      plan_steps_[plan_point].primitive != NULL;
+  }
+
+  bool PlannerCore::trackPrimitive(const PlannerInput &input,
+      CycleResult &result) {
+    const int plan_point = result.plan_point;
+    const PlanStep & step = plan_steps_[plan_point];
+    const Pose2D & ref = plan_[plan_point];
+    double ref_yaw = ref.theta;
+
+    // lateral error, + to the left of the plan, and heading error
+    double dx = input.x - ref.x;
+    double dy = input.y - ref.y;
+    double lateral = -sin(ref_yaw) * dx + cos(ref_yaw) * dy;
+    double heading = shortestAngularDistance(ref_yaw, input.theta);
+
+    // when backing up the heading error grows the other way, so its
+    // correction has to flip to stay damped
+    double target_curvature = step.curvature
+      - params_.primitive_lateral_gain * lateral
+      - step.direction * params_.primitive_heading_gain * heading;
+    double max_curvature = 1 / params_.min_radius;
+    target_curvature = std::max(-max_curvature,
+        std::min(max_curvature, target_curvature));
+
+    double target_speed = std::min(step.speed,
+        fabs(input.linear_vel) + params_.acc_lim);
+    target_speed = std::max(target_speed, params_.min_vel);
+    target_speed *= step.direction;
+
+    // the primitives we're following are the local plan. Like the sampled
+    // paths, it's in the direction of travel, up to the next reversal
+    result.local_path.clear();
+    double length = 0;
+    for( int i=plan_point; i<plan_steps_.size() &&
+        length < PRIMITIVE_LOCAL_LENGTH &&
+        plan_steps_[i].primitive != NULL &&
+        plan_steps_[i].direction == step.direction; i++ ) {
+      result.local_path.push_back(dubins_plus::Segment(plan_steps_[i].length,
+            step.direction * plan_steps_[i].curvature));
+      length += plan_steps_[i].length;
+    }
+    result.start = ref;
+    if( step.direction < 0 ) {
+      result.start.theta = normalizeAngle(ref_yaw + M_PI);
+    }
+
+    // the tables know nothing of obstacles that turned up after the plan
+    // was made, so the path ahead is checked like any candidate, from the
+    // plan pose the feedback steers back to. Its rejections aren't counted
+    // with the candidates'.
+    CandidateChecks checks;
+    CycleResult check_result;
+    beginChecks(input, result.start, step.direction > 0, plan_point,
+        check_result, checks);
+    if( ! candidateClear(result.local_path, checks, check_result) ) {
+      result.local_path.clear();
+      result.start = Pose2D();
+      result.tracking_blocked = true;
+      return false;
+    }
+
+    result.status = CycleResult::TRACKING;
+    result.primitive = step.primitive;
+    result.primitive_step = step.index;
+    result.lateral_error = lateral;
+    result.heading_error = heading;
+    result.linear = target_speed;
+    result.angular = target_curvature * target_speed;
+    result.traversal_fallback = check_result.traversal_fallback;
+    return true;
+  }
+
+  void PlannerCore::beginCandidates(const PlannerInput &input,
+      CycleResult &result, CycleContext &ctx) {
+    const int plan_point = result.plan_point;
+    ScopedSpan lookahead_span(tracer_, "lookahead");
+    Pose2D plan_pose = plan_[plan_point];
+    int i = plan_point + 1;
+    Pose2D next_pose = plan_[i];
+    // get the direction (forward/backwards) on the plan
+    bool forward = isForwards(plan_pose, next_pose);
+
+    // Pure pursuit algorithm (Coulter R. Craig, 1992)
+    // compute the curvature at the current point
+    double local_curvature = curvature(plan_pose, next_pose);
+    if( plan_point > 0 ) {
+      const Pose2D & prev_pose = plan_[plan_point-1];
+      // average curvature to previous point with curvature to next point
+      local_curvature = (local_curvature + curvature(prev_pose, plan_pose))/2;
+    }
+    // Pure pursuit lookahead
+    // r = 1 / curvature
+    // lookahend = factor * r
+    //           = factor / curvature
+    // get a point forward of where we are on the plan
+    double forward_dist = 0;
+    double dtheta = 0;
+
+    while( forward_dist < params_.lookahead_factor / local_curvature &&
+        i < plan_.size() &&
+        isForwards(plan_pose, next_pose) == forward ) {
+      plan_pose = plan_[i-1];
+      next_pose = plan_[i];
+      forward_dist += dist(plan_pose, next_pose);
+      dtheta += std::abs(shortestAngularDistance(next_pose.theta,
+            plan_pose.theta));
+
+      double c = curvature(plan_pose, next_pose);
+      if( c > local_curvature ) {
+        local_curvature = c;
+      }
+
+      i++;
+    }
+    lookahead_span.end();
+
+    ctx.costmap = input.costmap;
+    ctx.linear_vel = input.linear_vel;
+    ctx.plan_point = plan_point;
+    ctx.target = i;
+    ctx.forward = forward;
+    ctx.forward_dist = forward_dist;
+    ctx.dtheta = dtheta;
+    ctx.goal = next_pose;
+    result.target = i;
+    result.target_distance = forward_dist;
+
+    // when the target is the end of the plan, any pose within the goal
+    // tolerances will do; aim for the nearest one instead of the exact
+    // goal so that the candidates don't loop around to hit it
+    ctx.target_is_goal = i >= plan_.size() &&
+      isForwards(plan_pose, next_pose) == forward;
+
+    // Dubins paths start at the robot
+    ctx.start = Pose2D(input.x, input.y, input.theta);
+    // if the path is backwards, invert the direction of initial and final
+    // poses
+    if( ! forward ) {
+      ctx.start.theta += M_PI;
+      ctx.goal.theta = normalizeAngle(ctx.goal.theta + M_PI);
+    }
+    ctx.start.theta = normalizeAngle(ctx.start.theta);
+    result.start = ctx.start;
+    result.goal = ctx.goal;
+
+    beginChecks(input, ctx.start, forward, plan_point, result, ctx.checks);
+
+    ctx.result = &result;
+  }
+
+  void PlannerCore::beginChecks(const PlannerInput &input,
+      const Pose2D &start, bool forward, int plan_point, CycleResult &result,
+      CandidateChecks &checks) {
+    const std::vector<Disc> & discs = forward ? forward_discs_ :
+      reverse_discs_;
+    checks.x = start.x;
+    checks.y = start.y;
+    checks.theta = start.theta;
+    checks.discs = &discs;
+    // how far the robot reaches from its origin
+    checks.reach = 0;
+    for( int j=0; j<discs.size(); j++ ) {
+      checks.reach = std::max(checks.reach, hypot(discs[j].x, discs[j].y) +
+          discs[j].radius);
+    }
+    checks.scan = have_scan_ && params_.use_scan_collision;
+    checks.moving = have_scan_ && params_.track_obstacles;
+    checks.costmap = params_.collision_mode != NO_COLLISION_CHECK;
+    checks.corridor = params_.corridor_width > 0;
+    checks.station = plan_point;
+    // the inflated cost each disc's center can't cross, if the inflation
+    // reaches far enough to tell; if not, every cell under the discs is
+    // checked instead
+    checks.thresholds = NULL;
+    if( params_.collision_mode == TRAVERSAL_COLLISION_CHECK ) {
+      traversal_thresholds_.resize(discs.size());
+      bool supported = true;
+      for( int j=0; j<discs.size(); j++ ) {
+        traversal_thresholds_[j] = inflatedThreshold(discs[j].radius,
+            input.costmap->getResolution(), params_.inscribed_radius,
+            params_.inflation_radius, params_.cost_scaling_factor);
+        supported = supported && traversal_thresholds_[j] > 0;
+      }
+      if( supported ) {
+        checks.thresholds = &traversal_thresholds_;
+      } else {
+        result.traversal_fallback = true;
+      }
+    }
+    // paths are timed from the current speed, speeding up to the maximum
+    checks.profile = SpeedProfile(fabs(input.linear_vel), params_.max_vel,
+        params_.acc_lim);
+    checks.now = input.now;
+
+    checks.free_arcs = params_.free_arc_bins > 0 && checks.costmap;
+    if( checks.free_arcs ) {
+      ScopedSpan free_arcs_span(tracer_, "free_arcs");
+      const CostGrid &costmap = *input.costmap;
+      free_arcs_.reset(1 / params_.min_radius, params_.free_arc_bins,
+          params_.free_arc_length, discs,
+          costmap.getResolution() * M_SQRT1_2);
+      free_arcs_.addCostmap(costmap, checks.x, checks.y, checks.theta,
+          LETHAL_OBSTACLE);
+    }
+  }
+
+  bool PlannerCore::endCandidates(const CycleContext &ctx, double speed,
+      CycleResult &result) {
+    if( result.best_score > MAX_SCORE ) {
+      // if the best local trajectory we were able to find is much worse
+      // than the global path, force the global planner to re-plan
+      result.status = CycleResult::NO_PATH;
+      return false;
+    }
+
+    const std::vector<dubins_plus::Segment> & path = result.local_path;
+    int i = 0;
+    for( ; i<path.size() && path[i].getLength() < 0.01; i++ );
+    const double target_curvature = i < path.size() ?
+      path[i].getCurvature() : 0;
+
+    result.status = CycleResult::SAMPLED;
+    result.linear = ctx.forward ? speed : -speed;
+    result.angular = target_curvature * speed;
+    return true;
+  }
+
+  void PlannerCore::endCycle(CycleResult &result) {
+    if( ! params_.move ) {
+      // if we're not supposed to be moving, zero out our command
+      result.linear = 0;
+      result.angular = 0;
+    }
+  }
+};
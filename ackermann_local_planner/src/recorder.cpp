@@ -0,0 +1,269 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/recorder.h>
+#include <ackermann_local_planner/trace.h>
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <tf/tf.h>
+
+namespace ackermann_local_planner {
+
+  InputRecorder::InputRecorder() : fd_(-1), mapped_size_(0), header_(NULL),
+    ring_(NULL), reserved_(0) {
+  }
+
+  InputRecorder::~InputRecorder() {
+    close();
+  }
+
+  bool InputRecorder::open(const std::string &filename, size_t capacity) {
+    close();
+    capacity &= ~size_t(7);
+    if( capacity < 2 * recordSize(0) ) {
+      return false;
+    }
+    fd_ = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if( fd_ < 0 ) {
+      return false;
+    }
+    mapped_size_ = sizeof(RecordFileHeader) + capacity;
+    void *map = MAP_FAILED;
+    if( ftruncate(fd_, mapped_size_) == 0 ) {
+      map = mmap(NULL, mapped_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+          0);
+    }
+    if( map == MAP_FAILED ) {
+      ::close(fd_);
+      fd_ = -1;
+      return false;
+    }
+    header_ = static_cast<RecordFileHeader*>(map);
+    ring_ = static_cast<char*>(map) + sizeof(RecordFileHeader);
+
+    memcpy(header_->magic, RECORD_MAGIC, sizeof(header_->magic));
+    header_->version = RECORD_VERSION;
+    header_->header_size = sizeof(RecordFileHeader);
+    header_->capacity = capacity;
+    header_->head = 0;
+    header_->tail = 0;
+    header_->count = 0;
+    header_->dropped = 0;
+    last_plan_.clear();
+    return true;
+  }
+
+  void InputRecorder::close() {
+    if( header_ != NULL ) {
+      msync(header_, mapped_size_, MS_ASYNC);
+      munmap(header_, mapped_size_);
+      header_ = NULL;
+      ring_ = NULL;
+    }
+    if( fd_ >= 0 ) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+
+  void InputRecorder::evict() {
+    const uint64_t capacity = header_->capacity;
+    uint64_t & tail = header_->tail;
+    const RecordHeader *r = reinterpret_cast<const RecordHeader*>(ring_ + tail);
+    if( capacity - tail < sizeof(RecordHeader) || r->type == RECORD_WRAP ) {
+      tail = 0;
+      return;
+    }
+    tail += recordSize(r->size);
+    header_->count--;
+  }
+
+  char *InputRecorder::reserve(RecordType type, double stamp, size_t size) {
+    reserved_ = 0;
+    if( header_ == NULL ) {
+      return NULL;
+    }
+    const uint64_t capacity = header_->capacity;
+    const size_t total = recordSize(size);
+    if( total > capacity / 2 ) {
+      header_->dropped++;
+      return NULL;
+    }
+
+    uint64_t & head = header_->head;
+    uint64_t & tail = header_->tail;
+    if( head + total > capacity ) {
+      // doesn't fit before the end of the ring; start over at the beginning,
+      // dropping whatever is still between here and the end
+      while( header_->count > 0 && tail >= head ) {
+        evict();
+      }
+      if( capacity - head >= sizeof(RecordHeader) ) {
+        RecordHeader *wrap = reinterpret_cast<RecordHeader*>(ring_ + head);
+        wrap->type = RECORD_WRAP;
+        wrap->size = 0;
+        wrap->stamp = stamp;
+      }
+      head = 0;
+    }
+    // drop the oldest records until there is room
+    while( header_->count > 0 && tail >= head && tail < head + total ) {
+      evict();
+    }
+    if( header_->count == 0 ) {
+      tail = head;
+    }
+
+    RecordHeader *r = reinterpret_cast<RecordHeader*>(ring_ + head);
+    r->type = type;
+    r->size = size;
+    r->stamp = stamp;
+    reserved_ = total;
+    return reinterpret_cast<char*>(r + 1);
+  }
+
+  void InputRecorder::commit() {
+    if( reserved_ > 0 ) {
+      header_->head += reserved_;
+      header_->count++;
+      reserved_ = 0;
+    }
+  }
+
+  void InputRecorder::recordCycleBegin(double stamp) {
+    char *data = reserve(RECORD_CYCLE_BEGIN, stamp, sizeof(RecordedCycle));
+    if( data ) {
+      RecordedCycle cycle;
+      memset(&cycle, 0, sizeof(cycle));
+      cycle.monotonic_ns = Tracer::now();
+      memcpy(data, &cycle, sizeof(cycle));
+      commit();
+    }
+  }
+
+  void InputRecorder::recordCycleEnd(double stamp,
+      const geometry_msgs::Twist &cmd_vel, bool result) {
+    char *data = reserve(RECORD_CYCLE_END, stamp, sizeof(RecordedCycle));
+    if( data ) {
+      RecordedCycle cycle;
+      memset(&cycle, 0, sizeof(cycle));
+      cycle.monotonic_ns = Tracer::now();
+      cycle.linear = cmd_vel.linear.x;
+      cycle.angular = cmd_vel.angular.z;
+      cycle.result = result;
+      memcpy(data, &cycle, sizeof(cycle));
+      commit();
+    }
+  }
+
+  void InputRecorder::recordPlan(double stamp,
+      const std::vector<geometry_msgs::PoseStamped> &plan) {
+    if( header_ == NULL ) {
+      return;
+    }
+    std::vector<RecordedPose> poses(plan.size());
+    for( int i=0; i<plan.size(); i++ ) {
+      poses[i].x = plan[i].pose.position.x;
+      poses[i].y = plan[i].pose.position.y;
+      poses[i].theta = tf::getYaw(plan[i].pose.orientation);
+    }
+    if( poses.size() == last_plan_.size() && (poses.empty() ||
+          memcmp(&poses[0], &last_plan_[0],
+            poses.size() * sizeof(RecordedPose)) == 0) ) {
+      return;
+    }
+    last_plan_.swap(poses);
+
+    const uint32_t count = last_plan_.size();
+    char *data = reserve(RECORD_PLAN, stamp,
+        sizeof(count) + count * sizeof(RecordedPose));
+    if( data ) {
+      memcpy(data, &count, sizeof(count));
+      if( count > 0 ) {
+        memcpy(data + sizeof(count), &last_plan_[0],
+            count * sizeof(RecordedPose));
+      }
+      commit();
+    }
+  }
+
+  void InputRecorder::recordPose(double stamp, double x, double y,
+      double theta) {
+    char *data = reserve(RECORD_POSE, stamp, sizeof(RecordedPose));
+    if( data ) {
+      RecordedPose pose;
+      pose.x = x;
+      pose.y = y;
+      pose.theta = theta;
+      memcpy(data, &pose, sizeof(pose));
+      commit();
+    }
+  }
+
+  void InputRecorder::recordOdom(double stamp, double linear, double angular) {
+    char *data = reserve(RECORD_ODOM, stamp, sizeof(RecordedOdom));
+    if( data ) {
+      RecordedOdom odom;
+      odom.linear = linear;
+      odom.angular = angular;
+      memcpy(data, &odom, sizeof(odom));
+      commit();
+    }
+  }
+
+  void InputRecorder::recordCostmap(double stamp,
+      const costmap_2d::Costmap2D &costmap) {
+    RecordedCostmap info;
+    info.size_x = costmap.getSizeInCellsX();
+    info.size_y = costmap.getSizeInCellsY();
+    info.resolution = costmap.getResolution();
+    info.origin_x = costmap.getOriginX();
+    info.origin_y = costmap.getOriginY();
+    const size_t cells = size_t(info.size_x) * info.size_y;
+    char *data = reserve(RECORD_COSTMAP, stamp, sizeof(info) + cells);
+    if( data ) {
+      memcpy(data, &info, sizeof(info));
+      memcpy(data + sizeof(info), costmap.getCharMap(), cells);
+      commit();
+    }
+  }
+};
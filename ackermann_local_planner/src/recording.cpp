@@ -0,0 +1,129 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/recording.h>
+
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ackermann_local_planner {
+
+  const char RECORD_MAGIC[8] = "ACKREC";
+  const uint32_t RECORD_VERSION = 1;
+
+  RecordingReader::RecordingReader() : fd_(-1), mapped_size_(0),
+    header_(NULL), ring_(NULL), position_(0), read_(0) {
+  }
+
+  RecordingReader::~RecordingReader() {
+    close();
+  }
+
+  bool RecordingReader::open(const std::string &filename) {
+    close();
+    error_.clear();
+    fd_ = ::open(filename.c_str(), O_RDONLY);
+    if( fd_ < 0 ) {
+      error_ = "can't open " + filename + ": " + strerror(errno);
+      return false;
+    }
+    struct stat st;
+    if( fstat(fd_, &st) != 0 || st.st_size < sizeof(RecordFileHeader) ) {
+      error_ = filename + " is too short";
+      close();
+      return false;
+    }
+    mapped_size_ = st.st_size;
+    void *map = mmap(NULL, mapped_size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if( map == MAP_FAILED ) {
+      error_ = "can't map " + filename + ": " + strerror(errno);
+      close();
+      return false;
+    }
+    header_ = static_cast<const RecordFileHeader*>(map);
+    if( memcmp(header_->magic, RECORD_MAGIC, sizeof(header_->magic)) != 0 ||
+        header_->version != RECORD_VERSION ||
+        header_->header_size != sizeof(RecordFileHeader) ||
+        header_->header_size + header_->capacity > mapped_size_ ) {
+      error_ = filename + " is not a planner recording";
+      close();
+      return false;
+    }
+    ring_ = static_cast<const char*>(map) + header_->header_size;
+    position_ = header_->tail;
+    read_ = 0;
+    return true;
+  }
+
+  void RecordingReader::close() {
+    if( header_ != NULL ) {
+      munmap(const_cast<RecordFileHeader*>(header_), mapped_size_);
+      header_ = NULL;
+      ring_ = NULL;
+    }
+    if( fd_ >= 0 ) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+
+  bool RecordingReader::next(RecordHeader &header, const char *&payload) {
+    if( header_ == NULL || read_ >= header_->count ) {
+      return false;
+    }
+    const uint64_t capacity = header_->capacity;
+    if( capacity - position_ < sizeof(RecordHeader) ||
+        reinterpret_cast<const RecordHeader*>(ring_ + position_)->type ==
+        RECORD_WRAP ) {
+      position_ = 0;
+    }
+    memcpy(&header, ring_ + position_, sizeof(header));
+    if( position_ + recordSize(header.size) > capacity ) {
+      error_ = "corrupt record";
+      return false;
+    }
+    payload = ring_ + position_ + sizeof(RecordHeader);
+    position_ += recordSize(header.size);
+    read_++;
+    return true;
+  }
+};
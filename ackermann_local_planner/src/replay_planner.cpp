@@ -0,0 +1,425 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/planner_policies.h>
+#include <ackermann_local_planner/recording.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <time.h>
+
+using namespace ackermann_local_planner;
+
+// planner parameters that can be set on the command line, by their names in
+// local_planner.yaml
+struct DoubleParam {
+  const char *name;
+  double PlannerParams::*field;
+};
+
+struct IntParam {
+  const char *name;
+  int PlannerParams::*field;
+};
+
+struct BoolParam {
+  const char *name;
+  bool PlannerParams::*field;
+};
+
+static const DoubleParam DOUBLE_PARAMS[] = {
+  { "max_vel", &PlannerParams::max_vel },
+  { "min_vel", &PlannerParams::min_vel },
+  { "min_radius", &PlannerParams::min_radius },
+  { "acc_lim", &PlannerParams::acc_lim },
+  { "lookahead_factor", &PlannerParams::lookahead_factor },
+  { "xy_goal_tolerance", &PlannerParams::xy_goal_tolerance },
+  { "yaw_goal_tolerance", &PlannerParams::yaw_goal_tolerance },
+  { "plan_curvature_tolerance", &PlannerParams::plan_curvature_tolerance },
+  { "cost_to_go_scale", &PlannerParams::cost_to_go_scale },
+  { "inscribed_radius", &PlannerParams::inscribed_radius },
+  { "inflation_radius", &PlannerParams::inflation_radius },
+  { "cost_scaling_factor", &PlannerParams::cost_scaling_factor },
+  { "max_lateral_acc", &PlannerParams::max_lateral_acc },
+  { "primitive_lateral_gain", &PlannerParams::primitive_lateral_gain },
+  { "primitive_heading_gain", &PlannerParams::primitive_heading_gain },
+  { "free_arc_length", &PlannerParams::free_arc_length },
+  { "frenet_max_offset", &PlannerParams::frenet_max_offset },
+  { "frenet_min_merge", &PlannerParams::frenet_min_merge },
+  { "frenet_max_merge", &PlannerParams::frenet_max_merge },
+  { "frenet_offset_cost", &PlannerParams::frenet_offset_cost },
+  { "corridor_width", &PlannerParams::corridor_width }
+};
+
+static const IntParam INT_PARAMS[] = {
+  { "radius_samples", &PlannerParams::radius_samples },
+  { "collision_mode", &PlannerParams::collision_mode },
+  { "free_arc_bins", &PlannerParams::free_arc_bins },
+  { "frenet_offset_samples", &PlannerParams::frenet_offset_samples },
+  { "frenet_merge_samples", &PlannerParams::frenet_merge_samples }
+};
+
+static const BoolParam BOOL_PARAMS[] = {
+  { "move", &PlannerParams::move },
+  { "reject_infeasible_plans", &PlannerParams::reject_infeasible_plans },
+  { "primitive_tracking", &PlannerParams::primitive_tracking }
+};
+
+#define COUNT(array) (sizeof(array) / sizeof(array[0]))
+
+static bool setParam(PlannerParams &params, const std::string &key,
+    const std::string &value) {
+  for( int i=0; i<COUNT(DOUBLE_PARAMS); i++ ) {
+    if( key == DOUBLE_PARAMS[i].name ) {
+      params.*DOUBLE_PARAMS[i].field = atof(value.c_str());
+      return true;
+    }
+  }
+  for( int i=0; i<COUNT(INT_PARAMS); i++ ) {
+    if( key == INT_PARAMS[i].name ) {
+      params.*INT_PARAMS[i].field = atoi(value.c_str());
+      return true;
+    }
+  }
+  for( int i=0; i<COUNT(BOOL_PARAMS); i++ ) {
+    if( key == BOOL_PARAMS[i].name ) {
+      params.*BOOL_PARAMS[i].field = value == "true" || value == "True" ||
+        value == "1";
+      return true;
+    }
+  }
+  return false;
+}
+
+static void listParams() {
+  for( int i=0; i<COUNT(DOUBLE_PARAMS); i++ ) {
+    printf("%s\n", DOUBLE_PARAMS[i].name);
+  }
+  for( int i=0; i<COUNT(INT_PARAMS); i++ ) {
+    printf("%s\n", INT_PARAMS[i].name);
+  }
+  for( int i=0; i<COUNT(BOOL_PARAMS); i++ ) {
+    printf("%s\n", BOOL_PARAMS[i].name);
+  }
+}
+
+static std::vector<double> parseList(const std::string &value) {
+  std::vector<double> list;
+  std::stringstream ss(value);
+  std::string item;
+  while( std::getline(ss, item, ',') ) {
+    list.push_back(atof(item.c_str()));
+  }
+  return list;
+}
+
+static double cpuSeconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// distance from the origin to the nearest edge of the footprint, as
+// costmap_2d computes it for the inflation
+static double inscribedRadius(const std::vector<Point2D> &footprint) {
+  double radius = HUGE_VAL;
+  for( int i=0; i<footprint.size(); i++ ) {
+    const Point2D &a = footprint[i];
+    const Point2D &b = footprint[(i + 1) % footprint.size()];
+    const double dx = b.x - a.x;
+    const double dy = b.y - a.y;
+    const double length2 = dx*dx + dy*dy;
+    double t = 0;
+    if( length2 > 0 ) {
+      t = std::max(0.0, std::min(1.0, -(a.x*dx + a.y*dy) / length2));
+    }
+    radius = std::min(radius, hypot(a.x + t*dx, a.y + t*dy));
+  }
+  return radius;
+}
+
+static void usage(const char *name) {
+  fprintf(stderr, "Usage: %s recording.rec [option=value ...]\n"
+      "       %s --params\n"
+      "Replays the plans and costmaps in a recording through the planner,\n"
+      "driving a simulated robot exactly as commanded, and prints\n"
+      "tracking_error, completion_time and cpu_time. Exits with 1 if the\n"
+      "robot collides, leaves the costmap or doesn't reach the goal.\n"
+      "Options:\n"
+      "  <parameter>=value     any planner parameter listed by --params\n"
+      "  footprint=x,y,x,y,... robot footprint (m)\n"
+      "  trajectory_library=   library built by build_trajectory_library\n"
+      "  rate=10               cycles per second after the recording ends\n"
+      "  max_time=120          give up on reaching the goal after this "
+      "long (s)\n", name, name);
+}
+
+int main(int argc, char **argv) {
+  if( argc == 2 && strcmp(argv[1], "--params") == 0 ) {
+    listParams();
+    return 0;
+  }
+  if( argc < 2 ) {
+    usage(argv[0]);
+    return 1;
+  }
+  PlannerParams params;
+  bool inscribed = false;
+  std::vector<Point2D> footprint = TrajectoryLibraryOptions().footprint;
+  std::string trajectory_library;
+  double rate = 10.0;
+  double max_time = 120.0;
+  for( int i=2; i<argc; i++ ) {
+    const std::string arg(argv[i]);
+    const size_t eq = arg.find('=');
+    if( eq == std::string::npos ) {
+      usage(argv[0]);
+      return 1;
+    }
+    const std::string key = arg.substr(0, eq);
+    const std::string value = arg.substr(eq + 1);
+    if( key == "footprint" ) {
+      const std::vector<double> xy = parseList(value);
+      footprint.clear();
+      for( int j=0; j+1<xy.size(); j+=2 ) {
+        footprint.push_back(Point2D(xy[j], xy[j+1]));
+      }
+    } else if( key == "trajectory_library" ) {
+      trajectory_library = value;
+    } else if( key == "rate" ) {
+      rate = atof(value.c_str());
+    } else if( key == "max_time" ) {
+      max_time = atof(value.c_str());
+    } else if( setParam(params, key, value) ) {
+      inscribed = inscribed || key == "inscribed_radius";
+    } else {
+      fprintf(stderr, "Unknown option %s\n", key.c_str());
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if( footprint.size() < 3 || rate <= 0 ) {
+    usage(argv[0]);
+    return 1;
+  }
+  if( ! inscribed ) {
+    params.inscribed_radius = inscribedRadius(footprint);
+  }
+
+  DefaultPlanner planner;
+  planner.setParams(params);
+  planner.setFootprint(footprint);
+  if( ! trajectory_library.empty() &&
+      ! planner.trajectoryLibrary().open(trajectory_library) ) {
+    fprintf(stderr, "%s\n", planner.trajectoryLibrary().error().c_str());
+    return 1;
+  }
+
+  RecordingReader reader;
+  if( ! reader.open(argv[1]) ) {
+    fprintf(stderr, "%s\n", reader.error().c_str());
+    return 1;
+  }
+
+  // the latest costmap in the recording
+  RecordedCostmap info;
+  std::vector<unsigned char> cells;
+
+  // the simulated robot starts where the recorded one did, and then drives
+  // the planner's commands instead of the recorded ones
+  bool have_pose = false;
+  Pose2D pose;
+  double linear = 0;
+  double angular = 0;
+
+  bool started = false;
+  double start_time = 0;
+  double last_time = 0;
+  int cycles = 0;
+  int plans = 0;
+  double error_sum = 0;
+  double cpu_time = 0;
+  std::string failure;
+
+  RecordHeader header;
+  const char *payload;
+  bool recorded = true;
+  while( true ) {
+    double stamp = 0;
+    if( recorded ) {
+      if( ! reader.next(header, payload) ) {
+        if( ! reader.error().empty() ) {
+          fprintf(stderr, "%s\n", reader.error().c_str());
+          return 1;
+        }
+        // the recording is over; keep driving on the last costmap
+        recorded = false;
+        continue;
+      }
+      switch( header.type ) {
+        case RECORD_PLAN: {
+          uint32_t count;
+          memcpy(&count, payload, sizeof(count));
+          std::vector<RecordedPose> poses(count);
+          if( count > 0 ) {
+            memcpy(&poses[0], payload + sizeof(count),
+                count * sizeof(RecordedPose));
+          }
+          std::vector<Pose2D> plan(count);
+          for( int i=0; i<count; i++ ) {
+            plan[i] = Pose2D(poses[i].x, poses[i].y, poses[i].theta);
+          }
+          std::vector<InfeasibleStretch> infeasible;
+          planner.setPlan(plan, infeasible);
+          plans++;
+          continue;
+        }
+        case RECORD_COSTMAP: {
+          memcpy(&info, payload, sizeof(info));
+          const size_t size = size_t(info.size_x) * info.size_y;
+          cells.assign(payload + sizeof(info), payload + sizeof(info) + size);
+          continue;
+        }
+        case RECORD_POSE:
+          if( ! have_pose ) {
+            RecordedPose p;
+            memcpy(&p, payload, sizeof(p));
+            pose = Pose2D(p.x, p.y, p.theta);
+            have_pose = true;
+          }
+          continue;
+        case RECORD_ODOM:
+          if( ! started ) {
+            RecordedOdom odom;
+            memcpy(&odom, payload, sizeof(odom));
+            linear = odom.linear;
+            angular = odom.angular;
+          }
+          continue;
+        case RECORD_CYCLE_END:
+          // the cycle's inputs are recorded between its beginning and end
+          if( plans == 0 || cells.empty() || ! have_pose ) {
+            continue;
+          }
+          stamp = header.stamp;
+          break;
+        default:
+          continue;
+      }
+    } else {
+      if( ! started ) {
+        failure = "the recording has no complete planning cycle";
+        break;
+      }
+      stamp = last_time + 1.0 / rate;
+    }
+
+    if( ! started ) {
+      started = true;
+      start_time = stamp;
+      last_time = stamp;
+    }
+    if( stamp - start_time > max_time ) {
+      failure = "didn't reach the goal";
+      break;
+    }
+    // drive the last command until now
+    const double dt = std::max(0.0, stamp - last_time);
+    pose.x += linear * cos(pose.theta) * dt;
+    pose.y += linear * sin(pose.theta) * dt;
+    pose.theta = normalizeAngle(pose.theta + angular * dt);
+    last_time = stamp;
+
+    const CostGrid grid(info.size_x, info.size_y, info.resolution,
+        info.origin_x, info.origin_y, &cells[0]);
+    int mx, my;
+    grid.worldToMapNoBounds(pose.x, pose.y, mx, my);
+    if( mx < 0 || my < 0 || mx >= info.size_x || my >= info.size_y ) {
+      failure = "left the costmap";
+      break;
+    }
+    if( grid.getCost(mx, my) >= INSCRIBED_INFLATED_OBSTACLE ) {
+      failure = "collided";
+      break;
+    }
+
+    PlannerInput input;
+    input.costmap = &grid;
+    input.x = pose.x;
+    input.y = pose.y;
+    input.theta = pose.theta;
+    input.linear_vel = linear;
+    input.angular_vel = angular;
+    input.now = stamp;
+    CycleResult result;
+    const double cpu_start = cpuSeconds();
+    planner.cycle(input, result);
+    cpu_time += cpuSeconds() - cpu_start;
+    cycles++;
+
+    if( result.status == CycleResult::EMPTY_PLAN ||
+        result.status == CycleResult::INFEASIBLE_PLAN ) {
+      // move_base would replan from here, which a replay can't
+      failure = "the plan can't be driven";
+      break;
+    }
+    error_sum += dist(pose, planner.plan()[result.plan_point]);
+    if( planner.goalReached() ) {
+      break;
+    }
+    // NO_PATH stops the robot for this cycle
+    linear = result.linear;
+    angular = result.angular;
+  }
+
+  printf("cycles: %d\n", cycles);
+  if( ! failure.empty() ) {
+    fprintf(stderr, "%s: %s after %d cycles at (%f, %f, %f)\n", argv[1],
+        failure.c_str(), cycles, pose.x, pose.y, pose.theta);
+    return 1;
+  }
+  printf("tracking_error: %f\n", error_sum / cycles);
+  printf("completion_time: %f\n", last_time - start_time);
+  printf("cpu_time: %f\n", cpu_time);
+  return 0;
+}
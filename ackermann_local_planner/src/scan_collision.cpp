@@ -0,0 +1,255 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/scan_collision.h>
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace ackermann_local_planner {
+
+  // curvatures smaller than this are driven as straight lines
+  static const double MIN_CURVATURE = 1e-6;
+
+  // upper bound on the number of buckets, in case a scan has a far outlier
+  static const int MAX_CELLS = 1 << 20;
+
+  // is angle (relative to the start of an arc) within the arc's sweep?
+  static bool inSweep(double angle, double sweep) {
+    if( fabs(sweep) >= 2*M_PI ) {
+      return true;
+    }
+    if( sweep < 0 ) {
+      angle = -angle;
+      sweep = -sweep;
+    }
+    angle -= 2*M_PI * floor(angle / (2*M_PI));
+    return angle <= sweep;
+  }
+
+  std::vector<Disc> coverFootprint(
+      const std::vector<Point2D> &footprint) {
+    std::vector<Disc> discs;
+    if( footprint.empty() ) {
+      return discs;
+    }
+    double min_x = footprint[0].x, max_x = footprint[0].x;
+    double min_y = footprint[0].y, max_y = footprint[0].y;
+    for( int i=1; i<footprint.size(); i++ ) {
+      min_x = std::min(min_x, footprint[i].x);
+      max_x = std::max(max_x, footprint[i].x);
+      min_y = std::min(min_y, footprint[i].y);
+      max_y = std::max(max_y, footprint[i].y);
+    }
+    double length = max_x - min_x;
+    double half_width = (max_y - min_y) / 2;
+    int n = std::max(1, int(ceil(length / std::max(2 * half_width, 1e-3))));
+    double spacing = length / n;
+    for( int i=0; i<n; i++ ) {
+      Disc d;
+      d.x = min_x + spacing * (i + 0.5);
+      d.y = (min_y + max_y) / 2;
+      // reaches the corners of its slice of the bounding box
+      d.radius = hypot(spacing / 2, half_width);
+      discs.push_back(d);
+    }
+    return discs;
+  }
+
+  ScanObstacles::ScanObstacles() : cell_size_(1.0), min_x_(0), min_y_(0),
+    size_x_(0), size_y_(0) {
+  }
+
+  void ScanObstacles::clear() {
+    x_.clear();
+    y_.clear();
+    size_x_ = 0;
+    size_y_ = 0;
+  }
+
+  void ScanObstacles::addPoint(double x, double y) {
+    x_.push_back(x);
+    y_.push_back(y);
+  }
+
+  void ScanObstacles::buildIndex(double cell_size) {
+    const int n = x_.size();
+    if( n == 0 ) {
+      size_x_ = 0;
+      size_y_ = 0;
+      return;
+    }
+    min_x_ = *std::min_element(x_.begin(), x_.end());
+    min_y_ = *std::min_element(y_.begin(), y_.end());
+    double max_x = *std::max_element(x_.begin(), x_.end());
+    double max_y = *std::max_element(y_.begin(), y_.end());
+    cell_size_ = cell_size;
+    while( double(max_x - min_x_) / cell_size_ *
+        double(max_y - min_y_) / cell_size_ > MAX_CELLS ) {
+      cell_size_ *= 2;
+    }
+    size_x_ = int((max_x - min_x_) / cell_size_) + 1;
+    size_y_ = int((max_y - min_y_) / cell_size_) + 1;
+
+    // counting sort of the points by bucket
+    start_.assign(size_x_ * size_y_ + 1, 0);
+    cell_.resize(n);
+    for( int i=0; i<n; i++ ) {
+      int cx = int((x_[i] - min_x_) / cell_size_);
+      int cy = int((y_[i] - min_y_) / cell_size_);
+      cell_[i] = cy * size_x_ + cx;
+      start_[cell_[i] + 1]++;
+    }
+    for( int c=0; c<size_x_ * size_y_; c++ ) {
+      start_[c + 1] += start_[c];
+    }
+    sorted_.resize(n);
+    // start_[c] is used as the insertion point for bucket c, which leaves it
+    // pointing at the start of bucket c+1; shift it back afterwards
+    for( int i=0; i<n; i++ ) {
+      sorted_[start_[cell_[i]]++] = i;
+    }
+    for( int c=size_x_ * size_y_; c>0; c-- ) {
+      start_[c] = start_[c - 1];
+    }
+    start_[0] = 0;
+  }
+
+  bool ScanObstacles::pathClear(const std::vector<dubins_plus::Segment> &path,
+      double x, double y, double theta,
+      const std::vector<Disc> &discs) const {
+    if( size_x_ == 0 ) {
+      return true;
+    }
+    for( int i=0; i<path.size(); i++ ) {
+      if( path[i].getLength() <= 0 ) {
+        continue;
+      }
+      for( int j=0; j<discs.size(); j++ ) {
+        if( ! segmentClear(path[i], x, y, theta, discs[j]) ) {
+          return false;
+        }
+      }
+      dubins_plus::advance(path[i], x, y, theta);
+    }
+    return true;
+  }
+
+  bool ScanObstacles::segmentClear(const dubins_plus::Segment &segment,
+      double x, double y, double theta, const Disc &disc) const {
+    const double c = cos(theta);
+    const double s = sin(theta);
+    const double length = segment.getLength();
+    const double k = segment.getCurvature();
+    const double r = disc.radius;
+    const bool arc = fabs(k) > MIN_CURVATURE;
+
+    // where the center of the disc starts and ends
+    double x0 = x + c * disc.x - s * disc.y;
+    double y0 = y + s * disc.x + c * disc.y;
+    double x1, y1;
+    // for arcs: every point of the robot turns about the same center
+    double ox = 0, oy = 0, rho = 0, phi0 = 0, sweep = 0;
+    if( arc ) {
+      ox = x - s / k;
+      oy = y + c / k;
+      rho = hypot(x0 - ox, y0 - oy);
+      phi0 = atan2(y0 - oy, x0 - ox);
+      sweep = k * length;
+      x1 = ox + rho * cos(phi0 + sweep);
+      y1 = oy + rho * sin(phi0 + sweep);
+    } else {
+      x1 = x0 + c * length;
+      y1 = y0 + s * length;
+    }
+
+    // swept bounding box
+    double lo_x = std::min(x0, x1), hi_x = std::max(x0, x1);
+    double lo_y = std::min(y0, y1), hi_y = std::max(y0, y1);
+    if( arc ) {
+      for( int q=0; q<4; q++ ) {
+        double a = q * M_PI / 2;
+        if( inSweep(a - phi0, sweep) ) {
+          lo_x = std::min(lo_x, ox + rho * cos(a));
+          hi_x = std::max(hi_x, ox + rho * cos(a));
+          lo_y = std::min(lo_y, oy + rho * sin(a));
+          hi_y = std::max(hi_y, oy + rho * sin(a));
+        }
+      }
+    }
+    int cx0 = std::max(0, int(floor((lo_x - r - min_x_) / cell_size_)));
+    int cy0 = std::max(0, int(floor((lo_y - r - min_y_) / cell_size_)));
+    int cx1 = std::min(size_x_ - 1, int(floor((hi_x + r - min_x_) / cell_size_)));
+    int cy1 = std::min(size_y_ - 1, int(floor((hi_y + r - min_y_) / cell_size_)));
+
+    const double r2 = r * r;
+    for( int cy=cy0; cy<=cy1; cy++ ) {
+      for( int cx=cx0; cx<=cx1; cx++ ) {
+        const int cell = cy * size_x_ + cx;
+        for( int i=start_[cell]; i<start_[cell + 1]; i++ ) {
+          const double px = x_[sorted_[i]];
+          const double py = y_[sorted_[i]];
+          double d2;
+          if( arc ) {
+            double vx = px - ox;
+            double vy = py - oy;
+            if( inSweep(atan2(vy, vx) - phi0, sweep) ) {
+              double d = hypot(vx, vy) - rho;
+              d2 = d * d;
+            } else {
+              // closest to one of the ends
+              d2 = std::min((px-x0)*(px-x0) + (py-y0)*(py-y0),
+                  (px-x1)*(px-x1) + (py-y1)*(py-y1));
+            }
+          } else {
+            // distance to the line segment
+            double t = (px - x0) * c + (py - y0) * s;
+            t = std::max(0.0, std::min(length, t));
+            double dx = px - (x0 + c * t);
+            double dy = py - (y0 + s * t);
+            d2 = dx * dx + dy * dy;
+          }
+          if( d2 < r2 ) {
+            return false;
+          }
+        }
+      }
+    }
+    return true;
+  }
+};
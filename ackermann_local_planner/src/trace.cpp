@@ -0,0 +1,296 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/trace.h>
+
+#include <time.h>
+
+namespace ackermann_local_planner {
+
+  Tracer::Tracer() : enabled_(false), file_(NULL), first_event_(true),
+    capacity_(0), flush_period_ns_(0), epoch_ns_(0),
+    buffers_(&Tracer::keepBuffer), next_tid_(1), work_(false),
+    stop_(false) {
+  }
+
+  Tracer::~Tracer() {
+    close();
+    for( size_t i=0; i<all_buffers_.size(); i++ ) {
+      delete all_buffers_[i];
+    }
+  }
+
+  uint64_t Tracer::now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+  }
+
+  bool Tracer::open(const std::string &filename, size_t capacity,
+      double flush_period) {
+    close();
+    // buffers from an earlier trace keep their threads, but are emptied and
+    // resized. Buffers are always locked before the file
+    std::vector<ThreadBuffer*> buffers;
+    {
+      boost::mutex::scoped_lock lock(file_mutex_);
+      buffers = all_buffers_;
+      capacity_ = capacity;
+    }
+    for( size_t i=0; i<buffers.size(); i++ ) {
+      boost::mutex::scoped_lock buf_lock(buffers[i]->mutex);
+      buffers[i]->spans.resize(capacity);
+      buffers[i]->written.resize(capacity);
+      buffers[i]->count = 0;
+      buffers[i]->dropped = 0;
+      buffers[i]->pending = false;
+    }
+
+    {
+      boost::mutex::scoped_lock lock(file_mutex_);
+      file_ = fopen(filename.c_str(), "w");
+      if( file_ == NULL ) {
+        error_ = "failed to open trace file " + filename;
+        return false;
+      }
+      error_.clear();
+      // JSON array format; the closing bracket is optional, so a trace from
+      // a process that died is still readable
+      fprintf(file_, "[\n");
+      first_event_ = true;
+      flush_period_ns_ = uint64_t(flush_period * 1e9);
+      epoch_ns_ = now();
+    }
+
+    {
+      boost::mutex::scoped_lock lock(work_mutex_);
+      work_ = false;
+      stop_ = false;
+    }
+    boost::thread writer(&Tracer::writer, this);
+    writer_.swap(writer);
+    enabled_.store(true);
+    return true;
+  }
+
+  size_t Tracer::close() {
+    // recording stops here; threads that already got past enabled() only
+    // reach their own buffers, which are never freed
+    if( ! enabled_.exchange(false) ) {
+      return 0;
+    }
+    {
+      boost::mutex::scoped_lock lock(work_mutex_);
+      stop_ = true;
+    }
+    work_cv_.notify_one();
+    writer_.join();
+
+    // spans recorded by threads that never flushed are written out too
+    std::vector<ThreadBuffer*> buffers;
+    {
+      boost::mutex::scoped_lock lock(file_mutex_);
+      buffers = all_buffers_;
+    }
+    size_t dropped = 0;
+    for( size_t i=0; i<buffers.size(); i++ ) {
+      ThreadBuffer & buf = *buffers[i];
+      boost::mutex::scoped_lock buf_lock(buf.mutex);
+      if( buf.pending ) {
+        writeSpans(buf.written, buf.written_count, buf.tid);
+        buf.pending = false;
+      }
+      writeSpans(buf.spans, buf.count, buf.tid);
+      buf.count = 0;
+      dropped += buf.dropped;
+      buf.dropped = 0;
+    }
+    boost::mutex::scoped_lock lock(file_mutex_);
+    fprintf(file_, "\n]\n");
+    fclose(file_);
+    file_ = NULL;
+    return dropped;
+  }
+
+  Tracer::ThreadBuffer* Tracer::buffer() {
+    ThreadBuffer* buf = buffers_.get();
+    if( buf == NULL ) {
+      // the one allocation a thread makes, on its first span
+      buf = new ThreadBuffer();
+      buf->spans.resize(capacity_);
+      buf->written.resize(capacity_);
+      buf->count = 0;
+      buf->dropped = 0;
+      buf->written_count = 0;
+      buf->pending = false;
+      buf->last_flush_ns = now();
+      {
+        boost::mutex::scoped_lock lock(file_mutex_);
+        buf->tid = next_tid_++;
+        all_buffers_.push_back(buf);
+      }
+      buffers_.reset(buf);
+    }
+    return buf;
+  }
+
+  void Tracer::record(const char* name, uint64_t start_ns, uint64_t end_ns) {
+    if( ! enabled() ) {
+      return;
+    }
+    ThreadBuffer* buf = buffer();
+    boost::mutex::scoped_lock lock(buf->mutex);
+    if( buf->count < buf->spans.size() ) {
+      TraceSpan & span = buf->spans[buf->count++];
+      span.name = name;
+      span.start_ns = start_ns;
+      span.end_ns = end_ns;
+    } else {
+      buf->dropped++;
+    }
+  }
+
+  size_t Tracer::maybeFlush() {
+    if( ! enabled() ) {
+      return 0;
+    }
+    ThreadBuffer* buf = buffer();
+    bool due;
+    {
+      boost::mutex::scoped_lock lock(buf->mutex);
+      due = buf->count * 2 >= buf->spans.size() ||
+        now() - buf->last_flush_ns >= flush_period_ns_;
+    }
+    return due ? flush(*buf) : 0;
+  }
+
+  size_t Tracer::flush() {
+    if( ! enabled() ) {
+      return 0;
+    }
+    return flush(*buffer());
+  }
+
+  size_t Tracer::flush(ThreadBuffer &buf) {
+    size_t dropped;
+    {
+      boost::mutex::scoped_lock buf_lock(buf.mutex);
+      buf.last_flush_ns = now();
+      dropped = buf.dropped;
+      buf.dropped = 0;
+      // if the writer hasn't finished with the last batch, this one waits
+      // for the next flush
+      if( buf.count == 0 || buf.pending ) {
+        return dropped;
+      }
+      // the buffers trade places, so nothing is copied or allocated
+      buf.spans.swap(buf.written);
+      buf.written_count = buf.count;
+      buf.count = 0;
+      buf.pending = true;
+    }
+    {
+      boost::mutex::scoped_lock lock(work_mutex_);
+      work_ = true;
+    }
+    work_cv_.notify_one();
+    return dropped;
+  }
+
+  void Tracer::writer() {
+    while( true ) {
+      bool stop;
+      {
+        boost::mutex::scoped_lock lock(work_mutex_);
+        while( ! work_ && ! stop_ ) {
+          work_cv_.wait(lock);
+        }
+        stop = stop_;
+        work_ = false;
+      }
+      writePending();
+      if( stop ) {
+        return;
+      }
+    }
+  }
+
+  void Tracer::writePending() {
+    std::vector<ThreadBuffer*> buffers;
+    {
+      boost::mutex::scoped_lock lock(file_mutex_);
+      buffers = all_buffers_;
+    }
+    for( size_t i=0; i<buffers.size(); i++ ) {
+      ThreadBuffer & buf = *buffers[i];
+      size_t count;
+      {
+        boost::mutex::scoped_lock buf_lock(buf.mutex);
+        if( ! buf.pending ) {
+          continue;
+        }
+        count = buf.written_count;
+      }
+      // the recording thread leaves the written spans alone until pending
+      // is cleared, so they are written without holding its lock
+      writeSpans(buf.written, count, buf.tid);
+      boost::mutex::scoped_lock buf_lock(buf.mutex);
+      buf.pending = false;
+    }
+  }
+
+  void Tracer::writeSpans(const std::vector<TraceSpan> &spans, size_t count,
+      int tid) {
+    if( count == 0 ) {
+      return;
+    }
+    boost::mutex::scoped_lock lock(file_mutex_);
+    if( file_ == NULL ) {
+      return;
+    }
+    for( size_t i=0; i<count; i++ ) {
+      const TraceSpan & span = spans[i];
+      // timestamps are in microseconds relative to when tracing started
+      fprintf(file_, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+          "\"ts\":%.3f,\"dur\":%.3f}", first_event_ ? "" : ",\n", span.name,
+          tid, (span.start_ns - epoch_ns_) / 1000.0,
+          (span.end_ns - span.start_ns) / 1000.0);
+      first_event_ = false;
+    }
+    fflush(file_);
+  }
+};
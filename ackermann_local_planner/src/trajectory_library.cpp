@@ -0,0 +1,372 @@
+/*********************************************************************
+*
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2014, Austin Hendrix
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of Willow Garage, Inc. nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*
+* Author: Austin Hendrix
+*********************************************************************/
+
+#include <ackermann_local_planner/trajectory_library.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace ackermann_local_planner {
+
+  static const char LIBRARY_MAGIC[8] = "ACKTRJ";
+  static const uint32_t LIBRARY_VERSION = 1;
+
+  TrajectoryLibraryOptions::TrajectoryLibraryOptions() : resolution(0.05),
+    num_headings(64), min_radius(0.7), max_lateral_acc(0.5),
+    curvature_samples(15) {
+    // dagny
+    const double x[4] = { -0.16, -0.16, 0.45, 0.45 };
+    const double y[4] = { -0.15, 0.15, 0.15, -0.15 };
+    for( int i=0; i<4; i++ ) {
+      footprint.push_back(Point2D(x[i], y[i]));
+    }
+    speeds.push_back(0.15);
+    speeds.push_back(0.3);
+    speeds.push_back(0.5);
+    speeds.push_back(-0.15);
+    times.push_back(1.0);
+    times.push_back(2.0);
+    times.push_back(3.0);
+  }
+
+  // cells around the robot, for sweeping one mask at a time
+  struct SweepGrid {
+    int half;         // cells from the robot to the edge
+    int width;
+    std::vector<char> cells;
+    int min_x, max_x, min_y, max_y;
+
+    explicit SweepGrid(int half) : half(half), width(2 * half + 1),
+      cells(width * width, 0) {
+      clear();
+    }
+
+    void clear() {
+      std::fill(cells.begin(), cells.end(), 0);
+      min_x = min_y = half;
+      max_x = max_y = -half;
+    }
+
+    // mark the cells within radius of a point; cell centers are at whole
+    // multiples of the resolution from the robot
+    void markDisc(double x, double y, double radius, double resolution) {
+      const int x0 = std::max(-half, (int)floor((x - radius) / resolution));
+      const int x1 = std::min(half, (int)ceil((x + radius) / resolution));
+      const int y0 = std::max(-half, (int)floor((y - radius) / resolution));
+      const int y1 = std::min(half, (int)ceil((y + radius) / resolution));
+      for( int cy=y0; cy<=y1; cy++ ) {
+        for( int cx=x0; cx<=x1; cx++ ) {
+          if( hypot(cx * resolution - x, cy * resolution - y) <= radius ) {
+            cells[(cy + half) * width + cx + half] = 1;
+            min_x = std::min(min_x, cx);
+            max_x = std::max(max_x, cx);
+            min_y = std::min(min_y, cy);
+            max_y = std::max(max_y, cy);
+          }
+        }
+      }
+    }
+  };
+
+  bool buildTrajectoryLibrary(const TrajectoryLibraryOptions &options,
+      const std::string &filename) {
+    const double res = options.resolution;
+    const std::vector<Disc> forward_discs = coverFootprint(options.footprint);
+    std::vector<Disc> reverse_discs = forward_discs;
+    double reach = 0;
+    for( int i=0; i<reverse_discs.size(); i++ ) {
+      reverse_discs[i].x = -reverse_discs[i].x;
+      reverse_discs[i].y = -reverse_discs[i].y;
+      reach = std::max(reach, hypot(forward_discs[i].x, forward_discs[i].y) +
+          forward_discs[i].radius);
+    }
+
+    std::vector<LibraryTrajectory> trajectories;
+    double max_length = 0;
+    for( int s=0; s<options.speeds.size(); s++ ) {
+      const double speed = options.speeds[s];
+      double max_curvature = 1 / options.min_radius;
+      if( options.max_lateral_acc > 0 && speed != 0 ) {
+        max_curvature = std::min(max_curvature,
+            options.max_lateral_acc / (speed * speed));
+      }
+      for( int t=0; t<options.times.size(); t++ ) {
+        for( int c=0; c<options.curvature_samples; c++ ) {
+          LibraryTrajectory trajectory;
+          trajectory.speed = speed;
+          trajectory.length = fabs(speed) * options.times[t];
+          trajectory.curvature = options.curvature_samples > 1 ?
+            max_curvature * (2.0 * c / (options.curvature_samples - 1) - 1) :
+            0;
+          trajectory.pad = 0;
+          trajectories.push_back(trajectory);
+          max_length = std::max(max_length, (double)trajectory.length);
+        }
+      }
+    }
+
+    // the robot is somewhere in its cell, and its heading somewhere in the
+    // heading bin; sweep enough headings across the bin that the far end of
+    // the longest trajectory moves at most half a cell between them. Poses
+    // are half a cell apart along the trajectory, so the discs are grown by
+    // half a cell to cover the gaps, as well as by half a cell diagonal
+    const double bin = 2 * M_PI / options.num_headings;
+    const double margin = res * (M_SQRT1_2 + 0.5);
+    const int sweeps = std::max(1,
+        (int)ceil(2 * (max_length + reach) * bin / res));
+
+    std::vector<SweptMask> masks;
+    std::vector<CellOffset> offsets;
+    SweepGrid grid((int)ceil((max_length + reach + margin) / res) + 1);
+    for( int h=0; h<options.num_headings; h++ ) {
+      for( int i=0; i<trajectories.size(); i++ ) {
+        const LibraryTrajectory &trajectory = trajectories[i];
+        const std::vector<Disc> &discs = trajectory.speed >= 0 ?
+          forward_discs : reverse_discs;
+        grid.clear();
+        for( int j=0; j<=sweeps; j++ ) {
+          const double start = (h + (double)j / sweeps - 0.5) * bin;
+          const int steps = std::max(1,
+              (int)ceil(2 * trajectory.length / res));
+          for( int k=0; k<=steps; k++ ) {
+            const double s = trajectory.length * k / steps;
+            const double theta = start + trajectory.curvature * s;
+            double x, y;
+            if( fabs(trajectory.curvature) < 1e-9 ) {
+              x = s * cos(start);
+              y = s * sin(start);
+            } else {
+              const double r = 1 / trajectory.curvature;
+              x = r * (sin(theta) - sin(start));
+              y = r * (cos(start) - cos(theta));
+            }
+            for( int d=0; d<discs.size(); d++ ) {
+              grid.markDisc(
+                  x + discs[d].x * cos(theta) - discs[d].y * sin(theta),
+                  y + discs[d].x * sin(theta) + discs[d].y * cos(theta),
+                  discs[d].radius + margin, res);
+            }
+          }
+        }
+
+        // by row, so that evaluation walks the costmap in order
+        SweptMask mask;
+        mask.first = offsets.size();
+        mask.min_dx = grid.min_x;
+        mask.max_dx = grid.max_x;
+        mask.min_dy = grid.min_y;
+        mask.max_dy = grid.max_y;
+        for( int y=grid.min_y; y<=grid.max_y; y++ ) {
+          for( int x=grid.min_x; x<=grid.max_x; x++ ) {
+            if( grid.cells[(y + grid.half) * grid.width + x + grid.half] ) {
+              CellOffset o;
+              o.dx = x;
+              o.dy = y;
+              offsets.push_back(o);
+            }
+          }
+        }
+        mask.count = offsets.size() - mask.first;
+        masks.push_back(mask);
+      }
+    }
+
+    TrajectoryLibraryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LIBRARY_MAGIC, sizeof(header.magic));
+    header.version = LIBRARY_VERSION;
+    header.header_size = sizeof(header);
+    header.resolution = res;
+    header.num_headings = options.num_headings;
+    header.num_trajectories = trajectories.size();
+    header.num_offsets = offsets.size();
+    header.trajectories_offset = sizeof(header);
+    header.masks_offset = header.trajectories_offset +
+      trajectories.size() * sizeof(LibraryTrajectory);
+    header.offsets_offset = header.masks_offset +
+      masks.size() * sizeof(SweptMask);
+
+    FILE *out = fopen(filename.c_str(), "wb");
+    if( out == NULL ) {
+      return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    ok = ok && (trajectories.empty() || fwrite(&trajectories[0],
+          sizeof(LibraryTrajectory), trajectories.size(), out) ==
+        trajectories.size());
+    ok = ok && (masks.empty() || fwrite(&masks[0], sizeof(SweptMask),
+          masks.size(), out) == masks.size());
+    ok = ok && (offsets.empty() || fwrite(&offsets[0], sizeof(CellOffset),
+          offsets.size(), out) == offsets.size());
+    ok = (fclose(out) == 0) && ok;
+    return ok;
+  }
+
+  TrajectoryLibrary::TrajectoryLibrary() : fd_(-1), mapped_size_(0),
+    header_(NULL), trajectories_(NULL), masks_(NULL), offsets_(NULL) {
+  }
+
+  TrajectoryLibrary::~TrajectoryLibrary() {
+    close();
+  }
+
+  bool TrajectoryLibrary::open(const std::string &filename) {
+    close();
+    error_.clear();
+    fd_ = ::open(filename.c_str(), O_RDONLY);
+    if( fd_ < 0 ) {
+      error_ = "can't open " + filename + ": " + strerror(errno);
+      return false;
+    }
+    struct stat st;
+    if( fstat(fd_, &st) != 0 || st.st_size < sizeof(TrajectoryLibraryHeader) ) {
+      error_ = filename + " is too short";
+      close();
+      return false;
+    }
+    mapped_size_ = st.st_size;
+    void *map = mmap(NULL, mapped_size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if( map == MAP_FAILED ) {
+      error_ = "can't map " + filename + ": " + strerror(errno);
+      close();
+      return false;
+    }
+    header_ = static_cast<const TrajectoryLibraryHeader*>(map);
+    const uint64_t masks = uint64_t(header_->num_headings) *
+      header_->num_trajectories;
+    if( memcmp(header_->magic, LIBRARY_MAGIC, sizeof(header_->magic)) != 0 ||
+        header_->version != LIBRARY_VERSION ||
+        header_->header_size != sizeof(TrajectoryLibraryHeader) ||
+        header_->num_headings == 0 ||
+        header_->trajectories_offset + header_->num_trajectories *
+        sizeof(LibraryTrajectory) > header_->masks_offset ||
+        header_->masks_offset + masks * sizeof(SweptMask) >
+        header_->offsets_offset ||
+        header_->offsets_offset + header_->num_offsets * sizeof(CellOffset) >
+        mapped_size_ ) {
+      error_ = filename + " is not a trajectory library";
+      close();
+      return false;
+    }
+    const char *base = static_cast<const char*>(map);
+    trajectories_ = reinterpret_cast<const LibraryTrajectory*>(base +
+        header_->trajectories_offset);
+    masks_ = reinterpret_cast<const SweptMask*>(base + header_->masks_offset);
+    offsets_ = reinterpret_cast<const CellOffset*>(base +
+        header_->offsets_offset);
+    for( uint64_t i=0; i<masks; i++ ) {
+      if( uint64_t(masks_[i].first) + masks_[i].count >
+          header_->num_offsets ) {
+        error_ = filename + " has a mask past the end of the offsets";
+        close();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void TrajectoryLibrary::close() {
+    if( header_ != NULL ) {
+      munmap(const_cast<TrajectoryLibraryHeader*>(header_), mapped_size_);
+      header_ = NULL;
+      trajectories_ = NULL;
+      masks_ = NULL;
+      offsets_ = NULL;
+    }
+    if( fd_ >= 0 ) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+
+  int TrajectoryLibrary::headingIndex(double theta) const {
+    const int n = header_->num_headings;
+    const int h = (int)floor(theta * n / (2 * M_PI) + 0.5);
+    return ((h % n) + n) % n;
+  }
+
+  double TrajectoryLibrary::cost(const CostGrid &costmap,
+      int mx, int my, int heading, int i, unsigned char threshold) const {
+    const SweptMask &m = mask(heading, i);
+    const CellOffset *o = offsets_ + m.first;
+    const unsigned char *map = costmap.getCharMap();
+    const int size_x = costmap.getSizeInCellsX();
+    const int size_y = costmap.getSizeInCellsY();
+    double sum = 0;
+    if( mx + m.min_dx >= 0 && mx + m.max_dx < size_x &&
+        my + m.min_dy >= 0 && my + m.max_dy < size_y ) {
+      // all on the map; no bounds checks
+      const unsigned char *center = map + my * size_x + mx;
+      for( uint32_t k=0; k<m.count; k++ ) {
+        const unsigned char c = center[o[k].dy * size_x + o[k].dx];
+        if( c == NO_INFORMATION ) {
+          continue;
+        }
+        if( c >= threshold ) {
+          return -1;
+        }
+        sum += c;
+      }
+    } else {
+      for( uint32_t k=0; k<m.count; k++ ) {
+        const int x = mx + o[k].dx;
+        const int y = my + o[k].dy;
+        if( x < 0 || y < 0 || x >= size_x || y >= size_y ) {
+          continue;
+        }
+        const unsigned char c = map[y * size_x + x];
+        if( c == NO_INFORMATION ) {
+          continue;
+        }
+        if( c >= threshold ) {
+          return -1;
+        }
+        sum += c;
+      }
+    }
+    return sum;
+  }
+};
@@ -0,0 +1,1514 @@
+#include "ackermann_local_planner/cell_traversal.h"
+#include "ackermann_local_planner/cost_to_go.h"
+#include "ackermann_local_planner/costmap_pyramid.h"
+#include "ackermann_local_planner/escape_search.h"
+#include "ackermann_local_planner/free_arc_table.h"
+#include "ackermann_local_planner/frenet_frame.h"
+#include "ackermann_local_planner/obstacle_tracker.h"
+#include "ackermann_local_planner/plan_corridor.h"
+#include "ackermann_local_planner/plan_validation.h"
+#include "ackermann_local_planner/planner_policies.h"
+#include "ackermann_local_planner/planner_types.h"
+#include "ackermann_local_planner/scan_collision.h"
+#include "ackermann_local_planner/trace.h"
+#include "ackermann_local_planner/trajectory_library.h"
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/thread/thread.hpp>
+
+using namespace ackermann_local_planner;
+
+// uniform in [lo, hi)
+double uniform(double lo, double hi) {
+  return lo + (hi - lo) * (rand() / (RAND_MAX + 1.0));
+}
+
+// whether any disc center comes within its radius of a cell center, driving
+// a library trajectory from x, y, theta; sampled every millimeter
+bool discsHitCell(const LibraryTrajectory &t, const std::vector<Disc> &discs,
+    double x, double y, double theta, double cx, double cy) {
+  const int steps = std::max(1, (int)ceil(t.length / 0.001));
+  for( int k=0; k<=steps; k++ ) {
+    const double s = t.length * k / steps;
+    const double heading = theta + t.curvature * s;
+    double px, py;
+    if( fabs(t.curvature) < 1e-9 ) {
+      px = x + s * cos(theta);
+      py = y + s * sin(theta);
+    } else {
+      const double r = 1 / t.curvature;
+      px = x + r * (sin(heading) - sin(theta));
+      py = y + r * (cos(theta) - cos(heading));
+    }
+    for( int d=0; d<discs.size(); d++ ) {
+      const double dx = px + discs[d].x * cos(heading) -
+        discs[d].y * sin(heading);
+      const double dy = py + discs[d].x * sin(heading) +
+        discs[d].y * cos(heading);
+      if( hypot(dx - cx, dy - cy) <= discs[d].radius ) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+TEST(TrajectoryLibraryTests, masksCoverDiscs) {
+  TrajectoryLibraryOptions options;
+  options.num_headings = 32;
+  options.curvature_samples = 7;
+  const std::string filename = testing::TempDir() + "test_library.trj";
+  ASSERT_TRUE(buildTrajectoryLibrary(options, filename));
+  TrajectoryLibrary library;
+  ASSERT_TRUE(library.open(filename));
+  remove(filename.c_str());
+  ASSERT_EQ(library.numHeadings(), 32);
+
+  const std::vector<Disc> forward = coverFootprint(options.footprint);
+  std::vector<Disc> reverse = forward;
+  for( int i=0; i<reverse.size(); i++ ) {
+    reverse[i].x = -reverse[i].x;
+    reverse[i].y = -reverse[i].y;
+  }
+
+  // one lethal cell at a time, near the robot's path
+  const double res = options.resolution;
+  const int size = 200;
+  std::vector<unsigned char> cells(size * size, FREE_SPACE);
+  const CostGrid grid(size, size, res, 0, 0, &cells[0]);
+
+  srand(7);
+  int hits = 0;
+  int misses = 0;
+  int false_alarms = 0;
+  for( int trial=0; trial<20000; trial++ ) {
+    const int j = rand() % library.size();
+    const LibraryTrajectory &t = library.trajectory(j);
+    const std::vector<Disc> &discs = t.speed >= 0 ? forward : reverse;
+    // anywhere in the center cell, at any heading; reverse trajectories
+    // start from the robot turned around, as in the planner
+    const double x = (size / 2 + uniform(0, 1)) * res;
+    const double y = (size / 2 + uniform(0, 1)) * res;
+    const double theta = uniform(-M_PI, M_PI);
+
+    const double s = uniform(0, t.length);
+    const double px = x + s * cos(theta) + uniform(-0.6, 0.6);
+    const double py = y + s * sin(theta) + uniform(-0.6, 0.6);
+    int ox, oy;
+    grid.worldToMapNoBounds(px, py, ox, oy);
+    ASSERT_GE(ox, 0);
+    ASSERT_GE(oy, 0);
+    ASSERT_LT(ox, size);
+    ASSERT_LT(oy, size);
+    cells[oy * size + ox] = LETHAL_OBSTACLE;
+
+    const bool hit = discsHitCell(t, discs, x, y, theta, (ox + 0.5) * res,
+        (oy + 0.5) * res);
+    int mx, my;
+    grid.worldToMapNoBounds(x, y, mx, my);
+    const bool blocked = library.cost(grid, mx, my,
+        library.headingIndex(theta), j, LETHAL_OBSTACLE) < 0;
+    hits += hit;
+    misses += hit && !blocked;
+    false_alarms += blocked && !hit;
+
+    cells[oy * size + ox] = FREE_SPACE;
+  }
+  // the masks are conservative: they never miss a collision
+  EXPECT_EQ(misses, 0);
+  // and the trials test something
+  EXPECT_GT(hits, 2000);
+  EXPECT_LT(false_alarms, hits);
+}
+
+// a world-aligned cell index at a coarser level, as the pyramid rounds it
+int coarsen(int a, int level) {
+  return (int)floor(a / (double)(1 << level));
+}
+
+TEST(TrajectoryLibraryTests, knownCells) {
+  TrajectoryLibraryOptions options;
+  options.num_headings = 32;
+  options.curvature_samples = 7;
+  // one speed each way, for 3 s
+  options.speeds.clear();
+  options.speeds.push_back(0.5);
+  options.speeds.push_back(-0.15);
+  options.times.clear();
+  options.times.push_back(3.0);
+  const std::string filename = testing::TempDir() + "test_library_known.trj";
+  ASSERT_TRUE(buildTrajectoryLibrary(options, filename));
+  TrajectoryLibrary library;
+  ASSERT_TRUE(library.open(filename));
+  remove(filename.c_str());
+
+  // the straight trajectories, forwards and in reverse
+  int ahead = -1;
+  int back = -1;
+  for( int j=0; j<library.size(); j++ ) {
+    const LibraryTrajectory &t = library.trajectory(j);
+    if( t.curvature != 0 ) {
+      continue;
+    }
+    int &best = t.speed > 0 ? ahead : back;
+    if( best < 0 || t.length > library.trajectory(best).length ) {
+      best = j;
+    }
+  }
+  ASSERT_GE(ahead, 0);
+  ASSERT_GE(back, 0);
+  ASSERT_NEAR(1.5, library.trajectory(ahead).length, 1e-6);
+  ASSERT_NEAR(0.45, library.trajectory(back).length, 1e-6);
+
+  // the robot is in cell 50, 50 of a 5 m square, facing along x
+  const int size = 100;
+  std::vector<unsigned char> cells(size * size, FREE_SPACE);
+  const CostGrid grid(size, size, 0.05, 0, 0, &cells[0]);
+  const int forward = library.headingIndex(0);
+  const int reverse = library.headingIndex(M_PI);
+  EXPECT_EQ(0.0, library.cost(grid, 50, 50, forward, ahead, LETHAL_OBSTACLE));
+  EXPECT_EQ(0.0, library.cost(grid, 50, 50, reverse, back, LETHAL_OBSTACLE));
+
+  // 75 cm and a meter ahead are swept by the forward straight, but not by
+  // the reverse one, and their costs are summed
+  cells[50 * size + 70] = 50;
+  cells[50 * size + 65] = 20;
+  EXPECT_EQ(70.0, library.cost(grid, 50, 50, forward, ahead,
+        LETHAL_OBSTACLE));
+  EXPECT_EQ(0.0, library.cost(grid, 50, 50, reverse, back, LETHAL_OBSTACLE));
+  cells[50 * size + 70] = LETHAL_OBSTACLE;
+  EXPECT_EQ(-1.0, library.cost(grid, 50, 50, forward, ahead,
+        LETHAL_OBSTACLE));
+  // facing along y it doesn't go there
+  EXPECT_EQ(0.0, library.cost(grid, 50, 50, library.headingIndex(M_PI / 2),
+        ahead, LETHAL_OBSTACLE));
+  cells[50 * size + 70] = FREE_SPACE;
+  cells[50 * size + 65] = FREE_SPACE;
+
+  // half a meter behind is past the back of the robot, which is 16 cm
+  // behind its origin, after backing up 45 cm; but not after going forward
+  cells[50 * size + 40] = LETHAL_OBSTACLE;
+  EXPECT_EQ(-1.0, library.cost(grid, 50, 50, reverse, back,
+        LETHAL_OBSTACLE));
+  EXPECT_EQ(0.0, library.cost(grid, 50, 50, forward, ahead,
+        LETHAL_OBSTACLE));
+  cells[50 * size + 40] = FREE_SPACE;
+
+  // well beyond the end of either, or a meter to the side, is never swept
+  cells[50 * size + 95] = LETHAL_OBSTACLE;
+  cells[70 * size + 60] = LETHAL_OBSTACLE;
+  cells[50 * size + 25] = LETHAL_OBSTACLE;
+  EXPECT_EQ(0.0, library.cost(grid, 50, 50, forward, ahead, LETHAL_OBSTACLE));
+  EXPECT_EQ(0.0, library.cost(grid, 50, 50, reverse, back, LETHAL_OBSTACLE));
+}
+
+TEST(CostmapPyramidTests, scrollsMatchRebuild) {
+  // a rolling window over a larger world, at an origin off the cell grid
+  const int world_size = 400;
+  const int size_x = 100;
+  const int size_y = 90;
+  const double res = 0.05;
+  std::vector<unsigned char> world(world_size * world_size, FREE_SPACE);
+  std::vector<unsigned char> cells(size_x * size_y);
+
+  srand(11);
+  for( int i=0; i<world.size(); i++ ) {
+    const int r = rand() % 100;
+    world[i] = r < 5 ? LETHAL_OBSTACLE : r < 8 ? NO_INFORMATION :
+      r < 20 ? rand() % LETHAL_OBSTACLE : FREE_SPACE;
+  }
+
+  CostmapPyramid pyramid;
+  int wx = 150;
+  int wy = 150;
+  double offset = 0.013;
+  // window cell the pyramid aligned its coarse cells to, in the world
+  int align_x = wx;
+  int align_y = wy;
+  for( int step=0; step<60; step++ ) {
+    if( step > 0 ) {
+      // mostly small scrolls, sometimes none, once off the grid
+      wx += rand() % 11 - 5;
+      wy += rand() % 11 - 5;
+      if( step == 30 ) {
+        offset += 0.5 * res;
+        align_x = wx;
+        align_y = wy;
+      }
+      // and edits, in and out of the window
+      for( int e=0; e<50; e++ ) {
+        const int x = wx - 10 + rand() % (size_x + 20);
+        const int y = wy - 10 + rand() % (size_y + 20);
+        world[y * world_size + x] = rand() % 3 == 0 ? LETHAL_OBSTACLE :
+          rand() % 2 == 0 ? NO_INFORMATION : FREE_SPACE;
+      }
+    }
+    for( int y=0; y<size_y; y++ ) {
+      for( int x=0; x<size_x; x++ ) {
+        cells[y * size_x + x] = world[(y + wy) * world_size + x + wx];
+      }
+    }
+    const CostGrid grid(size_x, size_y, res, wx * res + offset,
+        wy * res + offset, &cells[0]);
+    pyramid.update(grid);
+    CostmapPyramid rebuilt;
+    rebuilt.update(grid);
+
+    // every level holds the highest known cost under each of its cells
+    for( int l=0; l<CostmapPyramid::LEVELS; l++ ) {
+      const int bx0 = coarsen(wx - align_x, l);
+      const int by0 = coarsen(wy - align_y, l);
+      const int bsize_x = coarsen(size_x - 1 + wx - align_x, l) - bx0 + 1;
+      const int bsize_y = coarsen(size_y - 1 + wy - align_y, l) - by0 + 1;
+      std::vector<unsigned char> expected(bsize_x * bsize_y, FREE_SPACE);
+      for( int y=0; y<size_y; y++ ) {
+        const int by = coarsen(y + wy - align_y, l) - by0;
+        for( int x=0; x<size_x; x++ ) {
+          const int bx = coarsen(x + wx - align_x, l) - bx0;
+          const unsigned char cost = cells[y * size_x + x];
+          if( cost != NO_INFORMATION ) {
+            expected[by * bsize_x + bx] = std::max(
+                expected[by * bsize_x + bx], cost);
+          }
+        }
+      }
+      for( int my=0; my<size_y; my++ ) {
+        const int by = coarsen(my + wy - align_y, l) - by0;
+        for( int mx=0; mx<size_x; mx++ ) {
+          const int bx = coarsen(mx + wx - align_x, l) - bx0;
+          ASSERT_EQ(expected[by * bsize_x + bx],
+              pyramid.levelCost(l, mx, my)) << "step " << step <<
+            " level " << l << " cell " << mx << ", " << my;
+        }
+      }
+    }
+    // and answers the same as a pyramid built from scratch
+    for( int i=0; i<200; i++ ) {
+      const double x = grid.getOriginX() + uniform(-0.5, size_x * res + 0.5);
+      const double y = grid.getOriginY() + uniform(-0.5, size_y * res + 0.5);
+      const double radius = uniform(0, 0.6);
+      const unsigned char threshold = rand() % 2 ? LETHAL_OBSTACLE : 128;
+      const bool free = rebuilt.discFree(x, y, radius, threshold, false);
+      ASSERT_EQ(free, pyramid.discFree(x, y, radius, threshold, true));
+      ASSERT_EQ(free, rebuilt.discFree(x, y, radius, threshold, true));
+    }
+  }
+}
+
+// the first arc length, every millimeter, at which a disc covers the center
+// of a lethal cell; max_length if none does
+double bruteFreeLength(const CostGrid &grid, const std::vector<Disc> &discs,
+    double x, double y, double theta, double curvature, double max_length) {
+  std::vector<Point2D> obstacles;
+  for( int my=0; my<grid.getSizeInCellsY(); my++ ) {
+    for( int mx=0; mx<grid.getSizeInCellsX(); mx++ ) {
+      if( grid.getCost(mx, my) == LETHAL_OBSTACLE ) {
+        Point2D p;
+        p.x = grid.getOriginX() + (mx + 0.5) * grid.getResolution();
+        p.y = grid.getOriginY() + (my + 0.5) * grid.getResolution();
+        obstacles.push_back(p);
+      }
+    }
+  }
+  const int steps = (int)ceil(max_length / 0.001);
+  for( int k=0; k<=steps; k++ ) {
+    const double s = max_length * k / steps;
+    double px = x, py = y, ptheta = theta;
+    dubins_plus::advance(dubins_plus::Segment(s, curvature), px, py, ptheta);
+    for( int d=0; d<discs.size(); d++ ) {
+      const double dx = px + discs[d].x * cos(ptheta) -
+        discs[d].y * sin(ptheta);
+      const double dy = py + discs[d].x * sin(ptheta) +
+        discs[d].y * cos(ptheta);
+      for( int o=0; o<obstacles.size(); o++ ) {
+        if( hypot(dx - obstacles[o].x, dy - obstacles[o].y) <=
+            discs[d].radius ) {
+          return s;
+        }
+      }
+    }
+  }
+  return max_length;
+}
+
+TEST(CostmapPyramidTests, knownCells) {
+  // a 2 m square at 5 cm, free but for a lethal cell at 20, 20, centered at
+  // 1.025, 1.025, and a cell of cost 100 at 5, 30
+  const int size = 40;
+  std::vector<unsigned char> cells(size * size, FREE_SPACE);
+  cells[20 * size + 20] = LETHAL_OBSTACLE;
+  cells[30 * size + 5] = 100;
+  // unknown is free
+  cells[5 * size + 30] = NO_INFORMATION;
+  CostmapPyramid pyramid;
+  pyramid.update(CostGrid(size, size, 0.05, 0, 0, &cells[0]));
+
+  // each level is the maximum over blocks of 2, 4 and 8 cells aligned to
+  // the costmap's origin
+  EXPECT_EQ(LETHAL_OBSTACLE, pyramid.levelCost(0, 20, 20));
+  EXPECT_EQ(FREE_SPACE, pyramid.levelCost(0, 21, 20));
+  EXPECT_EQ(LETHAL_OBSTACLE, pyramid.levelCost(1, 21, 21));
+  EXPECT_EQ(FREE_SPACE, pyramid.levelCost(1, 22, 21));
+  EXPECT_EQ(LETHAL_OBSTACLE, pyramid.levelCost(2, 23, 23));
+  EXPECT_EQ(FREE_SPACE, pyramid.levelCost(2, 24, 23));
+  EXPECT_EQ(LETHAL_OBSTACLE, pyramid.levelCost(3, 16, 23));
+  EXPECT_EQ(FREE_SPACE, pyramid.levelCost(3, 15, 23));
+  EXPECT_EQ(100, pyramid.levelCost(3, 0, 31));
+  EXPECT_EQ(FREE_SPACE, pyramid.levelCost(3, 31, 0));
+
+  for( int c=0; c<2; c++ ) {
+    const bool coarse = c == 1;
+    // a disc whose edge is just short of, or just past, the cell's center
+    EXPECT_TRUE(pyramid.discFree(1.325, 1.025, 0.299, LETHAL_OBSTACLE,
+          coarse));
+    EXPECT_FALSE(pyramid.discFree(1.325, 1.025, 0.301, LETHAL_OBSTACLE,
+          coarse));
+    EXPECT_TRUE(pyramid.discFree(1.025, 0.725, 0.299, LETHAL_OBSTACLE,
+          coarse));
+    EXPECT_FALSE(pyramid.discFree(1.025, 0.725, 0.301, LETHAL_OBSTACLE,
+          coarse));
+    EXPECT_TRUE(pyramid.discFree(1.025 - 0.2, 1.025 + 0.2, 0.28,
+          LETHAL_OBSTACLE, coarse));
+    EXPECT_FALSE(pyramid.discFree(1.025 - 0.2, 1.025 + 0.2, 0.29,
+          LETHAL_OBSTACLE, coarse));
+    // only costs at or above the threshold collide
+    EXPECT_FALSE(pyramid.discFree(0.275, 1.525, 0.1, 100, coarse));
+    EXPECT_TRUE(pyramid.discFree(0.275, 1.525, 0.1, 101, coarse));
+    EXPECT_TRUE(pyramid.discFree(1.525, 0.275, 0.1, 1, coarse));
+  }
+
+  // boxes that stop just short of the cell's center, or just reach past it
+  dubins_plus::Bounds box;
+  box.add(0.5, 0.5);
+  box.add(1.02, 1.5);
+  EXPECT_TRUE(pyramid.boxFree(box, LETHAL_OBSTACLE));
+  box.add(1.03, 1.5);
+  EXPECT_FALSE(pyramid.boxFree(box, LETHAL_OBSTACLE));
+}
+
+TEST(FreeArcTableTests, knownLengths) {
+  // a single disc on the robot's origin; bins every 0.25 from -1.5 to 1.5
+  std::vector<Disc> discs(1);
+  discs[0].x = 0;
+  discs[0].y = 0;
+  discs[0].radius = 0.3;
+  FreeArcTable table;
+  table.reset(1.5, 13, 2.5, discs, 0);
+  ASSERT_EQ(13, table.size());
+  ASSERT_NEAR(0.0, table.curvature(6), 1e-12);
+  ASSERT_NEAR(1.0, table.curvature(10), 1e-12);
+
+  // 2 m straight ahead only blocks driving straight, 30 cm short of it
+  table.addObstacle(2.0, 0);
+  for( int i=0; i<table.size(); i++ ) {
+    EXPECT_NEAR(i == 6 ? 1.7 : 2.5, table.length(i), 1e-9) << "bin " << i;
+  }
+  // and halfway to the next bin, the shorter of the two
+  EXPECT_NEAR(1.7, table.freeLength(0.125), 1e-9);
+  EXPECT_NEAR(1.7, table.freeLength(0), 1e-9);
+
+  // on the circle turning left at a radius of 1 m, a quarter turn around;
+  // contact is when the disc's center is 0.3 m short of it, along the chord
+  table.reset(1.5, 13, 2.5, discs, 0);
+  table.addObstacle(1.0, 1.0);
+  EXPECT_NEAR(M_PI / 2 - 2 * asin(0.15), table.length(10), 1e-9);
+  // not when driving straight, or turning right
+  for( int i=0; i<=6; i++ ) {
+    EXPECT_NEAR(2.5, table.length(i), 1e-9) << "bin " << i;
+  }
+
+  // a disc ahead of the origin, with a margin, reaches further
+  discs[0].x = 0.4;
+  discs[0].radius = 0.2;
+  table.reset(1.5, 13, 2.5, discs, 0.05);
+  table.addObstacle(2.0, 0);
+  EXPECT_NEAR(2.0 - 0.4 - 0.25, table.length(6), 1e-9);
+
+  // a single lethal cell, centered 2.025 m ahead and 2.5 cm to the left of
+  // the robot
+  discs[0].x = 0;
+  discs[0].radius = 0.3;
+  const int size = 100;
+  std::vector<unsigned char> cells(size * size, FREE_SPACE);
+  cells[50 * size + 90] = LETHAL_OBSTACLE;
+  cells[10 * size + 10] = INSCRIBED_INFLATED_OBSTACLE;
+  const CostGrid grid(size, size, 0.05, -2.5, -2.5, &cells[0]);
+  table.reset(1.5, 13, 2.5, discs, 0);
+  table.addCostmap(grid, 0, 0, 0, LETHAL_OBSTACLE);
+  const double expected = 2.025 - sqrt(0.3 * 0.3 - 0.025 * 0.025);
+  EXPECT_NEAR(expected, table.length(6), 1e-9);
+  EXPECT_NEAR(2.5, table.length(5), 1e-9);
+  // the same cell from a robot a meter behind it and facing it
+  table.reset(1.5, 13, 2.5, discs, 0);
+  table.addCostmap(grid, 2.025, -0.975, M_PI / 2, LETHAL_OBSTACLE);
+  EXPECT_NEAR(1.0 - 0.3, table.length(6), 1e-9);
+}
+
+TEST(FreeArcTableTests, matchesSampling) {
+  std::vector<Disc> discs = coverFootprint(TrajectoryLibraryOptions().footprint);
+  // and one off the robot's axis
+  Disc side;
+  side.x = 0.1;
+  side.y = 0.25;
+  side.radius = 0.1;
+  discs.push_back(side);
+
+  const int size = 80;
+  const double res = 0.05;
+  const double max_length = 2.5;
+  std::vector<unsigned char> cells(size * size);
+  const CostGrid grid(size, size, res, -2.0, -2.0, &cells[0]);
+
+  srand(13);
+  for( int trial=0; trial<10; trial++ ) {
+    const double x = uniform(-0.5, 0.5);
+    const double y = uniform(-0.5, 0.5);
+    const double theta = uniform(-M_PI, M_PI);
+    // scattered obstacles, none where the robot starts
+    for( int my=0; my<size; my++ ) {
+      for( int mx=0; mx<size; mx++ ) {
+        const double cx = -2.0 + (mx + 0.5) * res;
+        const double cy = -2.0 + (my + 0.5) * res;
+        const int r = rand() % 100;
+        cells[my * size + mx] = hypot(cx - x, cy - y) < 0.6 ? FREE_SPACE :
+          r < 1 ? LETHAL_OBSTACLE : r < 3 ? NO_INFORMATION : FREE_SPACE;
+      }
+    }
+
+    FreeArcTable table;
+    table.reset(1.5, 13, max_length, discs, 0);
+    table.addCostmap(grid, x, y, theta, LETHAL_OBSTACLE);
+    ASSERT_EQ(table.size(), 13);
+    for( int i=0; i<table.size(); i++ ) {
+      const double k = table.curvature(i);
+      const double expected = bruteFreeLength(grid, discs, x, y, theta, k,
+          max_length);
+      // contact is between the last free sample and the first one that
+      // hits
+      EXPECT_LE(table.length(i), expected + 1e-6) << "trial " << trial <<
+        " curvature " << k;
+      EXPECT_GE(table.length(i), expected - 0.002) << "trial " << trial <<
+        " curvature " << k;
+      // between bins, the shorter of the two
+      EXPECT_LE(table.freeLength(k), table.length(i));
+      if( i > 0 ) {
+        const double between = table.freeLength(
+            (table.curvature(i - 1) + k) / 2);
+        EXPECT_EQ(std::min(table.length(i - 1), table.length(i)), between);
+      }
+    }
+  }
+}
+
+// a cell a curve is in, and the arc length at which it got there
+struct CellVisit {
+  int x;
+  int y;
+  double entry;
+};
+
+// the cells a curve passes through, sampled every step, in order
+std::vector<CellVisit> sampleCells(double x, double y, double theta,
+    double length, double curvature, double step) {
+  std::vector<CellVisit> visits;
+  const int steps = (int)ceil(length / step);
+  for( int k=0; k<=steps; k++ ) {
+    const double s = length * k / steps;
+    double px = x, py = y, ptheta = theta;
+    dubins_plus::advance(dubins_plus::Segment(s, curvature), px, py, ptheta);
+    CellVisit visit;
+    visit.x = (int)floor(px);
+    visit.y = (int)floor(py);
+    visit.entry = s;
+    if( visits.empty() || visits.back().x != visit.x ||
+        visits.back().y != visit.y ) {
+      visits.push_back(visit);
+    }
+  }
+  return visits;
+}
+
+// walk a curve, and check its cells and where it entered them
+void expectCells(CellTraversal cells, const int *xs, const int *ys,
+    const double *entries, int n) {
+  int cx, cy;
+  int i = 0;
+  while( cells.next(cx, cy) ) {
+    ASSERT_LT(i, n) << "extra cell " << cx << ", " << cy;
+    EXPECT_EQ(xs[i], cx) << "cell " << i;
+    EXPECT_EQ(ys[i], cy) << "cell " << i;
+    EXPECT_NEAR(entries[i], cells.entry(), 1e-9) << "cell " << i;
+    i++;
+  }
+  EXPECT_EQ(n, i);
+}
+
+TEST(CellTraversalTests, knownCells) {
+  // from the center of cell 0, 0 to the center of cell 4, 2
+  const double h = sqrt(5.0) / 2;
+  const int line_x[] = { 0, 1, 1, 2, 3, 3, 4 };
+  const int line_y[] = { 0, 0, 1, 1, 1, 2, 2 };
+  const double line_s[] = { 0, 0.5 * h, h, 1.5 * h, 2.5 * h, 3 * h,
+    3.5 * h };
+  expectCells(CellTraversal(0.5, 0.5, atan2(1.0, 2.0), sqrt(20.0), 0),
+      line_x, line_y, line_s, 7);
+
+  // backwards along x, into negative cells
+  const int back_x[] = { 0, -1, -2 };
+  const int back_y[] = { 0, 0, 0 };
+  const double back_s[] = { 0, 0.5, 1.5 };
+  expectCells(CellTraversal(0.5, 0.5, M_PI, 2.0, 0), back_x, back_y, back_s,
+      3);
+
+  // a quarter turn left at a radius of 2 cells about 0.5, 2.5; it crosses
+  // x = 1 where sin(phi) = 1/4, y = 1 where cos(phi) = 3/4, and so on
+  const int arc_x[] = { 0, 1, 1, 2, 2 };
+  const int arc_y[] = { 0, 0, 1, 1, 2 };
+  const double arc_s[] = { 0, 2 * asin(0.25), 2 * acos(0.75),
+    2 * asin(0.75), 2 * acos(0.25) };
+  expectCells(CellTraversal(0.5, 0.5, 0, M_PI, 0.5), arc_x, arc_y, arc_s, 5);
+
+  // the same turn to the right, mirrored below y = 0.5
+  const int right_y[] = { 0, 0, -1, -1, -2 };
+  expectCells(CellTraversal(0.5, 0.5, 0, M_PI, -0.5), arc_x, right_y, arc_s,
+      5);
+}
+
+TEST(CellTraversalTests, matchesSampling) {
+  const double step = 1e-4;
+  srand(17);
+  for( int trial=0; trial<200; trial++ ) {
+    const double x = uniform(-5, 5);
+    const double y = uniform(-5, 5);
+    const double theta = uniform(-2 * M_PI, 2 * M_PI);
+    const double length = uniform(0, 30);
+    // a quarter of them lines, the rest arcs down to a couple of cells
+    // across, some of them more than once around
+    const double curvature = trial % 4 == 0 ? 0 : uniform(-1, 1);
+
+    const std::vector<CellVisit> sampled = sampleCells(x, y, theta, length,
+        curvature, step);
+    CellTraversal cells(x, y, theta, length, curvature);
+    int cx, cy;
+    int j = 0;
+    int visited = 0;
+    while( cells.next(cx, cy) ) {
+      visited++;
+      ASSERT_LT(visited, 10000);
+      if( j < sampled.size() && cx == sampled[j].x && cy == sampled[j].y ) {
+        EXPECT_NEAR(sampled[j].entry, cells.entry(), step + 1e-9) <<
+          "trial " << trial << " cell " << cx << ", " << cy;
+        j++;
+        continue;
+      }
+      // a cell the samples stepped over: the curve only clips its corner,
+      // and enters it on its edge
+      double px = x, py = y, ptheta = theta;
+      dubins_plus::advance(dubins_plus::Segment(cells.entry(), curvature),
+          px, py, ptheta);
+      const double dx = std::max(0.0, std::max(cx - px, px - (cx + 1)));
+      const double dy = std::max(0.0, std::max(cy - py, py - (cy + 1)));
+      EXPECT_LT(hypot(dx, dy), 1e-6) << "trial " << trial << " cell " <<
+        cx << ", " << cy;
+    }
+    // every sampled cell, in order
+    EXPECT_EQ(sampled.size(), j) << "trial " << trial;
+  }
+}
+
+TEST(PlanCorridorTests, knownWidths) {
+  // a 3 m square at 5 cm; the plan runs along the middle of row 40, at
+  // y = 2.025, every 10 cm from x = 0.525
+  const int size = 60;
+  std::vector<unsigned char> cells(size * size, FREE_SPACE);
+  for( int x=0; x<size; x++ ) {
+    // a wall on the left, starting at y = 2.5, with a gap from x = 1.0 to
+    // 1.2; and one on the right that ends at y = 1.75
+    if( x < 20 || x >= 24 ) {
+      cells[50 * size + x] = LETHAL_OBSTACLE;
+    }
+    cells[34 * size + x] = INSCRIBED_INFLATED_OBSTACLE;
+    // nearer costs under the threshold, and unknown, don't block
+    cells[38 * size + x] = INSCRIBED_INFLATED_OBSTACLE - 1;
+    cells[36 * size + x] = NO_INFORMATION;
+  }
+  const CostGrid grid(size, size, 0.05, 0, 0, &cells[0]);
+  std::vector<Pose2D> plan;
+  for( int i=0; i<=20; i++ ) {
+    plan.push_back(Pose2D(0.525 + 0.1 * i, 2.025, 0));
+  }
+  FrenetFrame frame;
+  frame.setPlan(plan);
+  PlanCorridor corridor;
+  corridor.setPlan(frame);
+  corridor.setWidth(1.0);
+  corridor.update(grid);
+  ASSERT_EQ(21, corridor.size());
+
+  for( int i=0; i<corridor.size(); i++ ) {
+    const bool gap = i == 5 || i == 6;
+    // each ray ends where it enters the first blocked cell
+    EXPECT_NEAR(gap ? 1.0 : 0.475, corridor.left(i), 1e-9) << "station " << i;
+    EXPECT_NEAR(0.275, corridor.right(i), 1e-9) << "station " << i;
+  }
+  EXPECT_TRUE(corridor.contains(0, 0.47));
+  EXPECT_FALSE(corridor.contains(0, 0.48));
+  EXPECT_TRUE(corridor.contains(0, -0.27));
+  EXPECT_FALSE(corridor.contains(0, -0.28));
+  EXPECT_TRUE(corridor.contains(5, 0.9));
+  EXPECT_NEAR(0.075, corridor.clearance(0, 0.4), 1e-9);
+  EXPECT_NEAR(0.175, corridor.clearance(0, -0.1), 1e-9);
+  EXPECT_NEAR(-0.025, corridor.clearance(0, -0.3), 1e-9);
+
+  // along the plan is inside; veering off to the left is not
+  std::vector<dubins_plus::Segment> path(1, dubins_plus::Segment(1.9, 0));
+  EXPECT_TRUE(corridor.pathInside(path, 0.525, 2.025, 0, 0));
+  path[0] = dubins_plus::Segment(1.0, 0);
+  EXPECT_FALSE(corridor.pathInside(path, 0.525, 2.025, M_PI / 4, 0));
+  // except through the gap
+  path[0] = dubins_plus::Segment(0.8, 0);
+  EXPECT_TRUE(corridor.pathInside(path, 1.075, 2.025, M_PI / 2, 5));
+}
+
+TEST(PlanCorridorTests, updatesMatchReset) {
+  // a winding plan, with its poses off the grid lines
+  std::vector<Pose2D> plan;
+  for( int i=0; i<80; i++ ) {
+    Pose2D pose;
+    pose.x = 5.0137 + 0.1 * i;
+    pose.y = 10.0071 + 0.8 * sin(0.1 * i);
+    pose.theta = atan2(0.08 * cos(0.1 * i), 1.0);
+    plan.push_back(pose);
+  }
+  FrenetFrame frame;
+  frame.setPlan(plan);
+
+  // a rolling window over a larger world that follows the plan
+  const int world_size = 400;
+  const int size = 120;
+  const double res = 0.05;
+  std::vector<unsigned char> world(world_size * world_size, FREE_SPACE);
+  std::vector<unsigned char> cells(size * size);
+  srand(19);
+  for( int i=0; i<world.size(); i++ ) {
+    const int r = rand() % 100;
+    world[i] = r < 2 ? LETHAL_OBSTACLE : r < 4 ? INSCRIBED_INFLATED_OBSTACLE :
+      r < 6 ? NO_INFORMATION : r < 20 ? rand() % INSCRIBED_INFLATED_OBSTACLE :
+      FREE_SPACE;
+  }
+
+  PlanCorridor corridor;
+  corridor.setPlan(frame);
+  corridor.setWidth(1.5);
+  int wx = 60;
+  int wy = 140;
+  int updated = 0;
+  const int steps = 40;
+  for( int step=0; step<steps; step++ ) {
+    if( step > 0 ) {
+      // scroll along the plan, sometimes not at all
+      wx += rand() % 6 - 1;
+      wy += rand() % 5 - 2;
+      // and edit cells in and out of the window
+      for( int e=0; e<40; e++ ) {
+        const int x = wx - 10 + rand() % (size + 20);
+        const int y = wy - 10 + rand() % (size + 20);
+        world[y * world_size + x] = rand() % 2 == 0 ? LETHAL_OBSTACLE :
+          rand() % 2 == 0 ? NO_INFORMATION : FREE_SPACE;
+      }
+    }
+    for( int y=0; y<size; y++ ) {
+      for( int x=0; x<size; x++ ) {
+        cells[y * size + x] = world[(y + wy) * world_size + x + wx];
+      }
+    }
+    const CostGrid grid(size, size, res, wx * res, wy * res, &cells[0]);
+    corridor.update(grid);
+    if( step > 0 ) {
+      updated += corridor.lastUpdateSize();
+    }
+
+    PlanCorridor fresh;
+    fresh.setPlan(frame);
+    fresh.setWidth(1.5);
+    fresh.update(grid);
+    ASSERT_EQ(fresh.size(), corridor.size());
+    for( int i=0; i<fresh.size(); i++ ) {
+      ASSERT_NEAR(fresh.left(i), corridor.left(i), 1e-9) << "step " <<
+        step << " station " << i;
+      ASSERT_NEAR(fresh.right(i), corridor.right(i), 1e-9) << "step " <<
+        step << " station " << i;
+    }
+  }
+  // the updates were incremental
+  EXPECT_GT(updated, 0);
+  EXPECT_LT(updated, (steps - 1) * corridor.size() / 2);
+}
+
+Pose2D pose(double x, double y, double theta) {
+  Pose2D p;
+  p.x = x;
+  p.y = y;
+  p.theta = theta;
+  return p;
+}
+
+TEST(PlanValidationTests, tightArc) {
+  // straight, a left turn of radius 0.5, then straight again
+  std::vector<Pose2D> plan;
+  for( int i=0; i<=10; i++ ) {
+    plan.push_back(pose(0.05 * i, 0, 0));
+  }
+  for( int k=1; k<=5; k++ ) {
+    const double phi = 0.1 * k;
+    plan.push_back(pose(0.5 + 0.5 * sin(phi), 0.5 - 0.5 * cos(phi), phi));
+  }
+  const Pose2D end = plan.back();
+  for( int i=1; i<=10; i++ ) {
+    plan.push_back(pose(end.x + 0.05 * i * cos(end.theta),
+          end.y + 0.05 * i * sin(end.theta), end.theta));
+  }
+
+  // too tight for a 0.7m turning radius, from the last straight pose to
+  // the end of the arc
+  std::vector<InfeasibleStretch> bad = validatePlan(plan, 1 / 0.7, 0.5);
+  ASSERT_EQ(1u, bad.size());
+  EXPECT_EQ(InfeasibleStretch::CURVATURE, bad[0].reason);
+  EXPECT_EQ(10, bad[0].start);
+  EXPECT_EQ(15, bad[0].end);
+  EXPECT_NEAR(2.0, bad[0].worst, 0.01);
+
+  // and fine for a 0.4m one
+  EXPECT_TRUE(validatePlan(plan, 1 / 0.4, 0.5).empty());
+}
+
+TEST(PlanValidationTests, cusps) {
+  std::vector<Pose2D> plan;
+  for( int i=0; i<=10; i++ ) {
+    plan.push_back(pose(0.05 * i, 0, 0));
+  }
+
+  // backing up with the same heading is a good cusp
+  std::vector<Pose2D> reverse = plan;
+  reverse.push_back(pose(0.45, 0, 0));
+  EXPECT_TRUE(validatePlan(reverse, 100, 0.5).empty());
+
+  // a heading change of 0.3 across the reversal is within a tolerance of
+  // 0.5 but not of 0.2
+  std::vector<Pose2D> turn = plan;
+  turn.push_back(pose(0.45, 0, 0.3));
+  EXPECT_TRUE(validatePlan(turn, 100, 0.5).empty());
+  std::vector<InfeasibleStretch> bad = validatePlan(turn, 100, 0.2);
+  ASSERT_EQ(1u, bad.size());
+  EXPECT_EQ(InfeasibleStretch::CUSP, bad[0].reason);
+  EXPECT_EQ(9, bad[0].start);
+  EXPECT_EQ(11, bad[0].end);
+  EXPECT_NEAR(0.3, bad[0].worst, 1e-9);
+
+  // turning around in place, as a plan for a differential drive robot
+  // would, is a bad cusp and too tight
+  std::vector<Pose2D> flip = plan;
+  flip.push_back(pose(0.45, 0, M_PI));
+  bad = validatePlan(flip, 1 / 0.7, 0.5);
+  ASSERT_EQ(2u, bad.size());
+  EXPECT_EQ(InfeasibleStretch::CUSP, bad[0].reason);
+  EXPECT_NEAR(M_PI, bad[0].worst, 1e-9);
+  EXPECT_EQ(InfeasibleStretch::CURVATURE, bad[1].reason);
+  EXPECT_EQ(10, bad[1].start);
+  EXPECT_EQ(11, bad[1].end);
+}
+
+TEST(CostToGoTests, knownCosts) {
+  // a straight plan 4m long along the middle of an empty 5m map
+  std::vector<Pose2D> plan;
+  for( int i=0; i<=80; i++ ) {
+    plan.push_back(pose(0.525 + 0.05 * i, 2.525, 0));
+  }
+  const int size = 100;
+  const double res = 0.05;
+  std::vector<unsigned char> cells(size * size, FREE_SPACE);
+  // and a box around a cell off to the side
+  for( int y=79; y<=81; y++ ) {
+    for( int x=19; x<=21; x++ ) {
+      if( x != 20 || y != 80 ) {
+        cells[y * size + x] = LETHAL_OBSTACLE;
+      }
+    }
+  }
+  const CostGrid grid(size, size, res, 0, 0, &cells[0]);
+
+  CostToGoField field;
+  field.setPlan(plan);
+  field.update(grid);
+  // along the plan, the length of plan left
+  EXPECT_NEAR(0.0, field.costAt(4.525, 2.525), 1e-4);
+  EXPECT_NEAR(4.0, field.costAt(0.525, 2.525), 1e-4);
+  EXPECT_NEAR(2.0, field.costAt(2.525, 2.525), 1e-4);
+  // straight across to the plan from 1m to the side of the goal
+  EXPECT_NEAR(1.0, field.costAt(4.525, 3.525), 1e-4);
+  EXPECT_NEAR(1.0, field.costAt(4.525, 1.525), 1e-4);
+  // nowhere to go from the box, and nothing off the map
+  EXPECT_TRUE(std::isinf(field.costAt(1.025, 4.025)));
+  EXPECT_TRUE(std::isinf(field.costAt(-1.0, 2.5)));
+  // lethal cells themselves are unreachable
+  EXPECT_TRUE(std::isinf(field.costAt(0.975, 4.025)));
+}
+
+TEST(CostToGoTests, updatesMatchReset) {
+  // a winding plan through a rolling window over a larger world
+  std::vector<Pose2D> plan;
+  for( int i=0; i<80; i++ ) {
+    plan.push_back(pose(5.0137 + 0.1 * i, 10.0071 + 0.8 * sin(0.1 * i),
+          atan2(0.08 * cos(0.1 * i), 1.0)));
+  }
+  const int world_size = 400;
+  const int size = 120;
+  const double res = 0.05;
+  std::vector<unsigned char> world(world_size * world_size, FREE_SPACE);
+  std::vector<unsigned char> cells(size * size);
+  srand(23);
+  for( int i=0; i<world.size(); i++ ) {
+    const int r = rand() % 100;
+    world[i] = r < 3 ? LETHAL_OBSTACLE : r < 5 ? NO_INFORMATION :
+      r < 25 ? rand() % INSCRIBED_INFLATED_OBSTACLE : FREE_SPACE;
+  }
+
+  CostToGoField field;
+  field.setPlan(plan);
+  int wx = 60;
+  int wy = 140;
+  for( int step=0; step<30; step++ ) {
+    if( step > 0 ) {
+      // edits every step, and a scroll every other step
+      if( step % 2 == 0 ) {
+        wx += rand() % 6 - 1;
+        wy += rand() % 5 - 2;
+      }
+      for( int e=0; e<40; e++ ) {
+        const int x = wx - 10 + rand() % (size + 20);
+        const int y = wy - 10 + rand() % (size + 20);
+        world[y * world_size + x] = rand() % 2 == 0 ? LETHAL_OBSTACLE :
+          rand() % 2 == 0 ? NO_INFORMATION : FREE_SPACE;
+      }
+    }
+    for( int y=0; y<size; y++ ) {
+      for( int x=0; x<size; x++ ) {
+        cells[y * size + x] = world[(y + wy) * world_size + x + wx];
+      }
+    }
+    const CostGrid grid(size, size, res, wx * res, wy * res, &cells[0]);
+    field.update(grid);
+
+    CostToGoField fresh;
+    fresh.setPlan(plan);
+    fresh.update(grid);
+    for( int y=0; y<size; y++ ) {
+      for( int x=0; x<size; x++ ) {
+        const double px = grid.getOriginX() + (x + 0.5) * res;
+        const double py = grid.getOriginY() + (y + 0.5) * res;
+        const double expected = fresh.costAt(px, py);
+        const double cost = field.costAt(px, py);
+        if( std::isinf(expected) ) {
+          ASSERT_TRUE(std::isinf(cost)) << "step " << step << " cell " <<
+            x << ", " << y;
+        } else {
+          ASSERT_NEAR(expected, cost, 1e-4 * (1 + expected)) << "step " <<
+            step << " cell " << x << ", " << y;
+        }
+      }
+    }
+    if( step > 0 ) {
+      // and the update didn't just start over
+      EXPECT_LT(field.lastUpdateSize(), size * size);
+    }
+  }
+}
+
+// whether a path from the origin clears a single scan point
+bool clearOfPoint(const std::vector<dubins_plus::Segment> &path,
+    const std::vector<Disc> &discs, double px, double py) {
+  ScanObstacles obstacles;
+  obstacles.addPoint(px, py);
+  // and one far away, so the index covers more than one bucket
+  obstacles.addPoint(-5, -5);
+  obstacles.buildIndex(0.5);
+  return obstacles.pathClear(path, 0, 0, 0, discs);
+}
+
+TEST(ScanObstaclesTests, discEdgeOnLine) {
+  std::vector<dubins_plus::Segment> path;
+  path.push_back(dubins_plus::Segment(2.0, 0.0));
+  std::vector<Disc> discs(1);
+  discs[0].x = 0;
+  discs[0].y = 0;
+  discs[0].radius = 0.3;
+
+  // beside the middle of the segment
+  EXPECT_FALSE(clearOfPoint(path, discs, 1.0, 0.299));
+  EXPECT_TRUE(clearOfPoint(path, discs, 1.0, 0.301));
+  EXPECT_FALSE(clearOfPoint(path, discs, 1.0, -0.299));
+  EXPECT_TRUE(clearOfPoint(path, discs, 1.0, -0.301));
+  // past either end
+  EXPECT_FALSE(clearOfPoint(path, discs, 2.299, 0));
+  EXPECT_TRUE(clearOfPoint(path, discs, 2.301, 0));
+  EXPECT_FALSE(clearOfPoint(path, discs, -0.299, 0));
+  EXPECT_TRUE(clearOfPoint(path, discs, -0.301, 0));
+
+  // a disc ahead of the robot's origin reaches that much further
+  discs[0].x = 0.5;
+  EXPECT_FALSE(clearOfPoint(path, discs, 2.799, 0));
+  EXPECT_TRUE(clearOfPoint(path, discs, 2.801, 0));
+}
+
+TEST(ScanObstaclesTests, discEdgeOnArc) {
+  // a quarter turn left about 0, 1
+  std::vector<dubins_plus::Segment> path;
+  path.push_back(dubins_plus::Segment(M_PI / 2, 1.0));
+  std::vector<Disc> discs(1);
+  discs[0].x = 0;
+  discs[0].y = 0;
+  discs[0].radius = 0.3;
+
+  // halfway around, outside and inside the arc
+  const double a = -M_PI / 4;
+  EXPECT_FALSE(clearOfPoint(path, discs, 1.299 * cos(a), 1 + 1.299 * sin(a)));
+  EXPECT_TRUE(clearOfPoint(path, discs, 1.301 * cos(a), 1 + 1.301 * sin(a)));
+  EXPECT_FALSE(clearOfPoint(path, discs, 0.701 * cos(a), 1 + 0.701 * sin(a)));
+  EXPECT_TRUE(clearOfPoint(path, discs, 0.699 * cos(a), 1 + 0.699 * sin(a)));
+  // past the end of the turn, at 1, 1 facing along y
+  EXPECT_FALSE(clearOfPoint(path, discs, 1, 1.299));
+  EXPECT_TRUE(clearOfPoint(path, discs, 1, 1.301));
+
+  // a disc ahead of the origin turns on a wider circle
+  discs[0].x = 0.5;
+  const double rho = hypot(0.5, 1.0);
+  const double mid = atan2(-1.0, 0.5) + M_PI / 4;
+  EXPECT_FALSE(clearOfPoint(path, discs, (rho + 0.299) * cos(mid),
+        1 + (rho + 0.299) * sin(mid)));
+  EXPECT_TRUE(clearOfPoint(path, discs, (rho + 0.301) * cos(mid),
+        1 + (rho + 0.301) * sin(mid)));
+
+  // and after a straight, the turn starts where the straight ends
+  discs[0].x = 0;
+  path.insert(path.begin(), dubins_plus::Segment(1.0, 0.0));
+  EXPECT_FALSE(clearOfPoint(path, discs, 1 + 1.299 * cos(a),
+        1 + 1.299 * sin(a)));
+  EXPECT_TRUE(clearOfPoint(path, discs, 1 + 1.301 * cos(a),
+        1 + 1.301 * sin(a)));
+}
+
+// along x from the origin for 2 m, then left along y for 2 m, every 10 cm
+std::vector<Pose2D> cornerPlan() {
+  std::vector<Pose2D> plan;
+  for( int i=0; i<=20; i++ ) {
+    plan.push_back(pose(0.1 * i, 0, i < 20 ? 0 : M_PI / 2));
+  }
+  for( int i=1; i<=20; i++ ) {
+    plan.push_back(pose(2.0, 0.1 * i, M_PI / 2));
+  }
+  return plan;
+}
+
+TEST(FrenetFrameTests, knownCoordinates) {
+  FrenetFrame frame;
+  frame.setPlan(cornerPlan());
+  ASSERT_EQ(41, frame.size());
+  EXPECT_NEAR(4.0, frame.arcLength(40), 1e-9);
+
+  double s, d;
+  // d is positive to the left of the plan's heading
+  frame.toFrenet(1.0, 0.5, 0, 40, s, d);
+  EXPECT_NEAR(1.0, s, 1e-9);
+  EXPECT_NEAR(0.5, d, 1e-9);
+  frame.toFrenet(1.25, -0.3, 0, 40, s, d);
+  EXPECT_NEAR(1.25, s, 1e-9);
+  EXPECT_NEAR(-0.3, d, 1e-9);
+  // heading along y, left is toward -x
+  frame.toFrenet(1.6, 1.0, 0, 40, s, d);
+  EXPECT_NEAR(3.0, s, 1e-9);
+  EXPECT_NEAR(0.4, d, 1e-9);
+  frame.toFrenet(2.4, 1.0, 0, 40, s, d);
+  EXPECT_NEAR(3.0, s, 1e-9);
+  EXPECT_NEAR(-0.4, d, 1e-9);
+  // only the poses asked for are searched
+  frame.toFrenet(2.4, 1.0, 0, 15, s, d);
+  EXPECT_NEAR(1.5, s, 1e-9);
+
+  double x, y, theta;
+  frame.toCartesian(3.0, 0.4, x, y, theta);
+  EXPECT_NEAR(1.6, x, 1e-9);
+  EXPECT_NEAR(1.0, y, 1e-9);
+  EXPECT_NEAR(M_PI / 2, theta, 1e-9);
+  frame.toCartesian(1.0, -0.5, x, y, theta);
+  EXPECT_NEAR(1.0, x, 1e-9);
+  EXPECT_NEAR(-0.5, y, 1e-9);
+  EXPECT_NEAR(0.0, theta, 1e-9);
+}
+
+TEST(FrenetFrameTests, roundTrip) {
+  srand(9);
+  FrenetFrame frame;
+  frame.setPlan(cornerPlan());
+  for( int i=0; i<1000; i++ ) {
+    // clear of the corner, where the nearest point could be on either leg
+    const double s = i % 2 ? uniform(0.2, 1.5) : uniform(2.5, 3.8);
+    const double d = uniform(-0.4, 0.4);
+    double x, y, theta;
+    frame.toCartesian(s, d, x, y, theta);
+    double s2, d2;
+    frame.toFrenet(x, y, 0, frame.size() - 1, s2, d2);
+    ASSERT_NEAR(s, s2, 1e-9) << "s " << s << " d " << d;
+    ASSERT_NEAR(d, d2, 1e-9) << "s " << s << " d " << d;
+    double x2, y2;
+    frame.toCartesian(s2, d2, x2, y2, theta);
+    ASSERT_NEAR(x, x2, 1e-9);
+    ASSERT_NEAR(y, y2, 1e-9);
+  }
+}
+
+// lethal cells in a rectangle of an 8 m square at 5 cm
+void addWall(std::vector<unsigned char> &cells, double x0, double y0,
+    double x1, double y1) {
+  const int size = 160;
+  cells.resize(size * size, FREE_SPACE);
+  for( int y=0; y<size; y++ ) {
+    for( int x=0; x<size; x++ ) {
+      const double cx = (x + 0.5) * 0.05;
+      const double cy = (y + 0.5) * 0.05;
+      if( cx >= x0 && cx <= x1 && cy >= y0 && cy <= y1 ) {
+        cells[y * size + x] = LETHAL_OBSTACLE;
+      }
+    }
+  }
+}
+
+EscapeSearch escapeSearch(const std::vector<unsigned char> &cells) {
+  EscapeSearch search;
+  EscapeSearchOptions options;
+  // long enough to always finish, so that the answer doesn't depend on how
+  // fast the machine is
+  options.search_time = 60.0;
+  search.setOptions(options);
+  std::vector<Point2D> footprint;
+  footprint.push_back(Point2D(-0.16, -0.15));
+  footprint.push_back(Point2D(-0.16, 0.15));
+  footprint.push_back(Point2D(0.45, 0.15));
+  footprint.push_back(Point2D(0.45, -0.15));
+  search.setFootprint(footprint);
+  search.updateCostmap(CostGrid(160, 160, 0.05, 0, 0, &cells[0]));
+  return search;
+}
+
+TEST(EscapeSearchTests, boxedInAhead) {
+  // walls 2 m wide 10 cm past the nose of the robot and half a meter
+  // behind it, and one 20 cm to its right; it can only get out to the left
+  std::vector<unsigned char> cells;
+  addWall(cells, 4.55, 3.0, 4.7, 5.0);
+  addWall(cells, 3.2, 3.0, 3.35, 5.0);
+  addWall(cells, 3.2, 3.55, 4.7, 3.65);
+  EscapeSearch search = escapeSearch(cells);
+  EXPECT_EQ(0.0, search.freeAhead(4.0, 4.0, 0));
+
+  std::vector<dubins_plus::Segment> maneuver;
+  ASSERT_TRUE(search.search(4.0, 4.0, 0, maneuver));
+  EXPECT_FALSE(search.timedOut());
+  // no room to go forward first or to back out, so back up and turn, then
+  // drive out
+  ASSERT_GE(maneuver.size(), 2u);
+  EXPECT_LT(maneuver.front().getLength(), 0);
+  EXPECT_GT(maneuver.back().getLength(), 0);
+  EXPECT_LE(maneuver.size(), (size_t)search.options().max_segments);
+
+  // every segment is clear, and the last one ends with room ahead
+  double x = 4.0, y = 4.0, theta = 0;
+  for( int i=0; i<maneuver.size(); i++ ) {
+    ASSERT_TRUE(search.segmentClear(maneuver[i], x, y, theta)) << i;
+    const double length = maneuver[i].getLength();
+    if( length < 0 ) {
+      theta += M_PI;
+    }
+    dubins_plus::advance(dubins_plus::Segment(fabs(length),
+          maneuver[i].getCurvature()), x, y, theta);
+    if( length < 0 ) {
+      theta -= M_PI;
+    }
+  }
+  EXPECT_EQ(search.options().clear_distance, search.ahead());
+  EXPECT_EQ(search.options().clear_distance, search.freeAhead(x, y, theta));
+  // out to the left
+  EXPECT_GT(y, 4.0);
+}
+
+TEST(EscapeSearchTests, alreadyClear) {
+  std::vector<unsigned char> cells;
+  addWall(cells, 7.0, 3.0, 7.2, 5.0);
+  EscapeSearch search = escapeSearch(cells);
+  std::vector<dubins_plus::Segment> maneuver;
+  EXPECT_FALSE(search.search(4.0, 4.0, 0, maneuver));
+  EXPECT_TRUE(maneuver.empty());
+  EXPECT_EQ(search.options().clear_distance, search.ahead());
+}
+
+TEST(EscapeSearchTests, walledIn) {
+  // lethal everywhere but a box too small to move in
+  std::vector<unsigned char> cells;
+  addWall(cells, 0, 0, 8, 8);
+  for( int y=74; y<86; y++ ) {
+    for( int x=74; x<96; x++ ) {
+      cells[y * 160 + x] = FREE_SPACE;
+    }
+  }
+  EscapeSearch search = escapeSearch(cells);
+  std::vector<dubins_plus::Segment> maneuver;
+  EXPECT_FALSE(search.search(4.0, 4.0, 0, maneuver));
+  EXPECT_TRUE(maneuver.empty());
+  EXPECT_EQ(0.0, search.ahead());
+}
+
+// a cluster of five points across x, y at 5 cm spacing
+void addScanCluster(double x, double y, std::vector<double> &xs,
+    std::vector<double> &ys) {
+  for( int i=-2; i<=2; i++ ) {
+    xs.push_back(x + 0.05 * i);
+    ys.push_back(y);
+  }
+}
+
+// scans every 0.1 s of a cluster moving from 3, 3, and a parked one at 4, -3
+ObstacleTracker trackCrossing(double vx, double vy, int scans) {
+  ObstacleTracker tracker;
+  for( int k=0; k<scans; k++ ) {
+    const double t = 0.1 * k;
+    std::vector<double> xs, ys;
+    addScanCluster(3 + vx * t, 3 + vy * t, xs, ys);
+    addScanCluster(4, -3, xs, ys);
+    tracker.update(t, xs, ys);
+  }
+  return tracker;
+}
+
+TEST(ObstacleTrackerTests, constantVelocity) {
+  ObstacleTracker tracker = trackCrossing(0.5, -1.0, 5);
+  ASSERT_EQ(2u, tracker.tracks().size());
+  const MovingObstacle &moving = tracker.tracks()[0];
+  EXPECT_NEAR(3.2, moving.x, 1e-9);
+  EXPECT_NEAR(2.6, moving.y, 1e-9);
+  EXPECT_NEAR(0.5, moving.vx, 1e-9);
+  EXPECT_NEAR(-1.0, moving.vy, 1e-9);
+  EXPECT_NEAR(0.1, moving.radius, 1e-9);
+  EXPECT_NEAR(0.4, moving.stamp, 1e-9);
+  EXPECT_EQ(5, moving.hits);
+  EXPECT_TRUE(tracker.isMoving(moving));
+  const MovingObstacle &parked = tracker.tracks()[1];
+  EXPECT_NEAR(4.0, parked.x, 1e-9);
+  EXPECT_NEAR(0.0, hypot(parked.vx, parked.vy), 1e-9);
+  EXPECT_FALSE(tracker.isMoving(parked));
+
+  // a track that hasn't been seen for long enough isn't checked against
+  EXPECT_FALSE(tracker.isMoving(trackCrossing(0.5, -1.0, 2).tracks()[0]));
+}
+
+TEST(ObstacleTrackerTests, predictedCrossing) {
+  // straight across the path along y = 0, crossing it at x = 3 at 3 s
+  ObstacleTracker tracker = trackCrossing(0.0, -1.0, 5);
+  ObstacleTrackerOptions options;
+  options.horizon = 5.0;
+  tracker.setOptions(options);
+  std::vector<dubins_plus::Segment> path;
+  path.push_back(dubins_plus::Segment(5.0, 0.0));
+  std::vector<Disc> discs(1);
+  discs[0].x = 0;
+  discs[0].y = 0;
+  discs[0].radius = 0.3;
+  // a scan after the last one, so the track has moved on to y = 2.5
+  const double now = 0.5;
+
+  // at 3 / 2.5 m/s the robot gets to x = 3 just as the obstacle does
+  const double meet = 3.0 / 2.5;
+  EXPECT_FALSE(tracker.pathClear(path, 0, 0, 0, discs,
+        SpeedProfile(meet, meet, 0), now));
+  // slower, it is still short of the crossing when the obstacle passes
+  EXPECT_TRUE(tracker.pathClear(path, 0, 0, 0, discs,
+        SpeedProfile(0.5, 0.5, 0), now));
+  // and faster, it is well past
+  EXPECT_TRUE(tracker.pathClear(path, 0, 0, 0, discs,
+        SpeedProfile(3.0, 3.0, 0), now));
+  // starting from further along, the robot would be across by then
+  EXPECT_TRUE(tracker.pathClear(path, 2.0, 0, 0, discs,
+        SpeedProfile(meet, meet, 0), now));
+
+  // the parked cluster at 4, -3 is left to the costmap, even on the path
+  EXPECT_TRUE(tracker.pathClear(path, 4.0, -5.0, M_PI / 2, discs,
+        SpeedProfile(0.1, 0.1, 0), now));
+}
+
+// record spans named after the thread, flushing every few
+void recordSpans(Tracer *tracer, const char *name, int spans, int flush_every) {
+  for( int i=0; i<spans; i++ ) {
+    const uint64_t start = Tracer::now();
+    tracer->record(name, start, start + 1000);
+    if( i % flush_every == flush_every - 1 ) {
+      tracer->flush();
+    }
+  }
+}
+
+// record until told to stop, flushing as the planner does
+void recordUntil(Tracer *tracer, const char *name,
+    const boost::atomic<bool> *stop) {
+  while( ! *stop ) {
+    const uint64_t start = Tracer::now();
+    tracer->record(name, start, start + 1000);
+    tracer->maybeFlush();
+  }
+}
+
+std::string readFile(const std::string &filename) {
+  std::ifstream in(filename.c_str());
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+size_t countOf(const std::string &text, const std::string &needle) {
+  size_t count = 0;
+  for( size_t at = text.find(needle); at != std::string::npos;
+      at = text.find(needle, at + 1) ) {
+    count++;
+  }
+  return count;
+}
+
+TEST(TracerTests, everySpanWritten) {
+  const std::string filename = testing::TempDir() + "test_trace.json";
+  const char *names[] = { "span_a", "span_b", "span_c", "span_d" };
+  const int spans = 2000;
+  Tracer tracer;
+  // room for every span, so that none are dropped even if the writer falls
+  // behind
+  ASSERT_TRUE(tracer.open(filename, spans, 10.0)) << tracer.error();
+  std::vector<boost::thread*> threads;
+  for( int t=0; t<4; t++ ) {
+    threads.push_back(new boost::thread(recordSpans, &tracer, names[t], spans,
+          7 + t));
+  }
+  for( int t=0; t<4; t++ ) {
+    threads[t]->join();
+    delete threads[t];
+  }
+  // the last few spans of each thread were never flushed; close gets them
+  EXPECT_EQ(0u, tracer.close());
+  EXPECT_FALSE(tracer.enabled());
+
+  const std::string text = readFile(filename);
+  ASSERT_EQ(0u, text.find("[\n"));
+  EXPECT_EQ(text.size() - 3, text.rfind("\n]\n"));
+  for( int t=0; t<4; t++ ) {
+    EXPECT_EQ((size_t)spans, countOf(text, std::string("\"") + names[t] +
+          "\"")) << names[t];
+  }
+  EXPECT_EQ((size_t)4 * spans, countOf(text, "\"ph\":\"X\""));
+  EXPECT_EQ((size_t)4 * spans - 1, countOf(text, "},\n{"));
+  remove(filename.c_str());
+}
+
+TEST(TracerTests, closeWhileRecording) {
+  const std::string filename = testing::TempDir() + "test_trace_close.json";
+  Tracer tracer;
+  boost::atomic<bool> stop(false);
+  std::vector<boost::thread*> threads;
+  for( int round=0; round<3; round++ ) {
+    ASSERT_TRUE(tracer.open(filename, 64, 0.001)) << tracer.error();
+    if( round == 0 ) {
+      threads.push_back(new boost::thread(recordUntil, &tracer, "span_a",
+            &stop));
+      threads.push_back(new boost::thread(recordUntil, &tracer, "span_b",
+            &stop));
+    }
+    boost::this_thread::sleep(boost::posix_time::milliseconds(20));
+    tracer.close();
+
+    // every trace is closed off, with no spans after the closing bracket
+    const std::string text = readFile(filename);
+    ASSERT_EQ(0u, text.find("[\n"));
+    EXPECT_EQ(text.size() - 3, text.rfind("\n]\n"));
+    EXPECT_EQ(countOf(text, "{"), countOf(text, "}"));
+    EXPECT_GT(countOf(text, "\"span_a\""), 0u);
+  }
+  stop = true;
+  for( size_t t=0; t<threads.size(); t++ ) {
+    threads[t]->join();
+    delete threads[t];
+  }
+  remove(filename.c_str());
+}
+
+// a small library of dagny's trajectories, built once for all of the planner
+// tests
+const std::string &plannerLibrary() {
+  static std::string filename;
+  if( filename.empty() ) {
+    TrajectoryLibraryOptions options;
+    options.num_headings = 32;
+    options.curvature_samples = 7;
+    options.speeds.clear();
+    options.speeds.push_back(0.3);
+    options.speeds.push_back(-0.15);
+    options.times.pop_back();
+    filename = testing::TempDir() + "test_planner_library.trj";
+    if( ! buildTrajectoryLibrary(options, filename) ) {
+      filename.clear();
+    }
+  }
+  return filename;
+}
+
+// dagny's parameters from local_planner.yaml, and a straight plan along
+// y = 4 from x = 1.5 to 6.5
+template<class P>
+void setUpPlanner(P &planner) {
+  PlannerParams params;
+  params.max_vel = 0.5;
+  params.min_vel = 0.15;
+  params.min_radius = 0.7;
+  params.acc_lim = 0.1;
+  planner.setParams(params);
+  planner.setFootprint(TrajectoryLibraryOptions().footprint);
+  ASSERT_FALSE(plannerLibrary().empty());
+  ASSERT_TRUE(planner.trajectoryLibrary().open(plannerLibrary()));
+  std::vector<Pose2D> plan;
+  for( int i=0; i<=50; i++ ) {
+    plan.push_back(pose(1.5 + 0.1 * i, 4.0, 0));
+  }
+  std::vector<InfeasibleStretch> infeasible;
+  planner.setPlan(plan, infeasible);
+  EXPECT_TRUE(infeasible.empty());
+}
+
+template<class P>
+bool runCycle(P &planner, const std::vector<unsigned char> &cells,
+    double x, double y, double theta, double linear_vel,
+    CycleResult &result) {
+  const CostGrid grid(160, 160, 0.05, 0, 0, &cells[0]);
+  PlannerInput input;
+  input.costmap = &grid;
+  input.x = x;
+  input.y = y;
+  input.theta = theta;
+  input.linear_vel = linear_vel;
+  return planner.cycle(input, result);
+}
+
+int rejections(const CycleResult &result) {
+  return result.rejected_free_arc + result.rejected_corridor +
+    result.rejected_scan + result.rejected_costmap + result.rejected_moving +
+    result.rejected_library;
+}
+
+// one cycle from on the plan, and one from beside it
+template<class P>
+void checkStraight(const char *name) {
+  P planner;
+  setUpPlanner(planner);
+  const std::vector<unsigned char> cells(160 * 160, FREE_SPACE);
+  CycleResult result;
+  ASSERT_TRUE(runCycle(planner, cells, 1.5, 4.0, 0, 0.3, result)) << name;
+  EXPECT_EQ(CycleResult::SAMPLED, result.status) << name;
+  EXPECT_GT(result.candidates, 0) << name;
+  EXPECT_EQ(0, rejections(result)) << name;
+  // straight along the plan, within the acceleration limit
+  EXPECT_NEAR(0.4, result.linear, 1e-9) << name;
+  EXPECT_NEAR(0.0, result.angular, 1e-6) << name;
+  // to the end of the plan
+  EXPECT_EQ(51, result.target) << name;
+  EXPECT_NEAR(5.0, result.target_distance, 1e-9) << name;
+  EXPECT_FALSE(planner.goalReached()) << name;
+
+  // 30 cm to the left of the plan and heading away, it turns right, back
+  // towards it
+  P beside;
+  setUpPlanner(beside);
+  ASSERT_TRUE(runCycle(beside, cells, 1.5, 4.3, 0.2, 0.3, result)) << name;
+  EXPECT_EQ(CycleResult::SAMPLED, result.status) << name;
+  EXPECT_LT(result.angular, 0) << name;
+}
+
+TEST(PlannerTests, straightPlan) {
+  checkStraight<DefaultPlanner>("default");
+  checkStraight<Planner<RadiusSampler, CostToGoScorer, DecelerateToTarget> >(
+      "radius");
+  checkStraight<Planner<FrenetSampler, CostToGoScorer, DecelerateToTarget> >(
+      "frenet");
+  checkStraight<Planner<LibrarySampler, CostToGoScorer, DecelerateToTarget> >(
+      "library");
+}
+
+TEST(PlannerTests, blockedPlan) {
+  // a wall across the map, just past the nose of the robot
+  std::vector<unsigned char> cells(160 * 160, FREE_SPACE);
+  addWall(cells, 2.0, 0, 2.2, 8);
+  DefaultPlanner planner;
+  setUpPlanner(planner);
+  CycleResult result;
+  EXPECT_FALSE(runCycle(planner, cells, 1.5, 4.0, 0, 0.3, result));
+  EXPECT_EQ(CycleResult::NO_PATH, result.status);
+  // every candidate, from every sampler, was rejected
+  EXPECT_GT(result.candidates, 0);
+  EXPECT_EQ(result.candidates, rejections(result));
+  EXPECT_GT(result.rejected_library, 0);
+  EXPECT_GT(result.rejected_free_arc + result.rejected_costmap, 0);
+  EXPECT_EQ(0.0, result.linear);
+  EXPECT_EQ(0.0, result.angular);
+}
+
+TEST(PlannerTests, drivesToGoal) {
+  // closed loop, at 10 Hz, driving exactly as commanded
+  const std::vector<unsigned char> cells(160 * 160, FREE_SPACE);
+  DefaultPlanner planner;
+  setUpPlanner(planner);
+  double x = 1.5, y = 4.1, theta = 0.1, v = 0;
+  double worst = 0;
+  int cycles = 0;
+  CycleResult result;
+  for( ; cycles<400 && ! planner.goalReached(); cycles++ ) {
+    ASSERT_TRUE(runCycle(planner, cells, x, y, theta, v, result)) <<
+      "cycle " << cycles;
+    if( result.status == CycleResult::AT_GOAL ) {
+      break;
+    }
+    ASSERT_EQ(CycleResult::SAMPLED, result.status) << "cycle " << cycles;
+    ASSERT_GT(result.linear, 0) << "cycle " << cycles;
+    v = result.linear;
+    const double dt = 0.1;
+    x += v * cos(theta) * dt;
+    y += v * sin(theta) * dt;
+    theta += result.angular * dt;
+    worst = std::max(worst, fabs(y - 4.0));
+  }
+  EXPECT_TRUE(planner.goalReached());
+  EXPECT_EQ(CycleResult::AT_GOAL, result.status);
+  EXPECT_EQ(0.0, result.linear);
+  EXPECT_EQ(0.0, result.angular);
+  EXPECT_EQ(50, result.plan_point);
+  // 5 m at up to half a meter a second, and never far off the plan
+  EXPECT_GT(cycles, 100);
+  EXPECT_LT(cycles, 200);
+  EXPECT_NEAR(6.5, x, 0.1);
+  EXPECT_NEAR(4.0, y, 0.1);
+  EXPECT_LT(worst, 0.15);
+}
+
+int main(int argc, char ** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
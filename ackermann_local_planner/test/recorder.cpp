@@ -0,0 +1,127 @@
+#include "ackermann_local_planner/recorder.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace ackermann_local_planner;
+
+// record n of a mix of types and sizes; its stamp is n
+void recordNumber(InputRecorder &recorder, int n) {
+  switch( n % 3 ) {
+    case 0:
+      recorder.recordPose(n, n, -n, 0.5);
+      break;
+    case 1:
+      recorder.recordOdom(n, n, 0.25);
+      break;
+    case 2: {
+      // plans of different lengths, so that records don't line up with
+      // the end of the ring
+      std::vector<geometry_msgs::PoseStamped> plan(n % 7);
+      for( int i=0; i<plan.size(); i++ ) {
+        plan[i].pose.position.x = n;
+        plan[i].pose.position.y = i;
+        plan[i].pose.orientation.w = 1.0;
+      }
+      recorder.recordPlan(n, plan);
+      break;
+    }
+  }
+}
+
+TEST(RecorderTests, ringRoundTrip) {
+  const std::string filename = testing::TempDir() + "test_recording.rec";
+  const size_t capacity = 4096;
+  const int records = 1000;
+  InputRecorder recorder;
+  ASSERT_TRUE(recorder.open(filename, capacity));
+  for( int n=0; n<records; n++ ) {
+    recordNumber(recorder, n);
+  }
+  recorder.close();
+
+  RecordingReader reader;
+  ASSERT_TRUE(reader.open(filename)) << reader.error();
+  // well past the size of the ring; only the newest records are left
+  ASSERT_GT(reader.size(), 0u);
+  ASSERT_LT(reader.size(), (uint64_t)records / 10);
+
+  RecordHeader header;
+  const char *payload;
+  int expected = -1;
+  uint64_t read = 0;
+  while( reader.next(header, payload) ) {
+    const int n = header.stamp;
+    // oldest to newest, with nothing missing in between
+    if( expected >= 0 ) {
+      ASSERT_EQ(expected, n);
+    }
+    expected = n + 1;
+    read++;
+
+    switch( n % 3 ) {
+      case 0: {
+        ASSERT_EQ(RECORD_POSE, header.type);
+        ASSERT_EQ(sizeof(RecordedPose), header.size);
+        RecordedPose pose;
+        memcpy(&pose, payload, sizeof(pose));
+        EXPECT_EQ(n, pose.x);
+        EXPECT_EQ(-n, pose.y);
+        EXPECT_EQ(0.5, pose.theta);
+        break;
+      }
+      case 1: {
+        ASSERT_EQ(RECORD_ODOM, header.type);
+        ASSERT_EQ(sizeof(RecordedOdom), header.size);
+        RecordedOdom odom;
+        memcpy(&odom, payload, sizeof(odom));
+        EXPECT_EQ(n, odom.linear);
+        EXPECT_EQ(0.25, odom.angular);
+        break;
+      }
+      case 2: {
+        ASSERT_EQ(RECORD_PLAN, header.type);
+        uint32_t count;
+        memcpy(&count, payload, sizeof(count));
+        ASSERT_EQ(n % 7, count);
+        ASSERT_EQ(sizeof(count) + count * sizeof(RecordedPose), header.size);
+        for( int i=0; i<count; i++ ) {
+          RecordedPose pose;
+          memcpy(&pose, payload + sizeof(count) + i * sizeof(RecordedPose),
+              sizeof(pose));
+          EXPECT_EQ(n, pose.x);
+          EXPECT_EQ(i, pose.y);
+          EXPECT_EQ(0, pose.theta);
+        }
+        break;
+      }
+    }
+  }
+  EXPECT_EQ(reader.size(), read);
+  // and the newest record is the last one written
+  EXPECT_EQ(records, expected);
+  reader.close();
+  remove(filename.c_str());
+}
+
+TEST(RecorderTests, notARecording) {
+  const std::string filename = testing::TempDir() + "test_not_recording.rec";
+  FILE *f = fopen(filename.c_str(), "w");
+  ASSERT_TRUE(f != NULL);
+  std::vector<char> junk(4096, 'x');
+  fwrite(&junk[0], 1, junk.size(), f);
+  fclose(f);
+
+  RecordingReader reader;
+  EXPECT_FALSE(reader.open(filename));
+  EXPECT_FALSE(reader.error().empty());
+  EXPECT_EQ(0u, reader.size());
+  remove(filename.c_str());
+}
+
+int main(int argc, char ** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,284 @@
+#!/usr/bin/env python
+# Offline parameter autotuner for the ackermann local planner
+#
+# Sweeps planner parameters over a corpus of scenarios, running one
+# evaluator process per (parameter set, scenario) in parallel. The evaluator
+# is any shell command, given on the command line, that runs the planner
+# against a scenario. In the command, {params} is replaced with a YAML file
+# of the parameters to load in the AckermannPlannerROS namespace, and
+# {scenario} with an entry from the config's scenario list.
+#
+# replay_scenario.py is the evaluator for recorded scenarios: it replays a
+# planner recording (see scenarios/) through ackermann_local_planner's
+# replay_planner, with local_planner.yaml plus {params}:
+#
+#   ./autotune.py autotune.yaml "./replay_scenario.py {params} {scenario}"
+#
+# A simulation can be used instead. The evaluator must exit with status 0
+# and print each of these metrics as a "name: value" line, on stdout or
+# stderr; other lines are ignored:
+#
+#   tracking_error: 0.042      (mean distance from the plan, in meters)
+#   completion_time: 31.5      (seconds to reach the goal)
+#   cpu_time: 0.81             (planner CPU time, in seconds)
+#
+# All three are minimized. A run that exits with any other status, or
+# leaves out a metric, fails its parameter set.
+#
+# The Pareto front over path quality and planner CPU time is reported, and
+# the cheapest parameter set that meets the quality bar is merged into a
+# copy of local_planner.yaml, which can be loaded in its place
+
+import os
+import re
+import sys
+import yaml
+import random
+import shutil
+import tempfile
+import itertools
+import subprocess
+import multiprocessing
+
+# metrics we expect from the evaluator. all of them are minimized
+QUALITY_METRICS = ['tracking_error', 'completion_time']
+COST_METRIC = 'cpu_time'
+METRICS = QUALITY_METRICS + [COST_METRIC]
+
+# parameters that the planner reads as integers
+INT_PARAMS = ['radius_samples']
+
+NAMESPACE = 'AckermannPlannerROS'
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+metric_re = re.compile(r'^\s*(\w+)\s*:\s*(\S+)\s*$')
+
+def param_values(name, spec):
+    """ Expand a [min, max, steps] specification into a list of values """
+    if len(spec) != 3:
+        raise ValueError("Parameter %s must be [min, max, steps]" % ( name ))
+    low, high, steps = spec
+    steps = int(steps)
+    if steps < 2:
+        values = [ low ]
+    else:
+        values = [ low + (high - low) * i / float(steps - 1)
+                   for i in range(steps) ]
+    if name in INT_PARAMS:
+        values = sorted(set(int(round(v)) for v in values))
+    return values
+
+def grid_sweep(parameters):
+    """ Every combination of the parameter values """
+    names = sorted(parameters.keys())
+    values = [ param_values(n, parameters[n]) for n in names ]
+    for combination in itertools.product(*values):
+        yield dict(zip(names, combination))
+
+def random_sweep(parameters, samples, seed):
+    """ Latin hypercube samples of the parameter space """
+    rand = random.Random(seed)
+    names = sorted(parameters.keys())
+    # one stratum per sample in each dimension, shuffled independently
+    strata = {}
+    for n in names:
+        strata[n] = range(samples)
+        rand.shuffle(strata[n])
+    for i in range(samples):
+        params = {}
+        for n in names:
+            low, high = parameters[n][0], parameters[n][1]
+            u = (strata[n][i] + rand.random()) / samples
+            v = low + (high - low) * u
+            if n in INT_PARAMS:
+                v = int(round(v))
+            params[n] = v
+        yield params
+
+def parse_metrics(output):
+    metrics = {}
+    for line in output.splitlines():
+        m = metric_re.match(line)
+        if m and m.group(1) in METRICS:
+            try:
+                metrics[m.group(1)] = float(m.group(2))
+            except ValueError:
+                pass
+    return metrics
+
+def evaluate(job):
+    """ Run the evaluator for one parameter set on one scenario """
+    job_id, index, params, scenario, evaluator, workdir = job
+    param_file = os.path.join(workdir, "params_%d.yaml" % ( job_id ))
+    with open(param_file, 'w') as out:
+        out.write(yaml.dump({ NAMESPACE: params }, default_flow_style=False))
+    command = evaluator.format(params=param_file, scenario=scenario)
+    try:
+        output = subprocess.check_output(command, shell=True,
+                                         stderr=subprocess.STDOUT)
+    except subprocess.CalledProcessError as e:
+        return index, scenario, None, "exited with %d" % ( e.returncode )
+    metrics = parse_metrics(output)
+    missing = [ m for m in METRICS if m not in metrics ]
+    if missing:
+        return index, scenario, None, "missing metrics %s" % ( missing )
+    return index, scenario, metrics, None
+
+def dominates(a, b):
+    """ True if metrics a are no worse than b everywhere and better somewhere """
+    better = False
+    for m in METRICS:
+        if a[m] > b[m]:
+            return False
+        if a[m] < b[m]:
+            better = True
+    return better
+
+def pareto_front(results):
+    front = []
+    for r in results:
+        if not any(dominates(o['metrics'], r['metrics']) for o in results):
+            front.append(r)
+    front.sort(key=lambda r: r['metrics'][COST_METRIC])
+    return front
+
+def meets_bar(metrics, bar):
+    for m in QUALITY_METRICS:
+        limit = bar.get('max_' + m)
+        if limit is not None and metrics[m] > limit:
+            return False
+    return True
+
+def format_params(params):
+    return ", ".join("%s=%g" % ( n, params[n] ) for n in sorted(params))
+
+def main():
+    import argparse
+    parser = argparse.ArgumentParser('Ackermann planner parameter autotuner')
+    parser.add_argument('config', help="YAML file describing the sweep")
+    parser.add_argument('evaluator',
+                        help="Command that runs the planner on one "
+                        "scenario; {params} and {scenario} are replaced "
+                        "with the parameter file and the scenario")
+    parser.add_argument('-o', '--output', default='local_planner_tuned.yaml',
+                        help="File to write the chosen parameters to")
+    parser.add_argument('-p', '--planner-config',
+                        default=os.path.join(HERE, 'local_planner.yaml'),
+                        help="Planner parameters to merge the chosen ones "
+                        "into")
+    parser.add_argument('-f', '--front',
+                        help="File to dump the whole Pareto front to")
+    parser.add_argument('-j', '--jobs', type=int,
+                        default=multiprocessing.cpu_count(),
+                        help="Number of evaluations to run in parallel")
+    parser.add_argument('-n', '--samples', type=int, default=0,
+                        help="Sample this many parameter sets at random "
+                        "instead of sweeping the full grid")
+    parser.add_argument('-s', '--seed', type=int, default=0,
+                        help="Random seed for sampling")
+
+    args = parser.parse_args()
+    if '{params}' not in args.evaluator:
+        parser.error("the evaluator must take the parameters as {params}")
+
+    config = yaml.safe_load(open(args.config))
+    planner_config = yaml.safe_load(open(args.planner_config))
+    parameters = config['parameters']
+    scenarios = config['scenarios']
+    evaluator = args.evaluator
+    bar = config.get('quality', {})
+    base = config.get('base', {})
+
+    if args.samples > 0:
+        candidates = list(random_sweep(parameters, args.samples, args.seed))
+    else:
+        candidates = list(grid_sweep(parameters))
+    for c in candidates:
+        for name in base:
+            c.setdefault(name, base[name])
+
+    print "%d parameter sets, %d scenarios, %d evaluations on %d cores" % (
+        len(candidates), len(scenarios), len(candidates) * len(scenarios),
+        args.jobs)
+
+    workdir = tempfile.mkdtemp(prefix='autotune_')
+    jobs = [ (i, c, s, evaluator, workdir)
+             for i, c in enumerate(candidates)
+             for s in scenarios ]
+    jobs = [ (j,) + job for j, job in enumerate(jobs) ]
+
+    runs = {}
+    failed = set()
+    pool = multiprocessing.Pool(args.jobs)
+    try:
+        done = 0
+        for index, scenario, metrics, error in pool.imap_unordered(evaluate,
+                                                                   jobs):
+            done += 1
+            if error:
+                print "FAILED: %s on %s: %s" % (
+                    format_params(candidates[index]), scenario, error)
+                failed.add(index)
+            else:
+                runs.setdefault(index, []).append(metrics)
+            if done % 10 == 0 or done == len(jobs):
+                print "%d/%d evaluations done" % ( done, len(jobs) )
+    finally:
+        pool.close()
+        pool.join()
+        shutil.rmtree(workdir)
+
+    # average each metric over the scenario corpus. a parameter set that
+    # failed any scenario is not a candidate
+    results = []
+    for index in runs:
+        if index in failed:
+            continue
+        metrics = {}
+        for m in METRICS:
+            metrics[m] = sum(r[m] for r in runs[index]) / len(runs[index])
+        results.append({ 'params': candidates[index], 'metrics': metrics })
+
+    if len(results) == 0:
+        print "ERROR: no parameter set completed every scenario"
+        sys.exit(1)
+
+    front = pareto_front(results)
+    print
+    print "Pareto front (%d of %d parameter sets):" % ( len(front),
+                                                       len(results) )
+    for r in front:
+        print "  %s  ->  %s" % ( format_params(r['params']),
+                                 ", ".join("%s=%g" % ( m, r['metrics'][m] )
+                                           for m in METRICS) )
+
+    if args.front:
+        with open(args.front, 'w') as out:
+            out.write(yaml.dump(front, default_flow_style=False))
+        print "Wrote Pareto front to %s" % ( args.front )
+
+    # the front is sorted by cost, so the first acceptable entry is the
+    # cheapest parameter set that meets the quality bar
+    chosen = None
+    for r in front:
+        if meets_bar(r['metrics'], bar):
+            chosen = r
+            break
+    if chosen is None:
+        print "ERROR: no parameter set meets the quality bar"
+        sys.exit(1)
+
+    print
+    print "Chosen:", format_params(chosen['params'])
+    planner_config.setdefault(NAMESPACE, {}).update(chosen['params'])
+    with open(args.output, 'w') as out:
+        out.write("# Generated by autotune.py from %s and %s\n" % (
+            args.planner_config, args.config ))
+        for m in METRICS:
+            out.write("#  %s: %g\n" % ( m, chosen['metrics'][m] ))
+        out.write(yaml.dump(planner_config, default_flow_style=False))
+    print "Wrote parameters to %s" % ( args.output )
+
+if __name__ == '__main__':
+    main()
@@ -3,12 +3,17 @@
 import math
 
 class MPrim():
-    def __init__(self, start, end, poses, cost=1, resolution=1.0):
+    def __init__(self, start, end, poses, cost=1, resolution=1.0,
+                 heading=None, segments=None):
         self.start = start
         self.end = end
         self.poses = poses
         self.cost = cost
         self.resolution = resolution
+        # continuous start heading and (length, sharpness) segments, for
+        #  the parametric format
+        self.heading = heading
+        self.segments = segments
 
     def __str__(self):
         return """MPrim:
@@ -31,6 +36,19 @@ intermediateposes: %d
             s += "%0.4f %0.4f %0.4f\n"%(pose[0]*res, pose[1]*res, pose[2])
         return s
 
+    def pformat(self, res=0.1):
+        """ Parametric format; lengths in meters, sharpness per meter^2 """
+        s = """startangle_c: %d
+endpose_c: %d %d %d
+additionalactioncostmult: %d
+startheading: %0.6f
+segments: %d
+"""%(self.start[2], self.end[0], self.end[1], self.end[2],
+     self.cost, self.heading, len(self.segments))
+        for length, sharpness in self.segments:
+            s += "%0.6f %0.6f\n"%(length*res, sharpness/(res*res))
+        return s
+
     def transform(self, transform, max_angle):
         """ Return a NEW copy of this MPrim as transformed by transform """
         start = transform(self.start, max_angle)
@@ -41,7 +59,15 @@ intermediateposes: %d
         poses = []
         for pose in self.poses:
             poses.append(transform(pose, math.pi * 2))
-        return MPrim(start, end, poses, cost)
+        heading = None
+        segments = None
+        if self.segments is not None:
+            heading = transform((0, 0, self.heading), math.pi * 2)[2]
+            # every transform we use is a reflection, which turns the other
+            #  way
+            segments = [ (l, -w) for l, w in self.segments ]
+        return MPrim(start, end, poses, cost, heading=heading,
+                     segments=segments)
 
     def length(self):
         """ Compute the length of this motion primitive """
@@ -95,6 +121,17 @@ totalnumberofprimitives: %d\n"""%(res, 16, sum([len(primitives[p]) for p in prim
     with open(file, "w") as f:
         f.write(out)
 
+def write_pmprim(file, primitives, res):
+    out = """resolution_m: %0.6f
+numberofangles: %d
+totalnumberofprimitives: %d\n"""%(res, 16, sum([len(primitives[p]) for p in primitives]))
+    for start in primitives:
+        for i,p in enumerate(primitives[start]):
+            out += "primID: %d\n"%(i)
+            out += p.pformat(res)
+    with open(file, "w") as f:
+        f.write(out)
+
 def main():
     import yaml
     import argparse
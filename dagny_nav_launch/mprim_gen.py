@@ -144,7 +144,8 @@ def trajectory_to_mprim(start, end, trajectory, num_poses, num_angles):
     poses = list(trajectory.get_poses(n=num_poses-1))
     assert(len(poses) == num_poses-1)
     poses.append(end)
-    return mprim.MPrim(st, en, poses)
+    return mprim.MPrim(st, en, poses, heading=start[2],
+                       segments=trajectory.get_segments())
 
 def generate_trajectories(min_radius, num_angles, primitives, seed):
     tolerance = 0.01 # tolerance for matching to the grid
@@ -334,6 +335,9 @@ def main():
     parser = argparse.ArgumentParser('Motion primitive generation')
     parser.add_argument('-o', '--output', 
                         help="Output file")
+    parser.add_argument('--parametric',
+                        help="Also write the primitives as clothoid"
+                        " segments, in .pmprim format, to this file")
     parser.add_argument('-r', '--resolution', default=0.1, type=float,
                         help="Primitive resolution (in meters)")
     parser.add_argument('-m', '--min-radius', default=0.6, type=float,
@@ -346,8 +350,16 @@ def main():
                         help="File to dump generated YAML configuration to")
     parser.add_argument('--prune', action='store_true', default=False,
                         help="Prune redundant paths")
+    parser.add_argument('--octant', action='store_true', default=False,
+                        help="Only write the start angles of the first octant."
+                        " SBPL can't read these; mprim_lattice expands them")
+    parser.add_argument('-c', '--coarse', default=1, type=int,
+                        help="Generate the coarse level of a multi-resolution"
+                        " set, on cells COARSE times the resolution. The"
+                        " primitives are given in coarse cells")
 
     args = parser.parse_args()
+    resolution = args.resolution * args.coarse
 
     num_angles = 16
     primitives = None
@@ -364,7 +376,7 @@ def main():
             print "Loaded num_angles from %s" % ( args.yaml )
             num_angles = config['num_angles']
 
-    trajectories = generate_trajectories(args.min_radius / args.resolution,
+    trajectories = generate_trajectories(args.min_radius / resolution,
                                 num_angles, primitives, seed)
     print len(trajectories), "base trajectories"
 
@@ -466,7 +478,13 @@ def main():
 
 
     if args.output:
-        mprim.write_mprim(args.output, traj, args.resolution)
+        if args.octant:
+            traj = dict((i, traj[i]) for i in range(1 + num_angles / 8))
+        mprim.write_mprim(args.output, traj, resolution)
+    if args.parametric:
+        if args.octant:
+            traj = dict((i, traj[i]) for i in range(1 + num_angles / 8))
+        mprim.write_pmprim(args.parametric, traj, resolution)
 
 if __name__ == '__main__':
     # simple test for index_angle
@@ -23,6 +23,11 @@ class Segment(object):
     def get_length(self):
         return self._length
 
+    # Get the (length, sharpness) of each clothoid this segment is made of;
+    #  sharpness is the change in angular velocity per unit length
+    def get_segments(self):
+        return [ (self._length, 0) ]
+
     def get_score(self, reference):
         if self._reference and reference == self._reference:
             return self._score
@@ -85,6 +90,12 @@ class Compound(Segment):
 
     def __repr__(self):
         return "Compound(%s)" %( ", ".join(map(repr, self._segments)) )
+
+    def get_segments(self):
+        segments = []
+        for s in self._segments:
+            segments.extend(s.get_segments())
+        return segments
     
     def get_pose(self, length):
         i = 0
@@ -171,6 +182,9 @@ class Spiral(Segment):
         self._end = self.get_pose(length)
         assert(self._end)
 
+    def get_segments(self):
+        return [ (self._length, self._w) ]
+
     def get_pose(self, length):
         # This implements:
         # dx = http://www.wolframalpha.com/input/?i=integral+of+cos%28+w+*+0.5+*+t%5E2+%2B+q*t+%2B+theta+%29+dt+from+0+to+x
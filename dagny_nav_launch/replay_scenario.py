@@ -0,0 +1,70 @@
+#!/usr/bin/env python
+# Evaluator for autotune.py: replays a scenario through the planner with the
+# parameters in local_planner.yaml, overridden by the ones being tuned
+#
+#   ./autotune.py autotune.yaml "./replay_scenario.py {params} {scenario}"
+#
+# A scenario is a planner recording; see scenarios/make_scenarios.py. The
+# replay runs in ackermann_local_planner's replay_planner, which prints the
+# metrics autotune.py reads and fails if the robot collides or doesn't reach
+# the goal.
+
+import os
+import sys
+import yaml
+import subprocess
+
+NAMESPACE = 'AckermannPlannerROS'
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+def main():
+    import argparse
+    parser = argparse.ArgumentParser('Replay a scenario through the '
+                                     'ackermann planner')
+    parser.add_argument('params', help="YAML file of the parameters to "
+                        "override, in the %s namespace" % ( NAMESPACE ))
+    parser.add_argument('scenario', help="Recording to replay")
+    parser.add_argument('-c', '--config',
+                        default=os.path.join(HERE, 'local_planner.yaml'),
+                        help="Planner parameters to start from")
+    parser.add_argument('--costmap',
+                        default=os.path.join(HERE, 'common_costmap.yaml'),
+                        help="Costmap parameters, for the footprint")
+    parser.add_argument('-r', '--replay',
+                        default='rosrun ackermann_local_planner replay_planner',
+                        help="Command that runs replay_planner")
+    args = parser.parse_args()
+
+    params = yaml.safe_load(open(args.config))[NAMESPACE]
+    tuned = yaml.safe_load(open(args.params))[NAMESPACE]
+    params.update(tuned)
+
+    replay = args.replay.split()
+    known = subprocess.check_output(replay + ['--params'],
+                                    universal_newlines=True).split()
+    # local_planner.yaml has ROS settings the replay has no use for, but a
+    # tuned parameter that it ignored would make every run look the same
+    unknown = [ name for name in tuned if name not in known ]
+    if unknown:
+        sys.stderr.write("replay_planner doesn't take %s\n" % (
+            ", ".join(sorted(unknown)) ))
+        sys.exit(1)
+
+    footprint = yaml.safe_load(open(args.costmap))['footprint']
+    command = replay + [ args.scenario, 'footprint=' + ",".join(
+        "%g,%g" % ( x, y ) for x, y in footprint) ]
+    if 'trajectory_library' in params:
+        command.append('trajectory_library=%s' % (
+            params['trajectory_library'] ))
+    for name in sorted(params):
+        if name not in known:
+            continue
+        value = params[name]
+        if isinstance(value, bool):
+            value = 'true' if value else 'false'
+        command.append('%s=%s' % ( name, value ))
+    sys.exit(subprocess.call(command))
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,161 @@
+#!/usr/bin/env python
+# Generates the autotune scenarios
+#
+# Each scenario is a planner recording, in the format that the ackermann
+# local planner's record_file writes, of one planning cycle: a plan, an
+# inflated costmap around it and the robot at the start of the plan.
+# replay_planner drives a simulated robot from there to the end of the plan.
+# Recordings from the robot can be used as scenarios in the same way.
+#
+#   ./make_scenarios.py        (writes hallway.rec and parking_lot.rec here)
+
+import os
+import math
+import struct
+
+RESOLUTION = 0.05
+
+# the local costmap's inflation layer, for dagny's footprint; see
+# common_costmap.yaml
+INSCRIBED_RADIUS = 0.15
+INFLATION_RADIUS = 0.6
+COST_SCALING_FACTOR = 10.0
+
+LETHAL_OBSTACLE = 254
+INSCRIBED_INFLATED_OBSTACLE = 253
+
+# record types, from recording.h
+RECORD_CYCLE_BEGIN = 1
+RECORD_CYCLE_END = 2
+RECORD_PLAN = 3
+RECORD_POSE = 4
+RECORD_ODOM = 5
+RECORD_COSTMAP = 6
+
+RECORD_MAGIC = b'ACKREC\0\0'
+RECORD_VERSION = 1
+FILE_HEADER = '<8sIIQQQQQ'
+RECORD_HEADER = '<IId'
+
+def record(kind, stamp, payload):
+    """ One record, padded to 8 bytes """
+    data = struct.pack(RECORD_HEADER, kind, len(payload), stamp) + payload
+    return data + b'\0' * (-len(data) % 8)
+
+def cycle(monotonic_ns):
+    return struct.pack('<Qddii', monotonic_ns, 0.0, 0.0, 1, 0)
+
+def plan_path(start, segments):
+    """ Poses every RESOLUTION along straight ('line', length) and turning
+    ('arc', radius, angle) segments; positive angles turn left """
+    x, y, theta = start
+    poses = [ (x, y, theta) ]
+    for segment in segments:
+        if segment[0] == 'line':
+            length = segment[1]
+            curvature = 0.0
+        else:
+            radius, angle = segment[1], segment[2]
+            length = abs(angle) * radius
+            curvature = math.copysign(1.0 / radius, angle)
+        steps = int(round(length / RESOLUTION))
+        for i in range(steps):
+            step = length / steps
+            if curvature == 0:
+                x += step * math.cos(theta)
+                y += step * math.sin(theta)
+            else:
+                dtheta = step * curvature
+                x += (math.sin(theta + dtheta) - math.sin(theta)) / curvature
+                y -= (math.cos(theta + dtheta) - math.cos(theta)) / curvature
+                theta += dtheta
+            poses.append((x, y, theta))
+    return poses
+
+def rect_distance(x, y, rect):
+    x0, y0, x1, y1 = rect
+    dx = max(x0 - x, 0, x - x1)
+    dy = max(y0 - y, 0, y - y1)
+    return math.hypot(dx, dy)
+
+def inflated_cost(distance):
+    """ Cell cost at a distance from the nearest obstacle, as costmap_2d's
+    inflation layer computes it """
+    if distance <= 0:
+        return LETHAL_OBSTACLE
+    if distance <= INSCRIBED_RADIUS:
+        return INSCRIBED_INFLATED_OBSTACLE
+    if distance > INFLATION_RADIUS:
+        return 0
+    factor = math.exp(-COST_SCALING_FACTOR * (distance - INSCRIBED_RADIUS))
+    return int((INSCRIBED_INFLATED_OBSTACLE - 1) * factor)
+
+def costmap(width, height, obstacles):
+    """ A costmap from the origin, with the obstacles as (x0, y0, x1, y1)
+    rectangles """
+    size_x = int(round(width / RESOLUTION))
+    size_y = int(round(height / RESOLUTION))
+    cells = bytearray(size_x * size_y)
+    for my in range(size_y):
+        y = (my + 0.5) * RESOLUTION
+        for mx in range(size_x):
+            x = (mx + 0.5) * RESOLUTION
+            d = min(rect_distance(x, y, r) for r in obstacles)
+            cells[my * size_x + mx] = inflated_cost(d)
+    return struct.pack('<IIddd', size_x, size_y, RESOLUTION, 0.0, 0.0) + \
+        bytes(cells)
+
+def write_scenario(filename, plan, grid):
+    start = plan[0]
+    records = [
+        record(RECORD_PLAN, 0.0, struct.pack('<I', len(plan)) +
+               b''.join(struct.pack('<ddd', *p) for p in plan)),
+        record(RECORD_CYCLE_BEGIN, 0.0, cycle(0)),
+        record(RECORD_COSTMAP, 0.0, grid),
+        record(RECORD_ODOM, 0.0, struct.pack('<dd', 0.0, 0.0)),
+        record(RECORD_POSE, 0.0, struct.pack('<ddd', *start)),
+        record(RECORD_CYCLE_END, 0.0, cycle(0)),
+    ]
+    ring = b''.join(records)
+    header = struct.pack(FILE_HEADER, RECORD_MAGIC, RECORD_VERSION,
+                         struct.calcsize(FILE_HEADER), len(ring), len(ring), 0,
+                         len(records), 0)
+    with open(filename, 'wb') as out:
+        out.write(header + ring)
+
+def hallway():
+    """ 8 m down a 2.4 m wide hallway, past a cabinet that sticks out of the
+    left wall """
+    plan = plan_path((1.0, 1.5, 0.0), [ ('line', 8.0) ])
+    walls = [ (0.0, 0.0, 10.0, 0.3), (0.0, 2.7, 10.0, 3.0),
+              (4.5, 2.0, 5.1, 2.7) ]
+    return plan, costmap(10.0, 3.0, walls)
+
+def parking_lot():
+    """ Down an aisle between parked cars, and left around the end of a row """
+    plan = plan_path((1.0, 2.0, 0.0),
+                     [ ('line', 4.0), ('arc', 1.5, math.pi / 2),
+                       ('line', 4.5) ])
+    cars = []
+    # a row below the aisle, and one above it that ends before the turn
+    for i in range(4):
+        cars.append((0.5 + 2.0 * i, 0.0, 2.2 + 2.0 * i, 0.9))
+    for i in range(2):
+        cars.append((0.5 + 2.0 * i, 3.2, 2.2 + 2.0 * i, 4.4))
+    # and cars either side of the aisle after the turn
+    for i in range(3):
+        cars.append((4.0, 4.5 + 2.0 * i, 5.6, 6.2 + 2.0 * i))
+        cars.append((7.6, 4.5 + 2.0 * i, 9.2, 6.2 + 2.0 * i))
+    return plan, costmap(10.0, 10.5, cars)
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    for name, scenario in [ ('hallway', hallway),
+                            ('parking_lot', parking_lot) ]:
+        plan, grid = scenario()
+        filename = os.path.join(here, name + '.rec')
+        write_scenario(filename, plan, grid)
+        print("Wrote %s" % ( filename ))
+
+if __name__ == '__main__':
+    main()
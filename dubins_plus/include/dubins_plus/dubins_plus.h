@@ -65,6 +65,87 @@ namespace dubins_plus {
   std::vector<Segment> dubins_path(double radius,
       geometry_msgs::Pose &start, geometry_msgs::Pose &end);
 
+  // shortest path from the origin, facing along x, to the point x,y, arriving
+  // with a heading within tolerance of theta. Uses segments of radius 1
+  std::vector<Segment> dubins_path_to_heading(double x, double y,
+      double theta, double tolerance);
+
+  // variant that takes start and end points, and a turning radius
+  std::vector<Segment> dubins_path_to_heading(double radius,
+      double x1, double y1, double theta1,
+      double x2, double y2, double theta2, double tolerance);
+
+  // path from the origin, facing along x, into the goal region: within
+  // xy_tolerance of x,y and with a heading within theta_tolerance of theta.
+  // Uses segments of radius 1. Found from a few dozen candidates, so it is
+  // close to, but not always exactly, the shortest. If the origin is already
+  // in the region the path is a single segment of length 0
+  std::vector<Segment> dubins_path_to_region(double x, double y, double theta,
+      double xy_tolerance, double theta_tolerance);
+
+  // variant that takes start and end points, and a turning radius
+  std::vector<Segment> dubins_path_to_region(double radius,
+      double x1, double y1, double theta1,
+      double x2, double y2, double theta2,
+      double xy_tolerance, double theta_tolerance);
+
+  // variant that takes start and end Poses
+  std::vector<Segment> dubins_path_to_region(double radius,
+      geometry_msgs::Pose &start, geometry_msgs::Pose &end,
+      double xy_tolerance, double theta_tolerance);
+
+  // move the pose x,y,theta to the end of the given segment
+  void advance(const Segment &segment, double &x, double &y, double &theta);
+
+  // move the pose x,y,theta the given distance along a path. Stops at the
+  // end of the path if the path is shorter than distance
+  void advance(const std::vector<Segment> &path, double distance,
+      double &x, double &y, double &theta);
+
+  /**
+   * @brief An axis-aligned box. Starts out empty
+   */
+  struct Bounds {
+    double min_x;
+    double min_y;
+    double max_x;
+    double max_y;
+
+    Bounds();
+    bool empty() const { return min_x > max_x || min_y > max_y; }
+    // grow the box to include a point, or another box
+    void add(double x, double y);
+    void add(const Bounds &other);
+    // grow the box by margin on every side
+    void grow(double margin);
+    bool intersects(const Bounds &other) const;
+    bool contains(const Bounds &other) const;
+  };
+
+  // tight bounding box of the curve traced by driving the given segment
+  // from the pose x,y,theta. Closed form: the end points, plus the points
+  // on an arc where its heading crosses a multiple of pi/2
+  Bounds segment_bounds(const Segment &segment, double x, double y,
+      double theta);
+
+  // tight bounding box of a path from the pose x,y,theta
+  Bounds path_bounds(const std::vector<Segment> &path, double x, double y,
+      double theta);
+
+  // conservative region swept by a disc of the given radius centered on the
+  // pose as it drives the path: one box per segment, each grown by radius.
+  // For a robot, radius is how far it reaches from its origin
+  std::vector<Bounds> swept_bounds(const std::vector<Segment> &path,
+      double x, double y, double theta, double radius);
+
+  // batch variants, for many candidate paths from the same start
+  std::vector<Bounds> path_bounds(
+      const std::vector<std::vector<Segment> > &paths,
+      double x, double y, double theta);
+  std::vector<std::vector<Bounds> > swept_bounds(
+      const std::vector<std::vector<Segment> > &paths,
+      double x, double y, double theta, double radius);
+
   // TODO(hendrix): Reeds-Shepp curves
   // TODO(hendrix): Balkcom-Mason curves
 }; // namespace dubins_plus
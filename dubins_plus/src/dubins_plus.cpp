@@ -44,6 +44,8 @@
 #define BOOST_SIGNALS_NO_DEPRECATION_WARNING
 #include <tf/tf.h>
 #include <cmath>
+#include <algorithm>
+#include <limits>
 
 namespace dubins_plus {
 #define TWO_PI (2*M_PI)
@@ -300,5 +302,456 @@ namespace dubins_plus {
         start.position.x, start.position.y, tf::getYaw(start.orientation),
         end.position.x, end.position.y, tf::getYaw(end.orientation));
   }
+
+  void advance(const Segment &segment, double &x, double &y, double &theta) {
+    double length = segment.getLength();
+    double curvature = segment.getCurvature();
+    if( fabs(curvature) < DUBINS_EPS ) {
+      x += length * cos(theta);
+      y += length * sin(theta);
+    } else {
+      // closed form for an arc
+      double end_theta = theta + curvature * length;
+      x += (sin(end_theta) - sin(theta)) / curvature;
+      y += (cos(theta) - cos(end_theta)) / curvature;
+      theta = end_theta;
+    }
+  }
+
+  void advance(const std::vector<Segment> &path, double distance,
+      double &x, double &y, double &theta) {
+    for( int i=0; i<path.size() && distance > 0; i++ ) {
+      double length = std::min(path[i].getLength(), distance);
+      advance(Segment(length, path[i].getCurvature()), x, y, theta);
+      distance -= length;
+    }
+  }
+
+  // helpers for paths to goal regions
+
+  inline double pathLength(const std::vector<Segment> &path) {
+    double length = 0;
+    for( int i=0; i<path.size(); i++ ) {
+      length += path[i].getLength();
+    }
+    return length;
+  }
+
+  inline double endHeading(const std::vector<Segment> &path) {
+    double theta = 0;
+    for( int i=0; i<path.size(); i++ ) {
+      theta += path[i].getLength() * path[i].getCurvature();
+    }
+    return theta;
+  }
+
+  inline bool headingWithin(double heading, double target,
+      double tolerance) {
+    return fabs(remainder(heading - target, TWO_PI)) <= tolerance + DUBINS_EPS;
+  }
+
+  inline void mirror(std::vector<Segment> &path) {
+    for( int i=0; i<path.size(); i++ ) {
+      path[i] = Segment(path[i].getLength(), -path[i].getCurvature());
+    }
+  }
+
+  inline void keepShortest(std::vector<Segment> &best, double &best_length,
+      const std::vector<Segment> &candidate) {
+    double length = pathLength(candidate);
+    if( length < best_length ) {
+      best = candidate;
+      best_length = length;
+    }
+  }
+
+  // the paths that can be shortest to a point when the final heading is
+  // free: left or right then straight, and left-right or right-left.
+  // Left turns only; the right turn versions are mirror images
+  void freeHeadingPathsLeft(double x, double y,
+      std::vector<std::vector<Segment> > &out) {
+    // relative to the center of the left turning circle
+    double dx = x;
+    double dy = y - 1;
+    double dc = sqrt(dx*dx + dy*dy);
+
+    // LS: the point is at (p, -1) in the frame of the tangent heading
+    if( dc >= 1 ) {
+      double p = sqrt(dc*dc - 1);
+      double t = mod2pi(atan2(dy, dx) + atan2(1., p));
+      std::vector<Segment> path;
+      path.push_back(Segment(t, 1));
+      path.push_back(Segment(p, 0));
+      out.push_back(path);
+    }
+
+    // LR: the center of the right circle is 2 from the left center, and the
+    // point is 1 from the right center
+    if( dc >= 1 && dc <= 3 ) {
+      double s = std::min(1., (dc*dc + 3) / (4*dc));
+      double delta = atan2(dy, dx);
+      double roots[2] = { asin(s), M_PI - asin(s) };
+      for( int i=0; i<2; i++ ) {
+        double t = mod2pi(delta + roots[i]);
+        double qx = sin(t), qy = 1 - cos(t);
+        double cx = 2*sin(t), cy = 1 - 2*cos(t);
+        double u = mod2pi(atan2(qy - cy, qx - cx) - atan2(y - cy, x - cx));
+        std::vector<Segment> path;
+        path.push_back(Segment(t, 1));
+        path.push_back(Segment(u, -1));
+        out.push_back(path);
+      }
+    }
+  }
+
+  std::vector<Segment> dubins_path_to_heading(double x, double y,
+      double theta, double tolerance) {
+    tolerance = std::min(fabs(tolerance), M_PI);
+
+    // the shortest path either arrives at one end of the heading interval,
+    // or is also locally shortest when the final heading is free
+    std::vector<Segment> best = dubins_path(x, y, theta - tolerance);
+    double best_length = pathLength(best);
+    keepShortest(best, best_length, dubins_path(x, y, theta + tolerance));
+
+    std::vector<std::vector<Segment> > free;
+    freeHeadingPathsLeft(x, y, free);
+    const int left = free.size();
+    freeHeadingPathsLeft(x, -y, free);
+    for( int i=left; i<free.size(); i++ ) {
+      mirror(free[i]);
+    }
+    for( int i=0; i<free.size(); i++ ) {
+      if( headingWithin(endHeading(free[i]), theta, tolerance) ) {
+        keepShortest(best, best_length, free[i]);
+      }
+    }
+    return best;
+  }
+
+  // distances along a segment, starting at x,y,theta, at which it crosses
+  // the circle of radius r around cx,cy, in order. Returns how many
+  int crossings(const Segment &segment, double x, double y, double theta,
+      double cx, double cy, double r, double out[2]) {
+    double length = segment.getLength();
+    double k = segment.getCurvature();
+    double s[2];
+    if( fabs(k) < DUBINS_EPS ) {
+      // |w + s u|^2 = r^2
+      double wx = x - cx;
+      double wy = y - cy;
+      double b = wx*cos(theta) + wy*sin(theta);
+      double disc = b*b - (wx*wx + wy*wy - r*r);
+      if( disc <= 0 ) {
+        return 0;
+      }
+      s[0] = -b - sqrt(disc);
+      s[1] = -b + sqrt(disc);
+    } else {
+      // intersect the turning circle with the goal circle
+      double R = 1 / fabs(k);
+      double ox = x - sin(theta) / k;
+      double oy = y + cos(theta) / k;
+      double D = hypot(cx - ox, cy - oy);
+      if( D < DUBINS_EPS ) {
+        return 0;
+      }
+      double c = (R*R + D*D - r*r) / (2*R*D);
+      if( c >= 1 || c <= -1 ) {
+        return 0;
+      }
+      double phi0 = atan2(y - oy, x - ox);
+      double phic = atan2(cy - oy, cx - ox);
+      double alpha = acos(c);
+      double sign = k > 0 ? 1 : -1;
+      s[0] = mod2pi(sign * (phic - alpha - phi0)) * R;
+      s[1] = mod2pi(sign * (phic + alpha - phi0)) * R;
+      if( s[1] < s[0] ) {
+        std::swap(s[0], s[1]);
+      }
+    }
+    int n = 0;
+    for( int i=0; i<2; i++ ) {
+      if( s[i] > 0 && s[i] <= length ) {
+        out[n++] = s[i];
+      }
+    }
+    return n;
+  }
+
+  // cut a path off at the first point where it is inside the goal region
+  // with an acceptable heading
+  std::vector<Segment> truncateAtRegion(const std::vector<Segment> &path,
+      double gx, double gy, double r, double theta, double tolerance) {
+    double x = 0, y = 0, heading = 0;
+    for( int i=0; i<path.size(); i++ ) {
+      const double length = path[i].getLength();
+      const double k = path[i].getCurvature();
+      // the stretches of this segment that are inside the circle
+      double cross[2];
+      int n = crossings(path[i], x, y, heading, gx, gy, r, cross);
+      bool inside = hypot(x - gx, y - gy) <= r;
+      double start = 0;
+      for( int j=0; j<=n; j++ ) {
+        double end = (j < n) ? cross[j] : length;
+        if( inside ) {
+          // the first point in [start, end] with a good heading
+          double offset = remainder(heading + k*start - theta, TWO_PI);
+          double s = -1;
+          if( fabs(offset) <= tolerance ) {
+            s = start;
+          } else if( k > DUBINS_EPS ) {
+            s = start + mod2pi(-tolerance - offset) / k;
+          } else if( k < -DUBINS_EPS ) {
+            s = start + mod2pi(offset - tolerance) / -k;
+          }
+          if( s >= 0 && s <= end ) {
+            std::vector<Segment> result(path.begin(), path.begin() + i);
+            result.push_back(Segment(s, k));
+            return result;
+          }
+        }
+        inside = !inside;
+        start = end;
+      }
+      advance(path[i], x, y, heading);
+    }
+    return path;
+  }
+
+  // path to the point at angle on the edge of the region
+  inline std::vector<Segment> edgePath(double x, double y, double theta,
+      double r, double tolerance, double angle) {
+    return truncateAtRegion(dubins_path_to_heading(x + r*cos(angle),
+          y + r*sin(angle), theta, tolerance), x, y, r, theta, tolerance);
+  }
+
+  std::vector<Segment> dubins_path_to_region(double x, double y, double theta,
+      double xy_tolerance, double theta_tolerance) {
+    xy_tolerance = fabs(xy_tolerance);
+    theta_tolerance = std::min(fabs(theta_tolerance), M_PI);
+    if( hypot(x, y) <= xy_tolerance &&
+        headingWithin(0, theta, theta_tolerance) ) {
+      return std::vector<Segment>(1, Segment(0, 0));
+    }
+
+    // the shortest path ends on the edge of the region. Aim for the center
+    // and points around the edge, stopping each path as soon as it is
+    // inside with a good heading, then refine around each edge point that
+    // is better than its neighbours
+    static const int EDGE_POINTS = 16;
+    static const int REFINE_STEPS = 6;
+    std::vector<Segment> best = truncateAtRegion(
+        dubins_path_to_heading(x, y, theta, theta_tolerance),
+        x, y, xy_tolerance, theta, theta_tolerance);
+    double best_length = pathLength(best);
+    if( xy_tolerance <= 0 ) {
+      return best;
+    }
+    const double spacing = TWO_PI / EDGE_POINTS;
+    double edge_length[EDGE_POINTS];
+    for( int i=0; i<EDGE_POINTS; i++ ) {
+      std::vector<Segment> path = edgePath(x, y, theta, xy_tolerance,
+          theta_tolerance, i * spacing);
+      edge_length[i] = pathLength(path);
+      keepShortest(best, best_length, path);
+    }
+    for( int i=0; i<EDGE_POINTS; i++ ) {
+      if( edge_length[i] > edge_length[(i + 1) % EDGE_POINTS] ||
+          edge_length[i] > edge_length[(i + EDGE_POINTS - 1) % EDGE_POINTS] ) {
+        continue;
+      }
+      double angle = i * spacing;
+      double length = edge_length[i];
+      double step = spacing;
+      for( int j=0; j<REFINE_STEPS; j++ ) {
+        step /= 2;
+        double center = angle;
+        for( int k=-1; k<=1; k+=2 ) {
+          std::vector<Segment> path = edgePath(x, y, theta, xy_tolerance,
+              theta_tolerance, center + k * step);
+          double l = pathLength(path);
+          if( l < length ) {
+            length = l;
+            angle = center + k * step;
+            keepShortest(best, best_length, path);
+          }
+        }
+      }
+    }
+    return best;
+  }
+
+  // move the goal into the frame of the start, scaled to a radius of 1
+  inline void normalize(double radius,
+      double x1, double y1, double theta1,
+      double x2, double y2, double theta2,
+      double &x, double &y, double &theta) {
+    double dx = x2 - x1;
+    double dy = y2 - y1;
+    x = ( cos(theta1) * dx + sin(theta1) * dy) / radius;
+    y = (-sin(theta1) * dx + cos(theta1) * dy) / radius;
+    theta = remainder(theta2 - theta1, TWO_PI);
+  }
+
+  inline std::vector<Segment> scale(const std::vector<Segment> &path,
+      double radius) {
+    std::vector<Segment> result;
+    for( int i=0; i<path.size(); i++ ) {
+      result.push_back(Segment(path[i].getLength() * radius,
+          path[i].getCurvature() / radius));
+    }
+    return result;
+  }
+
+  std::vector<Segment> dubins_path_to_heading(double radius,
+      double x1, double y1, double theta1,
+      double x2, double y2, double theta2, double tolerance) {
+    double x, y, theta;
+    normalize(radius, x1, y1, theta1, x2, y2, theta2, x, y, theta);
+    return scale(dubins_path_to_heading(x, y, theta, tolerance), radius);
+  }
+
+  std::vector<Segment> dubins_path_to_region(double radius,
+      double x1, double y1, double theta1,
+      double x2, double y2, double theta2,
+      double xy_tolerance, double theta_tolerance) {
+    double x, y, theta;
+    normalize(radius, x1, y1, theta1, x2, y2, theta2, x, y, theta);
+    return scale(dubins_path_to_region(x, y, theta, xy_tolerance / radius,
+          theta_tolerance), radius);
+  }
+
+  std::vector<Segment> dubins_path_to_region(double radius,
+      geometry_msgs::Pose &start, geometry_msgs::Pose &end,
+      double xy_tolerance, double theta_tolerance) {
+    return dubins_path_to_region(radius,
+        start.position.x, start.position.y, tf::getYaw(start.orientation),
+        end.position.x, end.position.y, tf::getYaw(end.orientation),
+        xy_tolerance, theta_tolerance);
+  }
+
+  // swept bounds
+
+  Bounds::Bounds() : min_x(std::numeric_limits<double>::infinity()),
+    min_y(std::numeric_limits<double>::infinity()),
+    max_x(-std::numeric_limits<double>::infinity()),
+    max_y(-std::numeric_limits<double>::infinity()) {
+  }
+
+  void Bounds::add(double x, double y) {
+    min_x = std::min(min_x, x);
+    min_y = std::min(min_y, y);
+    max_x = std::max(max_x, x);
+    max_y = std::max(max_y, y);
+  }
+
+  void Bounds::add(const Bounds &other) {
+    if( ! other.empty() ) {
+      add(other.min_x, other.min_y);
+      add(other.max_x, other.max_y);
+    }
+  }
+
+  void Bounds::grow(double margin) {
+    if( ! empty() ) {
+      min_x -= margin;
+      min_y -= margin;
+      max_x += margin;
+      max_y += margin;
+    }
+  }
+
+  bool Bounds::intersects(const Bounds &other) const {
+    return ! empty() && ! other.empty() &&
+      min_x <= other.max_x && other.min_x <= max_x &&
+      min_y <= other.max_y && other.min_y <= max_y;
+  }
+
+  bool Bounds::contains(const Bounds &other) const {
+    return ! empty() && ! other.empty() &&
+      min_x <= other.min_x && other.max_x <= max_x &&
+      min_y <= other.min_y && other.max_y <= max_y;
+  }
+
+  Bounds segment_bounds(const Segment &segment, double x, double y,
+      double theta) {
+    Bounds bounds;
+    bounds.add(x, y);
+    double ex = x, ey = y, etheta = theta;
+    advance(segment, ex, ey, etheta);
+    bounds.add(ex, ey);
+
+    const double curvature = segment.getCurvature();
+    if( fabs(curvature) < DUBINS_EPS ) {
+      return bounds;
+    }
+    // the point at heading phi is center + (sin(phi), -cos(phi)) / curvature
+    const double cx = x - sin(theta) / curvature;
+    const double cy = y + cos(theta) / curvature;
+    const double sweep = curvature * segment.getLength();
+    if( fabs(sweep) >= TWO_PI ) {
+      const double r = 1 / fabs(curvature);
+      bounds.add(cx - r, cy - r);
+      bounds.add(cx + r, cy + r);
+      return bounds;
+    }
+    // x is extreme where the heading is pi/2 + n*pi, and y where it is n*pi
+    const double lo = std::min(theta, theta + sweep);
+    const double hi = std::max(theta, theta + sweep);
+    for( int n=int(ceil(lo / M_PI_2)); n * M_PI_2 <= hi; n++ ) {
+      const double phi = n * M_PI_2;
+      bounds.add(cx + sin(phi) / curvature, cy - cos(phi) / curvature);
+    }
+    return bounds;
+  }
+
+  Bounds path_bounds(const std::vector<Segment> &path, double x, double y,
+      double theta) {
+    Bounds bounds;
+    bounds.add(x, y);
+    for( int i=0; i<path.size(); i++ ) {
+      bounds.add(segment_bounds(path[i], x, y, theta));
+      advance(path[i], x, y, theta);
+    }
+    return bounds;
+  }
+
+  std::vector<Bounds> swept_bounds(const std::vector<Segment> &path,
+      double x, double y, double theta, double radius) {
+    std::vector<Bounds> swept;
+    for( int i=0; i<path.size(); i++ ) {
+      swept.push_back(segment_bounds(path[i], x, y, theta));
+      swept.back().grow(radius);
+      advance(path[i], x, y, theta);
+    }
+    if( swept.empty() ) {
+      swept.push_back(Bounds());
+      swept.back().add(x, y);
+      swept.back().grow(radius);
+    }
+    return swept;
+  }
+
+  std::vector<Bounds> path_bounds(
+      const std::vector<std::vector<Segment> > &paths,
+      double x, double y, double theta) {
+    std::vector<Bounds> bounds;
+    bounds.reserve(paths.size());
+    for( int i=0; i<paths.size(); i++ ) {
+      bounds.push_back(path_bounds(paths[i], x, y, theta));
+    }
+    return bounds;
+  }
+
+  std::vector<std::vector<Bounds> > swept_bounds(
+      const std::vector<std::vector<Segment> > &paths,
+      double x, double y, double theta, double radius) {
+    std::vector<std::vector<Bounds> > swept(paths.size());
+    for( int i=0; i<paths.size(); i++ ) {
+      swept[i] = swept_bounds(paths[i], x, y, theta, radius);
+    }
+    return swept;
+  }
 };
 
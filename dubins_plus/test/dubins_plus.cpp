@@ -2,6 +2,7 @@
 #include "dubins_plus/dubins_plus.h"
 
 #include <gtest/gtest.h>
+#include <cstdlib>
 
 using namespace dubins_plus;
 
@@ -108,6 +109,240 @@ TEST(DubinsTests, startAngle) {
   }
 }
 
+TEST(DubinsTests, advance) {
+  // following a dubins path should land on its goal
+  double input[][6] = {
+    0, 0, 0, 2, 1, M_PI/2,
+    1, 1, M_PI/2, 0, 2, M_PI,
+    0, 0, M_PI/4, -1, 3, -M_PI/2,
+    2, -1, 0, -3, 0, 0,
+  };
+  int input_sz = sizeof(input)/sizeof(double)/6;
+
+  for(int i=0; i<input_sz; i++) {
+    std::vector<Segment> a = dubins_path(0.5,
+        input[i][0], input[i][1], input[i][2],
+        input[i][3], input[i][4], input[i][5]);
+    double x = input[i][0];
+    double y = input[i][1];
+    double theta = input[i][2];
+    for(int j=0; j<a.size(); j++) {
+      advance(a[j], x, y, theta);
+    }
+    EXPECT_NEAR(x, input[i][3], 1e-6);
+    EXPECT_NEAR(y, input[i][4], 1e-6);
+    EXPECT_NEAR(remainder(theta - input[i][5], 2*M_PI), 0.0, 1e-6);
+  }
+}
+
+TEST(DubinsTests, advanceDistance) {
+  // half way around a unit circle
+  std::vector<Segment> a;
+  a.push_back(Segment(M_PI, 1.0));
+  a.push_back(Segment(2.0, 0.0));
+  double x = 0, y = 0, theta = 0;
+  advance(a, M_PI/2, x, y, theta);
+  EXPECT_NEAR(x, 1.0, 1e-9);
+  EXPECT_NEAR(y, 1.0, 1e-9);
+  EXPECT_NEAR(theta, M_PI/2, 1e-9);
+
+  // past the end of the path stops at the end
+  x = 0, y = 0, theta = 0;
+  advance(a, 10.0, x, y, theta);
+  EXPECT_NEAR(x, -2.0, 1e-9);
+  EXPECT_NEAR(y, 2.0, 1e-9);
+  EXPECT_NEAR(theta, M_PI, 1e-9);
+}
+
+double pathLength(const std::vector<Segment> &path) {
+  double length = 0;
+  for( int i=0; i<path.size(); i++ ) {
+    length += path[i].getLength();
+  }
+  return length;
+}
+
+TEST(DubinsTests, toHeading) {
+  // no tolerance is the same as an exact goal
+  std::vector<Segment> exact = dubins_path(2, 1, M_PI/2);
+  std::vector<Segment> a = dubins_path_to_heading(2, 1, M_PI/2, 0);
+  EXPECT_NEAR(pathLength(a), pathLength(exact), 1e-9);
+
+  // straight ahead is good enough if the tolerance covers it
+  a = dubins_path_to_heading(3, 0, M_PI/2, M_PI/2);
+  EXPECT_NEAR(pathLength(a), 3.0, 1e-9);
+
+  // a quarter turn to the left is shorter than any exact goal around it
+  a = dubins_path_to_heading(1, 1, M_PI/2, 0.3);
+  EXPECT_NEAR(pathLength(a), M_PI/2, 1e-9);
+  EXPECT_LT(pathLength(a), pathLength(dubins_path(1, 1, M_PI/2 - 0.3)));
+  EXPECT_LT(pathLength(a), pathLength(dubins_path(1, 1, M_PI/2 + 0.3)));
+}
+
+TEST(DubinsTests, toHeadingRandom) {
+  srand(1);
+  for( int i=0; i<200; i++ ) {
+    double x = 8.0 * rand() / RAND_MAX - 4;
+    double y = 8.0 * rand() / RAND_MAX - 4;
+    double theta = 2 * M_PI * rand() / RAND_MAX - M_PI;
+    double tolerance = 1.5 * rand() / RAND_MAX;
+    std::vector<Segment> a = dubins_path_to_heading(x, y, theta, tolerance);
+
+    // ends at the point, with a heading in the interval
+    double ex = 0, ey = 0, etheta = 0;
+    for( int j=0; j<a.size(); j++ ) {
+      advance(a[j], ex, ey, etheta);
+    }
+    EXPECT_NEAR(ex, x, 1e-6);
+    EXPECT_NEAR(ey, y, 1e-6);
+    EXPECT_LE(fabs(remainder(etheta - theta, 2*M_PI)), tolerance + 1e-6);
+
+    // no worse than any exact goal in the interval
+    for( int j=0; j<=10; j++ ) {
+      double h = theta - tolerance + 2 * tolerance * j / 10;
+      EXPECT_LE(pathLength(a), pathLength(dubins_path(x, y, h)) + 1e-9);
+    }
+  }
+}
+
+TEST(DubinsTests, toRegion) {
+  // already there
+  std::vector<Segment> a = dubins_path_to_region(0.1, 0, 0.1, 0.2, 0.2);
+  ASSERT_EQ(a.size(), 1);
+  EXPECT_FLOAT_EQ(a[0].getLength(), 0.0);
+
+  // straight ahead stops at the edge of the region
+  a = dubins_path_to_region(3, 0, 0, 0.5, 0.1);
+  EXPECT_NEAR(pathLength(a), 2.5, 1e-9);
+
+  // with a radius and start pose
+  a = dubins_path_to_region(2.0, 1, 1, M_PI/2, 1, 4, M_PI/2, 0.5, 0.1);
+  EXPECT_NEAR(pathLength(a), 2.5, 1e-9);
+}
+
+TEST(DubinsTests, toRegionRandom) {
+  srand(2);
+  for( int i=0; i<200; i++ ) {
+    double x = 8.0 * rand() / RAND_MAX - 4;
+    double y = 8.0 * rand() / RAND_MAX - 4;
+    double theta = 2 * M_PI * rand() / RAND_MAX - M_PI;
+    double xy_tolerance = 0.5 * rand() / RAND_MAX;
+    double theta_tolerance = 1.0 * rand() / RAND_MAX;
+    std::vector<Segment> a = dubins_path_to_region(x, y, theta,
+        xy_tolerance, theta_tolerance);
+
+    // ends in the region
+    double ex = 0, ey = 0, etheta = 0;
+    for( int j=0; j<a.size(); j++ ) {
+      advance(a[j], ex, ey, etheta);
+    }
+    EXPECT_LE(hypot(ex - x, ey - y), xy_tolerance + 1e-6);
+    EXPECT_LE(fabs(remainder(etheta - theta, 2*M_PI)),
+        theta_tolerance + 1e-6);
+
+    // no worse than going to the center
+    EXPECT_LE(pathLength(a), pathLength(dubins_path_to_heading(x, y, theta,
+            theta_tolerance)) + 1e-9);
+  }
+}
+
+TEST(DubinsTests, boundsArc) {
+  // quarter and half of a unit circle to the left
+  Bounds b = segment_bounds(Segment(M_PI/2, 1.0), 0, 0, 0);
+  EXPECT_NEAR(b.min_x, 0.0, 1e-9);
+  EXPECT_NEAR(b.max_x, 1.0, 1e-9);
+  EXPECT_NEAR(b.min_y, 0.0, 1e-9);
+  EXPECT_NEAR(b.max_y, 1.0, 1e-9);
+  b = segment_bounds(Segment(M_PI, 1.0), 0, 0, 0);
+  EXPECT_NEAR(b.max_x, 1.0, 1e-9);
+  EXPECT_NEAR(b.max_y, 2.0, 1e-9);
+
+  // the same quarter, backwards
+  b = segment_bounds(Segment(-M_PI/2, 1.0), 0, 0, 0);
+  EXPECT_NEAR(b.min_x, -1.0, 1e-9);
+  EXPECT_NEAR(b.max_x, 0.0, 1e-9);
+  EXPECT_NEAR(b.min_y, 0.0, 1e-9);
+  EXPECT_NEAR(b.max_y, 1.0, 1e-9);
+
+  // more than a full circle covers the whole circle
+  b = segment_bounds(Segment(10.0, -2.0), 1, 1, M_PI/2);
+  EXPECT_NEAR(b.min_x, 1.0, 1e-9);
+  EXPECT_NEAR(b.max_x, 2.0, 1e-9);
+  EXPECT_NEAR(b.min_y, 0.5, 1e-9);
+  EXPECT_NEAR(b.max_y, 1.5, 1e-9);
+
+  // a straight line is its end points
+  b = segment_bounds(Segment(2.0, 0.0), 1, 1, M_PI/4);
+  EXPECT_NEAR(b.max_x, 1 + sqrt(2.0), 1e-9);
+  EXPECT_NEAR(b.min_y, 1.0, 1e-9);
+}
+
+TEST(DubinsTests, boundsRandom) {
+  // the box holds every point along the path, and each side is touched
+  srand(7);
+  for( int i=0; i<200; i++ ) {
+    double x1 = (rand() % 1000) / 100.0 - 5;
+    double y1 = (rand() % 1000) / 100.0 - 5;
+    double theta1 = (rand() % 628) / 100.0 - M_PI;
+    double x2 = (rand() % 1000) / 100.0 - 5;
+    double y2 = (rand() % 1000) / 100.0 - 5;
+    double theta2 = (rand() % 628) / 100.0 - M_PI;
+    std::vector<Segment> a = dubins_path(0.5, x1, y1, theta1, x2, y2, theta2);
+    Bounds b = path_bounds(a, x1, y1, theta1);
+    Bounds sampled;
+    const double length = pathLength(a);
+    for( int k=0; k<=2000; k++ ) {
+      double x = x1, y = y1, theta = theta1;
+      advance(a, length * k / 2000, x, y, theta);
+      sampled.add(x, y);
+    }
+    EXPECT_TRUE(b.contains(sampled));
+    EXPECT_NEAR(b.min_x, sampled.min_x, 1e-3);
+    EXPECT_NEAR(b.min_y, sampled.min_y, 1e-3);
+    EXPECT_NEAR(b.max_x, sampled.max_x, 1e-3);
+    EXPECT_NEAR(b.max_y, sampled.max_y, 1e-3);
+
+    // swept boxes are each segment grown by the radius, and cover the path
+    std::vector<Bounds> swept = swept_bounds(a, x1, y1, theta1, 0.3);
+    ASSERT_EQ(swept.size(), a.size());
+    Bounds all;
+    for( int j=0; j<swept.size(); j++ ) {
+      all.add(swept[j]);
+    }
+    EXPECT_NEAR(all.min_x, b.min_x - 0.3, 1e-9);
+    EXPECT_NEAR(all.max_y, b.max_y + 0.3, 1e-9);
+  }
+}
+
+TEST(DubinsTests, boundsBatch) {
+  std::vector<std::vector<Segment> > paths;
+  for( int i=0; i<10; i++ ) {
+    paths.push_back(dubins_path(1.0, 0, 0, 0, i - 5.0, 3.0, i * 0.5));
+  }
+  std::vector<Bounds> b = path_bounds(paths, 0, 0, 0);
+  std::vector<std::vector<Bounds> > swept = swept_bounds(paths, 0, 0, 0,
+      0.5);
+  ASSERT_EQ(b.size(), paths.size());
+  ASSERT_EQ(swept.size(), paths.size());
+  for( int i=0; i<paths.size(); i++ ) {
+    Bounds single = path_bounds(paths[i], 0, 0, 0);
+    EXPECT_EQ(b[i].min_x, single.min_x);
+    EXPECT_EQ(b[i].max_y, single.max_y);
+    EXPECT_EQ(swept[i].size(), paths[i].size());
+  }
+
+  // an empty path sweeps the disc around the start
+  std::vector<Bounds> start = swept_bounds(std::vector<Segment>(), 1, 2, 0,
+      0.5);
+  ASSERT_EQ(start.size(), 1u);
+  EXPECT_NEAR(start[0].min_x, 0.5, 1e-9);
+  EXPECT_NEAR(start[0].max_y, 2.5, 1e-9);
+
+  Bounds empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_FALSE(empty.intersects(start[0]));
+}
+
 int main(int argc, char ** argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
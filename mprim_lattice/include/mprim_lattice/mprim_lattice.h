@@ -0,0 +1,161 @@
+/**
+ * mprim_lattice: SBPL lattice motion primitives
+ *
+ * Reads the .mprim files that the SBPL lattice planner plans with, so that
+ * the rest of the navigation stack can work with the exact geometry of the
+ * primitives a plan was built from instead of re-deriving it from poses.
+ *
+ * Author: Austin Hendrix
+ */
+
+#ifndef MPRIM_LATTICE_H
+#define MPRIM_LATTICE_H
+
+#include <string>
+#include <vector>
+#include <istream>
+
+namespace mprim_lattice {
+  class ParametricSet;
+
+  /**
+   * @brief A continuous pose; meters and radians
+   */
+  struct Pose {
+    double x;
+    double y;
+    double theta;
+
+    Pose() : x(0), y(0), theta(0) {}
+    Pose(double x, double y, double theta) : x(x), y(y), theta(theta) {}
+  };
+
+  /**
+   * @brief One motion primitive, and the feedforward tables for following it
+   *
+   * The step tables have one entry per step between consecutive
+   * intermediate poses.
+   */
+  struct Primitive {
+    int id;            ///< @brief primID; unique within the start angle
+    int start_angle;   ///< @brief discrete start heading
+    int end_x;         ///< @brief end cell, relative to the start cell
+    int end_y;
+    int end_angle;     ///< @brief discrete end heading
+    int cost_mult;     ///< @brief additionalactioncostmult
+
+    /// @brief intermediate poses; positions relative to the start cell
+    std::vector<Pose> poses;
+
+    /// @brief arc length from the start of the primitive to each pose
+    std::vector<double> station;
+    /// @brief signed curvature of each step; + is left, per meter of travel
+    /// in the direction of the step
+    std::vector<double> curvature;
+    /// @brief +1 where the step is driven forwards, -1 backwards
+    std::vector<int> direction;
+    /// @brief speed limit of each step; filled in by
+    /// PrimitiveSet::setSpeedLimits
+    std::vector<double> speed;
+
+    /// @brief total arc length
+    double length;
+  };
+
+  /**
+   * @brief All of the primitives in a .mprim file, by start angle
+   */
+  class PrimitiveSet {
+    public:
+      PrimitiveSet();
+
+      /**
+       * @brief Load a .mprim file. Replaces anything loaded before
+       * @return false if the file could not be read; see error()
+       */
+      bool load(const std::string &filename);
+
+      /**
+       * @brief Load .mprim data from a stream
+       */
+      bool load(std::istream &in);
+
+      /**
+       * @brief Sample a parametric set, with poses no further apart than
+       * spacing (m). Replaces anything loaded before
+       */
+      void load(const ParametricSet &set, double spacing);
+
+      /**
+       * @brief Description of the last load failure
+       */
+      const std::string &error() const { return error_; }
+
+      bool empty() const { return size_ == 0; }
+      int size() const { return size_; }
+
+      double resolution() const { return resolution_; }
+      int numAngles() const { return by_angle_.size(); }
+
+      /**
+       * @brief The primitives that start at a discrete heading
+       */
+      const std::vector<Primitive> &primitives(int start_angle) const {
+        return by_angle_[start_angle];
+      }
+
+      /**
+       * @brief Recompute the speed table of every primitive
+       */
+      void setSpeedLimits(double max_vel, double max_lateral_acc);
+
+      /**
+       * @brief Continuous heading of a discrete angle
+       */
+      double angle(int index) const;
+
+      /**
+       * @brief The discrete angle nearest to a continuous heading
+       */
+      int angleIndex(double theta) const;
+
+      /**
+       * @brief Find the primitive that a stretch of a plan was built from
+       *
+       * Planners built on SBPL emit the intermediate poses of each primitive
+       * in turn, so path[start] is the start of the primitive and the poses
+       * that follow it are its intermediate poses offset by path[start].
+       *
+       * @param path The plan
+       * @param start Index of the first pose of the stretch
+       * @param xy_tolerance How far each pose may be from the primitive (m)
+       * @param theta_tolerance How far each heading may differ (rad)
+       * @return The matching primitive, or NULL if nothing matches
+       */
+      const Primitive *match(const std::vector<Pose> &path, int start,
+          double xy_tolerance, double theta_tolerance) const;
+
+    private:
+      double resolution_;
+      int size_;
+      std::vector<std::vector<Primitive> > by_angle_;
+      std::string error_;
+  };
+
+  /**
+   * @brief Speed limit for each step of a primitive, from its curvature
+   *
+   * The speed at a step with curvature k is limited so that the lateral
+   * acceleration v^2 * |k| stays below max_lateral_acc.
+   */
+  std::vector<double> speedTable(const Primitive &primitive, double max_vel,
+      double max_lateral_acc);
+
+  /**
+   * @brief Fill in the station, curvature and direction tables of a
+   * primitive from its intermediate poses
+   */
+  void computeTables(Primitive &primitive);
+}; // namespace mprim_lattice
+
+#endif
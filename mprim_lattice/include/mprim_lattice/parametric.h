@@ -0,0 +1,183 @@
+/**
+ * mprim_lattice: SBPL lattice motion primitives
+ *
+ * Parametric primitives: the handful of clothoid segments that mprim_gen.py
+ * builds each primitive from, instead of a fixed number of sampled poses.
+ * Poses are evaluated on demand at whatever spacing the caller needs, so a
+ * collision check can sample as densely as the costmap calls for while the
+ * primitive set itself stays a few numbers per primitive.
+ *
+ * A .pmprim file has the same header and per-primitive fields as a .mprim
+ * file, with the intermediate poses replaced by the heading the primitive
+ * starts at and a list of segments:
+ *
+ *   startheading: 0.000000
+ *   segments: 3
+ *   0.100000 0.000000
+ *   0.131623 12.500000
+ *   ...
+ *
+ * Each segment is a length in meters and a sharpness: the change in
+ * curvature per meter. Curvature starts at zero and is continuous, so a
+ * sharpness of zero is a line or an arc depending on what came before it.
+ *
+ * Author: Austin Hendrix
+ */
+
+#ifndef MPRIM_LATTICE_PARAMETRIC_H
+#define MPRIM_LATTICE_PARAMETRIC_H
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <ostream>
+
+#include "mprim_lattice/mprim_lattice.h"
+
+namespace mprim_lattice {
+  /**
+   * @brief A stretch of path whose curvature changes linearly with arc
+   * length
+   */
+  struct Clothoid {
+    double length;      ///< @brief meters; never negative
+    double sharpness;   ///< @brief change in curvature per meter; + is left
+
+    Clothoid() : length(0), sharpness(0) {}
+    Clothoid(double length, double sharpness) : length(length),
+      sharpness(sharpness) {}
+  };
+
+  /**
+   * @brief Where a segment starts, so that any pose along it can be
+   * evaluated without walking the segments before it
+   */
+  struct Knot {
+    double station;     ///< @brief arc length from the start of the primitive
+    Pose pose;
+    double curvature;
+  };
+
+  /**
+   * @brief One motion primitive, as the segments it was generated from
+   */
+  struct ParametricPrimitive {
+    int id;            ///< @brief primID; unique within the start angle
+    int start_angle;   ///< @brief discrete start heading
+    int end_x;         ///< @brief end cell, relative to the start cell
+    int end_y;
+    int end_angle;     ///< @brief discrete end heading
+    int cost_mult;     ///< @brief additionalactioncostmult
+
+    /// @brief continuous start heading; the generator's lattice angles need
+    /// not be evenly spaced
+    double start_theta;
+    std::vector<Clothoid> segments;
+
+    /// @brief start of each segment; filled in by computeKnots
+    std::vector<Knot> knots;
+    /// @brief how far the integrated end is from the end cell; spread along
+    /// the primitive by evaluate(), so it ends exactly on the lattice
+    double closure_x;
+    double closure_y;
+    /// @brief total arc length
+    double length;
+  };
+
+  /**
+   * @brief All of the primitives in a .pmprim file, by start angle
+   */
+  class ParametricSet {
+    public:
+      ParametricSet();
+
+      /**
+       * @brief Load a .pmprim file. Replaces anything loaded before
+       * @return false if the file could not be read; see error()
+       */
+      bool load(const std::string &filename);
+
+      /**
+       * @brief Load .pmprim data from a stream
+       */
+      bool load(std::istream &in);
+
+      /**
+       * @brief Write the set back out in .pmprim format
+       */
+      void save(std::ostream &out) const;
+
+      /**
+       * @brief Description of the last load failure
+       */
+      const std::string &error() const { return error_; }
+
+      bool empty() const { return size_ == 0; }
+      int size() const { return size_; }
+
+      double resolution() const { return resolution_; }
+      int numAngles() const { return by_angle_.size(); }
+
+      /**
+       * @brief The primitives that start at a discrete heading
+       */
+      const std::vector<ParametricPrimitive> &primitives(
+          int start_angle) const {
+        return by_angle_[start_angle];
+      }
+
+    private:
+      double resolution_;
+      int size_;
+      std::vector<std::vector<ParametricPrimitive> > by_angle_;
+      std::string error_;
+  };
+
+  /**
+   * @brief Drive a clothoid from a pose
+   *
+   * Lines and arcs are evaluated in closed form; spirals with Gauss-Legendre
+   * quadrature over pieces short enough that the error is far below the
+   * precision of a .mprim file.
+   *
+   * @param start Pose at the start of the segment
+   * @param curvature Curvature at the start of the segment
+   * @param sharpness Change in curvature per meter
+   * @param length How far along the segment to go
+   */
+  Pose advance(const Pose &start, double curvature, double sharpness,
+      double length);
+
+  /**
+   * @brief Fill in the knots, closure and length of a primitive from its
+   * segments
+   */
+  void computeKnots(ParametricPrimitive &primitive, double resolution);
+
+  /**
+   * @brief The pose at arc length s along a primitive; clamped to its ends.
+   * Positions are relative to the start cell
+   */
+  Pose evaluate(const ParametricPrimitive &primitive, double s);
+
+  /**
+   * @brief Curvature at arc length s along a primitive
+   */
+  double curvatureAt(const ParametricPrimitive &primitive, double s);
+
+  /**
+   * @brief Evenly spaced poses along a primitive, no further apart than
+   * spacing, including both ends
+   */
+  void sample(const ParametricPrimitive &primitive, double spacing,
+      std::vector<Pose> &poses);
+
+  /**
+   * @brief A sampled primitive, with its tables, for everything that works
+   * on poses
+   */
+  Primitive toPrimitive(const ParametricPrimitive &primitive,
+      double spacing);
+}; // namespace mprim_lattice
+
+#endif
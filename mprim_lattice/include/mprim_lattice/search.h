@@ -0,0 +1,221 @@
+/**
+ * mprim_lattice: SBPL lattice motion primitives
+ *
+ * A* over the lattice, with an optional second, coarser level of
+ * primitives for open space.
+ *
+ * The coarse primitives are the same kind of primitives built on cells that
+ * are a whole number of fine cells across, so every coarse state is also a
+ * fine state. Near the start and the goal every fine state is searched.
+ * Everywhere else only the states on the coarse grid exist: they are
+ * expanded with the coarse primitives, and fine primitives may only end on
+ * them. That keeps the transitions between the levels consistent; a path
+ * leaves the fine area by reaching the coarse grid, and comes back in on
+ * a coarse primitive.
+ *
+ * The same search answers one-to-many cost queries: Dijkstra from one start
+ * until every goal is settled, so ordering many waypoints takes one search
+ * per waypoint instead of one per pair.
+ *
+ * Path searches can be spread over several threads, as hash-distributed A*
+ * (HDA*, Kishimoto, Fukunaga and Botea, 2009): each thread owns the states
+ * that hash to it and keeps its own open list, and sends the successors it
+ * generates to their owners. A state can be reached more cheaply after it
+ * has been expanded, so it is opened again, and the search goes on until
+ * nothing left anywhere could lead to a cheaper path. The cost is the same
+ * as searching on one thread.
+ *
+ * Author: Austin Hendrix
+ */
+
+#ifndef MPRIM_LATTICE_SEARCH_H
+#define MPRIM_LATTICE_SEARCH_H
+
+#include <string>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include "mprim_lattice/symmetry.h"
+
+namespace mprim_lattice {
+  /**
+   * @brief A lattice state; a map cell and a discrete heading
+   */
+  struct State {
+    int x;
+    int y;
+    int angle;
+
+    State() : x(0), y(0), angle(0) {}
+    State(int x, int y, int angle) : x(x), y(y), angle(angle) {}
+
+    bool operator==(const State &o) const {
+      return x == o.x && y == o.y && angle == o.angle;
+    }
+  };
+
+  /**
+   * @brief One primitive of a path
+   */
+  struct Step {
+    State start;
+    int primitive;    ///< @brief index among the primitives of the start angle
+    bool coarse;      ///< @brief from the coarse set
+  };
+
+  /**
+   * @class LatticeSearch
+   * @brief Plans over a grid map with lattice primitives
+   *
+   * Map cells are fine lattice cells. Cells at or above the lethal cost are
+   * blocked, and a primitive is blocked if any of its intermediate poses is
+   * in a blocked cell or off of the map; the map is expected to be inflated
+   * by the robot's radius, as for the SBPL planners.
+   */
+  class LatticeSearch {
+    public:
+      LatticeSearch();
+
+      /**
+       * @brief Set the primitives to search with. They must outlive the search
+       * @param coarse Primitives for open space, or NULL to search with the
+       * fine primitives only. Its cells must be a whole number of fine cells
+       * across, and it must have the same headings as the fine set
+       * @return false if the levels don't line up; see error()
+       */
+      bool setPrimitives(const OctantPrimitives *fine,
+          const OctantPrimitives *coarse = NULL);
+
+      /**
+       * @brief Search every fine state within this many cells of the start or
+       * the goal
+       */
+      void setFineRadius(int cells) { fine_radius_ = cells; }
+
+      /**
+       * @brief Search for paths with this many threads. The default, 1,
+       * searches on the calling thread. Cost queries always do
+       *
+       * More threads have not been shown to be faster. In benchmark_search
+       * on dagny.mprim, 2 threads expanded 2.6 times as many states as one
+       * and 4 threads 1.5 times as many, re-expanding states that were
+       * reached more cheaply later; only single core timings exist. Run
+       * benchmark_search on the target machine before raising this.
+       */
+      void setThreads(int threads) { threads_ = threads < 1 ? 1 : threads; }
+
+      /**
+       * @brief Set the map. The cells are not copied, and must outlive the
+       * search
+       * @param cells width * height costs, row-major from the map origin
+       */
+      void setMap(int width, int height, const unsigned char *cells,
+          unsigned char lethal);
+
+      /**
+       * @brief Search for the cheapest path from start to goal
+       * @return false if there is no path; see error()
+       */
+      bool plan(const State &start, const State &goal);
+
+      /**
+       * @brief Cost from one start to each of many goals, from one search
+       *
+       * Expands outwards from the start, without a heuristic unless there is
+       * only one goal, and stops once every goal that can be reached has
+       * been settled. The fine area is
+       * around the start and every goal. The node storage of the last search
+       * is reused, so repeated queries don't reallocate.
+       *
+       * @param costs Set to the cost to each goal, or -1 where there is no
+       * path
+       * @return The number of goals reached
+       */
+      int costs(const State &start, const std::vector<State> &goals,
+          std::vector<double> &costs);
+
+      const std::string &error() const { return error_; }
+
+      /**
+       * @brief The primitives of the last path, in order
+       */
+      const std::vector<Step> &steps() const { return steps_; }
+
+      /**
+       * @brief Cost of the last path; the sum of the primitive costs
+       */
+      double cost() const { return cost_; }
+
+      /**
+       * @brief The number of states expanded by the last search
+       */
+      int expansions() const { return expansions_; }
+
+      /**
+       * @brief The intermediate poses of the last path, in meters from the
+       * map origin
+       */
+      std::vector<Pose> path() const;
+
+      /**
+       * @brief Whether a state is on the coarse grid
+       */
+      bool onCoarseGrid(const State &s) const {
+        return factor_ > 0 && s.x % factor_ == 0 && s.y % factor_ == 0;
+      }
+
+    private:
+      class ParallelSearch;
+
+      struct Node {
+        State state;
+        double g;
+        int parent;
+        int primitive;
+        bool coarse;
+        bool closed;
+      };
+
+      bool onMap(const State &s) const {
+        return s.x >= 0 && s.y >= 0 && s.x < width_ && s.y < height_;
+      }
+      int key(const State &s) const {
+        return (s.y * width_ + s.x) * fine_->numAngles() + s.angle;
+      }
+      void reset(const State &start);
+      int pop();
+      bool inFineArea(const State &s) const;
+      bool blocked(const OctantPrimitives &primitives, const State &s,
+          int i) const;
+      double heuristic(const State &s) const;
+      void expand(int node, bool coarse);
+      bool planParallel(const State &start, const State &goal);
+
+      const OctantPrimitives *fine_;
+      const OctantPrimitives *coarse_;
+      int factor_;       ///< @brief fine cells per coarse cell; 0 if no coarse
+      int fine_radius_;
+      int threads_;
+
+      int width_;
+      int height_;
+      const unsigned char *cells_;
+      unsigned char lethal_;
+
+      State start_;
+      std::vector<State> goals_;
+
+      std::vector<Node> nodes_;
+      boost::unordered_map<int, int> index_;
+      typedef std::pair<double, int> Entry;
+      std::vector<Entry> open_;
+
+      std::vector<Step> steps_;
+      double cost_;
+      int expansions_;
+      std::string error_;
+  };
+}; // namespace mprim_lattice
+
+#endif
@@ -0,0 +1,198 @@
+/**
+ * mprim_lattice: SBPL lattice motion primitives
+ *
+ * The lattice looks the same under the eight rotations and reflections that
+ * map the grid onto itself, as long as the number of angles is a multiple of
+ * eight. Anything that depends only on where the robot is relative to its
+ * start can be stored for the start headings in one octant, and looked up
+ * for any other heading by transforming the query into that octant.
+ *
+ * Author: Austin Hendrix
+ */
+
+#ifndef MPRIM_LATTICE_SYMMETRY_H
+#define MPRIM_LATTICE_SYMMETRY_H
+
+#include <string>
+#include <vector>
+
+#include "mprim_lattice/mprim_lattice.h"
+
+namespace mprim_lattice {
+  /**
+   * @brief A rotation or reflection of the lattice
+   *
+   * Cells go through an integer matrix and discrete headings through
+   * a -> angle_sign * a + angle_offset, so applying one is a few multiplies
+   * and no branches.
+   */
+  struct Transform {
+    int xx, xy;
+    int yx, yy;
+    int angle_sign;
+    int angle_offset;
+
+    int x(int px, int py) const { return xx * px + xy * py; }
+    int y(int px, int py) const { return yx * px + yy * py; }
+    int angle(int a, int num_angles) const {
+      return ((angle_sign * a + angle_offset) % num_angles + num_angles) %
+        num_angles;
+    }
+
+    /**
+     * @brief Transform a continuous pose
+     */
+    Pose apply(const Pose &p, int num_angles) const;
+
+    /**
+     * @brief This transform followed by another
+     */
+    Transform then(const Transform &next) const;
+
+    Transform inverse() const;
+
+    static Transform identity();
+    /// @brief a rotation by quarter turns to the left
+    static Transform rotation(int quarters, int num_angles);
+    /// @brief a reflection about the x axis
+    static Transform mirrorX();
+  };
+
+  /**
+   * @brief The transforms that take each heading into the canonical octant,
+   * headings 0 through num_angles / 8, and back
+   *
+   * If the number of angles is not a multiple of eight the lattice has no
+   * usable symmetry, and every heading is its own canonical heading.
+   */
+  class Octant {
+    public:
+      explicit Octant(int num_angles = 16);
+
+      int numAngles() const { return num_angles_; }
+
+      /**
+       * @brief The number of canonical headings
+       */
+      int numCanonical() const { return num_canonical_; }
+
+      const Transform &toCanonical(int angle) const { return to_[angle]; }
+      const Transform &fromCanonical(int angle) const { return from_[angle]; }
+
+      /**
+       * @brief The canonical heading that a heading maps to
+       */
+      int canonicalAngle(int angle) const { return canonical_[angle]; }
+
+    private:
+      int num_angles_;
+      int num_canonical_;
+      std::vector<Transform> to_;
+      std::vector<Transform> from_;
+      std::vector<int> canonical_;
+  };
+
+  /**
+   * @brief Where a primitive goes, and what it costs; everything a search
+   * needs to know about it
+   */
+  struct Successor {
+    int dx;           ///< @brief end cell, relative to the start cell
+    int dy;
+    int end_angle;
+    double cost;      ///< @brief length times the cost multiplier
+    int primitive;    ///< @brief index among the primitives of the start angle
+  };
+
+  /**
+   * @brief A primitive set stored for the canonical headings only
+   *
+   * The primitives for the other headings are transformed on the fly.
+   */
+  class OctantPrimitives {
+    public:
+      OctantPrimitives();
+
+      /**
+       * @brief Keep the canonical headings of a primitive set
+       *
+       * Headings outside of the canonical octant may be left out of the set;
+       * any that are given must be the images of the canonical ones.
+       *
+       * @return false if the set isn't symmetric; see error()
+       */
+      bool build(const PrimitiveSet &set);
+
+      const std::string &error() const { return error_; }
+
+      const Octant &octant() const { return octant_; }
+      int numAngles() const { return octant_.numAngles(); }
+      double resolution() const { return resolution_; }
+
+      /**
+       * @brief The number of primitives that start at a heading
+       */
+      int size(int start_angle) const {
+        return canonical_[octant_.canonicalAngle(start_angle)].size();
+      }
+
+      Successor successor(int start_angle, int i) const;
+
+      /**
+       * @brief Intermediate pose j of primitive i from a heading, relative to
+       * the start cell
+       */
+      Pose pose(int start_angle, int i, int j) const;
+
+      int numPoses(int start_angle, int i) const {
+        return canonical_[octant_.canonicalAngle(start_angle)][i].poses.size();
+      }
+
+    private:
+      Octant octant_;
+      double resolution_;
+      std::vector<std::vector<Primitive> > canonical_;
+      std::string error_;
+  };
+
+  /**
+   * @brief Obstacle-free cost between lattice states near each other, for
+   * use as a search heuristic
+   *
+   * Indexed by the offset to the goal cell and the goal heading, for the
+   * canonical start headings only.
+   */
+  class HeuristicTable {
+    public:
+      HeuristicTable();
+
+      /**
+       * @brief Search the lattice from each canonical start heading
+       * @param radius Offsets of up to this many cells in x and y are stored.
+       * Paths are searched out to twice that, so that paths which swing wide
+       * of the stored area are still found
+       */
+      void build(const OctantPrimitives &primitives, int radius);
+
+      int radius() const { return radius_; }
+
+      /**
+       * @brief Cost from (0, 0, start_angle) to (dx, dy, end_angle). Infinite
+       * if the offset is outside of the table or can't be reached
+       */
+      float cost(int dx, int dy, int start_angle, int end_angle) const;
+
+      /**
+       * @brief The number of entries stored
+       */
+      int size() const { return costs_.size(); }
+
+    private:
+      Octant octant_;
+      int radius_;
+      int width_;
+      std::vector<float> costs_;
+  };
+}; // namespace mprim_lattice
+
+#endif
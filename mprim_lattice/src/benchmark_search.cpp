@@ -0,0 +1,173 @@
+/**
+ * mprim_lattice: SBPL lattice motion primitives
+ *
+ * Author: Austin Hendrix
+ *
+ * Times path searches on a random map with one thread and with several, to
+ * measure the speedup of the parallel search on this machine
+ */
+
+#include "mprim_lattice/mprim_lattice.h"
+#include "mprim_lattice/symmetry.h"
+#include "mprim_lattice/search.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <time.h>
+
+#include <boost/thread.hpp>
+
+using namespace mprim_lattice;
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static std::vector<int> parseList(const std::string &value) {
+  std::vector<int> list;
+  std::stringstream ss(value);
+  std::string item;
+  while( std::getline(ss, item, ',') ) {
+    list.push_back(atoi(item.c_str()));
+  }
+  return list;
+}
+
+static void usage(const char *name) {
+  fprintf(stderr, "Usage: %s primitives.mprim [option=value ...]\n"
+      "Options:\n"
+      "  size=200              map width and height (cells)\n"
+      "  density=0.02          fraction of the map covered by 4x4 blocks\n"
+      "  queries=10            start and goal pairs\n"
+      "  threads=1,2,4,...     thread counts; up to the number of cores\n"
+      "  seed=5                random seed\n", name);
+}
+
+int main(int argc, char **argv) {
+  if( argc < 2 ) {
+    usage(argv[0]);
+    return 1;
+  }
+  int size = 200;
+  double density = 0.02;
+  int queries = 10;
+  int seed = 5;
+  std::vector<int> threads;
+  const int cores = std::max(1u, boost::thread::hardware_concurrency());
+  for( int t=1; t<=std::max(cores, 4); t*=2 ) {
+    threads.push_back(t);
+  }
+  for( int i=2; i<argc; i++ ) {
+    const std::string arg(argv[i]);
+    const size_t eq = arg.find('=');
+    if( eq == std::string::npos ) {
+      usage(argv[0]);
+      return 1;
+    }
+    const std::string key = arg.substr(0, eq);
+    const std::string value = arg.substr(eq + 1);
+    if( key == "size" ) {
+      size = atoi(value.c_str());
+    } else if( key == "density" ) {
+      density = atof(value.c_str());
+    } else if( key == "queries" ) {
+      queries = atoi(value.c_str());
+    } else if( key == "threads" ) {
+      threads = parseList(value);
+    } else if( key == "seed" ) {
+      seed = atoi(value.c_str());
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if( size < 8 || queries < 1 || threads.empty() ) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  PrimitiveSet set;
+  if( ! set.load(std::string(argv[1])) ) {
+    fprintf(stderr, "%s\n", set.error().c_str());
+    return 1;
+  }
+  OctantPrimitives primitives;
+  if( ! primitives.build(set) ) {
+    fprintf(stderr, "%s\n", primitives.error().c_str());
+    return 1;
+  }
+
+  // scattered blocks, as in the tests
+  srand(seed);
+  std::vector<unsigned char> map(size * size, 0);
+  const int blocks = density * size * size / 16;
+  for( int i=0; i<blocks; i++ ) {
+    const int bx = rand() % (size - 4);
+    const int by = rand() % (size - 4);
+    for( int y=by; y<by+4; y++ ) {
+      for( int x=bx; x<bx+4; x++ ) {
+        map[y * size + x] = 254;
+      }
+    }
+  }
+  std::vector<State> starts;
+  std::vector<State> goals;
+  while( starts.size() < queries ) {
+    const State start(rand() % size, rand() % size,
+        rand() % primitives.numAngles());
+    const State goal(rand() % size, rand() % size,
+        rand() % primitives.numAngles());
+    if( map[start.y * size + start.x] == 0 &&
+        map[goal.y * size + goal.x] == 0 ) {
+      starts.push_back(start);
+      goals.push_back(goal);
+    }
+  }
+
+  printf("%d queries on a %dx%d map, %d cores\n", queries, size, size,
+      cores);
+  printf("threads   time (s)  speedup  expansions  found\n");
+  double serial_time = 0;
+  std::vector<double> serial_costs;
+  for( int t=0; t<threads.size(); t++ ) {
+    LatticeSearch search;
+    search.setMap(size, size, &map[0], 254);
+    search.setThreads(threads[t]);
+    if( ! search.setPrimitives(&primitives, NULL) ) {
+      fprintf(stderr, "%s\n", search.error().c_str());
+      return 1;
+    }
+    long expansions = 0;
+    int found = 0;
+    std::vector<double> costs;
+    const double begin = seconds();
+    for( int q=0; q<queries; q++ ) {
+      const bool ok = search.plan(starts[q], goals[q]);
+      found += ok;
+      costs.push_back(ok ? search.cost() : -1);
+      expansions += search.expansions();
+    }
+    const double elapsed = seconds() - begin;
+    if( t == 0 ) {
+      serial_time = elapsed;
+      serial_costs = costs;
+    }
+    // every thread count finds paths of the same cost
+    for( int q=0; q<queries; q++ ) {
+      if( fabs(costs[q] - serial_costs[q]) > 1e-6 ) {
+        fprintf(stderr, "Query %d costs %g with %d threads but %g with %d\n",
+            q, costs[q], threads[t], serial_costs[q], threads[0]);
+      }
+    }
+    printf("%7d  %9.3f  %7.2f  %10ld  %5d\n", threads[t], elapsed,
+        serial_time / elapsed, expansions, found);
+  }
+  return 0;
+}
@@ -0,0 +1,212 @@
+/**
+ * mprim_lattice: SBPL lattice motion primitives
+ *
+ * Author: Austin Hendrix
+ *
+ * .mprim reader and primitive tables
+ */
+
+#include "mprim_lattice/mprim_lattice.h"
+#include "mprim_lattice/parametric.h"
+
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace mprim_lattice {
+  // steps shorter than this have no meaningful curvature
+  static const double MIN_STEP = 1e-9;
+
+  // read "key: value", checking the key
+  template<class T>
+  static bool readField(std::istream &in, const char *key, T &value) {
+    std::string k;
+    if( !(in >> k) || k != key || !(in >> value) ) {
+      return false;
+    }
+    return true;
+  }
+
+  PrimitiveSet::PrimitiveSet() : resolution_(0), size_(0) {
+  }
+
+  bool PrimitiveSet::load(const std::string &filename) {
+    std::ifstream in(filename.c_str());
+    if( !in ) {
+      error_ = "can't open " + filename;
+      return false;
+    }
+    return load(in);
+  }
+
+  bool PrimitiveSet::load(std::istream &in) {
+    resolution_ = 0;
+    size_ = 0;
+    by_angle_.clear();
+    error_.clear();
+
+    int num_angles = 0;
+    int total = 0;
+    if( !readField(in, "resolution_m:", resolution_) ||
+        !readField(in, "numberofangles:", num_angles) ||
+        !readField(in, "totalnumberofprimitives:", total) ||
+        resolution_ <= 0 || num_angles <= 0 ) {
+      error_ = "bad header";
+      return false;
+    }
+    by_angle_.resize(num_angles);
+
+    for( int i=0; i<total; i++ ) {
+      Primitive p;
+      int num_poses = 0;
+      if( !readField(in, "primID:", p.id) ||
+          !readField(in, "startangle_c:", p.start_angle) ||
+          !readField(in, "endpose_c:", p.end_x) ||
+          !(in >> p.end_y >> p.end_angle) ||
+          !readField(in, "additionalactioncostmult:", p.cost_mult) ||
+          !readField(in, "intermediateposes:", num_poses) ) {
+        std::stringstream ss;
+        ss << "bad header for primitive " << i;
+        error_ = ss.str();
+        return false;
+      }
+      if( p.start_angle < 0 || p.start_angle >= num_angles ||
+          num_poses < 1 ) {
+        std::stringstream ss;
+        ss << "primitive " << i << " has start angle " << p.start_angle <<
+          " and " << num_poses << " poses";
+        error_ = ss.str();
+        return false;
+      }
+      p.poses.resize(num_poses);
+      for( int j=0; j<num_poses; j++ ) {
+        Pose & pose = p.poses[j];
+        if( !(in >> pose.x >> pose.y >> pose.theta) ) {
+          std::stringstream ss;
+          ss << "bad pose " << j << " in primitive " << i;
+          error_ = ss.str();
+          return false;
+        }
+      }
+      computeTables(p);
+      by_angle_[p.start_angle].push_back(p);
+      size_++;
+    }
+    return true;
+  }
+
+  void PrimitiveSet::load(const ParametricSet &set, double spacing) {
+    resolution_ = set.resolution();
+    size_ = 0;
+    by_angle_.clear();
+    error_.clear();
+    by_angle_.resize(set.numAngles());
+    for( int a=0; a<set.numAngles(); a++ ) {
+      const std::vector<ParametricPrimitive> & primitives =
+        set.primitives(a);
+      for( int i=0; i<primitives.size(); i++ ) {
+        by_angle_[a].push_back(toPrimitive(primitives[i], spacing));
+        size_++;
+      }
+    }
+  }
+
+  void PrimitiveSet::setSpeedLimits(double max_vel, double max_lateral_acc) {
+    for( int a=0; a<by_angle_.size(); a++ ) {
+      for( int i=0; i<by_angle_[a].size(); i++ ) {
+        Primitive & p = by_angle_[a][i];
+        p.speed = speedTable(p, max_vel, max_lateral_acc);
+      }
+    }
+  }
+
+  double PrimitiveSet::angle(int index) const {
+    return index * 2 * M_PI / by_angle_.size();
+  }
+
+  int PrimitiveSet::angleIndex(double theta) const {
+    const int n = by_angle_.size();
+    int index = floor(theta * n / (2 * M_PI) + 0.5);
+    index %= n;
+    if( index < 0 ) {
+      index += n;
+    }
+    return index;
+  }
+
+  const Primitive *PrimitiveSet::match(const std::vector<Pose> &path,
+      int start, double xy_tolerance, double theta_tolerance) const {
+    if( empty() || start < 0 || start >= path.size() ) {
+      return NULL;
+    }
+    const Pose & origin = path[start];
+    const std::vector<Primitive> & candidates =
+      by_angle_[angleIndex(origin.theta)];
+    for( int i=0; i<candidates.size(); i++ ) {
+      const Primitive & p = candidates[i];
+      if( start + p.poses.size() > path.size() ) {
+        continue;
+      }
+      bool good = true;
+      for( int j=0; j<p.poses.size() && good; j++ ) {
+        const Pose & a = path[start + j];
+        const Pose & b = p.poses[j];
+        double dx = (a.x - origin.x) - (b.x - p.poses[0].x);
+        double dy = (a.y - origin.y) - (b.y - p.poses[0].y);
+        double dtheta = remainder(a.theta - b.theta, 2 * M_PI);
+        good = hypot(dx, dy) <= xy_tolerance &&
+          fabs(dtheta) <= theta_tolerance;
+      }
+      if( good ) {
+        return &p;
+      }
+    }
+    return NULL;
+  }
+
+  void computeTables(Primitive &primitive) {
+    const std::vector<Pose> & poses = primitive.poses;
+    const int steps = poses.size() - 1;
+    primitive.station.resize(poses.size());
+    primitive.curvature.resize(std::max(steps, 0));
+    primitive.direction.resize(std::max(steps, 0));
+    primitive.length = 0;
+    if( poses.empty() ) {
+      return;
+    }
+    primitive.station[0] = 0;
+    for( int i=0; i<steps; i++ ) {
+      double dx = poses[i+1].x - poses[i].x;
+      double dy = poses[i+1].y - poses[i].y;
+      double dtheta = remainder(poses[i+1].theta - poses[i].theta, 2 * M_PI);
+      double chord = hypot(dx, dy);
+      // the chord of an arc points along the heading half way through it
+      double mid = poses[i].theta + dtheta / 2;
+      int direction = (cos(mid) * dx + sin(mid) * dy < 0) ? -1 : 1;
+      double arc = chord;
+      if( fabs(dtheta) > MIN_STEP ) {
+        arc = chord * (dtheta / 2) / sin(dtheta / 2);
+      }
+      primitive.direction[i] = direction;
+      // turning in place has no length; an Ackermann robot can't do that
+      // anyway, so call it straight
+      primitive.curvature[i] = (arc > MIN_STEP) ? dtheta / (direction * arc)
+        : 0;
+      primitive.length += fabs(arc);
+      primitive.station[i+1] = primitive.length;
+    }
+  }
+
+  std::vector<double> speedTable(const Primitive &primitive, double max_vel,
+      double max_lateral_acc) {
+    std::vector<double> speed(primitive.curvature.size(), max_vel);
+    for( int i=0; i<speed.size(); i++ ) {
+      double k = fabs(primitive.curvature[i]);
+      if( k > MIN_STEP ) {
+        speed[i] = std::min(max_vel, sqrt(max_lateral_acc / k));
+      }
+    }
+    return speed;
+  }
+};
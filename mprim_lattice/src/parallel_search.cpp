@@ -0,0 +1,323 @@
+/**
+ * mprim_lattice: SBPL lattice motion primitives
+ *
+ * Author: Austin Hendrix
+ *
+ * Hash-distributed A* over the lattice, one open list per thread
+ */
+
+#include "mprim_lattice/search.h"
+
+#include <limits>
+#include <algorithm>
+#include <functional>
+
+#include <boost/atomic.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/lockfree/queue.hpp>
+
+namespace mprim_lattice {
+
+  // messages each inbox has room for before it allocates more
+  static const int INBOX_SIZE = 4096;
+
+  /**
+   * @brief The workers of one parallel search, and what they share
+   *
+   * The search is over when no worker has anything left to expand and no
+   * message is on its way. Both are kept in one counter: a message counts
+   * from before it is sent until it has been handled, and a worker counts
+   * while it is busy. A worker only becomes busy by taking a message from
+   * its inbox, and it starts counting before the message stops, so the
+   * counter can't reach zero while there is work anywhere.
+   */
+  class LatticeSearch::ParallelSearch {
+    public:
+      ParallelSearch(const LatticeSearch &search, int threads);
+
+      /**
+       * @brief Search from start to goal on every worker, and follow the
+       * path back
+       * @return false if there is no path
+       */
+      bool run(const State &start, const State &goal,
+          std::vector<Step> &steps, double &cost);
+
+      int expansions() const;
+
+    private:
+      // a successor, sent by the worker that expanded its parent to the
+      // worker that owns it
+      // plain data, as the queues need
+      struct Message {
+        int from_x;
+        int from_y;
+        int from_angle;
+        int to_x;
+        int to_y;
+        int to_angle;
+        double g;
+        int parent;       // global id of the parent; -1 for the start
+        int primitive;
+        bool coarse;
+      };
+
+      struct Worker {
+        std::vector<Node> nodes;
+        boost::unordered_map<int, int> index;
+        std::vector<Entry> open;
+        boost::lockfree::queue<Message> inbox;
+        int expansions;
+
+        Worker() : inbox(INBOX_SIZE), expansions(0) {}
+      };
+
+      int owner(const State &s) const;
+      void work(int id);
+      void receive(int id, const Message &message);
+      int pop(Worker &worker);
+      void expand(int id, int node, bool coarse);
+
+      const LatticeSearch &search_;
+      const int threads_;
+      std::vector<boost::shared_ptr<Worker> > workers_;
+
+      State goal_;
+      // node of the goal in its owner, which is the only one to set it
+      int goal_node_;
+      // cost of the best path so far
+      boost::atomic<double> bound_;
+      // messages in flight, plus busy workers
+      boost::atomic<int> pending_;
+  };
+
+  LatticeSearch::ParallelSearch::ParallelSearch(const LatticeSearch &search,
+      int threads) : search_(search), threads_(threads), goal_node_(-1),
+    bound_(std::numeric_limits<double>::infinity()), pending_(0) {
+    for( int i=0; i<threads_; i++ ) {
+      workers_.push_back(boost::shared_ptr<Worker>(new Worker()));
+    }
+  }
+
+  int LatticeSearch::ParallelSearch::owner(const State &s) const {
+    // neighboring states go to different workers, so that they all share
+    // the frontier
+    const unsigned int hash = (unsigned int)s.x * 73856093u ^
+      (unsigned int)s.y * 19349663u ^ (unsigned int)s.angle * 83492791u;
+    return hash % threads_;
+  }
+
+  int LatticeSearch::ParallelSearch::expansions() const {
+    int total = 0;
+    for( int i=0; i<threads_; i++ ) {
+      total += workers_[i]->expansions;
+    }
+    return total;
+  }
+
+  void LatticeSearch::ParallelSearch::receive(int id,
+      const Message &message) {
+    Worker &worker = *workers_[id];
+    const OctantPrimitives &primitives = message.coarse ? *search_.coarse_ :
+      *search_.fine_;
+    const State from(message.from_x, message.from_y, message.from_angle);
+    const State to(message.to_x, message.to_y, message.to_angle);
+    const int k = search_.key(to);
+    boost::unordered_map<int, int>::iterator itr = worker.index.find(k);
+    int node;
+    if( itr == worker.index.end() ) {
+      if( message.parent >= 0 &&
+          search_.blocked(primitives, from, message.primitive) ) {
+        return;
+      }
+      node = worker.nodes.size();
+      worker.index[k] = node;
+      worker.nodes.push_back(Node());
+      worker.nodes[node].state = to;
+    } else {
+      // unlike on one thread, states can be reached more cheaply after
+      // they were expanded, and are opened again
+      node = itr->second;
+      if( message.g >= worker.nodes[node].g ||
+          search_.blocked(primitives, from, message.primitive) ) {
+        return;
+      }
+    }
+    Node &n = worker.nodes[node];
+    n.g = message.g;
+    n.parent = message.parent;
+    n.primitive = message.primitive;
+    n.coarse = message.coarse;
+    n.closed = false;
+
+    if( to == goal_ ) {
+      // nothing is gained by expanding the goal
+      goal_node_ = node;
+      bound_.store(message.g);
+      return;
+    }
+    const double f = message.g + search_.heuristic(to);
+    if( f < bound_.load() ) {
+      worker.open.push_back(Entry(f, node));
+      std::push_heap(worker.open.begin(), worker.open.end(),
+          std::greater<Entry>());
+    }
+  }
+
+  int LatticeSearch::ParallelSearch::pop(Worker &worker) {
+    const double bound = bound_.load();
+    while( ! worker.open.empty() ) {
+      // the bound only comes down, so nothing left can beat it
+      if( worker.open.front().first >= bound ) {
+        worker.open.clear();
+        return -1;
+      }
+      std::pop_heap(worker.open.begin(), worker.open.end(),
+          std::greater<Entry>());
+      const int node = worker.open.back().second;
+      worker.open.pop_back();
+      if( ! worker.nodes[node].closed ) {
+        worker.nodes[node].closed = true;
+        return node;
+      }
+    }
+    return -1;
+  }
+
+  void LatticeSearch::ParallelSearch::expand(int id, int node, bool coarse) {
+    const OctantPrimitives &primitives = coarse ? *search_.coarse_ :
+      *search_.fine_;
+    const int scale = coarse ? search_.factor_ : 1;
+    const State s = workers_[id]->nodes[node].state;
+    const double g = workers_[id]->nodes[node].g;
+    for( int i=0; i<primitives.size(s.angle); i++ ) {
+      const Successor succ = primitives.successor(s.angle, i);
+      const State next(s.x + succ.dx * scale, s.y + succ.dy * scale,
+          succ.end_angle);
+      if( ! search_.onMap(next) ) {
+        continue;
+      }
+      if( search_.factor_ > 0 && !search_.inFineArea(next) &&
+          !search_.onCoarseGrid(next) ) {
+        continue;
+      }
+      Message message;
+      message.g = g + succ.cost;
+      if( message.g + search_.heuristic(next) >= bound_.load() ) {
+        continue;
+      }
+      message.from_x = s.x;
+      message.from_y = s.y;
+      message.from_angle = s.angle;
+      message.to_x = next.x;
+      message.to_y = next.y;
+      message.to_angle = next.angle;
+      message.parent = node * threads_ + id;
+      message.primitive = i;
+      message.coarse = coarse;
+      // the blocked check is left to the owner, which can skip it for
+      // states it already has more cheaply
+      const int to = owner(next);
+      if( to == id ) {
+        receive(id, message);
+      } else {
+        pending_++;
+        workers_[to]->inbox.push(message);
+      }
+    }
+  }
+
+  void LatticeSearch::ParallelSearch::work(int id) {
+    Worker &worker = *workers_[id];
+    bool busy = false;
+    while( true ) {
+      Message message;
+      while( worker.inbox.pop(message) ) {
+        if( ! busy ) {
+          busy = true;
+          pending_++;
+        }
+        receive(id, message);
+        pending_--;
+      }
+
+      const int node = pop(worker);
+      if( node >= 0 ) {
+        worker.expansions++;
+        // expanding can add to the nodes, so the state is copied
+        const State s = worker.nodes[node].state;
+        if( search_.factor_ == 0 || search_.inFineArea(s) ) {
+          expand(id, node, false);
+        }
+        if( search_.onCoarseGrid(s) ) {
+          expand(id, node, true);
+        }
+        continue;
+      }
+
+      if( busy ) {
+        busy = false;
+        pending_--;
+      }
+      if( pending_.load() == 0 ) {
+        return;
+      }
+      boost::this_thread::yield();
+    }
+  }
+
+  bool LatticeSearch::ParallelSearch::run(const State &start,
+      const State &goal, std::vector<Step> &steps, double &cost) {
+    goal_ = goal;
+    Message message;
+    message.from_x = message.to_x = start.x;
+    message.from_y = message.to_y = start.y;
+    message.from_angle = message.to_angle = start.angle;
+    message.g = 0;
+    message.parent = -1;
+    message.primitive = -1;
+    message.coarse = false;
+    pending_++;
+    workers_[owner(start)]->inbox.push(message);
+
+    boost::thread_group threads;
+    for( int i=0; i<threads_; i++ ) {
+      threads.create_thread(boost::bind(&ParallelSearch::work, this, i));
+    }
+    threads.join_all();
+
+    if( goal_node_ < 0 ) {
+      return false;
+    }
+    int worker = owner(goal);
+    int node = goal_node_;
+    cost = workers_[worker]->nodes[node].g;
+    while( workers_[worker]->nodes[node].parent >= 0 ) {
+      const Node &n = workers_[worker]->nodes[node];
+      const int parent_worker = n.parent % threads_;
+      const int parent_node = n.parent / threads_;
+      Step step;
+      step.start = workers_[parent_worker]->nodes[parent_node].state;
+      step.primitive = n.primitive;
+      step.coarse = n.coarse;
+      steps.push_back(step);
+      worker = parent_worker;
+      node = parent_node;
+    }
+    std::reverse(steps.begin(), steps.end());
+    return true;
+  }
+
+  bool LatticeSearch::planParallel(const State &start, const State &goal) {
+    start_ = start;
+    ParallelSearch parallel(*this, threads_);
+    const bool found = parallel.run(start, goal, steps_, cost_);
+    expansions_ = parallel.expansions();
+    if( ! found ) {
+      error_ = "no path to the goal";
+    }
+    return found;
+  }
+};
@@ -0,0 +1,260 @@
+/**
+ * mprim_lattice: SBPL lattice motion primitives
+ *
+ * Author: Austin Hendrix
+ *
+ * .pmprim reader and writer, and the clothoid evaluator
+ */
+
+#include "mprim_lattice/parametric.h"
+
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+namespace mprim_lattice {
+  // segments with less sharpness than this are lines or arcs
+  static const double MIN_SHARPNESS = 1e-12;
+  // curvatures smaller than this are straight
+  static const double MIN_CURVATURE = 1e-12;
+  // most the heading may change over one quadrature piece; the 5-point rule
+  // is then good to far better than a micron per meter
+  static const double MAX_PIECE_TURN = 0.25;
+
+  // Gauss-Legendre nodes and weights on [-1, 1]
+  static const double GL_NODES[5] = { -0.9061798459386640, -0.5384693101056831,
+    0.0, 0.5384693101056831, 0.9061798459386640 };
+  static const double GL_WEIGHTS[5] = { 0.2369268850561891,
+    0.4786286704993665, 0.5688888888888889, 0.4786286704993665,
+    0.2369268850561891 };
+
+  // read "key: value", checking the key
+  template<class T>
+  static bool readField(std::istream &in, const char *key, T &value) {
+    std::string k;
+    if( !(in >> k) || k != key || !(in >> value) ) {
+      return false;
+    }
+    return true;
+  }
+
+  ParametricSet::ParametricSet() : resolution_(0), size_(0) {
+  }
+
+  bool ParametricSet::load(const std::string &filename) {
+    std::ifstream in(filename.c_str());
+    if( !in ) {
+      error_ = "can't open " + filename;
+      return false;
+    }
+    return load(in);
+  }
+
+  bool ParametricSet::load(std::istream &in) {
+    resolution_ = 0;
+    size_ = 0;
+    by_angle_.clear();
+    error_.clear();
+
+    int num_angles = 0;
+    int total = 0;
+    if( !readField(in, "resolution_m:", resolution_) ||
+        !readField(in, "numberofangles:", num_angles) ||
+        !readField(in, "totalnumberofprimitives:", total) ||
+        resolution_ <= 0 || num_angles <= 0 ) {
+      error_ = "bad header";
+      return false;
+    }
+    by_angle_.resize(num_angles);
+
+    for( int i=0; i<total; i++ ) {
+      ParametricPrimitive p;
+      int num_segments = 0;
+      if( !readField(in, "primID:", p.id) ||
+          !readField(in, "startangle_c:", p.start_angle) ||
+          !readField(in, "endpose_c:", p.end_x) ||
+          !(in >> p.end_y >> p.end_angle) ||
+          !readField(in, "additionalactioncostmult:", p.cost_mult) ||
+          !readField(in, "startheading:", p.start_theta) ||
+          !readField(in, "segments:", num_segments) ) {
+        std::stringstream ss;
+        ss << "bad header for primitive " << i;
+        error_ = ss.str();
+        return false;
+      }
+      if( p.start_angle < 0 || p.start_angle >= num_angles ||
+          num_segments < 1 ) {
+        std::stringstream ss;
+        ss << "primitive " << i << " has start angle " << p.start_angle <<
+          " and " << num_segments << " segments";
+        error_ = ss.str();
+        return false;
+      }
+      p.segments.resize(num_segments);
+      for( int j=0; j<num_segments; j++ ) {
+        Clothoid & segment = p.segments[j];
+        if( !(in >> segment.length >> segment.sharpness) ||
+            segment.length < 0 ) {
+          std::stringstream ss;
+          ss << "bad segment " << j << " in primitive " << i;
+          error_ = ss.str();
+          return false;
+        }
+      }
+      computeKnots(p, resolution_);
+      by_angle_[p.start_angle].push_back(p);
+      size_++;
+    }
+    return true;
+  }
+
+  void ParametricSet::save(std::ostream &out) const {
+    out << std::fixed << std::setprecision(6);
+    out << "resolution_m: " << resolution_ << "\n";
+    out << "numberofangles: " << by_angle_.size() << "\n";
+    out << "totalnumberofprimitives: " << size_ << "\n";
+    for( int a=0; a<by_angle_.size(); a++ ) {
+      for( int i=0; i<by_angle_[a].size(); i++ ) {
+        const ParametricPrimitive & p = by_angle_[a][i];
+        out << "primID: " << p.id << "\n";
+        out << "startangle_c: " << p.start_angle << "\n";
+        out << "endpose_c: " << p.end_x << " " << p.end_y << " " <<
+          p.end_angle << "\n";
+        out << "additionalactioncostmult: " << p.cost_mult << "\n";
+        out << "startheading: " << p.start_theta << "\n";
+        out << "segments: " << p.segments.size() << "\n";
+        for( int j=0; j<p.segments.size(); j++ ) {
+          out << p.segments[j].length << " " << p.segments[j].sharpness <<
+            "\n";
+        }
+      }
+    }
+  }
+
+  Pose advance(const Pose &start, double curvature, double sharpness,
+      double length) {
+    const double k = curvature;
+    const double w = sharpness;
+    const double L = length;
+    Pose end(start.x, start.y, start.theta + k * L + w * L * L / 2);
+    if( fabs(w) < MIN_SHARPNESS ) {
+      if( fabs(k) < MIN_CURVATURE ) {
+        end.x += L * cos(start.theta);
+        end.y += L * sin(start.theta);
+      } else {
+        end.x += (sin(end.theta) - sin(start.theta)) / k;
+        end.y -= (cos(end.theta) - cos(start.theta)) / k;
+      }
+      return end;
+    }
+    // bound on how far the heading moves; split into pieces that each turn
+    // a little, where the quadrature is accurate
+    const double turn = (fabs(k) + fabs(w) * L) * L;
+    const int pieces = 1 + int(turn / MAX_PIECE_TURN);
+    const double h = L / pieces;
+    double sx = 0;
+    double sy = 0;
+    for( int i=0; i<pieces; i++ ) {
+      const double mid = (i + 0.5) * h;
+      for( int j=0; j<5; j++ ) {
+        const double s = mid + GL_NODES[j] * h / 2;
+        const double theta = start.theta + k * s + w * s * s / 2;
+        sx += GL_WEIGHTS[j] * cos(theta);
+        sy += GL_WEIGHTS[j] * sin(theta);
+      }
+    }
+    end.x += sx * h / 2;
+    end.y += sy * h / 2;
+    return end;
+  }
+
+  void computeKnots(ParametricPrimitive &primitive, double resolution) {
+    const std::vector<Clothoid> & segments = primitive.segments;
+    primitive.knots.resize(segments.size());
+    Pose pose(0, 0, primitive.start_theta);
+    double curvature = 0;
+    double station = 0;
+    for( int i=0; i<segments.size(); i++ ) {
+      Knot & knot = primitive.knots[i];
+      knot.station = station;
+      knot.pose = pose;
+      knot.curvature = curvature;
+      pose = advance(pose, curvature, segments[i].sharpness,
+          segments[i].length);
+      curvature += segments[i].sharpness * segments[i].length;
+      station += segments[i].length;
+    }
+    primitive.length = station;
+    primitive.closure_x = primitive.end_x * resolution - pose.x;
+    primitive.closure_y = primitive.end_y * resolution - pose.y;
+  }
+
+  // the segment that arc length s is on
+  static int segmentAt(const ParametricPrimitive &primitive, double s) {
+    int i = primitive.knots.size() - 1;
+    while( i > 0 && primitive.knots[i].station > s ) {
+      i--;
+    }
+    return i;
+  }
+
+  Pose evaluate(const ParametricPrimitive &primitive, double s) {
+    if( primitive.knots.empty() ) {
+      return Pose(0, 0, primitive.start_theta);
+    }
+    s = std::max(0.0, std::min(primitive.length, s));
+    const int i = segmentAt(primitive, s);
+    const Knot & knot = primitive.knots[i];
+    Pose pose = advance(knot.pose, knot.curvature,
+        primitive.segments[i].sharpness, s - knot.station);
+    if( primitive.length > 0 ) {
+      const double t = s / primitive.length;
+      pose.x += t * primitive.closure_x;
+      pose.y += t * primitive.closure_y;
+    }
+    pose.theta = fmod(pose.theta, 2 * M_PI);
+    if( pose.theta < 0 ) {
+      pose.theta += 2 * M_PI;
+    }
+    return pose;
+  }
+
+  double curvatureAt(const ParametricPrimitive &primitive, double s) {
+    if( primitive.knots.empty() ) {
+      return 0;
+    }
+    s = std::max(0.0, std::min(primitive.length, s));
+    const int i = segmentAt(primitive, s);
+    const Knot & knot = primitive.knots[i];
+    return knot.curvature + primitive.segments[i].sharpness *
+      (s - knot.station);
+  }
+
+  void sample(const ParametricPrimitive &primitive, double spacing,
+      std::vector<Pose> &poses) {
+    int steps = 1;
+    if( spacing > 0 ) {
+      steps = std::max(1, int(ceil(primitive.length / spacing)));
+    }
+    poses.resize(steps + 1);
+    for( int i=0; i<=steps; i++ ) {
+      poses[i] = evaluate(primitive, primitive.length * i / steps);
+    }
+  }
+
+  Primitive toPrimitive(const ParametricPrimitive &primitive,
+      double spacing) {
+    Primitive p;
+    p.id = primitive.id;
+    p.start_angle = primitive.start_angle;
+    p.end_x = primitive.end_x;
+    p.end_y = primitive.end_y;
+    p.end_angle = primitive.end_angle;
+    p.cost_mult = primitive.cost_mult;
+    sample(primitive, spacing, p.poses);
+    computeTables(p);
+    return p;
+  }
+};
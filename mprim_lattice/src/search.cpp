@@ -0,0 +1,320 @@
+/**
+ * mprim_lattice: SBPL lattice motion primitives
+ *
+ * Author: Austin Hendrix
+ *
+ * A* over the lattice, with an optional coarse level for open space
+ */
+
+#include "mprim_lattice/search.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include <sstream>
+
+namespace mprim_lattice {
+
+  LatticeSearch::LatticeSearch() : fine_(NULL), coarse_(NULL), factor_(0),
+    fine_radius_(20), threads_(1), width_(0), height_(0), cells_(NULL),
+    lethal_(254), cost_(0), expansions_(0) {
+  }
+
+  bool LatticeSearch::setPrimitives(const OctantPrimitives *fine,
+      const OctantPrimitives *coarse) {
+    fine_ = fine;
+    coarse_ = NULL;
+    factor_ = 0;
+    error_.clear();
+    if( coarse == NULL ) {
+      return true;
+    }
+    if( coarse->numAngles() != fine->numAngles() ) {
+      error_ = "coarse primitives have different headings";
+      return false;
+    }
+    const double ratio = coarse->resolution() / fine->resolution();
+    const int factor = (int)floor(ratio + 0.5);
+    if( factor < 1 || fabs(ratio - factor) > 1e-6 ) {
+      std::stringstream ss;
+      ss << "coarse resolution " << coarse->resolution() <<
+        " is not a multiple of " << fine->resolution();
+      error_ = ss.str();
+      return false;
+    }
+    coarse_ = coarse;
+    factor_ = factor;
+    return true;
+  }
+
+  void LatticeSearch::setMap(int width, int height,
+      const unsigned char *cells, unsigned char lethal) {
+    width_ = width;
+    height_ = height;
+    cells_ = cells;
+    lethal_ = lethal;
+  }
+
+  bool LatticeSearch::inFineArea(const State &s) const {
+    if( std::max(abs(s.x - start_.x), abs(s.y - start_.y)) <=
+        fine_radius_ ) {
+      return true;
+    }
+    for( int i=0; i<goals_.size(); i++ ) {
+      if( std::max(abs(s.x - goals_[i].x), abs(s.y - goals_[i].y)) <=
+          fine_radius_ ) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool LatticeSearch::blocked(const OctantPrimitives &primitives,
+      const State &s, int i) const {
+    // intermediate poses are relative to the center of the start cell, and
+    // the coarse ones can be several cells apart, so check between them
+    // every half a cell
+    const double res = fine_->resolution();
+    const int count = primitives.numPoses(s.angle, i);
+    Pose last = primitives.pose(s.angle, i, 0);
+    for( int j=0; j<count; j++ ) {
+      const Pose p = primitives.pose(s.angle, i, j);
+      const int samples = std::max(1,
+          (int)ceil(2 * hypot(p.x - last.x, p.y - last.y) / res));
+      for( int k=1; k<=samples; k++ ) {
+        const double t = (double)k / samples;
+        const int x = (int)floor(s.x + 0.5 + (last.x + t * (p.x - last.x)) /
+            res);
+        const int y = (int)floor(s.y + 0.5 + (last.y + t * (p.y - last.y)) /
+            res);
+        if( x < 0 || y < 0 || x >= width_ || y >= height_ ||
+            cells_[y * width_ + x] >= lethal_ ) {
+          return true;
+        }
+      }
+      last = p;
+    }
+    return false;
+  }
+
+  double LatticeSearch::heuristic(const State &s) const {
+    // a primitive costs at least its length, which is at least the distance
+    // between its ends. With many goals there is nothing to aim for
+    if( goals_.size() != 1 ) {
+      return 0;
+    }
+    return hypot(goals_[0].x - s.x, goals_[0].y - s.y) * fine_->resolution();
+  }
+
+  void LatticeSearch::expand(int node, bool coarse) {
+    const OctantPrimitives &primitives = coarse ? *coarse_ : *fine_;
+    const int scale = coarse ? factor_ : 1;
+    const State s = nodes_[node].state;
+    for( int i=0; i<primitives.size(s.angle); i++ ) {
+      const Successor succ = primitives.successor(s.angle, i);
+      const State next(s.x + succ.dx * scale, s.y + succ.dy * scale,
+          succ.end_angle);
+      if( ! onMap(next) ) {
+        continue;
+      }
+      // outside of the fine area, only the coarse states exist
+      if( factor_ > 0 && !inFineArea(next) && !onCoarseGrid(next) ) {
+        continue;
+      }
+      const double g = nodes_[node].g + succ.cost;
+      boost::unordered_map<int, int>::iterator itr = index_.find(key(next));
+      int id;
+      if( itr == index_.end() ) {
+        if( blocked(primitives, s, i) ) {
+          continue;
+        }
+        id = nodes_.size();
+        index_[key(next)] = id;
+        nodes_.push_back(Node());
+        nodes_[id].state = next;
+        nodes_[id].closed = false;
+      } else {
+        id = itr->second;
+        if( nodes_[id].closed || g >= nodes_[id].g ||
+            blocked(primitives, s, i) ) {
+          continue;
+        }
+      }
+      nodes_[id].g = g;
+      nodes_[id].parent = node;
+      nodes_[id].primitive = i;
+      nodes_[id].coarse = coarse;
+      open_.push_back(Entry(g + heuristic(next), id));
+      std::push_heap(open_.begin(), open_.end(), std::greater<Entry>());
+    }
+  }
+
+  void LatticeSearch::reset(const State &start) {
+    // clearing keeps the storage of the last search
+    nodes_.clear();
+    index_.clear();
+    open_.clear();
+    start_ = start;
+
+    Node root;
+    root.state = start;
+    root.g = 0;
+    root.parent = -1;
+    root.primitive = -1;
+    root.coarse = false;
+    root.closed = false;
+    nodes_.push_back(root);
+    index_[key(start)] = 0;
+    open_.push_back(Entry(heuristic(start), 0));
+  }
+
+  int LatticeSearch::pop() {
+    while( ! open_.empty() ) {
+      std::pop_heap(open_.begin(), open_.end(), std::greater<Entry>());
+      const int node = open_.back().second;
+      open_.pop_back();
+      if( ! nodes_[node].closed ) {
+        nodes_[node].closed = true;
+        return node;
+      }
+    }
+    return -1;
+  }
+
+  bool LatticeSearch::plan(const State &start, const State &goal) {
+    steps_.clear();
+    cost_ = 0;
+    expansions_ = 0;
+    error_.clear();
+
+    if( fine_ == NULL || cells_ == NULL ) {
+      error_ = "no primitives or map";
+      return false;
+    }
+    if( ! onMap(start) || ! onMap(goal) ) {
+      error_ = "start or goal is off of the map";
+      return false;
+    }
+    goals_.assign(1, goal);
+    if( threads_ > 1 ) {
+      return planParallel(start, goal);
+    }
+    reset(start);
+
+    int found = -1;
+    for( int node = pop(); node >= 0; node = pop() ) {
+      if( nodes_[node].state == goal ) {
+        found = node;
+        break;
+      }
+      expansions_++;
+
+      const State &s = nodes_[node].state;
+      if( factor_ == 0 || inFineArea(s) ) {
+        expand(node, false);
+      }
+      if( onCoarseGrid(s) ) {
+        expand(node, true);
+      }
+    }
+
+    if( found < 0 ) {
+      error_ = "no path to the goal";
+      return false;
+    }
+    cost_ = nodes_[found].g;
+    for( int node = found; nodes_[node].parent >= 0;
+        node = nodes_[node].parent ) {
+      Step step;
+      step.start = nodes_[nodes_[node].parent].state;
+      step.primitive = nodes_[node].primitive;
+      step.coarse = nodes_[node].coarse;
+      steps_.push_back(step);
+    }
+    std::reverse(steps_.begin(), steps_.end());
+    return true;
+  }
+
+  int LatticeSearch::costs(const State &start,
+      const std::vector<State> &goals, std::vector<double> &costs) {
+    steps_.clear();
+    cost_ = 0;
+    expansions_ = 0;
+    error_.clear();
+    costs.assign(goals.size(), -1);
+
+    if( fine_ == NULL || cells_ == NULL ) {
+      error_ = "no primitives or map";
+      return 0;
+    }
+    if( ! onMap(start) ) {
+      error_ = "start is off of the map";
+      return 0;
+    }
+
+    // the goals by state, so that each settled node is one lookup; goals
+    // off of the map or in blocked cells are never reached
+    goals_.clear();
+    std::vector<std::pair<int, int> > keys;
+    for( int i=0; i<goals.size(); i++ ) {
+      if( onMap(goals[i]) &&
+          cells_[goals[i].y * width_ + goals[i].x] < lethal_ ) {
+        goals_.push_back(goals[i]);
+        keys.push_back(std::make_pair(key(goals[i]), i));
+      }
+    }
+    std::sort(keys.begin(), keys.end());
+    reset(start);
+
+    int reached = 0;
+    int remaining = keys.size();
+    for( int node = pop(); node >= 0 && remaining > 0; node = pop() ) {
+      const int k = key(nodes_[node].state);
+      std::vector<std::pair<int, int> >::iterator itr = std::lower_bound(
+          keys.begin(), keys.end(),
+          std::make_pair(k, -1));
+      for( ; itr != keys.end() && itr->first == k; ++itr ) {
+        costs[itr->second] = nodes_[node].g;
+        reached++;
+        remaining--;
+      }
+      if( remaining == 0 ) {
+        break;
+      }
+      expansions_++;
+
+      const State &s = nodes_[node].state;
+      if( factor_ == 0 || inFineArea(s) ) {
+        expand(node, false);
+      }
+      if( onCoarseGrid(s) ) {
+        expand(node, true);
+      }
+    }
+    if( reached < goals.size() ) {
+      error_ = "some goals can't be reached";
+    }
+    return reached;
+  }
+
+  std::vector<Pose> LatticeSearch::path() const {
+    std::vector<Pose> poses;
+    const double res = fine_ ? fine_->resolution() : 0;
+    for( int i=0; i<steps_.size(); i++ ) {
+      const Step &step = steps_[i];
+      const OctantPrimitives &primitives = step.coarse ? *coarse_ : *fine_;
+      const double x = (step.start.x + 0.5) * res;
+      const double y = (step.start.y + 0.5) * res;
+      const int count = primitives.numPoses(step.start.angle, step.primitive);
+      // the first pose of each primitive is the last of the one before it
+      for( int j = (i == 0 ? 0 : 1); j<count; j++ ) {
+        Pose p = primitives.pose(step.start.angle, step.primitive, j);
+        p.x += x;
+        p.y += y;
+        poses.push_back(p);
+      }
+    }
+    return poses;
+  }
+};
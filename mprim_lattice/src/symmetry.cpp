@@ -0,0 +1,265 @@
+/**
+ * mprim_lattice: SBPL lattice motion primitives
+ *
+ * Author: Austin Hendrix
+ *
+ * Octant symmetry of the lattice, and tables stored in one octant
+ */
+
+#include "mprim_lattice/symmetry.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <sstream>
+
+namespace mprim_lattice {
+
+  Pose Transform::apply(const Pose &p, int num_angles) const {
+    return Pose(xx * p.x + xy * p.y, yx * p.x + yy * p.y,
+        angle_sign * p.theta + angle_offset * 2 * M_PI / num_angles);
+  }
+
+  Transform Transform::then(const Transform &next) const {
+    Transform t;
+    t.xx = next.xx * xx + next.xy * yx;
+    t.xy = next.xx * xy + next.xy * yy;
+    t.yx = next.yx * xx + next.yy * yx;
+    t.yy = next.yx * xy + next.yy * yy;
+    t.angle_sign = next.angle_sign * angle_sign;
+    t.angle_offset = next.angle_sign * angle_offset + next.angle_offset;
+    return t;
+  }
+
+  Transform Transform::inverse() const {
+    // the matrix is orthogonal
+    Transform t;
+    t.xx = xx;
+    t.xy = yx;
+    t.yx = xy;
+    t.yy = yy;
+    t.angle_sign = angle_sign;
+    t.angle_offset = -angle_sign * angle_offset;
+    return t;
+  }
+
+  Transform Transform::identity() {
+    Transform t;
+    t.xx = 1;
+    t.xy = 0;
+    t.yx = 0;
+    t.yy = 1;
+    t.angle_sign = 1;
+    t.angle_offset = 0;
+    return t;
+  }
+
+  Transform Transform::rotation(int quarters, int num_angles) {
+    Transform t = identity();
+    quarters = ((quarters % 4) + 4) % 4;
+    for( int i=0; i<quarters; i++ ) {
+      // (x, y) -> (-y, x)
+      Transform q;
+      q.xx = 0;
+      q.xy = -1;
+      q.yx = 1;
+      q.yy = 0;
+      q.angle_sign = 1;
+      q.angle_offset = num_angles / 4;
+      t = t.then(q);
+    }
+    return t;
+  }
+
+  Transform Transform::mirrorX() {
+    Transform t = identity();
+    t.yy = -1;
+    t.angle_sign = -1;
+    return t;
+  }
+
+  Octant::Octant(int num_angles) : num_angles_(num_angles),
+    num_canonical_(num_angles), to_(num_angles, Transform::identity()),
+    from_(num_angles, Transform::identity()), canonical_(num_angles) {
+    const bool symmetric = num_angles > 0 && num_angles % 8 == 0;
+    if( symmetric ) {
+      num_canonical_ = num_angles / 8 + 1;
+    }
+    const int quarter = num_angles / 4;
+    for( int a=0; a<num_angles; a++ ) {
+      if( symmetric ) {
+        const int q = a / quarter;
+        const int rem = a % quarter;
+        if( rem <= num_angles / 8 ) {
+          // rotate back into the first quadrant
+          to_[a] = Transform::rotation(-q, num_angles);
+        } else {
+          // rotate to just below the x axis, then mirror up above it
+          to_[a] = Transform::rotation(-(q + 1), num_angles).then(
+              Transform::mirrorX());
+        }
+      }
+      from_[a] = to_[a].inverse();
+      canonical_[a] = to_[a].angle(a, num_angles);
+    }
+  }
+
+  OctantPrimitives::OctantPrimitives() : resolution_(0) {
+  }
+
+  // what a primitive does, for comparing sets of primitives
+  static std::vector<int> signature(const Successor &s, int cost_mult) {
+    std::vector<int> sig(4);
+    sig[0] = s.dx;
+    sig[1] = s.dy;
+    sig[2] = s.end_angle;
+    sig[3] = cost_mult;
+    return sig;
+  }
+
+  bool OctantPrimitives::build(const PrimitiveSet &set) {
+    octant_ = Octant(set.numAngles());
+    resolution_ = set.resolution();
+    canonical_.clear();
+    error_.clear();
+    const int n = octant_.numAngles();
+
+    for( int c=0; c<octant_.numCanonical(); c++ ) {
+      canonical_.push_back(set.primitives(c));
+    }
+
+    // check that the other headings are images of the canonical ones
+    for( int a=octant_.numCanonical(); a<n; a++ ) {
+      const std::vector<Primitive> & given = set.primitives(a);
+      if( given.empty() ) {
+        continue;
+      }
+      std::vector<std::vector<int> > expected;
+      for( int i=0; i<size(a); i++ ) {
+        expected.push_back(signature(successor(a, i),
+              canonical_[octant_.canonicalAngle(a)][i].cost_mult));
+      }
+      std::vector<std::vector<int> > actual;
+      for( int i=0; i<given.size(); i++ ) {
+        Successor s;
+        s.dx = given[i].end_x;
+        s.dy = given[i].end_y;
+        s.end_angle = ((given[i].end_angle % n) + n) % n;
+        actual.push_back(signature(s, given[i].cost_mult));
+      }
+      std::sort(expected.begin(), expected.end());
+      std::sort(actual.begin(), actual.end());
+      if( expected != actual ) {
+        std::stringstream ss;
+        ss << "primitives for angle " << a << " are not the image of angle "
+          << octant_.canonicalAngle(a);
+        error_ = ss.str();
+        canonical_.clear();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  Successor OctantPrimitives::successor(int start_angle, int i) const {
+    const int n = octant_.numAngles();
+    const Primitive & p =
+      canonical_[octant_.canonicalAngle(start_angle)][i];
+    const Transform & t = octant_.fromCanonical(start_angle);
+    Successor s;
+    s.dx = t.x(p.end_x, p.end_y);
+    s.dy = t.y(p.end_x, p.end_y);
+    s.end_angle = t.angle(p.end_angle, n);
+    s.cost = p.length * p.cost_mult;
+    s.primitive = i;
+    return s;
+  }
+
+  Pose OctantPrimitives::pose(int start_angle, int i, int j) const {
+    const Primitive & p =
+      canonical_[octant_.canonicalAngle(start_angle)][i];
+    return octant_.fromCanonical(start_angle).apply(p.poses[j],
+        octant_.numAngles());
+  }
+
+  HeuristicTable::HeuristicTable() : radius_(0), width_(0) {
+  }
+
+  void HeuristicTable::build(const OctantPrimitives &primitives, int radius) {
+    typedef std::pair<double, int> Entry;
+    octant_ = primitives.octant();
+    radius_ = radius;
+    width_ = 2 * radius + 1;
+    const int n = octant_.numAngles();
+    costs_.assign(octant_.numCanonical() * width_ * width_ * n,
+        std::numeric_limits<float>::infinity());
+
+    // search area
+    const int search_radius = 2 * radius;
+    const int search_width = 2 * search_radius + 1;
+    std::vector<double> dist(search_width * search_width * n);
+
+    for( int c=0; c<octant_.numCanonical(); c++ ) {
+      std::fill(dist.begin(), dist.end(),
+          std::numeric_limits<double>::infinity());
+      std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> >
+        queue;
+      const int start = (search_radius * search_width + search_radius) * n + c;
+      dist[start] = 0;
+      queue.push(Entry(0, start));
+      while( ! queue.empty() ) {
+        const Entry top = queue.top();
+        queue.pop();
+        const int state = top.second;
+        if( top.first > dist[state] ) {
+          continue;
+        }
+        const int a = state % n;
+        const int x = (state / n) % search_width - search_radius;
+        const int y = state / n / search_width - search_radius;
+        for( int i=0; i<primitives.size(a); i++ ) {
+          const Successor s = primitives.successor(a, i);
+          const int nx = x + s.dx;
+          const int ny = y + s.dy;
+          if( abs(nx) > search_radius || abs(ny) > search_radius ) {
+            continue;
+          }
+          const int next = ((ny + search_radius) * search_width + nx +
+              search_radius) * n + s.end_angle;
+          const double d = top.first + s.cost;
+          if( d < dist[next] ) {
+            dist[next] = d;
+            queue.push(Entry(d, next));
+          }
+        }
+      }
+
+      for( int y=-radius; y<=radius; y++ ) {
+        for( int x=-radius; x<=radius; x++ ) {
+          for( int e=0; e<n; e++ ) {
+            costs_[((c * width_ + y + radius) * width_ + x + radius) * n + e] =
+              dist[((y + search_radius) * search_width + x + search_radius) *
+              n + e];
+          }
+        }
+      }
+    }
+  }
+
+  float HeuristicTable::cost(int dx, int dy, int start_angle,
+      int end_angle) const {
+    const int n = octant_.numAngles();
+    const Transform & t = octant_.toCanonical(start_angle);
+    // unsigned, so that one compare catches both ends of the range
+    const unsigned int x = t.x(dx, dy) + radius_;
+    const unsigned int y = t.y(dx, dy) + radius_;
+    if( x >= (unsigned int)width_ || y >= (unsigned int)width_ ) {
+      return std::numeric_limits<float>::infinity();
+    }
+    const int c = t.angle(start_angle, n);
+    return costs_[((c * width_ + y) * width_ + x) * n + t.angle(end_angle, n)];
+  }
+};
@@ -0,0 +1,759 @@
+#include "mprim_lattice/mprim_lattice.h"
+#include "mprim_lattice/symmetry.h"
+#include "mprim_lattice/search.h"
+#include "mprim_lattice/parametric.h"
+
+#include <cmath>
+#include <sstream>
+#include <limits>
+#include <queue>
+#include <functional>
+#include <gtest/gtest.h>
+
+using namespace mprim_lattice;
+
+// a straight primitive and a quarter circle of radius 0.4, both starting
+// at angle 0, and a straight primitive at angle 4 (pi/2)
+const char *TEST_MPRIM =
+"resolution_m: 0.100000\n"
+"numberofangles: 16\n"
+"totalnumberofprimitives: 3\n"
+"primID: 0\n"
+"startangle_c: 0\n"
+"endpose_c: 2 0 0\n"
+"additionalactioncostmult: 1\n"
+"intermediateposes: 3\n"
+"0.0000 0.0000 0.0000\n"
+"0.1000 0.0000 0.0000\n"
+"0.2000 0.0000 0.0000\n"
+"primID: 1\n"
+"startangle_c: 0\n"
+"endpose_c: 4 4 4\n"
+"additionalactioncostmult: 2\n"
+"intermediateposes: 3\n"
+"0.0000 0.0000 0.0000\n"
+"0.2828 0.1172 0.7854\n"
+"0.4000 0.4000 1.5708\n"
+"primID: 0\n"
+"startangle_c: 4\n"
+"endpose_c: 0 2 4\n"
+"additionalactioncostmult: 1\n"
+"intermediateposes: 2\n"
+"0.0000 0.0000 1.5708\n"
+"0.0000 0.2000 1.5708\n";
+
+TEST(MPrimTests, load) {
+  std::istringstream in(TEST_MPRIM);
+  PrimitiveSet set;
+  ASSERT_TRUE(set.load(in));
+  EXPECT_EQ(set.size(), 3);
+  EXPECT_EQ(set.numAngles(), 16);
+  EXPECT_FLOAT_EQ(set.resolution(), 0.1);
+  ASSERT_EQ(set.primitives(0).size(), 2);
+  ASSERT_EQ(set.primitives(4).size(), 1);
+  EXPECT_EQ(set.primitives(1).size(), 0);
+
+  const Primitive & p = set.primitives(0)[1];
+  EXPECT_EQ(p.id, 1);
+  EXPECT_EQ(p.end_x, 4);
+  EXPECT_EQ(p.end_y, 4);
+  EXPECT_EQ(p.end_angle, 4);
+  EXPECT_EQ(p.cost_mult, 2);
+  ASSERT_EQ(p.poses.size(), 3);
+  EXPECT_FLOAT_EQ(p.poses[2].theta, 1.5708);
+}
+
+TEST(MPrimTests, badFile) {
+  std::istringstream in("resolution_m: 0.1\nnumberofangles: 16\n"
+      "totalnumberofprimitives: 1\nprimID: 0\nstartangle_c: 20\n");
+  PrimitiveSet set;
+  EXPECT_FALSE(set.load(in));
+  EXPECT_FALSE(set.error().empty());
+  EXPECT_TRUE(set.empty());
+
+  EXPECT_FALSE(set.load("/nonexistent.mprim"));
+}
+
+TEST(MPrimTests, tables) {
+  std::istringstream in(TEST_MPRIM);
+  PrimitiveSet set;
+  ASSERT_TRUE(set.load(in));
+
+  const Primitive & straight = set.primitives(0)[0];
+  ASSERT_EQ(straight.curvature.size(), 2);
+  EXPECT_NEAR(straight.curvature[0], 0.0, 1e-9);
+  EXPECT_EQ(straight.direction[0], 1);
+  EXPECT_NEAR(straight.length, 0.2, 1e-9);
+  EXPECT_NEAR(straight.station[1], 0.1, 1e-9);
+
+  const Primitive & arc = set.primitives(0)[1];
+  EXPECT_NEAR(arc.curvature[0], 2.5, 1e-3);
+  EXPECT_NEAR(arc.curvature[1], 2.5, 1e-3);
+  EXPECT_NEAR(arc.length, M_PI * 0.4 / 2, 1e-3);
+
+  std::vector<double> speed = speedTable(arc, 1.0, 0.4);
+  ASSERT_EQ(speed.size(), 2);
+  EXPECT_NEAR(speed[0], 0.4, 1e-3);
+  speed = speedTable(straight, 1.0, 0.4);
+  EXPECT_FLOAT_EQ(speed[0], 1.0);
+
+  set.setSpeedLimits(0.3, 0.4);
+  ASSERT_EQ(set.primitives(0)[1].speed.size(), 2);
+  EXPECT_FLOAT_EQ(set.primitives(0)[0].speed[0], 0.3);
+  EXPECT_NEAR(set.primitives(0)[1].speed[1], 0.3, 1e-9);
+}
+
+TEST(MPrimTests, backwards) {
+  Primitive p;
+  p.poses.push_back(Pose(0, 0, 0));
+  p.poses.push_back(Pose(-0.1, 0, 0));
+  computeTables(p);
+  ASSERT_EQ(p.direction.size(), 1);
+  EXPECT_EQ(p.direction[0], -1);
+  EXPECT_NEAR(p.length, 0.1, 1e-9);
+}
+
+TEST(MPrimTests, angles) {
+  std::istringstream in(TEST_MPRIM);
+  PrimitiveSet set;
+  ASSERT_TRUE(set.load(in));
+  EXPECT_EQ(set.angleIndex(0), 0);
+  EXPECT_EQ(set.angleIndex(M_PI/2), 4);
+  EXPECT_EQ(set.angleIndex(-M_PI/8), 15);
+  EXPECT_EQ(set.angleIndex(2*M_PI - 0.01), 0);
+  EXPECT_NEAR(set.angle(4), M_PI/2, 1e-9);
+}
+
+TEST(MPrimTests, match) {
+  std::istringstream in(TEST_MPRIM);
+  PrimitiveSet set;
+  ASSERT_TRUE(set.load(in));
+
+  // the arc, then the straight primitive at pi/2, starting at (1, 2)
+  std::vector<Pose> path;
+  path.push_back(Pose(1.0, 2.0, 0.0));
+  path.push_back(Pose(1.2828, 2.1172, 0.7854));
+  path.push_back(Pose(1.4, 2.4, 1.5708));
+  path.push_back(Pose(1.4, 2.6, 1.5708));
+
+  const Primitive * p = set.match(path, 0, 0.01, 0.02);
+  ASSERT_TRUE(p != NULL);
+  EXPECT_EQ(p->id, 1);
+  EXPECT_EQ(p->start_angle, 0);
+
+  p = set.match(path, 2, 0.01, 0.02);
+  ASSERT_TRUE(p != NULL);
+  EXPECT_EQ(p->start_angle, 4);
+
+  // nothing starts at angle 1, and a primitive can't run off the path
+  EXPECT_TRUE(set.match(path, 1, 0.01, 0.02) == NULL);
+  EXPECT_TRUE(set.match(path, 3, 0.01, 0.02) == NULL);
+
+  // out of tolerance
+  path[1].y += 0.05;
+  EXPECT_TRUE(set.match(path, 0, 0.01, 0.02) == NULL);
+}
+
+// one octant of a small lattice: a straight primitive and turns to the
+// neighbouring headings from each of the canonical headings 0, 1 and 2
+const char *OCTANT_MPRIM =
+"resolution_m: 0.100000\n"
+"numberofangles: 16\n"
+"totalnumberofprimitives: 9\n"
+"primID: 0\n"
+"startangle_c: 0\n"
+"endpose_c: 1 0 0\n"
+"additionalactioncostmult: 1\n"
+"intermediateposes: 2\n"
+"0.0000 0.0000 0.0000\n"
+"0.1000 0.0000 0.0000\n"
+"primID: 1\n"
+"startangle_c: 0\n"
+"endpose_c: 2 1 1\n"
+"additionalactioncostmult: 1\n"
+"intermediateposes: 2\n"
+"0.0000 0.0000 0.0000\n"
+"0.2000 0.1000 0.3927\n"
+"primID: 2\n"
+"startangle_c: 0\n"
+"endpose_c: 2 -1 15\n"
+"additionalactioncostmult: 1\n"
+"intermediateposes: 2\n"
+"0.0000 0.0000 0.0000\n"
+"0.2000 -0.1000 5.8905\n"
+"primID: 0\n"
+"startangle_c: 1\n"
+"endpose_c: 2 1 1\n"
+"additionalactioncostmult: 1\n"
+"intermediateposes: 2\n"
+"0.0000 0.0000 0.3927\n"
+"0.2000 0.1000 0.3927\n"
+"primID: 1\n"
+"startangle_c: 1\n"
+"endpose_c: 2 0 0\n"
+"additionalactioncostmult: 1\n"
+"intermediateposes: 2\n"
+"0.0000 0.0000 0.3927\n"
+"0.2000 0.0000 0.0000\n"
+"primID: 2\n"
+"startangle_c: 1\n"
+"endpose_c: 1 1 2\n"
+"additionalactioncostmult: 1\n"
+"intermediateposes: 2\n"
+"0.0000 0.0000 0.3927\n"
+"0.1000 0.1000 0.7854\n"
+"primID: 0\n"
+"startangle_c: 2\n"
+"endpose_c: 1 1 2\n"
+"additionalactioncostmult: 1\n"
+"intermediateposes: 2\n"
+"0.0000 0.0000 0.7854\n"
+"0.1000 0.1000 0.7854\n"
+"primID: 1\n"
+"startangle_c: 2\n"
+"endpose_c: 2 1 1\n"
+"additionalactioncostmult: 1\n"
+"intermediateposes: 2\n"
+"0.0000 0.0000 0.7854\n"
+"0.2000 0.1000 0.3927\n"
+"primID: 2\n"
+"startangle_c: 2\n"
+"endpose_c: 1 2 3\n"
+"additionalactioncostmult: 1\n"
+"intermediateposes: 2\n"
+"0.0000 0.0000 0.7854\n"
+"0.1000 0.2000 1.1781\n";
+
+TEST(MPrimTests, octant) {
+  Octant octant(16);
+  EXPECT_EQ(octant.numCanonical(), 3);
+  for( int a=0; a<16; a++ ) {
+    const Transform & to = octant.toCanonical(a);
+    const Transform & from = octant.fromCanonical(a);
+    int c = octant.canonicalAngle(a);
+    EXPECT_GE(c, 0);
+    EXPECT_LE(c, 2);
+    EXPECT_EQ(to.angle(a, 16), c);
+    EXPECT_EQ(from.angle(c, 16), a);
+
+    // there and back again
+    EXPECT_EQ(from.x(to.x(3, 1), to.y(3, 1)), 3);
+    EXPECT_EQ(from.y(to.x(3, 1), to.y(3, 1)), 1);
+
+    // headings turn with the cells
+    for( int h=0; h<16; h++ ) {
+      double theta = h * M_PI / 8;
+      double x = 100 * cos(theta);
+      double y = 100 * sin(theta);
+      double t = to.angle(h, 16) * M_PI / 8;
+      EXPECT_NEAR(to.xx * x + to.xy * y, 100 * cos(t), 1e-9);
+      EXPECT_NEAR(to.yx * x + to.yy * y, 100 * sin(t), 1e-9);
+    }
+  }
+
+  // no symmetry to use
+  Octant odd(12);
+  EXPECT_EQ(odd.numCanonical(), 12);
+  EXPECT_EQ(odd.canonicalAngle(7), 7);
+}
+
+TEST(MPrimTests, octantPrimitives) {
+  std::istringstream in(OCTANT_MPRIM);
+  PrimitiveSet set;
+  ASSERT_TRUE(set.load(in));
+  OctantPrimitives octant;
+  ASSERT_TRUE(octant.build(set));
+
+  // the straight primitive, a quarter turn around
+  ASSERT_EQ(octant.size(4), 3);
+  Successor s = octant.successor(4, 0);
+  EXPECT_EQ(s.dx, 0);
+  EXPECT_EQ(s.dy, 1);
+  EXPECT_EQ(s.end_angle, 4);
+  EXPECT_NEAR(s.cost, 0.1, 1e-9);
+
+  // a left turn from heading 3 is the mirror image of a right turn from
+  // heading 1
+  s = octant.successor(3, 1);
+  EXPECT_EQ(s.dx, 0);
+  EXPECT_EQ(s.dy, 2);
+  EXPECT_EQ(s.end_angle, 4);
+  Pose p = octant.pose(3, 1, 1);
+  EXPECT_NEAR(p.x, 0.0, 1e-4);
+  EXPECT_NEAR(p.y, 0.2, 1e-4);
+  EXPECT_NEAR(remainder(p.theta - M_PI / 2, 2 * M_PI), 0, 1e-4);
+
+  // the test set doesn't have the symmetric image of its primitives
+  std::istringstream bad(TEST_MPRIM);
+  ASSERT_TRUE(set.load(bad));
+  EXPECT_FALSE(octant.build(set));
+  EXPECT_FALSE(octant.error().empty());
+}
+
+TEST(MPrimTests, heuristicTable) {
+  std::istringstream in(OCTANT_MPRIM);
+  PrimitiveSet set;
+  ASSERT_TRUE(set.load(in));
+  OctantPrimitives octant;
+  ASSERT_TRUE(octant.build(set));
+
+  const int radius = 4;
+  HeuristicTable table;
+  table.build(octant, radius);
+  const int width = 2 * radius + 1;
+  EXPECT_EQ(table.size(), 3 * width * width * 16);
+  EXPECT_NEAR(table.cost(3, 0, 0, 0), 0.3, 1e-6);
+  EXPECT_NEAR(table.cost(0, -3, 12, 12), 0.3, 1e-6);
+  EXPECT_EQ(table.cost(radius + 1, 0, 0, 0),
+      std::numeric_limits<float>::infinity());
+
+  // search from every heading, without the symmetry
+  typedef std::pair<double, int> Entry;
+  const int search = 2 * radius;
+  const int search_width = 2 * search + 1;
+  for( int a=0; a<16; a++ ) {
+    std::vector<double> dist(search_width * search_width * 16,
+        std::numeric_limits<double>::infinity());
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > open;
+    int start = (search * search_width + search) * 16 + a;
+    dist[start] = 0;
+    open.push(Entry(0, start));
+    while( ! open.empty() ) {
+      Entry e = open.top();
+      open.pop();
+      if( e.first > dist[e.second] ) {
+        continue;
+      }
+      int h = e.second % 16;
+      int x = (e.second / 16) % search_width - search;
+      int y = e.second / 16 / search_width - search;
+      for( int i=0; i<octant.size(h); i++ ) {
+        Successor s = octant.successor(h, i);
+        if( abs(x + s.dx) > search || abs(y + s.dy) > search ) {
+          continue;
+        }
+        int next = ((y + s.dy + search) * search_width + x + s.dx + search) *
+          16 + s.end_angle;
+        if( e.first + s.cost < dist[next] ) {
+          dist[next] = e.first + s.cost;
+          open.push(Entry(dist[next], next));
+        }
+      }
+    }
+    for( int y=-radius; y<=radius; y++ ) {
+      for( int x=-radius; x<=radius; x++ ) {
+        for( int h=0; h<16; h++ ) {
+          double expected = dist[((y + search) * search_width + x + search) *
+            16 + h];
+          float actual = table.cost(x, y, a, h);
+          if( expected == std::numeric_limits<double>::infinity() ) {
+            EXPECT_EQ(actual, std::numeric_limits<float>::infinity());
+          } else {
+            EXPECT_NEAR(actual, expected, 1e-5);
+          }
+        }
+      }
+    }
+  }
+}
+
+// the same primitives on cells that are factor times as big
+std::string scaleMprim(const char *mprim, int factor) {
+  std::istringstream in(mprim);
+  std::stringstream out;
+  std::string line;
+  while( std::getline(in, line) ) {
+    std::istringstream fields(line);
+    double x, y, theta;
+    if( line.compare(0, 13, "resolution_m:") == 0 ) {
+      fields.ignore(13);
+      fields >> x;
+      out << "resolution_m: " << x * factor << "\n";
+    } else if( (isdigit(line[0]) || line[0] == '-') &&
+        (fields >> x >> y >> theta) ) {
+      out << x * factor << " " << y * factor << " " << theta << "\n";
+    } else {
+      out << line << "\n";
+    }
+  }
+  return out.str();
+}
+
+TEST(MPrimTests, multiResolutionSearch) {
+  std::istringstream fine_in(OCTANT_MPRIM);
+  std::istringstream coarse_in(scaleMprim(OCTANT_MPRIM, 4));
+  PrimitiveSet fine_set;
+  PrimitiveSet coarse_set;
+  ASSERT_TRUE(fine_set.load(fine_in));
+  ASSERT_TRUE(coarse_set.load(coarse_in));
+  EXPECT_NEAR(coarse_set.resolution(), 0.4, 1e-9);
+  OctantPrimitives fine;
+  OctantPrimitives coarse;
+  ASSERT_TRUE(fine.build(fine_set));
+  ASSERT_TRUE(coarse.build(coarse_set));
+
+  // a 30m square, with a wall across most of it
+  const int size = 300;
+  std::vector<unsigned char> map(size * size, 0);
+  for( int y=0; y<250; y++ ) {
+    for( int x=145; x<155; x++ ) {
+      map[y * size + x] = 254;
+    }
+  }
+  const State start(20, 20, 0);
+  const State goal(280, 21, 0);
+
+  LatticeSearch search;
+  search.setMap(size, size, &map[0], 254);
+  ASSERT_TRUE(search.setPrimitives(&fine));
+  ASSERT_TRUE(search.plan(start, goal));
+  const double fine_cost = search.cost();
+  const int fine_expansions = search.expansions();
+
+  ASSERT_TRUE(search.setPrimitives(&fine, &coarse));
+  search.setFineRadius(10);
+  ASSERT_TRUE(search.plan(start, goal));
+  EXPECT_LT(search.expansions() * 10, fine_expansions);
+  EXPECT_GE(search.cost(), fine_cost - 1e-9);
+  EXPECT_LT(search.cost(), fine_cost * 1.2);
+
+  // the steps join up, and the coarse ones start on the coarse grid
+  const std::vector<Step> &steps = search.steps();
+  ASSERT_FALSE(steps.empty());
+  EXPECT_TRUE(steps.front().start == start);
+  int coarse_steps = 0;
+  for( int i=0; i<steps.size(); i++ ) {
+    const OctantPrimitives &p = steps[i].coarse ? coarse : fine;
+    const int scale = steps[i].coarse ? 4 : 1;
+    const Successor s = p.successor(steps[i].start.angle,
+        steps[i].primitive);
+    const State end(steps[i].start.x + s.dx * scale,
+        steps[i].start.y + s.dy * scale, s.end_angle);
+    if( i + 1 < steps.size() ) {
+      EXPECT_TRUE(end == steps[i+1].start);
+    } else {
+      EXPECT_TRUE(end == goal);
+    }
+    if( steps[i].coarse ) {
+      EXPECT_TRUE(search.onCoarseGrid(steps[i].start));
+      coarse_steps++;
+    }
+  }
+  EXPECT_GT(coarse_steps, 0);
+
+  // and stay off of the wall
+  const std::vector<Pose> path = search.path();
+  ASSERT_FALSE(path.empty());
+  for( int i=0; i<path.size(); i++ ) {
+    const int x = (int)floor(path[i].x / 0.1);
+    const int y = (int)floor(path[i].y / 0.1);
+    ASSERT_TRUE(x >= 0 && y >= 0 && x < size && y < size);
+    EXPECT_LT(map[y * size + x], 254);
+  }
+  EXPECT_NEAR(path.back().x, (goal.x + 0.5) * 0.1, 1e-3);
+  EXPECT_NEAR(path.back().y, (goal.y + 0.5) * 0.1, 1e-3);
+
+  // coarse cells must be a whole number of fine cells across
+  std::istringstream three_in(scaleMprim(OCTANT_MPRIM, 3));
+  ASSERT_TRUE(coarse_set.load(three_in));
+  ASSERT_TRUE(coarse.build(coarse_set));
+  EXPECT_TRUE(search.setPrimitives(&fine, &coarse));
+  std::string text = scaleMprim(OCTANT_MPRIM, 3);
+  text.replace(0, text.find('\n'), "resolution_m: 0.25");
+  std::istringstream odd_in(text);
+  ASSERT_TRUE(coarse_set.load(odd_in));
+  OctantPrimitives odd;
+  ASSERT_TRUE(odd.build(coarse_set));
+  EXPECT_FALSE(search.setPrimitives(&fine, &odd));
+  EXPECT_FALSE(search.error().empty());
+  ASSERT_TRUE(search.setPrimitives(&fine, &coarse));
+
+  // no way through
+  for( int x=0; x<size; x++ ) {
+    map[200 * size + x] = 254;
+  }
+  EXPECT_FALSE(search.plan(start, State(20, 280, 0)));
+}
+
+TEST(MPrimTests, oneToManyCosts) {
+  std::istringstream fine_in(OCTANT_MPRIM);
+  PrimitiveSet fine_set;
+  ASSERT_TRUE(fine_set.load(fine_in));
+  OctantPrimitives fine;
+  ASSERT_TRUE(fine.build(fine_set));
+
+  // a 10m square, with a wall across part of it
+  const int size = 100;
+  std::vector<unsigned char> map(size * size, 0);
+  for( int y=0; y<70; y++ ) {
+    for( int x=48; x<52; x++ ) {
+      map[y * size + x] = 254;
+    }
+  }
+  LatticeSearch search;
+  search.setMap(size, size, &map[0], 254);
+  ASSERT_TRUE(search.setPrimitives(&fine));
+
+  const State start(10, 10, 0);
+  std::vector<State> goals;
+  srand(11);
+  while( goals.size() < 12 ) {
+    const State goal(rand() % size, rand() % size, rand() % 16);
+    if( map[goal.y * size + goal.x] == 0 ) {
+      goals.push_back(goal);
+    }
+  }
+  // the same goal twice, one off of the map and one in the wall
+  goals.push_back(goals[0]);
+  goals.push_back(State(size, 5, 0));
+  goals.push_back(State(50, 10, 0));
+
+  std::vector<double> costs;
+  const int reached = search.costs(start, goals, costs);
+  ASSERT_EQ(costs.size(), goals.size());
+  const int batch_expansions = search.expansions();
+
+  // the same costs as planning to each goal on its own
+  int single_expansions = 0;
+  int planned = 0;
+  for( int i=0; i<12; i++ ) {
+    if( search.plan(start, goals[i]) ) {
+      EXPECT_NEAR(costs[i], search.cost(), 1e-6);
+      planned++;
+    } else {
+      EXPECT_EQ(costs[i], -1);
+    }
+    single_expansions += search.expansions();
+  }
+  EXPECT_GE(planned, 10);
+  EXPECT_EQ(reached, planned + (costs[0] >= 0 ? 1 : 0));
+  EXPECT_LT(batch_expansions, single_expansions);
+  EXPECT_NEAR(costs[12], costs[0], 1e-9);
+  EXPECT_EQ(costs[13], -1);
+  EXPECT_EQ(costs[14], -1);
+
+  // the start is free, and a single goal is the same as plan()
+  EXPECT_EQ(search.costs(start, std::vector<State>(1, start), costs), 1);
+  EXPECT_EQ(costs[0], 0);
+  for( int i=0; i<12; i++ ) {
+    if( search.plan(start, goals[i]) ) {
+      const double cost = search.cost();
+      EXPECT_EQ(search.costs(start, std::vector<State>(1, goals[i]), costs),
+          1);
+      EXPECT_NEAR(costs[0], cost, 1e-6);
+      break;
+    }
+  }
+}
+
+TEST(MPrimTests, parallelSearch) {
+  std::istringstream fine_in(OCTANT_MPRIM);
+  std::istringstream coarse_in(scaleMprim(OCTANT_MPRIM, 4));
+  PrimitiveSet fine_set;
+  PrimitiveSet coarse_set;
+  ASSERT_TRUE(fine_set.load(fine_in));
+  ASSERT_TRUE(coarse_set.load(coarse_in));
+  OctantPrimitives fine;
+  OctantPrimitives coarse;
+  ASSERT_TRUE(fine.build(fine_set));
+  ASSERT_TRUE(coarse.build(coarse_set));
+
+  // a 10m square, with a wall across most of it and scattered blocks
+  const int size = 100;
+  std::vector<unsigned char> map(size * size, 0);
+  for( int y=0; y<80; y++ ) {
+    for( int x=48; x<52; x++ ) {
+      map[y * size + x] = 254;
+    }
+  }
+  srand(5);
+  for( int i=0; i<20; i++ ) {
+    const int bx = rand() % (size - 4);
+    const int by = rand() % (size - 4);
+    for( int y=by; y<by+4; y++ ) {
+      for( int x=bx; x<bx+4; x++ ) {
+        map[y * size + x] = 254;
+      }
+    }
+  }
+
+  LatticeSearch serial;
+  serial.setMap(size, size, &map[0], 254);
+  LatticeSearch parallel;
+  parallel.setMap(size, size, &map[0], 254);
+  parallel.setThreads(4);
+
+  // the same costs as one thread, with and without the coarse level
+  for( int level=0; level<2; level++ ) {
+    ASSERT_TRUE(serial.setPrimitives(&fine, level ? &coarse : NULL));
+    ASSERT_TRUE(parallel.setPrimitives(&fine, level ? &coarse : NULL));
+    int planned = 0;
+    for( int i=0; i<8; i++ ) {
+      const State start(rand() % size, rand() % size, rand() % 16);
+      const State goal(rand() % size, rand() % size, rand() % 16);
+      const bool found = serial.plan(start, goal);
+      ASSERT_EQ(parallel.plan(start, goal), found);
+      if( ! found ) {
+        continue;
+      }
+      planned++;
+      EXPECT_NEAR(parallel.cost(), serial.cost(), 1e-6);
+
+      // the steps join up, and add up to the cost
+      const std::vector<Step> &steps = parallel.steps();
+      State at = start;
+      double cost = 0;
+      for( int j=0; j<steps.size(); j++ ) {
+        EXPECT_TRUE(steps[j].start == at);
+        const int scale = steps[j].coarse ? 4 : 1;
+        const Successor s = (steps[j].coarse ? coarse : fine).successor(
+            at.angle, steps[j].primitive);
+        at = State(at.x + s.dx * scale, at.y + s.dy * scale, s.end_angle);
+        cost += s.cost;
+      }
+      EXPECT_TRUE(at == goal);
+      EXPECT_NEAR(cost, parallel.cost(), 1e-6);
+    }
+    EXPECT_GE(planned, 4);
+  }
+
+  // the start is the goal
+  const State free_state(10, 95, 0);
+  ASSERT_EQ(map[95 * size + 10], 0);
+  ASSERT_TRUE(parallel.plan(free_state, free_state));
+  EXPECT_EQ(parallel.cost(), 0);
+  EXPECT_TRUE(parallel.steps().empty());
+
+  // no way through; every worker runs out of states and stops
+  for( int x=0; x<size; x++ ) {
+    map[90 * size + x] = 254;
+  }
+  EXPECT_FALSE(parallel.plan(State(10, 10, 0), free_state));
+  EXPECT_FALSE(parallel.error().empty());
+}
+
+// a straight primitive, and a quarter turn at angle 0: a spiral up to
+// curvature 2.5, an arc, and a spiral back down, after a short straight
+const char *TEST_PMPRIM =
+"resolution_m: 0.100000\n"
+"numberofangles: 16\n"
+"totalnumberofprimitives: 2\n"
+"primID: 0\n"
+"startangle_c: 0\n"
+"endpose_c: 3 0 0\n"
+"additionalactioncostmult: 1\n"
+"startheading: 0.000000\n"
+"segments: 1\n"
+"0.300000 0.000000\n"
+"primID: 1\n"
+"startangle_c: 0\n"
+"endpose_c: 6 5 4\n"
+"additionalactioncostmult: 2\n"
+"startheading: 0.000000\n"
+"segments: 4\n"
+"0.100000 0.000000\n"
+"0.200000 12.500000\n"
+"0.428320 0.000000\n"
+"0.200000 -12.500000\n";
+
+TEST(MPrimTests, clothoid) {
+  // against the generator's Fresnel integral form, in primitives.py
+  Pose p = advance(Pose(), 0, 0.1, 5);
+  EXPECT_NEAR(p.x, 4.2732691420089255, 1e-9);
+  EXPECT_NEAR(p.y, 1.8620681128161767, 1e-9);
+  EXPECT_NEAR(p.theta, 1.25, 1e-12);
+  p = advance(Pose(), 0.5, -0.1, 5);
+  EXPECT_NEAR(p.x, 3.1145313202640916, 1e-9);
+  EXPECT_NEAR(p.y, 3.4681149738592167, 1e-9);
+  p = advance(Pose(), 0.5, 0, 5);
+  EXPECT_NEAR(p.x, 1.1969442882079129, 1e-9);
+  EXPECT_NEAR(p.y, 3.602287231093867, 1e-9);
+  EXPECT_NEAR(p.theta, 2.5, 1e-12);
+
+  // splitting a segment anywhere lands in the same place
+  const Pose start(0.3, -0.2, 1.0);
+  const Pose whole = advance(start, -1.5, 4.0, 2.0);
+  const Pose half = advance(start, -1.5, 4.0, 0.7);
+  const Pose rest = advance(half, -1.5 + 4.0 * 0.7, 4.0, 1.3);
+  EXPECT_NEAR(rest.x, whole.x, 1e-9);
+  EXPECT_NEAR(rest.y, whole.y, 1e-9);
+  EXPECT_NEAR(rest.theta, whole.theta, 1e-12);
+}
+
+TEST(MPrimTests, parametric) {
+  std::istringstream in(TEST_PMPRIM);
+  ParametricSet set;
+  ASSERT_TRUE(set.load(in)) << set.error();
+  EXPECT_EQ(set.size(), 2);
+  EXPECT_EQ(set.numAngles(), 16);
+  ASSERT_EQ(set.primitives(0).size(), 2u);
+
+  const ParametricPrimitive & turn = set.primitives(0)[1];
+  EXPECT_EQ(turn.cost_mult, 2);
+  EXPECT_NEAR(turn.length, 0.92832, 1e-9);
+  // the integrated end is within a few mm of the cell, and ends exactly on
+  // it once the closure is spread out
+  EXPECT_LT(hypot(turn.closure_x, turn.closure_y), 0.01);
+  Pose p = evaluate(turn, 0);
+  EXPECT_NEAR(p.x, 0, 1e-12);
+  EXPECT_NEAR(p.y, 0, 1e-12);
+  p = evaluate(turn, turn.length);
+  EXPECT_NEAR(p.x, 0.6, 1e-9);
+  EXPECT_NEAR(p.y, 0.5, 1e-9);
+  EXPECT_NEAR(p.theta, M_PI / 2, 1e-4);
+  p = evaluate(turn, 100);
+  EXPECT_NEAR(p.x, 0.6, 1e-9);
+
+  EXPECT_NEAR(curvatureAt(turn, 0.05), 0, 1e-12);
+  EXPECT_NEAR(curvatureAt(turn, 0.2), 1.25, 1e-9);
+  EXPECT_NEAR(curvatureAt(turn, 0.5), 2.5, 1e-9);
+  EXPECT_NEAR(curvatureAt(turn, turn.length), 0, 1e-9);
+
+  // any spacing; the tables follow the curvature
+  std::vector<Pose> poses;
+  sample(turn, 0.01, poses);
+  EXPECT_EQ(poses.size(), 94u);
+  Primitive sampled = toPrimitive(turn, 0.005);
+  EXPECT_EQ(sampled.end_x, 6);
+  EXPECT_EQ(sampled.end_angle, 4);
+  // the closure pulls the path in a little
+  EXPECT_NEAR(sampled.length, turn.length, 0.01);
+  const int steps = sampled.curvature.size();
+  for( int i=0; i<steps; i++ ) {
+    const double s = turn.length * (i + 0.5) / steps;
+    EXPECT_NEAR(sampled.curvature[i], curvatureAt(turn, s), 0.05);
+    EXPECT_EQ(sampled.direction[i], 1);
+    EXPECT_LE(sampled.station[i+1] - sampled.station[i], 0.0051);
+  }
+
+  // a pose set sampled at one spacing matches plans sampled at another
+  PrimitiveSet primitives;
+  primitives.load(set, 0.02);
+  EXPECT_EQ(primitives.size(), 2);
+  EXPECT_EQ(primitives.resolution(), set.resolution());
+  std::vector<Pose> path;
+  path.push_back(Pose(1.0, 1.0, 0));
+  for( int i=1; i<primitives.primitives(0)[1].poses.size(); i++ ) {
+    const Pose & q = primitives.primitives(0)[1].poses[i];
+    path.push_back(Pose(1.0 + q.x, 1.0 + q.y, q.theta));
+  }
+  EXPECT_EQ(primitives.match(path, 0, 0.01, 0.05),
+      &primitives.primitives(0)[1]);
+
+  // written back out the same
+  std::ostringstream out;
+  set.save(out);
+  EXPECT_EQ(out.str(), TEST_PMPRIM);
+
+  std::istringstream bad("resolution_m: 0.1\nnumberofangles: 16\n"
+      "totalnumberofprimitives: 1\nprimID: 0\nstartangle_c: 0\n"
+      "endpose_c: 1 0 0\nadditionalactioncostmult: 1\n"
+      "startheading: 0.0\nsegments: 1\n-0.1 0.0\n");
+  EXPECT_FALSE(set.load(bad));
+  EXPECT_TRUE(set.empty());
+}
+
+int main(int argc, char ** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}